@@ -12,12 +12,20 @@
 #include <caterva.h>
 
 #include "caterva_blosc.h"
+#include "caterva_compound.h"
 #include "caterva_plainbuffer.h"
+#include "caterva_pyramid.h"
+#include "caterva_utils.h"
 
 int caterva_context_new(caterva_config_t *cfg, caterva_context_t **ctx) {
     CATERVA_ERROR_NULL(cfg);
     CATERVA_ERROR_NULL(ctx);
 
+    if ((cfg->alloc_aligned == NULL) != (cfg->free_aligned == NULL)) {
+        DEBUG_PRINT("The aligned allocation and release functions must be set together");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
     (*ctx) = (caterva_context_t *) cfg->alloc(sizeof(caterva_context_t));
     if (!(*ctx)) {
         DEBUG_PRINT("Allocation fails");
@@ -30,6 +38,7 @@ int caterva_context_new(caterva_config_t *cfg, caterva_context_t **ctx) {
         return CATERVA_ERR_NULL_POINTER;
     }
     memcpy((*ctx)->cfg, cfg, sizeof(caterva_config_t));
+    memset(&(*ctx)->stats, 0, sizeof(caterva_stats_t));
 
     return CATERVA_SUCCEED;
 }
@@ -44,15 +53,50 @@ int caterva_context_free(caterva_context_t **ctx) {
     return CATERVA_SUCCEED;
 }
 
-int caterva_array_empty(caterva_context_t *ctx, caterva_params_t *params,
-                        caterva_storage_t *storage, caterva_array_t **array) {
-    CATERVA_ERROR_NULL(ctx);
-    CATERVA_ERROR_NULL(params);
-    CATERVA_ERROR_NULL(storage);
-    CATERVA_ERROR_NULL(array);
+static int pyramid_new(caterva_context_t *ctx, caterva_params_t *params,
+                       caterva_storage_t *storage, const void *fill_value,
+                       caterva_array_t **array);
 
+// Create an array without data (the fill value, if it is not NULL, is recorded but not applied)
+static int array_new(caterva_context_t *ctx, caterva_params_t *params,
+                     caterva_storage_t *storage, const void *fill_value,
+                     caterva_array_t **array) {
     if (storage->backend == CATERVA_STORAGE_BLOSC) {
-        CATERVA_ERROR(caterva_blosc_array_empty(ctx, params, storage, array));
+        // The prefilter computes the items inside Blosc, after the rounding, the predictor and the
+        // deltas would be applied
+        caterva_predictor_t predictor = storage->properties.blosc.predictor;
+        if (!caterva_predictor_supported(predictor, params->itemsize) ||
+            (predictor != CATERVA_PREDICTOR_NONE && ctx->cfg->prefilter != NULL)) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        caterva_storage_properties_blosc_t *blosc = &storage->properties.blosc;
+        if (!caterva_lossy_supported(blosc->lossy_mode, blosc->lossy_tolerance, blosc->lossy_bits,
+                                     params->itemsize) ||
+            (blosc->lossy_mode != CATERVA_LOSSY_NONE && ctx->cfg->prefilter != NULL)) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        int32_t keyframe_interval = storage->properties.blosc.keyframe_interval;
+        int8_t delta_axis = storage->properties.blosc.delta_axis;
+        if (keyframe_interval < 0 ||
+            (keyframe_interval > 0 && (delta_axis < 0 || delta_axis >= params->ndim ||
+                                       ctx->cfg->prefilter != NULL))) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        if (blosc->sum_index &&
+            (!caterva_item_supported(blosc->sum_kind, params->itemsize) ||
+             ctx->cfg->prefilter != NULL)) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        if (blosc->bloom_index &&
+            (params->itemsize > 8 || blosc->bloom_bits > CATERVA_BLOOM_BITS_MAX ||
+             ctx->cfg->prefilter != NULL)) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        if (storage->properties.blosc.pyramid_levels != 0) {
+            CATERVA_ERROR(pyramid_new(ctx, params, storage, fill_value, array));
+            return CATERVA_SUCCEED;
+        }
+        CATERVA_ERROR(caterva_blosc_array_empty(ctx, params, storage, fill_value, array));
     } else {
         CATERVA_ERROR(caterva_plainbuffer_array_empty(ctx, params, storage, array));
     }
@@ -61,6 +105,117 @@ int caterva_array_empty(caterva_context_t *ctx, caterva_params_t *params,
     (*array)->empty = true;
     (*array)->nchunks = 0;
 
+    if (fill_value != NULL) {
+        (*array)->fill_value = caterva_malloc(ctx, (size_t) params->itemsize,
+                                              CATERVA_ALLOC_ARRAY);
+        CATERVA_ERROR_NULL((*array)->fill_value);
+        memcpy((*array)->fill_value, fill_value, params->itemsize);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Create an array and its downsampled levels without data
+static int pyramid_new(caterva_context_t *ctx, caterva_params_t *params,
+                       caterva_storage_t *storage, const void *fill_value,
+                       caterva_array_t **array) {
+    caterva_params_t lparams;
+    caterva_storage_t lstorage;
+    uint8_t smeta[CATERVA_PYRAMID_METALAYER_LEN];
+    char *lfilename;
+    CATERVA_ERROR(caterva_pyramid_storage(ctx, params, storage, 0, smeta, &lfilename, &lparams,
+                                          &lstorage));
+    CATERVA_ERROR(array_new(ctx, &lparams, &lstorage, fill_value, array));
+
+    int8_t nlevels = storage->properties.blosc.pyramid_levels;
+    caterva_array_t **levels = caterva_malloc(ctx, nlevels * sizeof(caterva_array_t *),
+                                              CATERVA_ALLOC_ARRAY);
+    int rc = levels != NULL ? CATERVA_SUCCEED : CATERVA_ERR_NULL_POINTER;
+    int8_t l = 0;
+    while (l < nlevels && rc == CATERVA_SUCCEED) {
+        // The levels of an array on disk are created in their own files
+        rc = caterva_pyramid_storage(ctx, params, storage, (int8_t) (l + 1), smeta, &lfilename,
+                                     &lparams, &lstorage);
+        if (rc == CATERVA_SUCCEED) {
+            rc = array_new(ctx, &lparams, &lstorage, fill_value, &levels[l]);
+            caterva_pyramid_filename_free(ctx, lfilename);
+        }
+        l = rc == CATERVA_SUCCEED ? (int8_t) (l + 1) : l;
+    }
+    if (rc != CATERVA_SUCCEED) {
+        for (int i = 0; i < l; ++i) {
+            caterva_array_free(ctx, &levels[i]);
+        }
+        if (levels != NULL) {
+            caterva_free(ctx, levels, nlevels * sizeof(caterva_array_t *), CATERVA_ALLOC_ARRAY);
+        }
+        caterva_array_free(ctx, array);
+        CATERVA_ERROR(rc);
+    }
+
+    (*array)->pyramid_levels = nlevels;
+    (*array)->pyramid_reduce = storage->properties.blosc.pyramid_reduce;
+    (*array)->pyramid_kind = storage->properties.blosc.pyramid_kind;
+    (*array)->levels = levels;
+
+    return CATERVA_SUCCEED;
+}
+
+// Apply the fill value of an array created without data (if it has one)
+static void fill_empty(caterva_array_t *array) {
+    if (array->fill_value != NULL) {
+        // No chunk is stored in a superchunk; all of them read as the fill value
+        if (array->storage == CATERVA_STORAGE_PLAINBUFFER) {
+            caterva_fill_buffer(array->buf, array->nitems, array->itemsize, array->fill_value);
+        }
+        array->filled = true;
+        array->empty = false;
+        array->nchunks = array->extnitems / array->chunknitems;
+        for (int64_t nchunk = 0; nchunk < array->nchunks; ++nchunk) {
+            caterva_sums_uniform(array, nchunk, array->fill_value);
+            caterva_bloom_uniform(array, nchunk, array->fill_value);
+        }
+    }
+}
+
+// Create an array without data, filled with the fill value if it is not NULL
+static int array_create(caterva_context_t *ctx, caterva_params_t *params,
+                        caterva_storage_t *storage, const void *fill_value,
+                        caterva_array_t **array) {
+    CATERVA_ERROR(array_new(ctx, params, storage, fill_value, array));
+
+    // The levels read as the fill value too (the reduction of a uniform window is its value)
+    fill_empty(*array);
+    for (int i = 0; i < (*array)->pyramid_levels; ++i) {
+        fill_empty((*array)->levels[i]);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_empty(caterva_context_t *ctx, caterva_params_t *params,
+                        caterva_storage_t *storage, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(array_create(ctx, params, storage, NULL, array));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_full(caterva_context_t *ctx, caterva_params_t *params,
+                       caterva_storage_t *storage, const void *fill_value,
+                       caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(fill_value);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(array_create(ctx, params, storage, fill_value, array));
+
     return CATERVA_SUCCEED;
 }
 
@@ -96,7 +251,56 @@ int caterva_array_from_file(caterva_context_t *ctx, const char *filename, bool c
     CATERVA_ERROR_NULL(filename);
     CATERVA_ERROR_NULL(array);
 
-    CATERVA_ERROR(caterva_blosc_from_file(ctx, filename, copy, array));
+    if (caterva_plainbuffer_is_file(filename)) {
+        CATERVA_ERROR(caterva_plainbuffer_from_file(ctx, filename, copy, array));
+    } else {
+        CATERVA_ERROR(caterva_blosc_from_file(ctx, filename, copy, array));
+        int rc = caterva_pyramid_from_file(ctx, filename, copy, array);
+        if (rc != CATERVA_SUCCEED) {
+            caterva_array_free(ctx, array);
+            CATERVA_ERROR(rc);
+        }
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_to_sframe(caterva_context_t *ctx, caterva_array_t *array, uint8_t **sframe,
+                            int64_t *len, bool *needs_free) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(sframe);
+    CATERVA_ERROR_NULL(len);
+    CATERVA_ERROR_NULL(needs_free);
+    CATERVA_ERROR_COMPOUND(array);
+    CATERVA_ERROR(caterva_array_flush(ctx, array));
+
+    if (array->storage != CATERVA_STORAGE_BLOSC) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+    CATERVA_ERROR(caterva_blosc_array_to_sframe(ctx, array, sframe, len, needs_free));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_save(caterva_context_t *ctx, caterva_array_t *array, const char *filename) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(filename);
+    CATERVA_ERROR_COMPOUND(array);
+    CATERVA_ERROR(caterva_array_flush(ctx, array));
+
+    switch (array->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            CATERVA_ERROR(caterva_blosc_array_save(ctx, array, filename));
+            CATERVA_ERROR(caterva_pyramid_save(ctx, array, filename));
+            break;
+        case CATERVA_STORAGE_PLAINBUFFER:
+            CATERVA_ERROR(caterva_plainbuffer_array_save(ctx, array, filename));
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
 
     return CATERVA_SUCCEED;
 }
@@ -105,17 +309,31 @@ int caterva_array_free(caterva_context_t *ctx, caterva_array_t **array) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
 
-    if (*array) {
+    int rc = CATERVA_SUCCEED;
+    if (*array && (*array)->nfields > 0) {
+        rc = caterva_compound_array_free(ctx, array);
+    } else if (*array) {
+        if ((*array)->pyramid_levels > 0) {
+            rc = caterva_pyramid_free(ctx, *array);
+        }
+        int brc = CATERVA_SUCCEED;
         switch ((*array)->storage) {
             case CATERVA_STORAGE_BLOSC:
-                caterva_blosc_array_free(ctx, array);
+                // It may fail writing the chunks left in the append buffer
+                brc = caterva_blosc_array_free(ctx, array);
                 break;
             case CATERVA_STORAGE_PLAINBUFFER:
                 caterva_plainbuffer_array_free(ctx, array);
                 break;
         }
-        ctx->cfg->free(*array);
+        rc = rc == CATERVA_SUCCEED ? brc : rc;
+        if ((*array)->fill_value != NULL) {
+            caterva_free(ctx, (*array)->fill_value, (size_t) (*array)->itemsize,
+                         CATERVA_ALLOC_ARRAY);
+        }
+        caterva_free(ctx, *array, sizeof(caterva_array_t), CATERVA_ALLOC_ARRAY);
     }
+    CATERVA_ERROR(rc);
     return CATERVA_SUCCEED;
 }
 
@@ -125,28 +343,54 @@ int caterva_array_append(caterva_context_t *ctx, caterva_array_t *array, void *c
     CATERVA_ERROR_NULL(array);
     CATERVA_ERROR_NULL(chunk);
 
+    CATERVA_ERROR(caterva_array_append_many(ctx, array, &chunk, &chunksize, 1));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_append_many(caterva_context_t *ctx, caterva_array_t *array, void **chunks,
+                              int64_t *chunksizes, int64_t nchunks) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(chunks);
+    CATERVA_ERROR_NULL(chunksizes);
+
     if (array->filled) {
         CATERVA_ERROR(CATERVA_ERR_CONTAINER_FILLED);
     }
+    if (nchunks < 0 || array->nchunks + nchunks > array->extnitems / array->chunknitems) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (array->nfields > 0) {
+        CATERVA_ERROR(caterva_compound_array_append_many(ctx, array, chunks, chunksizes, nchunks));
+        return CATERVA_SUCCEED;
+    }
+    int64_t nchunk = array->nchunks;
     switch (array->storage) {
         case CATERVA_STORAGE_BLOSC:
-            if (chunksize != array->next_chunknitems * array->itemsize) {
-                CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
-            }
-            CATERVA_ERROR(caterva_blosc_array_append(ctx, array, chunk, (int32_t) chunksize));
+            CATERVA_ERROR(caterva_blosc_array_append_many(ctx, array, chunks, chunksizes, nchunks));
+            // The chunks of the levels are appended along with the ones of the array
+            CATERVA_ERROR(caterva_pyramid_append(ctx, array, nchunk, chunks, chunksizes, nchunks));
             break;
         case CATERVA_STORAGE_PLAINBUFFER:
-            if (chunksize != array->chunknitems * array->itemsize) {
-                CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+            // A plain buffer is made of a single chunk
+            for (int64_t i = 0; i < nchunks; ++i) {
+                CATERVA_ERROR_NULL(chunks[i]);
+                if (chunksizes[i] != array->chunknitems * array->itemsize) {
+                    CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+                }
+                CATERVA_ERROR(caterva_plainbuffer_array_append(ctx, array, chunks[i],
+                                                               chunksizes[i]));
+                array->nchunks++;
             }
-            CATERVA_ERROR(caterva_plainbuffer_array_append(ctx, array, chunk, chunksize));
             break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
 
-    array->nchunks++;
-    array->empty = false;
+    if (nchunks > 0) {
+        array->empty = false;
+    }
     if (array->nchunks == array->extnitems / array->chunknitems) {
         array->filled = true;
     }
@@ -154,6 +398,47 @@ int caterva_array_append(caterva_context_t *ctx, caterva_array_t *array, void *c
     return CATERVA_SUCCEED;
 }
 
+int caterva_array_flush(caterva_context_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    if (array->nfields > 0) {
+        CATERVA_ERROR(caterva_compound_array_flush(ctx, array));
+    } else if (array->storage == CATERVA_STORAGE_BLOSC) {
+        CATERVA_ERROR(caterva_blosc_array_flush(ctx, array));
+        CATERVA_ERROR(caterva_blosc_array_store_indexes(ctx, array));
+        CATERVA_ERROR(caterva_pyramid_flush(ctx, array));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_set_chunk(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                            void *chunk, int64_t chunksize) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(chunk);
+    CATERVA_ERROR_COMPOUND(array);
+
+    if (array->storage != CATERVA_STORAGE_BLOSC) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+    if (array->fill_value == NULL) {
+        DEBUG_PRINT("Only the chunks of an array with a fill value can be set");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (array->pyramid_levels > 0) {
+        DEBUG_PRINT("The chunks of an array with levels can only be appended");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (nchunk < 0 || nchunk >= array->extnitems / array->chunknitems) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    CATERVA_ERROR(caterva_blosc_array_set_chunk(ctx, array, nchunk, chunk, chunksize));
+
+    return CATERVA_SUCCEED;
+}
+
 int caterva_array_from_buffer(caterva_context_t *ctx, void *buffer, int64_t buffersize,
                               caterva_params_t *params, caterva_storage_t *storage,
                               caterva_array_t **array) {
@@ -163,7 +448,7 @@ int caterva_array_from_buffer(caterva_context_t *ctx, void *buffer, int64_t buff
     CATERVA_ERROR_NULL(buffer);
     CATERVA_ERROR_NULL(array);
 
-    CATERVA_ERROR(caterva_array_empty(ctx, params, storage, array));
+    CATERVA_ERROR(array_new(ctx, params, storage, NULL, array));
 
     if (buffersize != (int64_t)(*array)->nitems * (*array)->itemsize) {
         CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
@@ -172,6 +457,7 @@ int caterva_array_from_buffer(caterva_context_t *ctx, void *buffer, int64_t buff
     switch ((*array)->storage) {
         case CATERVA_STORAGE_BLOSC:
             CATERVA_ERROR(caterva_blosc_array_from_buffer(ctx, *array, buffer, buffersize));
+            CATERVA_ERROR(caterva_pyramid_from_buffer(ctx, *array, buffer));
             break;
         case CATERVA_STORAGE_PLAINBUFFER:
             CATERVA_ERROR(caterva_plainbuffer_array_from_buffer(ctx, *array, buffer, buffersize));
@@ -188,6 +474,14 @@ int caterva_array_to_buffer(caterva_context_t *ctx, caterva_array_t *array, void
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
     CATERVA_ERROR_NULL(buffer);
+    CATERVA_ERROR(caterva_array_flush(ctx, array));
+
+    if (array->nfields > 0) {
+        int64_t start[CATERVA_MAX_DIM] = {0};
+        CATERVA_ERROR(caterva_array_get_slice_buffer(ctx, array, start, array->shape,
+                                                     array->shape, buffer, buffersize));
+        return CATERVA_SUCCEED;
+    }
 
     if (buffersize < (int64_t) array->nitems * array->itemsize) {
         CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
@@ -216,6 +510,18 @@ int caterva_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t *src,
     CATERVA_ERROR_NULL(stop);
     CATERVA_ERROR_NULL(shape);
     CATERVA_ERROR_NULL(buffer);
+    CATERVA_ERROR(caterva_array_flush(ctx, src));
+
+    if (src->nfields > 0) {
+        // All the fields, in the order of a record
+        const char *names[CATERVA_MAX_FIELDS];
+        for (int i = 0; i < src->nfields; ++i) {
+            names[i] = src->fields[i].name;
+        }
+        CATERVA_ERROR(caterva_array_get_fields_slice_buffer(ctx, src, names, src->nfields, start,
+                                                            stop, shape, buffer, buffersize));
+        return CATERVA_SUCCEED;
+    }
 
     int64_t size = 1;
     for (int i = 0; i < src->ndim; ++i) {
@@ -253,6 +559,7 @@ int caterva_array_set_slice_buffer(caterva_context_t *ctx, void *buffer, int64_t
     CATERVA_ERROR_NULL(start);
     CATERVA_ERROR_NULL(stop);
     CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_COMPOUND(array);
 
     int64_t size = 1;
     for (int i = 0; i < array->ndim; ++i) {
@@ -286,8 +593,10 @@ int caterva_array_get_slice(caterva_context_t *ctx, caterva_array_t *src, int64_
     CATERVA_ERROR_NULL(start);
     CATERVA_ERROR_NULL(stop);
     CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_COMPOUND(src);
+    CATERVA_ERROR(caterva_array_flush(ctx, src));
 
-    caterva_params_t params;
+    caterva_params_t params = {0};
     params.ndim = src->ndim;
     params.itemsize = src->itemsize;
     for (int i = 0; i < src->ndim; ++i) {
@@ -316,6 +625,16 @@ int caterva_array_squeeze(caterva_context_t *ctx, caterva_array_t *array) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
 
+    if (array->nfields > 0) {
+        CATERVA_ERROR(caterva_compound_array_squeeze(ctx, array));
+        return CATERVA_SUCCEED;
+    }
+    if (array->pyramid_levels > 0) {
+        // The levels may have other axes of length 1
+        DEBUG_PRINT("An array with levels can not be squeezed");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
     switch (array->storage) {
         case CATERVA_STORAGE_BLOSC:
             CATERVA_ERROR(caterva_blosc_array_squeeze(ctx, array));
@@ -336,8 +655,14 @@ int caterva_array_copy(caterva_context_t *ctx, caterva_array_t *src, caterva_sto
     CATERVA_ERROR_NULL(src);
     CATERVA_ERROR_NULL(storage);
     CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR(caterva_array_flush(ctx, src));
+
+    if (src->nfields > 0) {
+        CATERVA_ERROR(caterva_compound_array_copy(ctx, src, storage, array));
+        return CATERVA_SUCCEED;
+    }
 
-    caterva_params_t params;
+    caterva_params_t params = {0};
     params.itemsize = src->itemsize;
     params.ndim = src->ndim;
     for (int i = 0; i < src->ndim; ++i) {
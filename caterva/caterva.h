@@ -87,14 +87,94 @@ static char *print_error(int rc) {
 }
 
 /* The version for metalayer format; starts from 0 and it must not exceed 127 */
-#define CATERVA_METALAYER_VERSION 0
+#define CATERVA_METALAYER_VERSION 4
 
 /* The maximum number of dimensions for caterva arrays */
 #define CATERVA_MAX_DIM 8
 
+/* The maximum number of fields of the compound items of an array */
+#define CATERVA_MAX_FIELDS 32
+
+/* The maximum number of downsampled levels of an array */
+#define CATERVA_MAX_LEVELS 16
+
+/* The bits per item of the Bloom filters of the blocks when none are given, and the maximum */
+#define CATERVA_BLOOM_BITS_DEFAULT 10
+#define CATERVA_BLOOM_BITS_MAX 32
+
 /* The maximum number of metalayers for caterva arrays */
 #define CATERVA_MAX_METALAYERS BLOSC2_MAX_METALAYERS - 1
 
+/* The memory budget used by caterva_array_rechunk() when none is given */
+#define CATERVA_RECHUNK_MEMBUDGET_DEFAULT ((int64_t) 512 * 1024 * 1024)
+
+/* The size of the append buffer of the arrays when none is given */
+#define CATERVA_APPEND_BUFFERSIZE_DEFAULT ((int64_t) 32 * 1024 * 1024)
+
+/* The alignment of the buffers allocated through the aligned allocation hooks */
+#define CATERVA_ALLOC_ALIGNMENT 64
+
+/**
+ * @brief The purposes of the memory blocks requested to the allocation hooks.
+ */
+typedef enum {
+    CATERVA_ALLOC_ARRAY,
+    //!< Indicates the memory used by a caterva array container.
+    CATERVA_ALLOC_CHUNK,
+    //!< Indicates a scratch buffer that holds a decompressed chunk.
+    CATERVA_ALLOC_PLAINBUFFER,
+    //!< Indicates the data of an array backed by a plain buffer.
+    CATERVA_ALLOC_MASKOUT,
+    //!< Indicates a mask used to decompress only some blocks of a chunk.
+    CATERVA_ALLOC_SCRATCH,
+    //!< Indicates any other temporary buffer.
+} caterva_alloc_purpose_t;
+
+/**
+ * @brief The stages in which the work done by caterva is divided.
+ */
+typedef enum {
+    CATERVA_STAGE_SETUP,
+    //!< Allocating the scratch buffers and building the block masks.
+    CATERVA_STAGE_IO,
+    //!< Reading and writing compressed chunks from/to the superchunk.
+    CATERVA_STAGE_DECOMPRESS,
+    //!< Decompressing chunks.
+    CATERVA_STAGE_SCATTER,
+    //!< Copying items between decompressed chunks and user buffers.
+    CATERVA_STAGE_REPART,
+    //!< Rearranging chunks into the block layout (and padding them).
+    CATERVA_STAGE_COMPRESS,
+    //!< Compressing chunks.
+    CATERVA_NSTAGES,
+    //!< The number of stages.
+} caterva_stage_t;
+
+/**
+ * @brief The phases of a stage reported to the tracing callback.
+ */
+typedef enum {
+    CATERVA_TRACE_BEGIN,
+    //!< The stage is about to start.
+    CATERVA_TRACE_END,
+    //!< The stage has finished.
+} caterva_trace_phase_t;
+
+/**
+ * @brief The policies that decide when the chunks appended to a Blosc array are written.
+ */
+typedef enum {
+    CATERVA_FLUSH_ON_APPEND,
+    //!< The chunks are written before caterva_array_append() or caterva_array_append_many()
+    //!< return (the chunks of a call are written together).
+    CATERVA_FLUSH_BUFFERED,
+    //!< The compressed chunks are kept in the append buffer of the array and written together
+    //!< when it holds @p append_buffersize bytes, when caterva_array_flush() is called, before
+    //!< the array is read and when it is freed.
+} caterva_flush_policy_t;
+
+struct caterva_trace_event_s;
+
 /**
  * @brief Configuration parameters used to create a caterva context.
  */
@@ -103,6 +183,15 @@ typedef struct {
     //!< The memory allocation function used internally.
     void (*free)(void *);
     //!< The memory release function used internally.
+    void *(*alloc_aligned)(size_t size, size_t alignment, caterva_alloc_purpose_t purpose,
+                           void *alloc_data);
+    //!< The aligned memory allocation function. If it is not NULL, it is used instead of alloc
+    //!< for the arrays and the buffers allocated internally.
+    void (*free_aligned)(void *ptr, size_t size, caterva_alloc_purpose_t purpose,
+                         void *alloc_data);
+    //!< The memory release function paired with alloc_aligned.
+    void *alloc_data;
+    //!< The user context passed to the aligned allocation and release functions.
     int compcodec;
     //!< Defines the codec used in compression.
     int complevel;
@@ -119,6 +208,23 @@ typedef struct {
     //!< Defines the function that is applied to the data before compressing it.
     blosc2_prefilter_params *pparams;
     //!< Indicates the parameters of the prefilter function.
+    bool stats;
+    //!< Enables the collection of runtime statistics (see caterva_array_get_stats()).
+    void (*trace)(const struct caterva_trace_event_s *event, void *trace_data);
+    //!< The function called at the beginning and at the end of each stage. It is only called if
+    //!< caterva is built with tracing support (the CATERVA_ENABLE_TRACING CMake option).
+    void *trace_data;
+    //!< The user context passed to the tracing function.
+    caterva_flush_policy_t flush_policy;
+    //!< When the chunks appended to Blosc arrays are written to their superchunks.
+    int64_t append_buffersize;
+    //!< The compressed bytes held by the append buffer of an array before they are written (only
+    //!< used with @p CATERVA_FLUSH_BUFFERED).
+    double target_speed;
+    //!< The speed (in MB/s) at which the chunks of Blosc arrays should be written. If it is not 0,
+    //!< the compression level starts at @p complevel and is moved one step after each chunk (or
+    //!< batch of appended chunks), down when the measured speed falls below the target and up
+    //!< when it is well above it.
 } caterva_config_t;
 
 /**
@@ -126,6 +232,9 @@ typedef struct {
  */
 static const caterva_config_t CATERVA_CONFIG_DEFAULTS = {.alloc = malloc,
                                                          .free = free,
+                                                         .alloc_aligned = NULL,
+                                                         .free_aligned = NULL,
+                                                         .alloc_data = NULL,
                                                          .compcodec = BLOSC_ZSTD,
                                                          .complevel = 5,
                                                          .usedict = 0,
@@ -133,7 +242,44 @@ static const caterva_config_t CATERVA_CONFIG_DEFAULTS = {.alloc = malloc,
                                                          .filters = {0, 0, 0, 0, 0, BLOSC_SHUFFLE},
                                                          .filtersmeta = {0, 0, 0, 0, 0, 0},
                                                          .prefilter = NULL,
-                                                         .pparams = NULL};
+                                                         .pparams = NULL,
+                                                         .stats = false,
+                                                         .trace = NULL,
+                                                         .trace_data = NULL,
+                                                         .flush_policy = CATERVA_FLUSH_ON_APPEND,
+                                                         .append_buffersize =
+                                                             CATERVA_APPEND_BUFFERSIZE_DEFAULT,
+                                                         .target_speed = 0};
+
+/**
+ * @brief Runtime statistics of the operations done on an array (or within a context).
+ */
+typedef struct {
+    int64_t nchunks_decompressed;
+    //!< The number of chunks decompressed (fully or partially).
+    int64_t nblocks_decompressed;
+    //!< The number of blocks decompressed.
+    int64_t nchunks_compressed;
+    //!< The number of chunks compressed.
+    int64_t bytes_read;
+    //!< The compressed bytes read from the superchunk.
+    int64_t bytes_decompressed;
+    //!< The bytes produced by the decompressor.
+    int64_t bytes_compressed;
+    //!< The bytes passed to the compressor.
+    int64_t bytes_written;
+    //!< The compressed bytes written to the superchunk.
+    int64_t cache_hits;
+    //!< The chunk reads served by the chunk cache.
+    int64_t cache_misses;
+    //!< The chunk reads that had to fill the chunk cache.
+    int64_t nchunks_uniform_read;
+    //!< The chunk reads served by broadcasting a single value (no decompression).
+    int64_t nchunks_uniform_written;
+    //!< The chunks stored as a single value because all their items were equal.
+    int64_t time_ns[CATERVA_NSTAGES];
+    //!< The time (in nanoseconds) spent in each stage.
+} caterva_stats_t;
 
 /**
  * @brief Context for caterva arrays that specifies the functions used to manage memory and
@@ -142,6 +288,8 @@ static const caterva_config_t CATERVA_CONFIG_DEFAULTS = {.alloc = malloc,
 typedef struct {
     caterva_config_t *cfg;
     //!< The configuration paramters.
+    caterva_stats_t stats;
+    //!< The statistics of all the arrays used within the context (if @p cfg->stats is set).
 } caterva_context_t;
 
 /**
@@ -166,6 +314,87 @@ typedef struct {
     //!< The size of the serialized data
 } caterva_metalayer_t;
 
+/**
+ * @brief The objectives of the automatic selection of the codec and filters of an array.
+ */
+typedef enum {
+    CATERVA_COMPRESSION_FIXED,
+    //!< The codec and filters of the context are used.
+    CATERVA_COMPRESSION_RATIO,
+    //!< The combination that compresses the most is chosen.
+    CATERVA_COMPRESSION_CSPEED,
+    //!< The combination that compresses the fastest is chosen.
+    CATERVA_COMPRESSION_DSPEED,
+    //!< The combination that decompresses the fastest is chosen.
+} caterva_compression_objective_t;
+
+/**
+ * @brief The predictors applied to the blocks of an array before they are compressed.
+ */
+typedef enum {
+    CATERVA_PREDICTOR_NONE,
+    //!< The blocks are compressed as they are.
+    CATERVA_PREDICTOR_INT,
+    //!< Each item is replaced by the error of its N-D Lorenzo prediction (out of the items that
+    //!< precede it along every axis of the block). For integers of 1, 2, 4 or 8 bytes.
+    CATERVA_PREDICTOR_FLOAT,
+    //!< The same as @p CATERVA_PREDICTOR_INT, for IEEE floats of 4 or 8 bytes (which are mapped to
+    //!< integers keeping their order, so that it is lossless).
+} caterva_predictor_t;
+
+/**
+ * @brief The error-bounded lossy modes for arrays of floats.
+ */
+typedef enum {
+    CATERVA_LOSSY_NONE,
+    //!< The items are stored as they are.
+    CATERVA_LOSSY_ABSOLUTE,
+    //!< Each item is rounded to the fewest mantissa bits that keep it within an absolute
+    //!< tolerance (the items within the tolerance of zero are stored as zeros).
+    CATERVA_LOSSY_RELATIVE,
+    //!< The items are rounded to the fewest mantissa bits that keep them within a relative
+    //!< tolerance (the subnormal items may exceed it).
+    CATERVA_LOSSY_PRECISION,
+    //!< The items are rounded to a number of mantissa bits.
+} caterva_lossy_mode_t;
+
+/**
+ * @brief The kinds of the items of an array (for the operations that need their values).
+ */
+typedef enum {
+    CATERVA_ITEM_UINT,
+    //!< Unsigned integers of 1, 2, 4 or 8 bytes.
+    CATERVA_ITEM_INT,
+    //!< Signed integers of 1, 2, 4 or 8 bytes.
+    CATERVA_ITEM_FLOAT,
+    //!< IEEE floats of 4 or 8 bytes.
+} caterva_item_kind_t;
+
+/**
+ * @brief The reductions used to build the levels of a pyramid out of the previous ones.
+ */
+typedef enum {
+    CATERVA_PYRAMID_NEAREST,
+    //!< Each item of a level is the first item of its window (for items of any size).
+    CATERVA_PYRAMID_MEAN,
+    //!< Each item is the mean of its window (rounded to the nearest integer for the integers).
+    CATERVA_PYRAMID_MAX,
+    //!< Each item is the maximum of its window (the NaNs are skipped unless they come first).
+} caterva_pyramid_reduce_t;
+
+/**
+ * @brief The orders of the chunks of an array in its superchunk.
+ */
+typedef enum {
+    CATERVA_CHUNK_ORDER_C,
+    //!< The chunks are stored in C order (the last axis varies fastest).
+    CATERVA_CHUNK_ORDER_MORTON,
+    //!< The chunks are stored along a Morton (Z-order) curve over the grid of chunks.
+    CATERVA_CHUNK_ORDER_HILBERT,
+    //!< The chunks are stored along a Hilbert curve over the grid of chunks, so that consecutive
+    //!< chunks in the superchunk are neighbours in the array.
+} caterva_chunk_order_t;
+
 /**
  * @brief The storage properties for an array backed by a Blosc superchunk.
  */
@@ -183,6 +412,60 @@ typedef struct {
     //!< List with the metalayers desired.
     int32_t nmetalayers;
     //!< The number of metalayers.
+    caterva_compression_objective_t objective;
+    //!< If it is not @p CATERVA_COMPRESSION_FIXED, the codec and filters are chosen when the first
+    //!< chunk is written, by compressing some of its blocks with a few candidates (the codecs,
+    //!< with no filter, shuffle, bitshuffle or delta). The compression level, and the truncation
+    //!< of the context if any, are kept. It is ignored if the context sets a prefilter.
+    caterva_predictor_t predictor;
+    //!< The predictor applied to the blocks (it is kept in the caterva metalayer). It cannot be
+    //!< used along with a prefilter.
+    int32_t keyframe_interval;
+    //!< If it is not 0, each chunk is stored as the XOR of its (predicted) blocks with the ones of
+    //!< the previous chunk along @p delta_axis, except for one chunk (a keyframe) every
+    //!< @p keyframe_interval along that axis. The chunks can only be appended (not set), and a
+    //!< chunk is decoded out of the previous ones up to a keyframe (or a cached chunk).
+    int8_t delta_axis;
+    //!< The axis along which the chunks are stored as deltas.
+    caterva_lossy_mode_t lossy_mode;
+    //!< The error bound of the items, which must be floats of 4 or 8 bytes. They are rounded
+    //!< before they are predicted and compressed, and the bound is kept in the
+    //!< @p caterva_lossy metalayer. It cannot be used along with a prefilter.
+    double lossy_tolerance;
+    //!< The absolute or relative tolerance (greater than 0).
+    int8_t lossy_bits;
+    //!< The number of mantissa bits kept by @p CATERVA_LOSSY_PRECISION.
+    int8_t pyramid_levels;
+    //!< The number of downsampled levels built while the chunks are written. Level @p l halves
+    //!< the shape of level @p l - 1 on every axis (each item reduces a window of 2 items per axis,
+    //!< clipped on the edges), so that the chunkshape must be divisible by 2^@p pyramid_levels.
+    //!< Each level is an array of its own (see caterva_array_get_level()) that carries the
+    //!< @p caterva_pyramid metalayer; it cannot be used along with a prefilter. The levels of an
+    //!< array on disk are kept in sibling files (level @p l of @p filename in
+    //!< @p filename.level<l>), which caterva_array_from_file() opens along with the array.
+    caterva_pyramid_reduce_t pyramid_reduce;
+    //!< The reduction of the windows.
+    caterva_item_kind_t pyramid_kind;
+    //!< The kind of the items (only used by @p CATERVA_PYRAMID_MEAN and @p CATERVA_PYRAMID_MAX).
+    bool sum_index;
+    //!< Flag to keep the sums of the items of every block and chunk as they are written (see
+    //!< caterva_array_get_box_sum()). The index is kept in the @p caterva_sums metalayer, which is
+    //!< updated when the array is flushed. It cannot be used along with a prefilter.
+    caterva_item_kind_t sum_kind;
+    //!< The kind of the items summed.
+    bool bloom_index;
+    //!< Flag to keep a Bloom filter of the items of every block as they are written (see
+    //!< caterva_array_find_equal()). The filters are kept in the @p caterva_bloom metalayer, which
+    //!< is updated when the array is flushed. It needs items of up to 8 bytes and cannot be used
+    //!< along with a prefilter.
+    uint8_t bloom_bits;
+    //!< The bits of the filter of a block per item of the block (if 0,
+    //!< @p CATERVA_BLOOM_BITS_DEFAULT is used). More bits give fewer false positives.
+    caterva_chunk_order_t chunk_order;
+    //!< The order of the chunks in the superchunk (it is kept in the caterva metalayer). The chunks
+    //!< are still numbered, appended and set in C order; only the place where they are stored
+    //!< changes. The chunks skipped along a curve while appending are stored as uninitialized
+    //!< placeholders (special chunks of the whole chunk size) until they are written.
 } caterva_storage_properties_blosc_t;
 
 /**
@@ -191,7 +474,7 @@ typedef struct {
 typedef struct {
     char *filename;
     //!< The plain buffer name. If @p filename is not @p NULL, the plain buffer will be stored on
-    //!< disk. (Not implemented yet).
+    //!< disk as a memory-mapped file (a small header with the shape followed by the data).
 } caterva_storage_properties_plainbuffer_t;
 
 /**
@@ -214,6 +497,16 @@ typedef struct {
     //!< The specific properties for the selected @p backend.
 } caterva_storage_t;
 
+/**
+ * @brief A field of the compound items of an array.
+ */
+typedef struct {
+    char *name;
+    //!< The name of the field.
+    uint8_t itemsize;
+    //!< The size (in bytes) of the field.
+} caterva_field_t;
+
 /**
  * @brief General parameters needed for the creation of a caterva array.
  */
@@ -226,6 +519,43 @@ typedef struct {
     //!< The array dimensions.
 } caterva_params_t;
 
+/**
+ * @brief General parameters needed for the creation of a caterva array of compound items.
+ */
+typedef struct {
+    int64_t shape[CATERVA_MAX_DIM];
+    //!< The array shape.
+    uint8_t ndim;
+    //!< The array dimensions.
+    int8_t nfields;
+    //!< The number of fields of the items. The items are records made of the @p fields one after
+    //!< the other (with no padding). Each field is stored in an array of its own, which is
+    //!< compressed with the size of the field as its type size and is only read when the field is.
+    caterva_field_t fields[CATERVA_MAX_FIELDS];
+    //!< The fields of the items, in the order they are laid out in a record.
+} caterva_compound_params_t;
+
+/**
+ * @brief Parameters used to propose the chunk and block shapes of an array.
+ */
+typedef struct {
+    int64_t l1_size;
+    //!< The size (in bytes) of the L1 data cache. If it is 0, it is detected at runtime.
+    int64_t l2_size;
+    //!< The size (in bytes) of the L2 cache. If it is 0, it is detected at runtime.
+    int64_t l3_size;
+    //!< The size (in bytes) of the L3 cache. If it is 0, it is detected at runtime.
+    bool access_axes[CATERVA_MAX_DIM];
+    //!< The axes along which the array is usually read (e.g. the time axis when time series are
+    //!< extracted). Chunks and blocks are stretched along these axes first.
+} caterva_tune_params_t;
+
+/**
+ * @brief The default parameters used to propose the chunk and block shapes (no access hints).
+ */
+static const caterva_tune_params_t CATERVA_TUNE_PARAMS_DEFAULTS = {
+    .l1_size = 0, .l2_size = 0, .l3_size = 0, .access_axes = {0}};
+
 /**
  * @brief An *optional* cache for a single block.
  *
@@ -239,10 +569,57 @@ struct chunk_cache_s {
     //!< The chunk number in cache. If @p nchunk equals to -1, it means that the cache is empty.
 };
 
+/**
+ * @brief The compressed chunks appended to an array that are not written to its superchunk yet.
+ */
+struct append_buffer_s {
+    uint8_t **cchunks;
+    //!< The compressed chunks, in order.
+    int64_t nchunks;
+    //!< The number of chunks in the buffer.
+    int64_t capacity;
+    //!< The number of chunks that fit in @p cchunks.
+    int64_t nbytes;
+    //!< The compressed size (in bytes) of the chunks in the buffer.
+};
+
+/* The maximum number of chunks kept by the delta cache of an array */
+#define CATERVA_DELTA_NCACHED 16
+
+/**
+ * @brief The chunks of an array stored as deltas that have been decoded (or written) lately, before
+ * the predictor is undone (or after it is applied).
+ */
+struct delta_cache_s {
+    uint8_t *chunks[CATERVA_DELTA_NCACHED];
+    //!< The chunks (in block layout).
+    int64_t nchunks[CATERVA_DELTA_NCACHED];
+    //!< The position of each chunk.
+    int32_t nentries;
+    //!< The number of chunks in the cache.
+    int32_t capacity;
+    //!< The maximum number of chunks in the cache.
+    int32_t next;
+    //!< The entry replaced next when the cache is full.
+};
+
+/**
+ * @brief The memory mapping of a plain buffer stored on disk.
+ */
+struct plainbuffer_mmap_s {
+    uint8_t *addr;
+    //!< Pointer to the mapped file (header included). If @p addr is NULL, the plain buffer is not
+    //!< backed by a file.
+    int64_t len;
+    //!< The size (in bytes) of the mapping.
+    void *handle;
+    //!< The handle of the file mapping (only used on Windows).
+};
+
 /**
  * @brief A multidimensional array of data that can be compressed data.
  */
-typedef struct {
+typedef struct caterva_array_s {
     caterva_storage_backend_t storage;
     //!< Storage type.
     blosc2_schunk *sc;
@@ -278,8 +655,8 @@ typedef struct {
     //!< Number of items in the next chunk to be appended.
     int8_t ndim;
     //!< Data dimensions.
-    int8_t itemsize;
-    //!< Size of each item.
+    int32_t itemsize;
+    //!< Size of each item (0 for a compound array, see @p recordsize).
     bool empty;
     //!< Indicate if an array is empty or is filled with data.
     bool filled;
@@ -288,8 +665,94 @@ typedef struct {
     //!< Number of chunks in the array.
     struct chunk_cache_s chunk_cache;
     //!< A partition cache.
+    struct plainbuffer_mmap_s mmap;
+    //!< The file mapping of a plain buffer stored on disk.
+    caterva_stats_t stats;
+    //!< The runtime statistics of the array (only collected if the context enables them).
+    uint8_t *fill_value;
+    //!< The fill value of the array (@p itemsize bytes) or NULL if it has none. The chunks not
+    //!< stored in a Blosc superchunk read as this value.
+    struct append_buffer_s append_buffer;
+    //!< The appended chunks waiting to be written (see @p caterva_flush_policy_t).
+    caterva_compression_objective_t objective;
+    //!< The objective of the codec and filters selection while it is pending. It is
+    //!< @p CATERVA_COMPRESSION_FIXED once they are chosen.
+    double cspeed;
+    //!< The smoothed write speed (in MB/s) measured when the context sets a target speed.
+    caterva_predictor_t predictor;
+    //!< The predictor applied to the blocks before they are compressed.
+    int32_t keyframe_interval;
+    //!< The distance between keyframes along @p delta_axis (0 if the chunks are not deltas).
+    int8_t delta_axis;
+    //!< The axis along which the chunks are stored as deltas.
+    struct delta_cache_s delta_cache;
+    //!< The chunks decoded lately, when the chunks are stored as deltas.
+    caterva_lossy_mode_t lossy_mode;
+    //!< The error bound of the items.
+    double lossy_tolerance;
+    //!< The absolute or relative tolerance of the items.
+    int8_t lossy_bits;
+    //!< The number of mantissa bits kept by @p CATERVA_LOSSY_PRECISION.
+    int8_t nfields;
+    //!< The number of fields of the items (0 if they are not compound).
+    caterva_field_t *fields;
+    //!< The fields of the items (their names are owned by the array).
+    struct caterva_array_s **field_arrays;
+    //!< The arrays where the fields are stored. A compound array stores no data of its own; its
+    //!< shapes and chunk counts follow the ones of its fields.
+    int32_t recordsize;
+    //!< The size (in bytes) of a compound item.
+    int8_t pyramid_levels;
+    //!< The number of downsampled levels of the array.
+    caterva_pyramid_reduce_t pyramid_reduce;
+    //!< The reduction used to build the levels.
+    caterva_item_kind_t pyramid_kind;
+    //!< The kind of the items reduced.
+    struct caterva_array_s **levels;
+    //!< The arrays of the levels (level @p l is @p levels[l - 1]), owned by the array. Their chunks
+    //!< are appended along with the ones of the array, in the same order.
+    caterva_item_kind_t sum_kind;
+    //!< The kind of the items summed by the sum index.
+    double *block_sums;
+    //!< The sums of the items of each block (in the order of the chunks, and of the blocks of a
+    //!< chunk), or NULL if the array has no sum index.
+    double *chunk_sums;
+    //!< The sums of the items of each chunk.
+    bool indexes_dirty;
+    //!< Whether the sum or Bloom index has changed since they were written to their metalayers
+    //!< (the reads never write them).
+    uint8_t bloom_bits;
+    //!< The bits of the Bloom filter of a block per item of the block.
+    uint8_t *blooms;
+    //!< The Bloom filters of the blocks (in the same order as @p block_sums), or NULL if the array
+    //!< has no Bloom index.
+    caterva_chunk_order_t chunk_order;
+    //!< The order of the chunks in the superchunk.
+    int64_t *chunk_positions;
+    //!< The position in the superchunk of each chunk (in C order), or NULL if the chunks are
+    //!< stored in C order.
+    bool scattered;
+    //!< Whether the chunks of the frame of the superchunk are no longer laid out by position (a
+    //!< chunk written again, such as a placeholder along a curve, goes to the end of a frame).
 } caterva_array_t;
 
+/**
+ * @brief An event reported to the tracing function of a context.
+ */
+typedef struct caterva_trace_event_s {
+    caterva_stage_t stage;
+    //!< The stage.
+    caterva_trace_phase_t phase;
+    //!< Whether the stage begins or ends.
+    caterva_array_t *array;
+    //!< The array being processed. It is NULL when a frame is opened before creating the array.
+    int64_t nchunk;
+    //!< The chunk being processed, or -1 if the stage does not refer to a single chunk.
+    int64_t nbytes;
+    //!< The bytes processed by the stage (only set when it ends). They are the compressed bytes for
+    //!< @p CATERVA_STAGE_IO and the uncompressed bytes for the rest of stages.
+} caterva_trace_event_t;
+
 /**
  * @brief Create a context for caterva.
  *
@@ -309,6 +772,76 @@ int caterva_context_new(caterva_config_t *cfg, caterva_context_t **ctx);
  */
 int caterva_context_free(caterva_context_t **ctx);
 
+/**
+ * @brief Get the runtime statistics collected within a context.
+ *
+ * The statistics are only collected when the @p stats field of the configuration is set.
+ *
+ * @param ctx The caterva context.
+ * @param stats Pointer to the structure where the statistics will be copied.
+ * @param reset Whether the statistics of the context are zeroed after copying them.
+ *
+ * @return An error code.
+ */
+int caterva_context_get_stats(caterva_context_t *ctx, caterva_stats_t *stats, bool reset);
+
+/**
+ * @brief Allocate memory backed by huge pages.
+ *
+ * Chunk and plain buffer allocations of at least 2 MB are placed in explicit huge pages when
+ * the system has them reserved and in transparent huge pages otherwise (Linux only). The rest
+ * of the allocations (and all of them on other platforms) fall back to aligned heap memory.
+ *
+ * @param size The size of the memory block.
+ * @param alignment The alignment of the memory block (a power of two).
+ * @param purpose The purpose of the memory block.
+ * @param alloc_data Unused.
+ *
+ * @return A pointer to the memory block or NULL if the allocation fails.
+ */
+void *caterva_alloc_hugepage(size_t size, size_t alignment, caterva_alloc_purpose_t purpose,
+                             void *alloc_data);
+
+/**
+ * @brief Release a memory block allocated with caterva_alloc_hugepage().
+ *
+ * @param ptr The memory block.
+ * @param size The size of the memory block.
+ * @param purpose The purpose of the memory block.
+ * @param alloc_data Unused.
+ */
+void caterva_free_hugepage(void *ptr, size_t size, caterva_alloc_purpose_t purpose,
+                           void *alloc_data);
+
+/**
+ * @brief Allocate memory local to a NUMA node.
+ *
+ * Allocations of at least 64 KB are mapped with a NUMA memory policy, so that their pages are
+ * placed on the node of the thread that first touches them or, if @p alloc_data points to a
+ * non-negative int, on that node (Linux only). The rest of the allocations (and all of them on
+ * other platforms) fall back to aligned heap memory.
+ *
+ * @param size The size of the memory block.
+ * @param alignment The alignment of the memory block (a power of two).
+ * @param purpose The purpose of the memory block.
+ * @param alloc_data NULL or a pointer to the int with the preferred NUMA node.
+ *
+ * @return A pointer to the memory block or NULL if the allocation fails.
+ */
+void *caterva_alloc_numa(size_t size, size_t alignment, caterva_alloc_purpose_t purpose,
+                         void *alloc_data);
+
+/**
+ * @brief Release a memory block allocated with caterva_alloc_numa().
+ *
+ * @param ptr The memory block.
+ * @param size The size of the memory block.
+ * @param purpose The purpose of the memory block.
+ * @param alloc_data NULL or a pointer to the int with the preferred NUMA node.
+ */
+void caterva_free_numa(void *ptr, size_t size, caterva_alloc_purpose_t purpose,
+                       void *alloc_data);
+
 /**
  * @brief Create an empty array.
  *
@@ -322,6 +855,26 @@ int caterva_context_free(caterva_context_t **ctx);
 int caterva_array_empty(caterva_context_t *ctx, caterva_params_t *params,
                         caterva_storage_t *storage, caterva_array_t **array);
 
+/**
+ * @brief Create an array filled with a value.
+ *
+ * The value is the fill value of the array: a Blosc array stores no chunks at all (so it is
+ * created instantly whatever its size) and its chunks read as the fill value until they are
+ * written (see caterva_array_set_chunk()). The fill value is kept in the caterva metalayer.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param params Pointer to the general params of the array desired.
+ * @param storage Pointer to the storage params of the array desired.
+ * @param fill_value Pointer to the value of the items (@p itemsize bytes, or a record for
+ * compound items).
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code.
+ */
+int caterva_array_full(caterva_context_t *ctx, caterva_params_t *params,
+                       caterva_storage_t *storage, const void *fill_value,
+                       caterva_array_t **array);
+
 /**
  * @brief Free an array.
  *
@@ -345,6 +898,38 @@ int caterva_array_free(caterva_context_t *ctx, caterva_array_t **array);
 int caterva_array_append(caterva_context_t *ctx, caterva_array_t *array, void *chunk,
                          int64_t chunksize);
 
+/**
+ * @brief Append several chunks to a caterva array at once.
+ *
+ * For Blosc arrays, the chunks are compressed in parallel (using the threads of the context) and
+ * handed to the superchunk together, as set by the flush policy of the context. Each chunk has the
+ * shape of the region it fills (smaller than the chunkshape on the edges) or the whole chunkshape
+ * (with the items out of the array ignored). The sizes of all the chunks are checked before
+ * anything is appended.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ * @param chunks The pointers to the buffers where the data of each chunk is stored.
+ * @param chunksizes The size (in bytes) of each buffer.
+ * @param nchunks The number of chunks.
+ *
+ * @return An error code.
+ */
+int caterva_array_append_many(caterva_context_t *ctx, caterva_array_t *array, void **chunks,
+                              int64_t *chunksizes, int64_t nchunks);
+
+/**
+ * @brief Write the chunks held in the append buffer of an array to its superchunk.
+ *
+ * It only has effect on Blosc arrays when the context uses @p CATERVA_FLUSH_BUFFERED.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ *
+ * @return An error code.
+ */
+int caterva_array_flush(caterva_context_t *ctx, caterva_array_t *array);
+
 /**
  * @brief Create a caterva array from a frame. It can only be used if the array
  * is backed by a blosc super-chunk.
@@ -379,10 +964,14 @@ int caterva_array_from_sframe(caterva_context_t *ctx, uint8_t *sframe, int64_t l
 /**
  * @brief Read a caterva array from disk.
  *
+ * Both Blosc frames and plain buffers stored on disk are supported. The downsampled levels of a
+ * Blosc array are opened too, out of their sibling files (see @p pyramid_levels).
+ *
  * @param ctx Pointer to the caterva context to be used.
  * @param filename The filename of the caterva array on disk.
- * @param copy If true, a new, sparse in-memory super-chunk is created. Else, a frame-backed one is
- * created (i.e. no copies are made).
+ * @param copy If true, a new, sparse in-memory super-chunk (or an in-memory plain buffer) is
+ * created. Else, a frame-backed one (or a memory-mapped plain buffer) is created (i.e. no copies
+ * are made).
  * @param array Pointer to the memory pointer where the array will be created.
  *
  * @return An error code.
@@ -390,6 +979,64 @@ int caterva_array_from_sframe(caterva_context_t *ctx, uint8_t *sframe, int64_t l
 int caterva_array_from_file(caterva_context_t *ctx, const char *filename, bool copy,
                             caterva_array_t **array);
 
+/**
+ * @brief Serialize a caterva array into a contiguous frame.
+ *
+ * The compressed chunks and the metalayers are copied as they are (no recompression). If the
+ * array is backed by an in-memory frame, that frame is returned directly. It can only be used if
+ * the array is backed by a blosc super-chunk.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ * @param sframe Pointer to the memory pointer where the serialized frame will be placed.
+ * @param len Pointer to the size (in bytes) of the serialized frame.
+ * @param needs_free Pointer to the flag telling whether @p sframe must be released by the caller
+ * (with free()). If it is false, @p sframe belongs to the array.
+ *
+ * @return An error code.
+ */
+int caterva_array_to_sframe(caterva_context_t *ctx, caterva_array_t *array, uint8_t **sframe,
+                            int64_t *len, bool *needs_free);
+
+/**
+ * @brief Write a caterva array to disk.
+ *
+ * Blosc arrays are written as a frame, chunk by chunk and without recompression; plain buffers
+ * are written in the format of the plain buffers stored on disk. In both cases the array can be
+ * read back with caterva_array_from_file(). The file must not be the one backing the array. The
+ * downsampled levels of the array are written to the sibling files of @p filename.
+ *
+ * The chunks of the frame are laid out by position, even if they were written out of order into
+ * the frame backing the array (as the chunks appended in C order along a curve, which fill the
+ * placeholders at the end of the frame). Saving such an array compacts it.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ * @param filename The filename where the array will be written.
+ *
+ * @return An error code.
+ */
+int caterva_array_save(caterva_context_t *ctx, caterva_array_t *array, const char *filename);
+
+/**
+ * @brief Write a chunk of an array with a fill value, in any order.
+ *
+ * The chunks that are never written are not stored (or only as a uniform chunk of the fill value,
+ * a special chunk of a few bytes, when a later chunk is written) and read as the fill value
+ * without any decompression. A chunk can be written again, replacing its previous data.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array (a Blosc array created with a fill value).
+ * @param nchunk The chunk number (in C order within the chunk grid).
+ * @param chunk Pointer to the buffer where the chunk data is stored (in C order).
+ * @param chunksize Size (in bytes) of the buffer. It is smaller than the size of a whole chunk for
+ * the chunks that exceed the array shape.
+ *
+ * @return An error code.
+ */
+int caterva_array_set_chunk(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                            void *chunk, int64_t chunksize);
+
 /**
  * @brief Create a caterva array from the data stored in a buffer.
  *
@@ -409,6 +1056,10 @@ int caterva_array_from_buffer(caterva_context_t *ctx, void *buffer, int64_t buff
 /**
  * @brief Extract the data into a C buffer from a caterva array.
  *
+ * The chunks of Blosc arrays are split between the threads of @p ctx. If the blocks only split the
+ * chunks along the first axis and the chunks span the rest of axes, the chunks not on the edges
+ * are decompressed straight into @p buffer.
+ *
  * @param ctx Pointer to the caterva context to be used.
  * @param array Pointer to the caterva array.
  * @param buffer Pointer to the buffer where the data will be stored.
@@ -449,6 +1100,10 @@ int caterva_array_squeeze(caterva_context_t *ctx, caterva_array_t *array);
 /**
  * @brief Get a slice from an array and store it into a C buffer.
  *
+ * A slice inside a single block of a Blosc array (such as a single item) is decoded straight out
+ * of the compressed chunk, from its first to its last item, unless the blocks are predicted or
+ * stored as deltas or the array has a chunk cache.
+ *
  * @param ctx Pointer to the caterva context to be used.
  * @param src Pointer to the array from which the slice will be extracted.
  * @param start The coordinates where the slice will begin.
@@ -491,4 +1146,339 @@ int caterva_array_set_slice_buffer(caterva_context_t *ctx, void *buffer, int64_t
 int caterva_array_copy(caterva_context_t *ctx, caterva_array_t *src, caterva_storage_t *storage,
                        caterva_array_t **array);
 
+/**
+ * @brief Permute the axes of an array. The result is built into a new caterva array.
+ *
+ * The destination is produced chunk by chunk; for each destination chunk only the overlapping
+ * part of the source is decompressed, so the whole array is never held in memory.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param src Pointer to the array to be permuted.
+ * @param perm The permutation of the axes. The axis i of the new array is the axis perm[i] of
+ * the source array.
+ * @param storage Pointer to the storage params of the array desired.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code
+ */
+int caterva_array_transpose(caterva_context_t *ctx, caterva_array_t *src, int8_t *perm,
+                            caterva_storage_t *storage, caterva_array_t **array);
+
+/**
+ * @brief Change the chunk and block shapes of an array. The result is built into a new caterva
+ * array.
+ *
+ * The source chunks are streamed in storage order and scattered into a staging area of
+ * partially filled destination chunks, which are compressed and appended as soon as they are
+ * complete. When the staging area fits in @p membudget every source chunk is decompressed only
+ * once; otherwise the destination chunks are built in groups that fit in the budget. The
+ * chunks are processed by up to nthreads threads. A result with levels (`pyramid_levels`) is
+ * built as a copy instead, so that its levels are reduced out of the chunks appended.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param src Pointer to the array to be rechunked.
+ * @param storage Pointer to the storage params of the array desired.
+ * @param membudget The maximum amount of memory (in bytes) used for staging chunks. If it is
+ * not positive, #CATERVA_RECHUNK_MEMBUDGET_DEFAULT is used. The threads are limited to the ones
+ * whose chunks fit in it, and an error is returned if it can not hold the chunks of a single one.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code
+ */
+int caterva_array_rechunk(caterva_context_t *ctx, caterva_array_t *src,
+                          caterva_storage_t *storage, int64_t membudget,
+                          caterva_array_t **array);
+
+/**
+ * @brief Join a sequence of arrays along an existing axis. The result is built into a new
+ * caterva array.
+ *
+ * When an input has the same chunk and block shapes and compression parameters as the result
+ * and its chunks are aligned with the ones of the result, they are copied without being
+ * decompressed. Only the rest of the chunks are rebuilt and compressed again. All of them are
+ * rebuilt when the result has levels (`pyramid_levels`).
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param arrays The arrays to be joined. Their shapes must match out of @p axis.
+ * @param narrays The number of arrays.
+ * @param axis The axis along which the arrays are joined.
+ * @param storage Pointer to the storage params of the array desired.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code
+ */
+int caterva_array_concatenate(caterva_context_t *ctx, caterva_array_t **arrays, int narrays,
+                              int8_t axis, caterva_storage_t *storage,
+                              caterva_array_t **array);
+
+/**
+ * @brief Join a sequence of arrays along a new axis. The result is built into a new caterva
+ * array.
+ *
+ * The chunks of the inputs are copied without being decompressed when the result has a unit
+ * chunk and block length along @p axis and, out of it, the same chunk and block shapes and
+ * compression parameters as the inputs (and it has no levels).
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param arrays The arrays to be stacked. They must have the same shape.
+ * @param narrays The number of arrays.
+ * @param axis The position of the new axis in the result.
+ * @param storage Pointer to the storage params of the array desired.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code
+ */
+int caterva_array_stack(caterva_context_t *ctx, caterva_array_t **arrays, int narrays,
+                        int8_t axis, caterva_storage_t *storage, caterva_array_t **array);
+
+/**
+ * @brief Create an empty array of compound items.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param params Pointer to the compound params of the array desired.
+ * @param storage Pointer to the storage params of the arrays of the fields.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code
+ */
+int caterva_array_empty_fields(caterva_context_t *ctx, caterva_compound_params_t *params,
+                               caterva_storage_t *storage, caterva_array_t **array);
+
+/**
+ * @brief Create an array of compound items filled with a record (see caterva_array_full()).
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param params Pointer to the compound params of the array desired.
+ * @param storage Pointer to the storage params of the arrays of the fields.
+ * @param fill_value Pointer to the record the items are filled with.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code
+ */
+int caterva_array_full_fields(caterva_context_t *ctx, caterva_compound_params_t *params,
+                              caterva_storage_t *storage, const void *fill_value,
+                              caterva_array_t **array);
+
+/**
+ * @brief Create an array of compound items out of a C buffer of records.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param buffer The buffer where the records are stored.
+ * @param buffersize The size (in bytes) of the buffer.
+ * @param params Pointer to the compound params of the array desired.
+ * @param storage Pointer to the storage params of the arrays of the fields.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code
+ */
+int caterva_array_from_buffer_fields(caterva_context_t *ctx, void *buffer, int64_t buffersize,
+                                     caterva_compound_params_t *params,
+                                     caterva_storage_t *storage, caterva_array_t **array);
+
+/**
+ * @brief Get the array where a field of a compound array is stored.
+ *
+ * The field array is owned by the compound array. It can be used as any other array (e.g. to be
+ * saved or sliced), but chunks must only be appended to the compound array.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the compound array.
+ * @param name The name of the field.
+ * @param field Pointer to the memory pointer where the field array will be returned.
+ *
+ * @return An error code
+ */
+int caterva_array_get_field(caterva_context_t *ctx, caterva_array_t *array, const char *name,
+                            caterva_array_t **field);
+
+/**
+ * @brief Get a slice of some of the fields of a compound array into a C buffer.
+ *
+ * Only the arrays of the fields requested are read. The items are written as records made of
+ * these fields, in the order of @p names.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param src Pointer to the compound array.
+ * @param names The names of the fields.
+ * @param nnames The number of fields.
+ * @param start The coordinates where the slice will begin.
+ * @param stop The coordinates where the slice will end.
+ * @param shape The shape of the buffer (it must be at least the shape of the slice).
+ * @param buffer Pointer to the buffer where data will be copied.
+ * @param buffersize The size (in bytes) of the buffer.
+ *
+ * @return An error code
+ */
+int caterva_array_get_fields_slice_buffer(caterva_context_t *ctx, caterva_array_t *src,
+                                          const char **names, int8_t nnames, int64_t *start,
+                                          int64_t *stop, int64_t *shape, void *buffer,
+                                          int64_t buffersize);
+
+/**
+ * @brief Create a compound array out of the arrays of its fields.
+ *
+ * The Blosc arrays of the fields carry a @p caterva_fields metalayer with the whole list of
+ * fields, so that the arrays saved on their own (e.g. with caterva_array_save()) can be opened
+ * again and joined. The compound array takes over the field arrays, which must be passed in the
+ * order of the list.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param fields The arrays of the fields.
+ * @param nfields The number of fields.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code
+ */
+int caterva_array_from_fields(caterva_context_t *ctx, caterva_array_t **fields, int8_t nfields,
+                              caterva_array_t **array);
+
+/**
+ * @brief Get a downsampled level of an array.
+ *
+ * The level array is owned by the array (level 0 is the array itself). It can be read as any
+ * other array, but chunks must only be appended to the array.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the array.
+ * @param level The level (between 0 and the @p pyramid_levels of the array).
+ * @param level_array Pointer to the memory pointer where the level array will be returned.
+ *
+ * @return An error code
+ */
+int caterva_array_get_level(caterva_context_t *ctx, caterva_array_t *array, int8_t level,
+                            caterva_array_t **level_array);
+
+/**
+ * @brief Get a slice of a downsampled level of an array into a C buffer.
+ *
+ * Only the chunks of the level that overlap the slice are read, so that the cost of a coarse read
+ * follows the size of the output rather than the region of the array it covers.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the array.
+ * @param level The level.
+ * @param start The coordinates (in the level) where the slice will begin.
+ * @param stop The coordinates (in the level) where the slice will end.
+ * @param shape The shape of the buffer (it must be at least the shape of the slice).
+ * @param buffer Pointer to the buffer where data will be copied.
+ * @param buffersize The size (in bytes) of the buffer.
+ *
+ * @return An error code
+ */
+int caterva_array_get_level_slice_buffer(caterva_context_t *ctx, caterva_array_t *array,
+                                         int8_t level, int64_t *start, int64_t *stop,
+                                         int64_t *shape, void *buffer, int64_t buffersize);
+
+/**
+ * @brief Join an array and its downsampled levels again.
+ *
+ * The Blosc arrays of a pyramid carry a @p caterva_pyramid metalayer with their level, so that
+ * the arrays saved on their own (not in the sibling files of the array) can be opened again and
+ * joined. The array (@p arrays[0]) takes
+ * over the level arrays.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param arrays The array followed by its levels, in order.
+ * @param narrays The number of arrays (the number of levels plus 1).
+ * @param array Pointer to the memory pointer where the array (@p arrays[0]) will be returned.
+ *
+ * @return An error code
+ */
+int caterva_array_from_levels(caterva_context_t *ctx, caterva_array_t **arrays, int8_t narrays,
+                              caterva_array_t **array);
+
+/**
+ * @brief Get the sum of the items in a box of an array with a sum index.
+ *
+ * The chunks and blocks fully covered by the box are added out of the index, so that only the
+ * blocks on the boundary of the box are decompressed. The items are summed as doubles (so that
+ * the sums of integers are exact up to 2^53); the mean is the sum divided by the number of items
+ * in the box.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the array.
+ * @param start The coordinates where the box begins.
+ * @param stop The coordinates where the box ends.
+ * @param sum Pointer to where the sum will be returned.
+ *
+ * @return An error code
+ */
+int caterva_array_get_box_sum(caterva_context_t *ctx, caterva_array_t *array, int64_t *start,
+                              int64_t *stop, double *sum);
+
+/**
+ * @brief Find the items of an array that are equal to a value.
+ *
+ * The items are compared bit by bit. If the array has a Bloom index, only the blocks whose filter
+ * may hold the value are decompressed (the others are masked out); otherwise every block is read.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the array (with items of up to 8 bytes).
+ * @param value Pointer to the value looked up.
+ * @param indexes Pointer to where the positions of the items found (in C order, increasing) will
+ * be placed. It must be released with free().
+ * @param nindexes Pointer to where the number of items found will be returned.
+ *
+ * @return An error code
+ */
+int caterva_array_find_equal(caterva_context_t *ctx, caterva_array_t *array, const void *value,
+                             int64_t **indexes, int64_t *nindexes);
+
+/**
+ * @brief Get the runtime statistics collected for an array.
+ *
+ * The statistics are only collected when the @p stats field of the context configuration is set.
+ * Operations building a new array from other ones account the reads to the sources and the
+ * writes to the result.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The caterva array.
+ * @param stats Pointer to the structure where the statistics will be copied.
+ * @param reset Whether the statistics of the array are zeroed after copying them.
+ *
+ * @return An error code.
+ */
+int caterva_array_get_stats(caterva_context_t *ctx, caterva_array_t *array,
+                            caterva_stats_t *stats, bool reset);
+
+/**
+ * @brief Propose the chunk and block shapes of a Blosc array.
+ *
+ * Blocks are sized to fit in the L2 cache and chunks to fit in the L3 cache (while keeping enough
+ * blocks per chunk to feed all the threads in @p ctx). Both are stretched along the
+ * @p access_axes hinted in @p tparams first.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param params Pointer to the general params of the array desired.
+ * @param tparams Pointer to the tuning params (cache sizes and access hints).
+ * @param storage Pointer to the Blosc storage params where the proposed chunkshape and blockshape
+ * will be stored.
+ *
+ * @return An error code.
+ */
+int caterva_storage_tune(caterva_context_t *ctx, caterva_params_t *params,
+                         caterva_tune_params_t *tparams, caterva_storage_t *storage);
+
+/**
+ * @brief Choose the chunk and block shapes of a Blosc array by benchmarking a few candidates.
+ *
+ * The candidates are derived from the caterva_storage_tune() proposal. Each one is used to
+ * compress @p sample with the codec configured in @p ctx and to read it back along the
+ * @p access_axes hinted in @p tparams. The fastest candidate is stored in @p storage.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param params Pointer to the general params of the array desired.
+ * @param tparams Pointer to the tuning params (cache sizes and access hints).
+ * @param sample Pointer to a buffer with a representative region of the array data.
+ * @param sampleshape The shape of the @p sample region.
+ * @param samplesize The size (in bytes) of the @p sample buffer.
+ * @param storage Pointer to the Blosc storage params where the chosen chunkshape and blockshape
+ * will be stored.
+ *
+ * @return An error code.
+ */
+int caterva_storage_calibrate(caterva_context_t *ctx, caterva_params_t *params,
+                              caterva_tune_params_t *tparams, void *sample, int64_t *sampleshape,
+                              int64_t samplesize, caterva_storage_t *storage);
+
 #endif  // CATERVA_CATERVA_H_
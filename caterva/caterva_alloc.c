@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_utils.h"
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* The size of the huge pages requested by caterva_alloc_hugepage() */
+#define CATERVA_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/* The minimum size of the blocks placed with a NUMA policy by caterva_alloc_numa() */
+#define CATERVA_NUMA_MIN_SIZE (64 * 1024)
+
+/* The NUMA memory policies (see mbind(2)); numaif.h is not always available */
+#define CATERVA_MPOL_PREFERRED 1
+#define CATERVA_MPOL_LOCAL 4
+
+void *caterva_malloc(caterva_context_t *ctx, size_t size, caterva_alloc_purpose_t purpose) {
+    caterva_config_t *cfg = ctx->cfg;
+    if (cfg->alloc_aligned != NULL) {
+        return cfg->alloc_aligned(size, CATERVA_ALLOC_ALIGNMENT, purpose, cfg->alloc_data);
+    }
+    return cfg->alloc(size);
+}
+
+void caterva_free(caterva_context_t *ctx, void *ptr, size_t size,
+                  caterva_alloc_purpose_t purpose) {
+    caterva_config_t *cfg = ctx->cfg;
+    if (ptr == NULL) {
+        return;
+    }
+    if (cfg->free_aligned != NULL) {
+        cfg->free_aligned(ptr, size, purpose, cfg->alloc_data);
+    } else {
+        cfg->free(ptr);
+    }
+}
+
+static void *heap_alloc(size_t size, size_t alignment) {
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+#if defined(_WIN32)
+    return _aligned_malloc(size, alignment);
+#else
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, alignment, size) != 0) {
+        return NULL;
+    }
+    return ptr;
+#endif
+}
+
+static void heap_free(void *ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+#if defined(__linux__)
+static size_t round_up(size_t size, size_t multiple) {
+    return (size + multiple - 1) / multiple * multiple;
+}
+
+static bool use_hugepages(size_t size, caterva_alloc_purpose_t purpose) {
+    return size >= CATERVA_HUGEPAGE_SIZE &&
+           (purpose == CATERVA_ALLOC_CHUNK || purpose == CATERVA_ALLOC_PLAINBUFFER);
+}
+
+static bool use_numa(size_t size) {
+    return size >= CATERVA_NUMA_MIN_SIZE;
+}
+#endif
+
+void *caterva_alloc_hugepage(size_t size, size_t alignment, caterva_alloc_purpose_t purpose,
+                             void *alloc_data) {
+    (void) alloc_data;
+#if defined(__linux__)
+    if (use_hugepages(size, purpose)) {
+        size_t len = round_up(size, CATERVA_HUGEPAGE_SIZE);
+        void *ptr;
+#if defined(MAP_HUGETLB)
+        ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                   -1, 0);
+        if (ptr != MAP_FAILED) {
+            return ptr;
+        }
+#endif
+        // No huge pages reserved; align a regular mapping so that it can use transparent ones
+        uint8_t *raw = mmap(NULL, len + CATERVA_HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            return NULL;
+        }
+        uint8_t *aligned = (uint8_t *) round_up((uintptr_t) raw, CATERVA_HUGEPAGE_SIZE);
+        if (aligned > raw) {
+            munmap(raw, (size_t) (aligned - raw));
+        }
+        size_t tail = (size_t) (raw + len + CATERVA_HUGEPAGE_SIZE - (aligned + len));
+        if (tail > 0) {
+            munmap(aligned + len, tail);
+        }
+        ptr = aligned;
+#if defined(MADV_HUGEPAGE)
+        madvise(ptr, len, MADV_HUGEPAGE);
+#endif
+        return ptr;
+    }
+#else
+    (void) purpose;
+#endif
+    return heap_alloc(size, alignment);
+}
+
+void caterva_free_hugepage(void *ptr, size_t size, caterva_alloc_purpose_t purpose,
+                           void *alloc_data) {
+    (void) alloc_data;
+#if defined(__linux__)
+    if (use_hugepages(size, purpose)) {
+        munmap(ptr, round_up(size, CATERVA_HUGEPAGE_SIZE));
+        return;
+    }
+#else
+    (void) size;
+    (void) purpose;
+#endif
+    heap_free(ptr);
+}
+
+void *caterva_alloc_numa(size_t size, size_t alignment, caterva_alloc_purpose_t purpose,
+                         void *alloc_data) {
+    (void) purpose;
+#if defined(__linux__)
+    if (use_numa(size)) {
+        size_t len = round_up(size, (size_t) sysconf(_SC_PAGESIZE));
+        void *ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            return NULL;
+        }
+#if defined(SYS_mbind)
+        // The pages are not populated yet, so the policy decides where they are placed on the
+        // first touch. A failing mbind (e.g. without NUMA support) keeps the default policy.
+        int node = alloc_data != NULL ? *(int *) alloc_data : -1;
+        unsigned long nodemask = 0;
+        unsigned long maxnode = 8 * sizeof(nodemask);
+        if (node >= 0 && (unsigned long) node < maxnode) {
+            nodemask = 1UL << node;
+            syscall(SYS_mbind, ptr, len, CATERVA_MPOL_PREFERRED, &nodemask, maxnode + 1, 0);
+        } else {
+            syscall(SYS_mbind, ptr, len, CATERVA_MPOL_LOCAL, NULL, 0, 0);
+        }
+#else
+        (void) alloc_data;
+#endif
+        return ptr;
+    }
+#else
+    (void) alloc_data;
+#endif
+    return heap_alloc(size, alignment);
+}
+
+void caterva_free_numa(void *ptr, size_t size, caterva_alloc_purpose_t purpose,
+                       void *alloc_data) {
+    (void) purpose;
+    (void) alloc_data;
+#if defined(__linux__)
+    if (use_numa(size)) {
+        munmap(ptr, round_up(size, (size_t) sysconf(_SC_PAGESIZE)));
+        return;
+    }
+#else
+    (void) size;
+#endif
+    heap_free(ptr);
+}
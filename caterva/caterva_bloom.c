@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_blosc.h"
+#include "caterva_utils.h"
+
+// The Bloom index keeps a Bloom filter of the items of every block of an array, which is built when
+// the chunk is written. An equality lookup only decompresses the blocks whose filter may hold the
+// item; the others are masked out. The items are compared bit by bit, so any item of up to 8 bytes
+// can be looked up (integers are the natural use, as floats equal in value may differ in bits).
+
+static char bloom_metalayer[] = "caterva_bloom";
+
+static int64_t nblocks_per_chunk(caterva_array_t *array) {
+    return array->extchunknitems / array->blocknitems;
+}
+
+// The bytes of the filter of each block
+static int64_t filter_size(caterva_array_t *array) {
+    return (array->blocknitems * array->bloom_bits + 7) / 8;
+}
+
+int caterva_bloom_new(caterva_context_t *ctx, caterva_array_t *array, uint8_t bits) {
+    array->bloom_bits = bits == 0 ? CATERVA_BLOOM_BITS_DEFAULT : bits;
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    size_t size = (size_t) (nchunks * nblocks_per_chunk(array) * filter_size(array));
+    array->blooms = caterva_malloc(ctx, size, CATERVA_ALLOC_ARRAY);
+    CATERVA_ERROR_NULL(array->blooms);
+    memset(array->blooms, 0, size);
+    return CATERVA_SUCCEED;
+}
+
+void caterva_bloom_free(caterva_context_t *ctx, caterva_array_t *array) {
+    if (array->blooms == NULL) {
+        return;
+    }
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    caterva_free(ctx, array->blooms,
+                 (size_t) (nchunks * nblocks_per_chunk(array) * filter_size(array)),
+                 CATERVA_ALLOC_ARRAY);
+    array->blooms = NULL;
+}
+
+// Two hashes of an item (the probes are h1 + i * h2)
+static void hash_item(const uint8_t *item, int32_t itemsize, uint64_t *h1, uint64_t *h2) {
+    uint64_t x = 0;
+    memcpy(&x, item, (size_t) itemsize);
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    *h1 = x & 0xffffffffULL;
+    *h2 = (x >> 32) | 1;
+}
+
+// The number of probes that minimizes the false positives (bits * ln 2)
+static int nprobes(caterva_array_t *array) {
+    int k = array->bloom_bits * 7 / 10;
+    return k < 1 ? 1 : k;
+}
+
+static void filter_add(caterva_array_t *array, uint8_t *filter, const uint8_t *item) {
+    uint64_t nbits = (uint64_t) filter_size(array) * 8;
+    uint64_t h1, h2;
+    hash_item(item, array->itemsize, &h1, &h2);
+    for (int i = 0; i < nprobes(array); ++i) {
+        uint64_t bit = (h1 + (uint64_t) i * h2) % nbits;
+        filter[bit / 8] |= (uint8_t) (1 << (bit % 8));
+    }
+}
+
+static bool filter_contains(caterva_array_t *array, const uint8_t *filter, const uint8_t *item) {
+    uint64_t nbits = (uint64_t) filter_size(array) * 8;
+    uint64_t h1, h2;
+    hash_item(item, array->itemsize, &h1, &h2);
+    for (int i = 0; i < nprobes(array); ++i) {
+        uint64_t bit = (h1 + (uint64_t) i * h2) % nbits;
+        if ((filter[bit / 8] & (1 << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void caterva_bloom_rchunk(caterva_array_t *array, int64_t nchunk, const uint8_t *rchunk) {
+    if (array->blooms == NULL) {
+        return;
+    }
+    int32_t itemsize = array->itemsize;
+    int64_t cshape[CATERVA_MAX_DIM];
+    caterva_blosc_chunk_shape(array, nchunk, cshape);
+    int64_t fsize = filter_size(array);
+    int64_t nblocks = nblocks_per_chunk(array);
+    uint8_t *filter = array->blooms + nchunk * nblocks * fsize;
+    memset(filter, 0, (size_t) (nblocks * fsize));
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        const uint8_t *block = rchunk + nblock * array->blocknitems * itemsize;
+        int64_t bshape[CATERVA_MAX_DIM];
+        int64_t bnitems = caterva_block_extent(array, cshape, nblock, bshape);
+        if (bnitems == 0) {
+            continue;
+        }
+        // Only the rows of the block inside the array are added (not the padding)
+        int64_t rowlen = bshape[array->ndim - 1];
+        for (int64_t row = 0; row < bnitems / rowlen; ++row) {
+            const uint8_t *items = block + caterva_block_row_offset(array, bshape, row) * itemsize;
+            for (int64_t i = 0; i < rowlen; ++i) {
+                // Runs of equal items are common in label arrays
+                if (i > 0 && memcmp(items + i * itemsize, items + (i - 1) * itemsize,
+                                    (size_t) itemsize) == 0) {
+                    continue;
+                }
+                filter_add(array, filter + nblock * fsize, items + i * itemsize);
+            }
+        }
+    }
+    array->indexes_dirty = true;
+}
+
+void caterva_bloom_uniform(caterva_array_t *array, int64_t nchunk, const uint8_t *value) {
+    if (array->blooms == NULL) {
+        return;
+    }
+    int64_t cshape[CATERVA_MAX_DIM];
+    caterva_blosc_chunk_shape(array, nchunk, cshape);
+    int64_t fsize = filter_size(array);
+    int64_t nblocks = nblocks_per_chunk(array);
+    uint8_t *filter = array->blooms + nchunk * nblocks * fsize;
+    memset(filter, 0, (size_t) (nblocks * fsize));
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        int64_t bshape[CATERVA_MAX_DIM];
+        if (caterva_block_extent(array, cshape, nblock, bshape) > 0) {
+            filter_add(array, filter + nblock * fsize, value);
+        }
+    }
+    array->indexes_dirty = true;
+}
+
+// The metalayer is [bits, bin 32 with the filters]
+int caterva_bloom_serialize(caterva_context_t *ctx, caterva_array_t *array, uint8_t **smeta,
+                            int32_t *smeta_len) {
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    uint32_t nbytes = (uint32_t) (nchunks * nblocks_per_chunk(array) * filter_size(array));
+    *smeta_len = 7 + (int32_t) nbytes;
+    *smeta = caterva_malloc(ctx, (size_t) *smeta_len, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(*smeta);
+    uint8_t *pmeta = *smeta;
+
+    *pmeta++ = 0x90 + 2;  // fixarray with 2 elements
+    *pmeta++ = array->bloom_bits;  // positive fixnum (7-bit positive integer)
+    *pmeta++ = 0xc6;  // bin 32
+    for (int i = 3; i >= 0; --i) {
+        *pmeta++ = (uint8_t) (nbytes >> (8 * i));
+    }
+    memcpy(pmeta, array->blooms, nbytes);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_bloom_deserialize(caterva_context_t *ctx, caterva_array_t *array,
+                              const uint8_t *smeta, uint32_t smeta_len) {
+    if (smeta_len < 7 || smeta[0] != 0x90 + 2 || smeta[1] == 0 ||
+        smeta[1] > CATERVA_BLOOM_BITS_MAX || smeta[2] != 0xc6) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    CATERVA_ERROR(caterva_bloom_new(ctx, array, smeta[1]));
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    uint32_t nbytes = (uint32_t) (nchunks * nblocks_per_chunk(array) * filter_size(array));
+    if (smeta_len != 7 + nbytes ||
+        (uint32_t) (smeta[3] << 24 | smeta[4] << 16 | smeta[5] << 8 | smeta[6]) != nbytes) {
+        caterva_bloom_free(ctx, array);
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    memcpy(array->blooms, smeta + 7, nbytes);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_bloom_store(caterva_context_t *ctx, caterva_array_t *array) {
+    if (array->blooms == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *smeta;
+    int32_t smeta_len;
+    CATERVA_ERROR(caterva_bloom_serialize(ctx, array, &smeta, &smeta_len));
+    int rc = blosc2_update_metalayer(array->sc, bloom_metalayer, smeta, (uint32_t) smeta_len);
+    caterva_free(ctx, smeta, (size_t) smeta_len, CATERVA_ALLOC_SCRATCH);
+    if (rc < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// The matches found so far
+struct matches_s {
+    int64_t *indexes;
+    int64_t nindexes;
+    int64_t capacity;
+};
+
+static int add_match(struct matches_s *matches, int64_t index) {
+    if (matches->nindexes == matches->capacity) {
+        int64_t capacity = matches->capacity == 0 ? 64 : 2 * matches->capacity;
+        int64_t *indexes = realloc(matches->indexes, (size_t) capacity * sizeof(int64_t));
+        CATERVA_ERROR_NULL(indexes);
+        matches->indexes = indexes;
+        matches->capacity = capacity;
+    }
+    matches->indexes[matches->nindexes++] = index;
+    return CATERVA_SUCCEED;
+}
+
+// Add the positions of the items of the block nblock of the chunk nchunk (with the given origin)
+// that are equal to value. If block is NULL, all the items of the block are equal to it.
+static int match_block(caterva_array_t *array, const int64_t *corigin, int64_t nblock,
+                       const uint8_t *block, const uint8_t *value, struct matches_s *matches) {
+    int8_t ndim = array->ndim;
+    int32_t itemsize = array->itemsize;
+    int64_t borigin[CATERVA_MAX_DIM];
+    int64_t rem = nblock;
+    for (int i = ndim - 1; i >= 0; --i) {
+        int64_t grid = array->extchunkshape[i] / array->blockshape[i];
+        borigin[i] = corigin[i] + rem % grid * array->blockshape[i];
+        rem /= grid;
+    }
+    for (int64_t n = 0; n < array->blocknitems; ++n) {
+        if (block != NULL && memcmp(block + n * itemsize, value, (size_t) itemsize) != 0) {
+            continue;
+        }
+        // The position of the item in the array (the padding is skipped)
+        int64_t index = 0;
+        int64_t stride = 1;
+        bool inside = true;
+        rem = n;
+        for (int i = ndim - 1; i >= 0; --i) {
+            int64_t coord = borigin[i] + rem % array->blockshape[i];
+            rem /= array->blockshape[i];
+            inside = inside && coord < array->shape[i];
+            index += coord * stride;
+            stride *= array->shape[i];
+        }
+        if (inside) {
+            CATERVA_ERROR(add_match(matches, index));
+        }
+    }
+    return CATERVA_SUCCEED;
+}
+
+static int compare_indexes(const void *a, const void *b) {
+    int64_t x = *(const int64_t *) a;
+    int64_t y = *(const int64_t *) b;
+    return (x > y) - (x < y);
+}
+
+int caterva_array_find_equal(caterva_context_t *ctx, caterva_array_t *array, const void *value,
+                             int64_t **indexes, int64_t *nindexes) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(value);
+    CATERVA_ERROR_NULL(indexes);
+    CATERVA_ERROR_NULL(nindexes);
+
+    if (array->storage != CATERVA_STORAGE_BLOSC || array->nfields > 0 ||
+        array->itemsize > 8) {
+        DEBUG_PRINT("Only the items of up to 8 bytes of Blosc arrays can be looked up");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (!array->filled) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    CATERVA_ERROR(caterva_blosc_array_flush(ctx, array));
+
+    int32_t itemsize = array->itemsize;
+    int8_t ndim = array->ndim;
+    int64_t nblocks = nblocks_per_chunk(array);
+    int64_t fsize = array->blooms != NULL ? filter_size(array) : 0;
+    size_t rchunksize = (size_t) array->extchunknitems * itemsize;
+    uint8_t *rchunk = caterva_malloc(ctx, rchunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR_NULL(rchunk);
+    bool *maskout = caterva_malloc(ctx, (size_t) nblocks, CATERVA_ALLOC_MASKOUT);
+    CATERVA_ERROR_NULL(maskout);
+
+    caterva_stats_t stats = {0};
+    struct matches_s matches = {0};
+    int rc = CATERVA_SUCCEED;
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    for (int64_t nchunk = 0; nchunk < nchunks && rc == CATERVA_SUCCEED; ++nchunk) {
+        // Only the blocks whose filter may hold the value are decompressed
+        int64_t ncandidates = 0;
+        for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+            maskout[nblock] = array->blooms != NULL &&
+                              !filter_contains(array, array->blooms + (nchunk * nblocks + nblock) *
+                                                          fsize, (const uint8_t *) value);
+            ncandidates += !maskout[nblock];
+        }
+        if (ncandidates == 0) {
+            continue;
+        }
+
+        uint8_t uvalue[CATERVA_MAX_ITEMSIZE];
+        bool uniform = false;
+        rc = caterva_blosc_read_chunk(ctx, array, array->sc->dctx, nchunk, maskout, rchunk,
+                                      rchunksize, uvalue, &uniform, &stats);
+        if (rc != CATERVA_SUCCEED ||
+            (uniform && memcmp(uvalue, value, (size_t) itemsize) != 0)) {
+            continue;
+        }
+        int64_t corigin[CATERVA_MAX_DIM];
+        int64_t rem = nchunk;
+        for (int i = ndim - 1; i >= 0; --i) {
+            int64_t grid = array->extshape[i] / array->chunkshape[i];
+            corigin[i] = rem % grid * array->chunkshape[i];
+            rem /= grid;
+        }
+        for (int64_t nblock = 0; nblock < nblocks && rc == CATERVA_SUCCEED; ++nblock) {
+            if (!maskout[nblock]) {
+                const uint8_t *block = uniform ? NULL
+                                               : rchunk + nblock * array->blocknitems * itemsize;
+                rc = match_block(array, corigin, nblock, block, (const uint8_t *) value,
+                                 &matches);
+            }
+        }
+    }
+    caterva_stats_merge(ctx, array, &stats);
+    caterva_free(ctx, maskout, (size_t) nblocks, CATERVA_ALLOC_MASKOUT);
+    caterva_free(ctx, rchunk, rchunksize, CATERVA_ALLOC_CHUNK);
+    if (rc != CATERVA_SUCCEED) {
+        free(matches.indexes);
+        CATERVA_ERROR(rc);
+    }
+
+    // The blocks of a chunk are not contiguous in the array
+    if (matches.nindexes > 1) {
+        qsort(matches.indexes, (size_t) matches.nindexes, sizeof(int64_t), compare_indexes);
+    }
+    *indexes = matches.indexes;
+    *nindexes = matches.nindexes;
+    return CATERVA_SUCCEED;
+}
@@ -12,6 +12,9 @@
 #include <assert.h>
 #include <caterva.h>
 
+#include "caterva_blosc.h"
+#include "caterva_utils.h"
+
 // big <-> little-endian and store it in a memory position.  Sizes supported: 1, 2, 4, 8 bytes.
 static void swap_store(void *dest, const void *pa, int size) {
     uint8_t *pa_ = (uint8_t *) pa;
@@ -54,15 +57,20 @@ static void swap_store(void *dest, const void *pa, int size) {
 }
 
 static int32_t serialize_meta(int8_t ndim, int64_t *shape, const int32_t *chunkshape,
-                              const int32_t *blockshape, uint8_t **smeta) {
+                              const int32_t *blockshape, int32_t itemsize,
+                              const uint8_t *fill_value, caterva_predictor_t predictor,
+                              int8_t delta_axis, int32_t keyframe_interval,
+                              caterva_chunk_order_t chunk_order, uint8_t **smeta) {
     // Allocate space for Caterva metalayer
     int32_t max_smeta_len = 1 + 1 + 1 + (1 + ndim * (1 + sizeof(int64_t))) +
-                            (1 + ndim * (1 + sizeof(int32_t))) + (1 + ndim * (1 + sizeof(int32_t)));
+                            (1 + ndim * (1 + sizeof(int32_t))) + (1 + ndim * (1 + sizeof(int32_t))) +
+                            (2 + itemsize) + 1 + 1 + (1 + sizeof(int32_t)) + 1;
     *smeta = malloc((size_t) max_smeta_len);
     uint8_t *pmeta = *smeta;
 
-    // Build an array with 5 entries (version, ndim, shape, chunkshape, blockshape)
-    *pmeta++ = 0x90 + 5;
+    // Build an array with 10 entries (version, ndim, shape, chunkshape, blockshape, fill value,
+    // predictor, delta axis, keyframe interval, chunk order)
+    *pmeta++ = 0x90 + 10;
 
     // version entry
     *pmeta++ = CATERVA_METALAYER_VERSION;  // positive fixnum (7-bit positive integer)
@@ -97,19 +105,81 @@ static int32_t serialize_meta(int8_t ndim, int64_t *shape, const int32_t *chunks
         swap_store(pmeta, blockshape + i, sizeof(int32_t));
         pmeta += sizeof(int32_t);
     }
+    assert(pmeta - *smeta < max_smeta_len);
+
+    // fill value entry
+    if (fill_value != NULL) {
+        *pmeta++ = 0xc4;  // bin8 with itemsize bytes
+        *pmeta++ = (uint8_t) itemsize;
+        memcpy(pmeta, fill_value, (size_t) itemsize);
+        pmeta += itemsize;
+    } else {
+        *pmeta++ = 0xc0;  // nil
+    }
+    assert(pmeta - *smeta < max_smeta_len);
+
+    // predictor entry
+    *pmeta++ = (uint8_t) predictor;  // positive fixnum (7-bit positive integer)
+    assert(pmeta - *smeta < max_smeta_len);
+
+    // delta axis entry
+    *pmeta++ = (uint8_t) delta_axis;  // positive fixnum (7-bit positive integer)
+    assert(pmeta - *smeta < max_smeta_len);
+
+    // keyframe interval entry
+    *pmeta++ = 0xd2;  // int32
+    swap_store(pmeta, &keyframe_interval, sizeof(int32_t));
+    pmeta += sizeof(int32_t);
+    assert(pmeta - *smeta < max_smeta_len);
+
+    // chunk order entry
+    *pmeta++ = (uint8_t) chunk_order;  // positive fixnum (7-bit positive integer)
     assert(pmeta - *smeta <= max_smeta_len);
     int32_t slen = (int32_t)(pmeta - *smeta);
 
     return slen;
 }
 
+// The lossy metalayer is an array with 3 entries (mode, tolerance, bits)
+static int32_t serialize_lossy_meta(caterva_lossy_mode_t mode, double tolerance, int8_t bits,
+                                    uint8_t *smeta) {
+    uint8_t *pmeta = smeta;
+    *pmeta++ = 0x90 + 3;
+    *pmeta++ = (uint8_t) mode;  // positive fixnum (7-bit positive integer)
+    *pmeta++ = 0xcb;  // float64
+    swap_store(pmeta, &tolerance, sizeof(double));
+    pmeta += sizeof(double);
+    *pmeta++ = (uint8_t) bits;  // positive fixnum (7-bit positive integer)
+    return (int32_t)(pmeta - smeta);
+}
+
+static void deserialize_lossy_meta(const uint8_t *smeta, caterva_lossy_mode_t *mode,
+                                   double *tolerance, int8_t *bits) {
+    const uint8_t *pmeta = smeta;
+    assert(*pmeta == 0x90 + 3);
+    pmeta += 1;
+    *mode = (caterva_lossy_mode_t) *pmeta++;
+    assert(*pmeta == 0xcb);  // float64
+    pmeta += 1;
+    swap_store(tolerance, pmeta, sizeof(double));
+    pmeta += sizeof(double);
+    *bits = (int8_t) *pmeta;
+}
+
 static int32_t deserialize_meta(uint8_t *smeta, uint32_t smeta_len, int8_t *ndim, int64_t *shape,
-                                int32_t *chunkshape, int32_t *blockshape) {
+                                int32_t *chunkshape, int32_t *blockshape, uint8_t **fill_value,
+                                uint8_t *fill_value_len, caterva_predictor_t *predictor,
+                                int8_t *delta_axis, int32_t *keyframe_interval,
+                                caterva_chunk_order_t *chunk_order) {
     uint8_t *pmeta = smeta;
     CATERVA_UNUSED_PARAM(smeta_len);
 
-    // Check that we have an array with 5 entries (version, ndim, shape, chunkshape, blockshape)
-    assert(*pmeta == 0x90 + 5);
+    // Check that we have an array with 5 entries (version, ndim, shape, chunkshape, blockshape),
+    // 6 entries (plus the fill value, since version 1), 7 entries (plus the predictor, since
+    // version 2), 9 entries (plus the delta axis and keyframe interval, since version 3) or 10
+    // entries (plus the chunk order, since version 4)
+    int8_t nentries = (int8_t) (*pmeta - 0x90);
+    assert(nentries >= 5 && nentries <= 10);
     pmeta += 1;
     assert((uint32_t)(pmeta - smeta) < smeta_len);
 
@@ -165,12 +235,59 @@ static int32_t deserialize_meta(uint8_t *smeta, uint32_t smeta_len, int8_t *ndim
         pmeta += sizeof(int32_t);
     }
     assert((uint32_t)(pmeta - smeta) <= smeta_len);
+
+    // fill value entry (pointing into smeta)
+    *fill_value = NULL;
+    *fill_value_len = 0;
+    if (nentries >= 6) {
+        if (*pmeta == 0xc4) {  // bin8
+            *fill_value_len = pmeta[1];
+            *fill_value = pmeta + 2;
+            pmeta += 2 + *fill_value_len;
+        } else {
+            assert(*pmeta == 0xc0);  // nil
+            pmeta += 1;
+        }
+    }
+    assert((uint32_t)(pmeta - smeta) <= smeta_len);
+
+    // predictor entry
+    *predictor = CATERVA_PREDICTOR_NONE;
+    if (nentries >= 7) {
+        *predictor = (caterva_predictor_t) pmeta[0];  // positive fixnum (7-bit positive integer)
+        pmeta += 1;
+    }
+    assert((uint32_t)(pmeta - smeta) <= smeta_len);
+
+    // delta axis and keyframe interval entries
+    *delta_axis = 0;
+    *keyframe_interval = 0;
+    if (nentries >= 9) {
+        *delta_axis = (int8_t) pmeta[0];  // positive fixnum (7-bit positive integer)
+        pmeta += 1;
+        assert(*pmeta == 0xd2);  // int32
+        pmeta += 1;
+        swap_store(keyframe_interval, pmeta, sizeof(int32_t));
+        pmeta += sizeof(int32_t);
+    }
+    assert((uint32_t)(pmeta - smeta) <= smeta_len);
+
+    // chunk order entry
+    *chunk_order = CATERVA_CHUNK_ORDER_C;
+    if (nentries >= 10) {
+        // positive fixnum (7-bit positive integer)
+        *chunk_order = (caterva_chunk_order_t) pmeta[0];
+        pmeta += 1;
+    }
+    assert((uint32_t)(pmeta - smeta) <= smeta_len);
     uint32_t slen = (uint32_t)(pmeta - smeta);
     CATERVA_UNUSED_PARAM(slen);
     assert(slen == smeta_len);
     return 0;
 }
 
+static int chunk_stored(caterva_array_t *array, int64_t nchunk, bool *stored);
+
 int caterva_blosc_from_frame(caterva_context_t *ctx, blosc2_frame *frame, bool copy,
                              caterva_array_t **array) {
     if (ctx == NULL) {
@@ -182,10 +299,15 @@ int caterva_blosc_from_frame(caterva_context_t *ctx, blosc2_frame *frame, bool c
         return CATERVA_ERR_NULL_POINTER;
     }
     /* Create a caterva_array_t buffer */
-    *array = (caterva_array_t *) ctx->cfg->alloc(sizeof(caterva_array_t));
+    *array = (caterva_array_t *) caterva_malloc(ctx, sizeof(caterva_array_t), CATERVA_ALLOC_ARRAY);
+    CATERVA_ERROR_NULL(*array);
 
-    /* Create a schunk out of the frame */
+    /* Create a schunk out of the frame (traced with a NULL array, as it is not initialized yet) */
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, NULL, -1, &t0);
     blosc2_schunk *sc = blosc2_schunk_from_frame(frame, copy);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, NULL, -1, frame->len, &t0, &stats);
     if (sc == NULL) {
         DEBUG_PRINT("Schunk is null");
         return CATERVA_ERR_NULL_POINTER;
@@ -199,7 +321,7 @@ int caterva_blosc_from_frame(caterva_context_t *ctx, blosc2_frame *frame, bool c
         return CATERVA_ERR_NULL_POINTER;
     }
 
-    (*array)->itemsize = (int8_t) cparams->typesize;
+    (*array)->itemsize = cparams->typesize;
 
     free(cparams);
 
@@ -210,8 +332,53 @@ int caterva_blosc_from_frame(caterva_context_t *ctx, blosc2_frame *frame, bool c
         DEBUG_PRINT("Blosc error");
         return CATERVA_ERR_BLOSC_FAILED;
     }
+    uint8_t *fill_value;
+    uint8_t fill_value_len;
+    caterva_chunk_order_t chunk_order;
     deserialize_meta(smeta, smeta_len, &(*array)->ndim, (*array)->shape, (*array)->chunkshape,
-                     (*array)->blockshape);
+                     (*array)->blockshape, &fill_value, &fill_value_len, &(*array)->predictor,
+                     &(*array)->delta_axis, &(*array)->keyframe_interval, &chunk_order);
+    memset(&(*array)->delta_cache, 0, sizeof(struct delta_cache_s));
+
+    // The error bound (if any) is kept for the chunks appended later
+    (*array)->lossy_mode = CATERVA_LOSSY_NONE;
+    (*array)->lossy_tolerance = 0;
+    (*array)->lossy_bits = 0;
+    if (blosc2_has_metalayer(sc, "caterva_lossy") >= 0) {
+        uint8_t *lmeta;
+        uint32_t lmeta_len;
+        if (blosc2_get_metalayer(sc, "caterva_lossy", &lmeta, &lmeta_len) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        deserialize_lossy_meta(lmeta, &(*array)->lossy_mode, &(*array)->lossy_tolerance,
+                               &(*array)->lossy_bits);
+        free(lmeta);
+    }
+    (*array)->nfields = 0;
+    (*array)->fields = NULL;
+    (*array)->field_arrays = NULL;
+    (*array)->recordsize = 0;
+    (*array)->pyramid_levels = 0;
+    (*array)->pyramid_reduce = CATERVA_PYRAMID_NEAREST;
+    (*array)->pyramid_kind = CATERVA_ITEM_UINT;
+    (*array)->levels = NULL;
+    (*array)->sum_kind = CATERVA_ITEM_UINT;
+    (*array)->block_sums = NULL;
+    (*array)->chunk_sums = NULL;
+    (*array)->indexes_dirty = false;
+    (*array)->bloom_bits = 0;
+    (*array)->blooms = NULL;
+    (*array)->chunk_order = CATERVA_CHUNK_ORDER_C;
+    (*array)->chunk_positions = NULL;
+    (*array)->scattered = false;
+    (*array)->objective = CATERVA_COMPRESSION_FIXED;
+    (*array)->cspeed = 0;
+    (*array)->fill_value = NULL;
+    if (fill_value != NULL && fill_value_len == (*array)->itemsize) {
+        (*array)->fill_value = caterva_malloc(ctx, (size_t) fill_value_len, CATERVA_ALLOC_ARRAY);
+        CATERVA_ERROR_NULL((*array)->fill_value);
+        memcpy((*array)->fill_value, fill_value, fill_value_len);
+    }
     free(smeta);
 
     int64_t *shape = (*array)->shape;
@@ -254,14 +421,60 @@ int caterva_blosc_from_frame(caterva_context_t *ctx, blosc2_frame *frame, bool c
     // The partition cache (empty initially)
     (*array)->chunk_cache.data = NULL;
     (*array)->chunk_cache.nchunk = -1;  // means no valid cache yet
+    memset(&(*array)->stats, 0, sizeof(caterva_stats_t));
 
     (*array)->buf = NULL;
-
-    if (sc->nchunks == (*array)->extnitems / (*array)->chunknitems) {
-        (*array)->filled = true;
+    (*array)->mmap.addr = NULL;
+    memset(&(*array)->append_buffer, 0, sizeof(struct append_buffer_s));
+
+    // The sum index (if any) is read back along with the chunks
+    if (blosc2_has_metalayer(sc, "caterva_sums") >= 0) {
+        uint8_t *smeta_sums;
+        uint32_t smeta_sums_len;
+        if (blosc2_get_metalayer(sc, "caterva_sums", &smeta_sums, &smeta_sums_len) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        int rc = caterva_sums_deserialize(ctx, *array, smeta_sums, smeta_sums_len);
+        free(smeta_sums);
+        CATERVA_ERROR(rc);
+    }
+    if (blosc2_has_metalayer(sc, "caterva_bloom") >= 0) {
+        uint8_t *smeta_bloom;
+        uint32_t smeta_bloom_len;
+        if (blosc2_get_metalayer(sc, "caterva_bloom", &smeta_bloom, &smeta_bloom_len) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        int rc = caterva_bloom_deserialize(ctx, *array, smeta_bloom, smeta_bloom_len);
+        free(smeta_bloom);
+        CATERVA_ERROR(rc);
+    }
+
+    CATERVA_ERROR(caterva_order_new(ctx, *array, chunk_order));
+
+    // With a fill value, the chunks not stored are implicit
+    int64_t nchunks = (*array)->extnitems / (*array)->chunknitems;
+    if ((*array)->fill_value != NULL) {
+        (*array)->nchunks = nchunks;
+    } else if ((*array)->chunk_positions != NULL) {
+        // The chunks are appended in C order, so the ones stored are the first ones
+        int64_t lo = 0;
+        int64_t hi = nchunks;
+        while (lo < hi) {
+            int64_t mid = lo + (hi - lo) / 2;
+            bool stored;
+            CATERVA_ERROR(chunk_stored(*array, mid, &stored));
+            if (stored) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        (*array)->nchunks = lo;
     } else {
-        (*array)->filled = false;
+        (*array)->nchunks = sc->nchunks;
     }
+    (*array)->filled = (*array)->nchunks == nchunks;
+    caterva_stats_merge(ctx, *array, &stats);
 
     return CATERVA_SUCCEED;
 }
@@ -269,7 +482,12 @@ int caterva_blosc_from_frame(caterva_context_t *ctx, blosc2_frame *frame, bool c
 int caterva_blosc_from_sframe(caterva_context_t *ctx, uint8_t *sframe, int64_t len, bool copy,
                               caterva_array_t **array) {
     // Generate a real frame first
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, NULL, -1, &t0);
     blosc2_frame *frame = blosc2_frame_from_sframe(sframe, len, copy);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, NULL, -1, len, &t0, &stats);
+    caterva_stats_merge(ctx, NULL, &stats);
     if (frame == NULL) {
         DEBUG_PRINT("Blosc error");
         return CATERVA_ERR_BLOSC_FAILED;
@@ -287,7 +505,13 @@ int caterva_blosc_from_sframe(caterva_context_t *ctx, uint8_t *sframe, int64_t l
 int caterva_blosc_from_file(caterva_context_t *ctx, const char *filename, bool copy,
                             caterva_array_t **array) {
     // Open the frame on-disk...
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, NULL, -1, &t0);
     blosc2_frame *frame = blosc2_frame_from_file(filename);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, NULL, -1, frame != NULL ? frame->len : 0, &t0,
+                      &stats);
+    caterva_stats_merge(ctx, NULL, &stats);
     if (frame == NULL) {
         DEBUG_PRINT("Blosc error");
         return CATERVA_ERR_BLOSC_FAILED;
@@ -302,8 +526,96 @@ int caterva_blosc_from_file(caterva_context_t *ctx, const char *filename, bool c
     return CATERVA_SUCCEED;
 }
 
+int caterva_blosc_array_to_sframe(caterva_context_t *ctx, caterva_array_t *array,
+                                  uint8_t **sframe, int64_t *len, bool *needs_free) {
+    // An in-memory frame is already serialized (unless its chunks have to be laid out again)
+    blosc2_frame *frame = array->sc->frame;
+    if (frame != NULL && frame->sdata != NULL && !array->scattered) {
+        *sframe = frame->sdata;
+        *len = frame->len;
+        *needs_free = false;
+        return CATERVA_SUCCEED;
+    }
+
+    // The compressed chunks (by position) and the metalayers are copied as they are
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    frame = blosc2_new_frame(NULL);
+    CATERVA_ERROR_NULL(frame);
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, array, -1, &t0);
+    int64_t flen = blosc2_schunk_to_frame(array->sc, frame);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, array, -1, flen, &t0, &stats);
+    caterva_stats_merge(ctx, array, &stats);
+    if (flen < 0) {
+        blosc2_free_frame(frame);
+        DEBUG_PRINT("Error serializing the superchunk");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    *sframe = frame->sdata;
+    *len = flen;
+    *needs_free = true;
+    frame->sdata = NULL;  // owned by the caller now
+    blosc2_free_frame(frame);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_array_save(caterva_context_t *ctx, caterva_array_t *array,
+                             const char *filename) {
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    // The frame is written straight to disk, chunk by chunk (by position)
+    blosc2_frame *frame = blosc2_new_frame((char *) filename);
+    CATERVA_ERROR_NULL(frame);
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, array, -1, &t0);
+    int64_t flen = blosc2_schunk_to_frame(array->sc, frame);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, array, -1, flen, &t0, &stats);
+    caterva_stats_merge(ctx, array, &stats);
+    blosc2_free_frame(frame);
+    if (flen < 0) {
+        DEBUG_PRINT("Error writing the frame");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Write the indexes of an array to their metalayers (only if they have changed, so that reading an
+// array never writes to it)
+int caterva_blosc_array_store_indexes(caterva_context_t *ctx, caterva_array_t *array) {
+    if (array->indexes_dirty) {
+        CATERVA_ERROR(caterva_sums_store(ctx, array));
+        CATERVA_ERROR(caterva_bloom_store(ctx, array));
+        array->indexes_dirty = false;
+    }
+    return CATERVA_SUCCEED;
+}
+
 int caterva_blosc_array_free(caterva_context_t *ctx, caterva_array_t **array) {
-    CATERVA_UNUSED_PARAM(ctx);
+    // The buffered chunks are written before releasing the superchunk
+    int rc = CATERVA_SUCCEED;
+    struct append_buffer_s *buffer = &(*array)->append_buffer;
+    if ((*array)->sc != NULL) {
+        rc = caterva_blosc_array_flush(ctx, *array);
+    }
+    for (int64_t i = 0; i < buffer->nchunks; ++i) {
+        size_t nbytes, cbytes, blocksize;
+        blosc_cbuffer_sizes(buffer->cchunks[i], &nbytes, &cbytes, &blocksize);
+        caterva_free(ctx, buffer->cchunks[i], cbytes, CATERVA_ALLOC_SCRATCH);
+    }
+    if (buffer->cchunks != NULL) {
+        caterva_free(ctx, buffer->cchunks, (size_t) buffer->capacity * sizeof(uint8_t *),
+                     CATERVA_ALLOC_SCRATCH);
+    }
+    caterva_delta_cache_free(ctx, *array);
+    // The indexes of an array backed by a file are kept up to date in it
+    if (rc == CATERVA_SUCCEED && (*array)->sc != NULL && (*array)->sc->frame != NULL &&
+        (*array)->sc->frame->fname != NULL) {
+        rc = caterva_blosc_array_store_indexes(ctx, *array);
+    }
+    caterva_sums_free(ctx, *array);
+    caterva_bloom_free(ctx, *array);
+    caterva_order_free(ctx, *array);
 
     if ((*array)->sc != NULL) {
         if ((*array)->sc->frame != NULL) {
@@ -311,6 +623,7 @@ int caterva_blosc_array_free(caterva_context_t *ctx, caterva_array_t **array) {
         }
         blosc2_free_schunk((*array)->sc);
     }
+    CATERVA_ERROR(rc);
     return CATERVA_SUCCEED;
 }
 
@@ -396,74 +709,407 @@ int caterva_blosc_array_repart_chunk(int8_t *rchunk, int64_t rchunksize, void *c
     return CATERVA_SUCCEED;
 }
 
-int caterva_blosc_array_append(caterva_context_t *ctx, caterva_array_t *array, void *chunk,
-                               int32_t chunksize) {
-    CATERVA_UNUSED_PARAM(ctx);
+// Build a uniform chunk (a special chunk of the whole chunk size that only holds the value of all
+// its items) into cchunk, which must hold a header and an item. Returns its size or a negative
+// value on error.
+int caterva_blosc_uniform_cchunk(caterva_array_t *array, const uint8_t *value, uint8_t *cchunk) {
+    blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+    cparams.typesize = array->itemsize;
+    return blosc2_chunk_repeatval(cparams, (int32_t) (array->extchunknitems * array->itemsize),
+                                  cchunk, BLOSC_EXTENDED_HEADER_LENGTH + array->itemsize, value);
+}
 
-    uint8_t *bchunk = (uint8_t *) chunk;
-    int64_t typesize = array->itemsize;
-    int32_t size_rep = (int32_t)(array->extchunknitems * typesize);
-    int8_t *rchunk = ctx->cfg->alloc((size_t) size_rep);
-    int32_t c_pshape[CATERVA_MAX_DIM];
-    int8_t c_ndim = array->ndim;
+// Check whether a compressed chunk is a special one of the given type (BLOSC2_SPECIAL_VALUE for the
+// uniform chunks and BLOSC2_SPECIAL_UNINIT for the chunks not written yet)
+static bool cchunk_special(const uint8_t *cchunk, int special) {
+    return ((cchunk[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK) == special;
+}
 
-    bool padding = false;
-    int32_t size_chunk = array->chunknitems * array->itemsize;
-    if (chunksize != size_chunk) {
-        padding = true;
-    }
-
-    if (padding) {
-        uint8_t *paddedchunk = ctx->cfg->alloc(size_chunk);
-        memset(paddedchunk, 0, size_chunk);
-        int32_t next_pshape[CATERVA_MAX_DIM];
-        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-            next_pshape[(CATERVA_MAX_DIM - c_ndim + i) % CATERVA_MAX_DIM] =
-                array->next_chunkshape[i];
-            c_pshape[(CATERVA_MAX_DIM - c_ndim + i) % CATERVA_MAX_DIM] = array->chunkshape[i];
-        }
-        int32_t seq_copylen = next_pshape[7] * array->itemsize;
-        bool blank;
-        int32_t ii[CATERVA_MAX_DIM];
-        int ind_src = 0;
-        int ind_dest = 0;
-        for (ii[0] = 0; ii[0] < c_pshape[0]; ii[0]++) {
-            for (ii[1] = 0; ii[1] < c_pshape[1]; ii[1]++) {
-                for (ii[2] = 0; ii[2] < c_pshape[2]; ii[2]++) {
-                    for (ii[3] = 0; ii[3] < c_pshape[3]; ii[3]++) {
-                        for (ii[4] = 0; ii[4] < c_pshape[4]; ii[4]++) {
-                            for (ii[5] = 0; ii[5] < c_pshape[5]; ii[5]++) {
-                                for (ii[6] = 0; ii[6] < c_pshape[6]; ii[6]++) {
-                                    // Calculate if line is full of 0s
-                                    blank = false;
-                                    for (int i = 0; i < CATERVA_MAX_DIM - 1; i++) {
-                                        if (ii[i] >= next_pshape[i]) {
-                                            blank = true;
-                                            break;
-                                        }
-                                    }
-                                    if (!blank) {
-                                        memcpy(paddedchunk + ind_dest * array->itemsize,
-                                               bchunk + ind_src * array->itemsize, seq_copylen);
-                                        ind_src += next_pshape[7];
-                                    }
-                                    ind_dest += c_pshape[7];
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+// Fill the superchunk up to position with placeholders of the whole chunk size (a uniform chunk of
+// the fill value, or an uninitialized chunk for the chunks not written yet along a curve)
+static int append_placeholders(caterva_array_t *array, int64_t position, caterva_stats_t *stats) {
+    if (array->sc->nchunks >= position) {
+        return CATERVA_SUCCEED;
+    }
+    if (array->fill_value == NULL && array->chunk_positions == NULL) {
+        DEBUG_PRINT("Chunks can only be skipped in arrays with a fill value");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    uint8_t placeholder[CATERVA_UNIFORM_CCHUNK_SIZE];
+    int csize;
+    if (array->fill_value != NULL) {
+        csize = caterva_blosc_uniform_cchunk(array, array->fill_value, placeholder);
+    } else {
+        blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+        cparams.typesize = array->itemsize;
+        csize = blosc2_chunk_uninit(cparams, (int32_t) (array->extchunknitems * array->itemsize),
+                                    placeholder, sizeof(placeholder));
+    }
+    if (csize <= 0) {
+        DEBUG_PRINT("Error building a placeholder chunk");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    while (array->sc->nchunks < position) {
+        if (blosc2_schunk_append_chunk(array->sc, placeholder, true) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
         }
-        caterva_blosc_array_repart_chunk(rchunk, size_rep, paddedchunk, size_chunk, array);
-        ctx->cfg->free(paddedchunk);
+        stats->bytes_written += csize;
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Store a compressed chunk in the position of the chunk nchunk in the superchunk
+static int store_cchunk(caterva_array_t *array, int64_t nchunk, uint8_t *cchunk,
+                        caterva_stats_t *stats) {
+    int64_t position = caterva_chunk_position(array, nchunk);
+    int rc = append_placeholders(array, position, stats);
+    if (rc != CATERVA_SUCCEED) {
+        return rc;
+    }
+    if (position < array->sc->nchunks) {
+        // The chunk written again goes to the end of a frame
+        array->scattered = array->scattered || array->sc->frame != NULL;
+        rc = blosc2_schunk_update_chunk(array->sc, (int) position, cchunk, true);
     } else {
-        caterva_blosc_array_repart_chunk(rchunk, size_rep, bchunk, chunksize, array);
+        rc = blosc2_schunk_append_chunk(array->sc, cchunk, true);
     }
-    if (blosc2_schunk_append_buffer(array->sc, rchunk, (size_t) size_rep) < 0) {
+    return rc < 0 ? CATERVA_ERR_BLOSC_FAILED : CATERVA_SUCCEED;
+}
+
+// Check whether the chunk nchunk of an array is stored in its superchunk (and it is not the
+// placeholder of a chunk not written yet)
+static int chunk_stored(caterva_array_t *array, int64_t nchunk, bool *stored) {
+    int64_t position = caterva_chunk_position(array, nchunk);
+    *stored = false;
+    if (position >= array->sc->nchunks) {
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *cchunk;
+    bool needs_free;
+    if (blosc2_schunk_get_chunk(array->sc, (int) position, &cchunk, &needs_free) < 0) {
         CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
     }
-    ctx->cfg->free(rchunk);
+    *stored = !cchunk_special(cchunk, BLOSC2_SPECIAL_UNINIT);
+    if (needs_free) {
+        free(cchunk);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Update the write speed of an array after nbytes have been written in elapsed seconds and move the
+// compression level of its superchunk one step towards the target speed of the context
+static int adapt_clevel(caterva_context_t *ctx, caterva_array_t *array, int64_t nbytes,
+                        double elapsed, bool *changed) {
+    *changed = false;
+    if (ctx->cfg->target_speed <= 0 || elapsed <= 0) {
+        return CATERVA_SUCCEED;
+    }
+    // The speed is smoothed so that a single slow chunk does not move the level
+    double speed = (double) nbytes / elapsed / (1024 * 1024);
+    array->cspeed = array->cspeed == 0 ? speed : (array->cspeed + speed) / 2;
+
+    blosc2_schunk *sc = array->sc;
+    int clevel = sc->clevel;
+    if (array->cspeed < ctx->cfg->target_speed && clevel > 1) {
+        clevel--;
+    } else if (array->cspeed > 2 * ctx->cfg->target_speed && clevel < 9) {
+        clevel++;
+    }
+    if (clevel == sc->clevel) {
+        return CATERVA_SUCCEED;
+    }
+
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(sc, &cparams) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    cparams->clevel = (uint8_t) clevel;
+    // The prefilter is not part of the parameters of the superchunk
+    cparams->prefilter = ctx->cfg->prefilter;
+    cparams->pparams = ctx->cfg->pparams;
+    sc->clevel = (uint8_t) clevel;
+    blosc2_free_ctx(sc->cctx);
+    sc->cctx = blosc2_create_cctx(*cparams);
+    free(cparams);
+    CATERVA_ERROR_NULL(sc->cctx);
+    // The speed of the new level is measured from scratch
+    array->cspeed = 0;
+    *changed = true;
+    return CATERVA_SUCCEED;
+}
+
+// Compress a chunk (in block layout) and store it in the position nchunk of the superchunk
+static int write_rchunk(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                        int8_t *rchunk, int32_t rchunksize, caterva_stats_t *stats) {
+    blosc_timestamp_t t0;
+    bool predicted = false;
+    blosc_timestamp_t start, end;
+    blosc_set_timestamp(&start);
+    // The first chunk chooses the codec and filters (out of its predicted blocks) in the automatic
+    // compression mode
+    if (array->objective != CATERVA_COMPRESSION_FIXED) {
+        CATERVA_ERROR(caterva_blosc_encode_rchunk(ctx, array, nchunk, (uint8_t *) rchunk, stats));
+        predicted = true;
+        CATERVA_ERROR(caterva_blosc_select_cparams(ctx, array, (uint8_t *) rchunk));
+    }
+    size_t cchunksize = (size_t) rchunksize + BLOSC_MAX_OVERHEAD;
+    uint8_t *cchunk = caterva_malloc(ctx, cchunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR_NULL(cchunk);
+
+    caterva_stage_begin(ctx, CATERVA_STAGE_COMPRESS, array, nchunk, &t0);
+    int csize = 0;
+    if (!predicted) {
+        csize = caterva_blosc_encode_rchunk(ctx, array, nchunk, (uint8_t *) rchunk, stats) ==
+                        CATERVA_SUCCEED ? 0 : -1;
+    }
+    if (csize == 0) {
+        csize = blosc2_compress_ctx(array->sc->cctx, (size_t) rchunksize, rchunk, cchunk,
+                                    cchunksize);
+    }
+    caterva_stage_end(ctx, CATERVA_STAGE_COMPRESS, array, nchunk, rchunksize, &t0, stats);
+    if (csize <= 0) {
+        caterva_free(ctx, cchunk, cchunksize, CATERVA_ALLOC_CHUNK);
+        DEBUG_PRINT("Error compressing a chunk");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, array, nchunk, &t0);
+    int rc = store_cchunk(array, nchunk, cchunk, stats);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, array, nchunk, csize, &t0, stats);
+    caterva_free(ctx, cchunk, cchunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR(rc);
+    blosc_set_timestamp(&end);
+
+    stats->nchunks_compressed++;
+    stats->bytes_compressed += rchunksize;
+    stats->bytes_written += csize;
+
+    bool changed;
+    CATERVA_ERROR(adapt_clevel(ctx, array, rchunksize, blosc_elapsed_secs(start, end), &changed));
+    return CATERVA_SUCCEED;
+}
+
+// Store a chunk whose items are all equal as a uniform chunk (neither predicted nor stored as a
+// delta)
+static int write_uniform(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                         const uint8_t *value, caterva_stats_t *stats) {
+    blosc_timestamp_t t0;
+    uint8_t cchunk[CATERVA_UNIFORM_CCHUNK_SIZE];
+    int csize = caterva_blosc_uniform_cchunk(array, value, cchunk);
+    if (csize <= 0) {
+        DEBUG_PRINT("Error building a uniform chunk");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, array, nchunk, &t0);
+    int rc = store_cchunk(array, nchunk, cchunk, stats);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, array, nchunk, csize, &t0, stats);
+    CATERVA_ERROR(rc);
+    stats->bytes_written += csize;
+    caterva_sums_uniform(array, nchunk, value);
+    caterva_bloom_uniform(array, nchunk, value);
+    stats->nchunks_uniform_written++;
+    return CATERVA_SUCCEED;
+}
+
+// Read a chunk and decompress the blocks not masked out as they are stored (undoing the predictor
+// only if unpredict is set)
+static int read_stored_chunk(caterva_context_t *ctx, caterva_array_t *array,
+                             blosc2_context *dctx, int64_t nchunk, bool *maskout, uint8_t *dest,
+                             size_t destsize, uint8_t *value, bool *uniform, bool unpredict,
+                             caterva_stats_t *stats) {
+    blosc_timestamp_t t0;
+    uint8_t *cchunk;
+    bool needs_free;
+
+    // The chunks past the stored ones are implicitly filled with the fill value
+    int64_t position = caterva_chunk_position(array, nchunk);
+    if (array->fill_value != NULL && position >= array->sc->nchunks) {
+        memcpy(value, array->fill_value, (size_t) array->itemsize);
+        *uniform = true;
+        stats->nchunks_uniform_read++;
+        return CATERVA_SUCCEED;
+    }
+
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, array, nchunk, &t0);
+    int csize = blosc2_schunk_get_chunk(array->sc, (int) position, &cchunk, &needs_free);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, array, nchunk, csize, &t0, stats);
+    if (csize < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    stats->bytes_read += csize;
+
+    // An uninitialized placeholder stands for a chunk that has not been written yet
+    if (cchunk_special(cchunk, BLOSC2_SPECIAL_UNINIT)) {
+        if (needs_free) {
+            free(cchunk);
+        }
+        DEBUG_PRINT("The chunk has not been written yet");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    // A uniform chunk only holds its value
+    *uniform = cchunk_special(cchunk, BLOSC2_SPECIAL_VALUE);
+    if (*uniform) {
+        caterva_stage_begin(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, &t0);
+        int rc = blosc2_getitem_ctx(dctx, cchunk, 0, 1, value);
+        caterva_stage_end(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, array->itemsize, &t0,
+                          stats);
+        if (needs_free) {
+            free(cchunk);
+        }
+        if (rc < 0) {
+            DEBUG_PRINT("Error getting the value of a uniform chunk");
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+        stats->nchunks_uniform_read++;
+        return CATERVA_SUCCEED;
+    }
+
+    int nblocks = (int) (array->extchunknitems / array->blocknitems);
+    int nblocks_read = nblocks;
+    if (maskout != NULL) {
+        caterva_stage_begin(ctx, CATERVA_STAGE_SETUP, array, nchunk, &t0);
+        nblocks_read = 0;
+        for (int nblock = 0; nblock < nblocks; ++nblock) {
+            nblocks_read += !maskout[nblock];
+        }
+        blosc2_set_maskout(dctx, maskout, nblocks);
+        caterva_stage_end(ctx, CATERVA_STAGE_SETUP, array, nchunk, 0, &t0, stats);
+    }
+
+    int64_t dbytes = (int64_t) nblocks_read * array->blocknitems * array->itemsize;
+    caterva_stage_begin(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, &t0);
+    int dsize = blosc2_decompress_ctx(dctx, cchunk, dest, destsize);
+    if (dsize >= 0 && unpredict) {
+        caterva_predictor_decode(array, dest, maskout);
+    }
+    caterva_stage_end(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, dbytes, &t0, stats);
+    if (needs_free) {
+        free(cchunk);
+    }
+    if (dsize < 0) {
+        DEBUG_PRINT("Error decompressing a chunk");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+
+    stats->nchunks_decompressed++;
+    stats->nblocks_decompressed += nblocks_read;
+    stats->bytes_decompressed += dbytes;
+    return CATERVA_SUCCEED;
+}
+
+// Read the blocks not masked out of a chunk stored as a delta, before the predictor is undone. The
+// deltas are undone out of the previous chunks up to a keyframe (or a cached chunk).
+static int read_delta_chunk(caterva_context_t *ctx, caterva_array_t *array, blosc2_context *dctx,
+                            int64_t nchunk, bool *maskout, uint8_t *dest, size_t destsize,
+                            uint8_t *value, bool *uniform, caterva_stats_t *stats) {
+    if (maskout == NULL && caterva_delta_cache_get(array, nchunk, dest)) {
+        *uniform = false;
+        return CATERVA_SUCCEED;
+    }
+    CATERVA_ERROR(read_stored_chunk(ctx, array, dctx, nchunk, maskout, dest, destsize, value,
+                                    uniform, false, stats));
+    // The uniform chunks are not stored as deltas
+    int64_t reference = caterva_delta_reference(array, nchunk);
+    if (*uniform || reference < 0) {
+        return CATERVA_SUCCEED;
+    }
+
+    size_t rchunksize = (size_t) array->extchunknitems * array->itemsize;
+    uint8_t *rchunk = caterva_malloc(ctx, rchunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR_NULL(rchunk);
+    uint8_t rvalue[CATERVA_MAX_ITEMSIZE];
+    bool runiform = false;
+    int rc = CATERVA_SUCCEED;
+    if (!caterva_delta_cache_get(array, reference, rchunk)) {
+        rc = read_delta_chunk(ctx, array, dctx, reference, maskout, rchunk, rchunksize, rvalue,
+                              &runiform, stats);
+    }
+    if (rc == CATERVA_SUCCEED) {
+        if (runiform) {
+            caterva_fill_buffer(rchunk, array->extchunknitems, array->itemsize, rvalue);
+            caterva_predictor_encode(array, rchunk);
+        }
+        caterva_delta_xor(array, dest, rchunk, maskout);
+        if (maskout == NULL) {
+            rc = caterva_delta_cache_put(ctx, array, nchunk, dest);
+        }
+    }
+    caterva_free(ctx, rchunk, rchunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+// Read a chunk and decompress the blocks not masked out (all if maskout is NULL) into dest. If the
+// chunk is uniform, only its value is read into value (and dest is left untouched).
+int caterva_blosc_read_chunk(caterva_context_t *ctx, caterva_array_t *array,
+                             blosc2_context *dctx, int64_t nchunk, bool *maskout, uint8_t *dest,
+                             size_t destsize, uint8_t *value, bool *uniform,
+                             caterva_stats_t *stats) {
+    if (array->keyframe_interval == 0) {
+        return read_stored_chunk(ctx, array, dctx, nchunk, maskout, dest, destsize, value, uniform,
+                                 true, stats);
+    }
+    CATERVA_ERROR(read_delta_chunk(ctx, array, dctx, nchunk, maskout, dest, destsize, value,
+                                   uniform, stats));
+    if (!*uniform) {
+        blosc_timestamp_t t0;
+        caterva_stage_begin(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, &t0);
+        caterva_predictor_decode(array, dest, maskout);
+        caterva_stage_end(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, 0, &t0, stats);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Round (within the error bound) and predict a whole chunk (in block layout) that is about to be
+// compressed in the position nchunk and, if the chunks are stored as deltas, XOR it with the chunk
+// it is a delta of
+int caterva_blosc_encode_rchunk(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                                uint8_t *rchunk, caterva_stats_t *stats) {
+    caterva_lossy_round(array, rchunk);
+    // The sums and filters are those of the items as they will be read back
+    caterva_sums_rchunk(array, nchunk, rchunk);
+    caterva_bloom_rchunk(array, nchunk, rchunk);
+    caterva_predictor_encode(array, rchunk);
+    if (array->keyframe_interval == 0) {
+        return CATERVA_SUCCEED;
+    }
+    // The chunk is kept (before the XOR) for the next chunk along the axis
+    CATERVA_ERROR(caterva_delta_cache_put(ctx, array, nchunk, rchunk));
+    int64_t reference = caterva_delta_reference(array, nchunk);
+    if (reference < 0) {
+        return CATERVA_SUCCEED;
+    }
+
+    size_t rchunksize = (size_t) array->extchunknitems * array->itemsize;
+    uint8_t *rchunk_ref = caterva_malloc(ctx, rchunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR_NULL(rchunk_ref);
+    uint8_t value[CATERVA_MAX_ITEMSIZE];
+    bool uniform = false;
+    int rc = CATERVA_SUCCEED;
+    if (!caterva_delta_cache_get(array, reference, rchunk_ref)) {
+        // The reference may still be waiting in the append buffer
+        rc = caterva_blosc_array_flush(ctx, array);
+        if (rc == CATERVA_SUCCEED) {
+            rc = read_delta_chunk(ctx, array, array->sc->dctx, reference, NULL, rchunk_ref,
+                                  rchunksize, value, &uniform, stats);
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        if (uniform) {
+            caterva_fill_buffer(rchunk_ref, array->extchunknitems, array->itemsize, value);
+            caterva_predictor_encode(array, rchunk_ref);
+        }
+        caterva_delta_xor(array, rchunk, rchunk_ref, NULL);
+    }
+    caterva_free(ctx, rchunk_ref, rchunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+// Update next_chunkshape and next_chunknitems after appending a chunk
+static int update_next_chunkshape(caterva_array_t *array) {
+    int8_t c_ndim = array->ndim;
+    int32_t c_pshape[CATERVA_MAX_DIM];
     // Calculate chunk position in each dimension
     int64_t c_shape[CATERVA_MAX_DIM];
     int64_t c_eshape[CATERVA_MAX_DIM];
@@ -502,6 +1148,448 @@ int caterva_blosc_array_append(caterva_context_t *ctx, caterva_array_t *array, v
     return CATERVA_SUCCEED;
 }
 
+// The shape of the chunk nchunk (smaller than chunkshape on the edges). Returns its nitems.
+int64_t caterva_blosc_chunk_shape(caterva_array_t *array, int64_t nchunk, int64_t *cshape) {
+    int64_t cnitems = 1;
+    int64_t rem = nchunk;
+    for (int i = array->ndim - 1; i >= 0; --i) {
+        int64_t grid = array->extshape[i] / array->chunkshape[i];
+        int64_t origin = rem % grid * array->chunkshape[i];
+        rem /= grid;
+        cshape[i] = array->shape[i] - origin < array->chunkshape[i] ? array->shape[i] - origin
+                                                                    : array->chunkshape[i];
+        cnitems *= cshape[i];
+    }
+    return cnitems;
+}
+
+// The shape of a chunk of chunksize bytes given for the position nchunk, which is either its own
+// shape or the whole chunkshape (already padded). Returns its nitems.
+static int64_t get_input_shape(caterva_array_t *array, int64_t nchunk, int64_t chunksize,
+                               int64_t *cshape) {
+    if (chunksize == (int64_t) array->chunknitems * array->itemsize) {
+        for (int i = 0; i < array->ndim; ++i) {
+            cshape[i] = array->chunkshape[i];
+        }
+        return array->chunknitems;
+    }
+    return caterva_blosc_chunk_shape(array, nchunk, cshape);
+}
+
+// Rearrange a chunk of shape cshape into rchunk (in block layout). The chunks on the edges are
+// padded into padded first.
+static void repart_edge_chunk(caterva_context_t *ctx, caterva_array_t *array,
+                              const uint8_t *chunk, const int64_t *cshape, int64_t cnitems,
+                              uint8_t *padded, int8_t *rchunk) {
+    int64_t chunksize = array->chunknitems * array->itemsize;
+    int64_t rchunksize = array->extchunknitems * array->itemsize;
+    if (cnitems == array->chunknitems) {
+        caterva_blosc_array_repart_chunk(rchunk, rchunksize, (void *) chunk, chunksize, array);
+        return;
+    }
+    int64_t pshape[CATERVA_MAX_DIM];
+    int64_t zeros[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < array->ndim; ++i) {
+        pshape[i] = array->chunkshape[i];
+    }
+    memset(padded, 0, (size_t) chunksize);
+    caterva_copy_region(ctx, array->ndim, array->itemsize, cshape, chunk, cshape, zeros, padded,
+                        pshape, zeros);
+    caterva_blosc_array_repart_chunk(rchunk, rchunksize, padded, chunksize, array);
+}
+
+// Pad, rearrange and compress the chunk nchunk into cchunk (a chunk whose items are all equal is
+// stored as a uniform chunk). Returns the compressed size or a negative value on error.
+static int compress_chunk(caterva_context_t *ctx, caterva_array_t *array, blosc2_context *cctx,
+                          int64_t nchunk, const uint8_t *chunk, int64_t chunksize,
+                          uint8_t *padded, int8_t *rchunk, uint8_t *cchunk,
+                          caterva_stats_t *stats) {
+    blosc_timestamp_t t0;
+    int32_t typesize = array->itemsize;
+    size_t rchunksize = (size_t) array->extchunknitems * typesize;
+    int64_t cshape[CATERVA_MAX_DIM];
+    int64_t cnitems = get_input_shape(array, nchunk, chunksize, cshape);
+
+    // A prefilter may compute the chunk out of anything, so its input is never deemed uniform
+    if (ctx->cfg->prefilter == NULL && caterva_is_uniform(chunk, cnitems, typesize)) {
+        stats->nchunks_uniform_written++;
+        caterva_sums_uniform(array, nchunk, chunk);
+        caterva_bloom_uniform(array, nchunk, chunk);
+        return caterva_blosc_uniform_cchunk(array, chunk, cchunk);
+    }
+    caterva_stage_begin(ctx, CATERVA_STAGE_REPART, array, nchunk, &t0);
+    repart_edge_chunk(ctx, array, chunk, cshape, cnitems, padded, rchunk);
+    caterva_stage_end(ctx, CATERVA_STAGE_REPART, array, nchunk, (int64_t) rchunksize, &t0, stats);
+
+    caterva_stage_begin(ctx, CATERVA_STAGE_COMPRESS, array, nchunk, &t0);
+    if (caterva_blosc_encode_rchunk(ctx, array, nchunk, (uint8_t *) rchunk, stats) !=
+        CATERVA_SUCCEED) {
+        caterva_stage_end(ctx, CATERVA_STAGE_COMPRESS, array, nchunk, 0, &t0, stats);
+        return -1;
+    }
+    int csize = blosc2_compress_ctx(cctx, rchunksize, rchunk, cchunk,
+                                    rchunksize + BLOSC_MAX_OVERHEAD);
+    caterva_stage_end(ctx, CATERVA_STAGE_COMPRESS, array, nchunk, (int64_t) rchunksize, &t0,
+                      stats);
+    if (csize > 0) {
+        stats->nchunks_compressed++;
+        stats->bytes_compressed += (int64_t) rchunksize;
+    }
+    return csize;
+}
+
+// Keep a copy of a compressed chunk in the append buffer of the array
+static int buffer_cchunk(caterva_context_t *ctx, caterva_array_t *array, const uint8_t *cchunk,
+                         int csize) {
+    struct append_buffer_s *buffer = &array->append_buffer;
+    if (buffer->nchunks == buffer->capacity) {
+        int64_t capacity = buffer->capacity == 0 ? 16 : 2 * buffer->capacity;
+        uint8_t **cchunks = caterva_malloc(ctx, (size_t) capacity * sizeof(uint8_t *),
+                                           CATERVA_ALLOC_SCRATCH);
+        CATERVA_ERROR_NULL(cchunks);
+        if (buffer->cchunks != NULL) {
+            memcpy(cchunks, buffer->cchunks, (size_t) buffer->nchunks * sizeof(uint8_t *));
+            caterva_free(ctx, buffer->cchunks, (size_t) buffer->capacity * sizeof(uint8_t *),
+                         CATERVA_ALLOC_SCRATCH);
+        }
+        buffer->cchunks = cchunks;
+        buffer->capacity = capacity;
+    }
+    uint8_t *copy = caterva_malloc(ctx, (size_t) csize, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(copy);
+    memcpy(copy, cchunk, (size_t) csize);
+    buffer->cchunks[buffer->nchunks++] = copy;
+    buffer->nbytes += csize;
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_array_flush(caterva_context_t *ctx, caterva_array_t *array) {
+    struct append_buffer_s *buffer = &array->append_buffer;
+    if (buffer->nchunks == 0) {
+        return CATERVA_SUCCEED;
+    }
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    int rc = CATERVA_SUCCEED;
+    int64_t nflushed = 0;
+    int64_t nbytes = 0;
+
+    // The buffered chunks are the last ones appended
+    int64_t first = array->nchunks - buffer->nchunks;
+
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, array, -1, &t0);
+    for (; nflushed < buffer->nchunks; ++nflushed) {
+        uint8_t *cchunk = buffer->cchunks[nflushed];
+        size_t cnbytes, cbytes, blocksize;
+        blosc_cbuffer_sizes(cchunk, &cnbytes, &cbytes, &blocksize);
+        rc = store_cchunk(array, first + nflushed, cchunk, &stats);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        caterva_free(ctx, cchunk, cbytes, CATERVA_ALLOC_SCRATCH);
+        nbytes += (int64_t) cbytes;
+    }
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, array, -1, nbytes, &t0, &stats);
+    stats.bytes_written += nbytes;
+    caterva_stats_merge(ctx, array, &stats);
+
+    // The chunks not written are kept for the next flush
+    memmove(buffer->cchunks, buffer->cchunks + nflushed,
+            (size_t) (buffer->nchunks - nflushed) * sizeof(uint8_t *));
+    buffer->nchunks -= nflushed;
+    buffer->nbytes -= nbytes;
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+// Create the (single-threaded) compression contexts of the workers that append chunks. A single
+// worker uses the context of the superchunk.
+static int create_worker_cctxs(caterva_array_t *array, blosc2_context **cctx, int64_t nworkers) {
+    if (nworkers == 1) {
+        cctx[0] = array->sc->cctx;
+        return CATERVA_SUCCEED;
+    }
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(array->sc, &cparams) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    cparams->nthreads = 1;
+    int rc = CATERVA_SUCCEED;
+    for (int64_t w = 0; w < nworkers; ++w) {
+        cctx[w] = blosc2_create_cctx(*cparams);
+        if (cctx[w] == NULL) {
+            rc = CATERVA_ERR_BLOSC_FAILED;
+        }
+    }
+    free(cparams);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+// Release the contexts created by create_worker_cctxs() (the ones not created are NULL)
+static void free_worker_cctxs(blosc2_context **cctx, int64_t nworkers) {
+    if (nworkers > 1) {
+        for (int64_t w = 0; w < nworkers; ++w) {
+            if (cctx[w] != NULL) {
+                blosc2_free_ctx(cctx[w]);
+                cctx[w] = NULL;
+            }
+        }
+    }
+}
+
+int caterva_blosc_array_append_many(caterva_context_t *ctx, caterva_array_t *array, void **chunks,
+                                    int64_t *chunksizes, int64_t nchunks) {
+    // Check the sizes of all the chunks before appending anything. Each chunk has either its own
+    // shape (smaller on the edges) or the whole chunkshape (padded).
+    for (int64_t i = 0; i < nchunks; ++i) {
+        int64_t cshape[CATERVA_MAX_DIM];
+        int64_t cnitems = caterva_blosc_chunk_shape(array, array->nchunks + i, cshape);
+        CATERVA_ERROR_NULL(chunks[i]);
+        if (chunksizes[i] != cnitems * array->itemsize &&
+            chunksizes[i] != (int64_t) array->chunknitems * array->itemsize) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+    }
+
+    // Without OpenMP the chunks are compressed one by one with the (multi-threaded) context of the
+    // superchunk, which is also the only one that runs the prefilter. The deltas depend on the
+    // previous chunks, so they are compressed one by one too.
+#if defined(_OPENMP)
+    int64_t nworkers = ctx->cfg->prefilter == NULL && array->keyframe_interval == 0
+                           ? ctx->cfg->nthreads : 1;
+#else
+    int64_t nworkers = 1;
+#endif
+    if (nworkers > nchunks) {
+        nworkers = nchunks;
+    }
+    if (nworkers < 1) {
+        nworkers = 1;
+    }
+
+    size_t chunksize = (size_t) array->chunknitems * array->itemsize;
+    size_t rchunksize = (size_t) array->extchunknitems * array->itemsize;
+    size_t workersize = chunksize + rchunksize + rchunksize + BLOSC_MAX_OVERHEAD;
+    uint8_t *scratch = caterva_malloc(ctx, (size_t) nworkers * workersize, CATERVA_ALLOC_CHUNK);
+    blosc2_context **cctx = caterva_malloc(ctx, (size_t) nworkers * sizeof(blosc2_context *),
+                                           CATERVA_ALLOC_SCRATCH);
+    int *csizes = caterva_malloc(ctx, (size_t) nworkers * sizeof(int), CATERVA_ALLOC_SCRATCH);
+    int rc = CATERVA_SUCCEED;
+    if (scratch == NULL || cctx == NULL || csizes == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    } else {
+        memset(cctx, 0, (size_t) nworkers * sizeof(blosc2_context *));
+    }
+
+    // In the automatic compression mode, the first chunk that is not uniform chooses the codec
+    // and filters before any chunk is compressed
+    for (int64_t i = 0; i < nchunks && rc == CATERVA_SUCCEED &&
+                        array->objective != CATERVA_COMPRESSION_FIXED; ++i) {
+        int64_t cshape[CATERVA_MAX_DIM];
+        int64_t cnitems = get_input_shape(array, array->nchunks + i, chunksizes[i], cshape);
+        if (caterva_is_uniform(chunks[i], cnitems, array->itemsize)) {
+            continue;
+        }
+        repart_edge_chunk(ctx, array, chunks[i], cshape, cnitems, scratch,
+                          (int8_t *) (scratch + chunksize));
+        caterva_lossy_round(array, scratch + chunksize);
+        caterva_predictor_encode(array, scratch + chunksize);
+        rc = caterva_blosc_select_cparams(ctx, array, scratch + chunksize);
+    }
+
+    if (rc == CATERVA_SUCCEED) {
+        rc = create_worker_cctxs(array, cctx, nworkers);
+    }
+
+    for (int64_t first = 0; first < nchunks && rc == CATERVA_SUCCEED; first += nworkers) {
+        int64_t nbatch = nchunks - first < nworkers ? nchunks - first : nworkers;
+        blosc_timestamp_t start, end;
+        blosc_set_timestamp(&start);
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nbatch) if (nbatch > 1)
+#endif
+        for (int64_t i = 0; i < nbatch; ++i) {
+            caterva_stats_t stats = {0};
+            uint8_t *padded = scratch + i * workersize;
+            int8_t *rchunk = (int8_t *) (padded + chunksize);
+            uint8_t *cchunk = padded + chunksize + rchunksize;
+            csizes[i] = compress_chunk(ctx, array, cctx[i], array->nchunks + i,
+                                       chunks[first + i], chunksizes[first + i], padded, rchunk,
+                                       cchunk, &stats);
+            caterva_stats_merge(ctx, array, &stats);
+        }
+        // The chunks are buffered in order
+        for (int64_t i = 0; i < nbatch; ++i) {
+            if (csizes[i] <= 0) {
+                DEBUG_PRINT("Error compressing a chunk");
+                rc = CATERVA_ERR_BLOSC_FAILED;
+                break;
+            }
+            rc = buffer_cchunk(ctx, array, scratch + i * workersize + chunksize + rchunksize,
+                               csizes[i]);
+            if (rc != CATERVA_SUCCEED) {
+                break;
+            }
+            update_next_chunkshape(array);
+            array->nchunks++;
+        }
+        if (rc == CATERVA_SUCCEED &&
+            array->append_buffer.nbytes >= ctx->cfg->append_buffersize) {
+            rc = caterva_blosc_array_flush(ctx, array);
+        }
+        blosc_set_timestamp(&end);
+
+        // The speed is the one the chunks are taken in at, so the uniform ones count too
+        int64_t nbytes = 0;
+        for (int64_t i = 0; i < nbatch; ++i) {
+            nbytes += chunksizes[first + i];
+        }
+        bool changed = false;
+        if (rc == CATERVA_SUCCEED) {
+            rc = adapt_clevel(ctx, array, nbytes, blosc_elapsed_secs(start, end), &changed);
+        }
+        if (rc == CATERVA_SUCCEED && changed) {
+            free_worker_cctxs(cctx, nworkers);
+            rc = create_worker_cctxs(array, cctx, nworkers);
+        }
+    }
+    if (rc == CATERVA_SUCCEED && ctx->cfg->flush_policy == CATERVA_FLUSH_ON_APPEND) {
+        rc = caterva_blosc_array_flush(ctx, array);
+    }
+
+    if (cctx != NULL) {
+        free_worker_cctxs(cctx, nworkers);
+    }
+    caterva_free(ctx, scratch, (size_t) nworkers * workersize, CATERVA_ALLOC_CHUNK);
+    caterva_free(ctx, cctx, (size_t) nworkers * sizeof(blosc2_context *), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, csizes, (size_t) nworkers * sizeof(int), CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_array_append_cchunk(caterva_context_t *ctx, caterva_array_t *array,
+                                      uint8_t *cchunk) {
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+
+    // The buffered chunks go first
+    CATERVA_ERROR(caterva_blosc_array_flush(ctx, array));
+
+    size_t nbytes, cbytes, blocksize;
+    blosc_cbuffer_sizes(cchunk, &nbytes, &cbytes, &blocksize);
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, array, array->nchunks, &t0);
+    int rc = store_cchunk(array, array->nchunks, cchunk, &stats);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, array, array->nchunks, (int64_t) cbytes, &t0,
+                      &stats);
+    CATERVA_ERROR(rc);
+    stats.bytes_written += (int64_t) cbytes;
+    caterva_stats_merge(ctx, array, &stats);
+
+    CATERVA_ERROR(update_next_chunkshape(array));
+    return CATERVA_SUCCEED;
+}
+
+// Record the sums and the filters of a compressed chunk passed through from another array (with
+// the same predictor) as the chunk nchunk of an array
+int caterva_blosc_index_cchunk(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                               const uint8_t *cchunk) {
+    if (array->block_sums == NULL && array->blooms == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    int rc = CATERVA_SUCCEED;
+    if (cchunk_special(cchunk, BLOSC2_SPECIAL_VALUE)) {
+        uint8_t value[CATERVA_MAX_ITEMSIZE];
+        if (blosc2_getitem_ctx(array->sc->dctx, cchunk, 0, 1, value) < 0) {
+            DEBUG_PRINT("Error getting the value of a uniform chunk");
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+        caterva_sums_uniform(array, nchunk, value);
+        caterva_bloom_uniform(array, nchunk, value);
+        return CATERVA_SUCCEED;
+    }
+
+    size_t rchunksize = (size_t) array->extchunknitems * array->itemsize;
+    uint8_t *rchunk = caterva_malloc(ctx, rchunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR_NULL(rchunk);
+    caterva_stage_begin(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, &t0);
+    int dsize = blosc2_decompress_ctx(array->sc->dctx, cchunk, rchunk, rchunksize);
+    if (dsize >= 0) {
+        caterva_predictor_decode(array, rchunk, NULL);
+    }
+    caterva_stage_end(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, (int64_t) rchunksize, &t0,
+                      &stats);
+    if (dsize < 0) {
+        DEBUG_PRINT("Error decompressing a chunk");
+        rc = CATERVA_ERR_BLOSC_FAILED;
+    } else {
+        caterva_sums_rchunk(array, nchunk, rchunk);
+        caterva_bloom_rchunk(array, nchunk, rchunk);
+        stats.nchunks_decompressed++;
+        stats.nblocks_decompressed += array->extchunknitems / array->blocknitems;
+        stats.bytes_decompressed += (int64_t) rchunksize;
+    }
+    caterva_free(ctx, rchunk, rchunksize, CATERVA_ALLOC_CHUNK);
+    caterva_stats_merge(ctx, array, &stats);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_array_set_chunk(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                                  void *chunk, int64_t chunksize) {
+    int32_t typesize = array->itemsize;
+
+    // A chunk stored as a delta would break the ones after it along the axis
+    if (array->keyframe_interval > 0) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    // The shape of the chunk (smaller than chunkshape on the edges)
+    int64_t cshape[CATERVA_MAX_DIM];
+    int64_t cnitems = caterva_blosc_chunk_shape(array, nchunk, cshape);
+    if (chunksize != cnitems * typesize) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    int rc;
+    if (ctx->cfg->prefilter == NULL && caterva_is_uniform(chunk, cnitems, typesize)) {
+        rc = write_uniform(ctx, array, nchunk, chunk, &stats);
+    } else {
+        size_t size_chunk = (size_t) array->chunknitems * typesize;
+        size_t size_rep = (size_t) array->extchunknitems * typesize;
+        int8_t *rchunk = caterva_malloc(ctx, size_rep, CATERVA_ALLOC_CHUNK);
+        CATERVA_ERROR_NULL(rchunk);
+        uint8_t *paddedchunk = NULL;
+        if (cnitems != array->chunknitems) {
+            paddedchunk = caterva_malloc(ctx, size_chunk, CATERVA_ALLOC_CHUNK);
+            CATERVA_ERROR_NULL(paddedchunk);
+        }
+        caterva_stage_begin(ctx, CATERVA_STAGE_REPART, array, nchunk, &t0);
+        repart_edge_chunk(ctx, array, chunk, cshape, cnitems, paddedchunk, rchunk);
+        caterva_stage_end(ctx, CATERVA_STAGE_REPART, array, nchunk, (int64_t) size_rep, &t0,
+                          &stats);
+        if (paddedchunk != NULL) {
+            caterva_free(ctx, paddedchunk, size_chunk, CATERVA_ALLOC_CHUNK);
+        }
+        rc = write_rchunk(ctx, array, nchunk, rchunk, (int32_t) size_rep, &stats);
+        caterva_free(ctx, rchunk, size_rep, CATERVA_ALLOC_CHUNK);
+    }
+    caterva_stats_merge(ctx, array, &stats);
+    CATERVA_ERROR(rc);
+
+    // The cached copy of the chunk is outdated now
+    if (array->chunk_cache.nchunk == nchunk) {
+        array->chunk_cache.nchunk = -1;
+    }
+    return CATERVA_SUCCEED;
+}
+
 int caterva_blosc_array_from_buffer(caterva_context_t *ctx, caterva_array_t *array, void *buffer,
                                     int64_t buffersize) {
     CATERVA_UNUSED_PARAM(buffersize);
@@ -519,10 +1607,16 @@ int caterva_blosc_array_from_buffer(caterva_context_t *ctx, caterva_array_t *arr
         d_pshape[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] = array->chunkshape[i];
     }
 
-    int8_t typesize = array->itemsize;
-    int8_t *chunk = ctx->cfg->alloc((size_t) array->chunknitems * typesize);
-    int8_t *rchunk = ctx->cfg->alloc((size_t) array->extchunknitems * typesize);
+    int32_t typesize = array->itemsize;
+    size_t chunksize = (size_t) array->chunknitems * typesize;
+    size_t rchunksize = (size_t) array->extchunknitems * typesize;
+    int8_t *chunk = caterva_malloc(ctx, chunksize, CATERVA_ALLOC_CHUNK);
+    int8_t *rchunk = caterva_malloc(ctx, rchunksize, CATERVA_ALLOC_CHUNK);
     CATERVA_ERROR_NULL(chunk);
+    CATERVA_ERROR_NULL(rchunk);
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    int rc = CATERVA_SUCCEED;
 
     /* Calculate the constants out of the for  */
     int64_t aux[CATERVA_MAX_DIM];
@@ -552,6 +1646,7 @@ int caterva_blosc_array_from_buffer(caterva_context_t *ctx, caterva_array_t *arr
                 }
             }
             int32_t seq_copylen = actual_psize[7] * typesize;
+            caterva_stage_begin(ctx, CATERVA_STAGE_SCATTER, array, array->nchunks, &t0);
             /* Copy each line of data from chunk to arr */
             int64_t ii[CATERVA_MAX_DIM];
             for (ii[6] = 0; ii[6] < actual_psize[6]; ii[6]++) {
@@ -582,12 +1677,25 @@ int caterva_blosc_array_from_buffer(caterva_context_t *ctx, caterva_array_t *arr
                     }
                 }
             }
-            // Copy each chunk from rchunk to dest
-            caterva_blosc_array_repart_chunk(rchunk, (int32_t) array->extchunknitems * typesize,
-                                             chunk, array->chunknitems * typesize, array);
-
-            blosc2_schunk_append_buffer(array->sc, rchunk,
-                                        (size_t) array->extchunknitems * typesize);
+            caterva_stage_end(ctx, CATERVA_STAGE_SCATTER, array, array->nchunks,
+                              (int64_t) chunksize, &t0, &stats);
+            if (ctx->cfg->prefilter == NULL &&
+                caterva_is_uniform((uint8_t *) chunk, array->chunknitems, typesize)) {
+                rc = write_uniform(ctx, array, array->nchunks, (uint8_t *) chunk, &stats);
+            } else {
+                // Copy each chunk from rchunk to dest
+                caterva_stage_begin(ctx, CATERVA_STAGE_REPART, array, array->nchunks, &t0);
+                caterva_blosc_array_repart_chunk(rchunk, (int32_t) array->extchunknitems * typesize,
+                                                 chunk, array->chunknitems * typesize, array);
+                caterva_stage_end(ctx, CATERVA_STAGE_REPART, array, array->nchunks,
+                                  (int64_t) rchunksize, &t0, &stats);
+
+                rc = write_rchunk(ctx, array, array->nchunks, rchunk, (int32_t) rchunksize,
+                                  &stats);
+            }
+            if (rc != CATERVA_SUCCEED) {
+                break;
+            }
             array->empty = false;
             array->nchunks++;
             if (array->nchunks == array->extnitems / array->chunknitems) {
@@ -595,12 +1703,144 @@ int caterva_blosc_array_from_buffer(caterva_context_t *ctx, caterva_array_t *arr
             }
         }
     }
-    ctx->cfg->free(chunk);
-    ctx->cfg->free(rchunk);
+    caterva_free(ctx, chunk, chunksize, CATERVA_ALLOC_CHUNK);
+    caterva_free(ctx, rchunk, rchunksize, CATERVA_ALLOC_CHUNK);
+    caterva_stats_merge(ctx, array, &stats);
+    CATERVA_ERROR(rc);
 
     return CATERVA_SUCCEED;
 }
 
+// Read a region that lies inside a single block straight out of the compressed chunk, decoding
+// only the items between its first and last ones (so that no chunk-sized buffer is needed). The
+// blocks of a predicted chunk, or of a chunk stored as a delta, can only be decoded whole, so read
+// is left to false for them (and when the chunk cache is in use).
+static int get_block_region(caterva_context_t *ctx, caterva_array_t *array, const int64_t *start,
+                            const int64_t *stop, const int64_t *shape, uint8_t *buffer,
+                            bool *read) {
+    *read = false;
+    if (array->predictor != CATERVA_PREDICTOR_NONE || array->keyframe_interval > 0 ||
+        array->chunk_cache.data != NULL) {
+        return CATERVA_SUCCEED;
+    }
+
+    // The chunk and block of the region and the offsets (in items) of its first and last items
+    int64_t nchunk = 0;
+    int64_t nblock = 0;
+    int64_t first = 0;
+    int64_t last = 0;
+    int64_t rshape[CATERVA_MAX_DIM];
+    int64_t rnitems = 1;
+    for (int i = 0; i < array->ndim; ++i) {
+        int64_t cstart = start[i] % array->chunkshape[i];
+        int64_t cstop = (stop[i] - 1) % array->chunkshape[i];
+        if (stop[i] <= start[i] || start[i] / array->chunkshape[i] !=
+                                       (stop[i] - 1) / array->chunkshape[i] ||
+            cstart / array->blockshape[i] != cstop / array->blockshape[i]) {
+            return CATERVA_SUCCEED;
+        }
+        nchunk = nchunk * (array->extshape[i] / array->chunkshape[i]) +
+                 start[i] / array->chunkshape[i];
+        nblock = nblock * (array->extchunkshape[i] / array->blockshape[i]) +
+                 cstart / array->blockshape[i];
+        first = first * array->blockshape[i] + cstart % array->blockshape[i];
+        last = last * array->blockshape[i] + cstop % array->blockshape[i];
+        rshape[i] = stop[i] - start[i];
+        rnitems *= rshape[i];
+    }
+    int32_t itemsize = array->itemsize;
+    *read = true;
+
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    uint8_t value[CATERVA_MAX_ITEMSIZE];
+    int64_t fill_start[CATERVA_MAX_DIM] = {0};
+    int64_t position = caterva_chunk_position(array, nchunk);
+    if (array->fill_value != NULL && position >= array->sc->nchunks) {
+        caterva_fill_region(array->ndim, itemsize, array->fill_value, rshape, buffer, shape,
+                            fill_start);
+        stats.nchunks_uniform_read++;
+        caterva_stats_merge(ctx, array, &stats);
+        return CATERVA_SUCCEED;
+    }
+
+    uint8_t *cchunk;
+    bool needs_free;
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, array, nchunk, &t0);
+    int csize = blosc2_schunk_get_chunk(array->sc, (int) position, &cchunk, &needs_free);
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, array, nchunk, csize, &t0, &stats);
+    if (csize < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    stats.bytes_read += csize;
+
+    // A uniform chunk only holds its value, and a single item goes straight to the buffer
+    bool uniform = cchunk_special(cchunk, BLOSC2_SPECIAL_VALUE);
+    int64_t span = uniform ? 1 : last - first + 1;
+    uint8_t *items = value;
+    if (!uniform && rnitems > 1) {
+        items = caterva_malloc(ctx, (size_t) (span * itemsize), CATERVA_ALLOC_SCRATCH);
+    } else if (!uniform) {
+        items = buffer;
+    }
+    int rc = CATERVA_SUCCEED;
+    if (cchunk_special(cchunk, BLOSC2_SPECIAL_UNINIT)) {
+        DEBUG_PRINT("The chunk has not been written yet");
+        rc = CATERVA_ERR_INVALID_ARGUMENT;
+    } else if (items == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    } else {
+        int start_item = uniform ? 0 : (int) (nblock * array->blocknitems + first);
+        caterva_stage_begin(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, &t0);
+        if (blosc2_getitem_ctx(array->sc->dctx, cchunk, start_item, (int) span, items) < 0) {
+            DEBUG_PRINT("Error getting the items of a block");
+            rc = CATERVA_ERR_BLOSC_FAILED;
+        }
+        caterva_stage_end(ctx, CATERVA_STAGE_DECOMPRESS, array, nchunk, span * itemsize, &t0,
+                          &stats);
+    }
+    if (needs_free) {
+        free(cchunk);
+    }
+
+    if (rc == CATERVA_SUCCEED) {
+        caterva_stage_begin(ctx, CATERVA_STAGE_SCATTER, array, nchunk, &t0);
+        if (uniform) {
+            caterva_fill_region(array->ndim, itemsize, value, rshape, buffer, shape, fill_start);
+            stats.nchunks_uniform_read++;
+        } else if (items != buffer) {
+            // Copy the rows of the region out of the items decoded
+            int64_t rowlen = rshape[array->ndim - 1];
+            for (int64_t row = 0; row < rnitems / rowlen; ++row) {
+                int64_t offset = 0;
+                int64_t rem = row;
+                int64_t stride = shape[array->ndim - 1];
+                for (int i = array->ndim - 2; i >= 0; --i) {
+                    offset += rem % rshape[i] * stride;
+                    rem /= rshape[i];
+                    stride *= shape[i];
+                }
+                memcpy(buffer + offset * itemsize,
+                       items + caterva_block_row_offset(array, rshape, row) * itemsize,
+                       (size_t) (rowlen * itemsize));
+            }
+        }
+        caterva_stage_end(ctx, CATERVA_STAGE_SCATTER, array, nchunk, rnitems * itemsize, &t0,
+                          &stats);
+        if (!uniform) {
+            stats.nchunks_decompressed++;
+            stats.nblocks_decompressed++;
+            stats.bytes_decompressed += span * itemsize;
+        }
+    }
+    if (items != value && items != buffer && items != NULL) {
+        caterva_free(ctx, items, (size_t) (span * itemsize), CATERVA_ALLOC_SCRATCH);
+    }
+    caterva_stats_merge(ctx, array, &stats);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
 int caterva_blosc_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t *array,
                                          int64_t *start, int64_t *stop, const int64_t *shape,
                                          void *buffer) {
@@ -643,16 +1883,32 @@ int caterva_blosc_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t
         s_spshape[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = blockshape__[i];
     }
 
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    uint8_t value[CATERVA_MAX_ITEMSIZE];
+    bool uniform;
+
+    // Acceleration path for the points and the tiny regions inside a single block
+    bool read;
+    CATERVA_ERROR(get_block_region(ctx, array, start, stop, shape, bbuffer, &read));
+    if (read) {
+        return CATERVA_SUCCEED;
+    }
+
     // Acceleration path for the case where we are doing (1-dim) aligned chunk reads
     if ((s_ndim == 1) && (array->chunkshape[0] == shape[0]) &&
         (array->chunkshape[0] == array->blockshape[0]) && (start[0] % array->chunkshape[0] == 0) &&
         (stop[0] % array->chunkshape[0] == 0)) {
         int nchunk = (int) (start[0] / array->chunkshape[0]);
         // In case of an aligned read, decompress directly in destination
-        if (blosc2_schunk_decompress_chunk(array->sc, nchunk, bbuffer,
-                                           (size_t) array->chunknitems * array->sc->typesize) < 0) {
-            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        int rc = caterva_blosc_read_chunk(ctx, array, array->sc->dctx, nchunk, NULL, bbuffer,
+                                          (size_t) array->chunknitems * array->sc->typesize,
+                                          value, &uniform, &stats);
+        if (rc == CATERVA_SUCCEED && uniform) {
+            caterva_fill_buffer(bbuffer, array->chunknitems, array->itemsize, value);
         }
+        caterva_stats_merge(ctx, array, &stats);
+        CATERVA_ERROR(rc);
         return CATERVA_SUCCEED;
     }
 
@@ -660,20 +1916,25 @@ int caterva_blosc_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t
         start_[j] = 0;
     }
     /* Create chunk buffers */
+    caterva_stage_begin(ctx, CATERVA_STAGE_SETUP, array, -1, &t0);
     int typesize = array->itemsize;
     int nblocks = ((int) array->extchunknitems) / array->blocknitems;
-    bool *block_maskout = ctx->cfg->alloc(nblocks);
+    bool *block_maskout = caterva_malloc(ctx, (size_t) nblocks, CATERVA_ALLOC_MASKOUT);
+    CATERVA_ERROR_NULL(block_maskout);
 
     uint8_t *chunk;
     bool local_cache;
     if (array->chunk_cache.data == NULL) {
-        chunk = (uint8_t *) ctx->cfg->alloc((size_t) array->extchunknitems * typesize);
+        chunk = (uint8_t *) caterva_malloc(ctx, (size_t) array->extchunknitems * typesize,
+                                           CATERVA_ALLOC_CHUNK);
         CATERVA_ERROR_NULL(chunk);
         local_cache = true;
     } else {
         chunk = array->chunk_cache.data;
         local_cache = false;
     }
+    caterva_stage_end(ctx, CATERVA_STAGE_SETUP, array, -1, 0, &t0, &stats);
+    int rc = CATERVA_SUCCEED;
     int64_t i_start[8], i_stop[8];
     for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
         i_start[i] = start_[i] / s_pshape[i];
@@ -693,16 +1954,13 @@ int caterva_blosc_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t
                             for (ii[6] = i_start[6]; ii[6] <= i_stop[6]; ++ii[6]) {
                                 for (ii[7] = i_start[7]; ii[7] <= i_stop[7]; ++ii[7]) {
                                     /* Get the chunk ii */
-                                    memset(block_maskout, true, nblocks);
                                     int nchunk = 0;
                                     int inc = 1;
                                     for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
                                         nchunk += (int) (ii[i] * inc);
                                         inc *= (int) (s_eshape[i] / s_pshape[i]);
                                     }
-                                    if (array->chunk_cache.data != NULL) {
-                                        array->chunk_cache.nchunk = nchunk;
-                                    }
+                                    memset(block_maskout, true, nblocks);
                                     /* Calculate the used blocks */
                                     for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
                                         if (ii[i] == i_start[i]) {
@@ -740,8 +1998,54 @@ int caterva_blosc_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t
                                             }
                                         }
                                     }
-                                    blosc2_set_maskout(array->sc->dctx, block_maskout, nblocks);
-                                    blosc2_schunk_decompress_chunk(array->sc, nchunk, chunk, (size_t) array->extchunknitems * typesize);
+                                    uniform = false;
+                                    if (!local_cache && array->chunk_cache.nchunk == nchunk) {
+                                        stats.cache_hits++;
+                                    } else {
+                                        // The whole chunk is decompressed when it is cached so that it can be reused
+                                        rc = caterva_blosc_read_chunk(ctx, array, array->sc->dctx, nchunk,
+                                                                      local_cache ? block_maskout : NULL, chunk,
+                                                                      (size_t) array->extchunknitems * typesize,
+                                                                      value, &uniform, &stats);
+                                        if (rc != CATERVA_SUCCEED) {
+                                            caterva_free(ctx, block_maskout, (size_t) nblocks,
+                                                         CATERVA_ALLOC_MASKOUT);
+                                            if (local_cache) {
+                                                caterva_free(ctx, chunk, (size_t) array->extchunknitems * typesize,
+                                                             CATERVA_ALLOC_CHUNK);
+                                            } else {
+                                                array->chunk_cache.nchunk = -1;
+                                            }
+                                            caterva_stats_merge(ctx, array, &stats);
+                                            CATERVA_ERROR(rc);
+                                        }
+                                        if (!local_cache && !uniform) {
+                                            stats.cache_misses++;
+                                            array->chunk_cache.nchunk = nchunk;
+                                        }
+                                    }
+                                    if (uniform) {
+                                        // Broadcast the value into the part of the buffer covered by the chunk
+                                        int64_t fill_shape[CATERVA_MAX_DIM];
+                                        int64_t fill_start[CATERVA_MAX_DIM];
+                                        int64_t nbytes_filled = typesize;
+                                        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                                            int64_t cstart = ii[i] * s_pshape[i];
+                                            int64_t rstart = start_[i] > cstart ? start_[i] : cstart;
+                                            int64_t rstop = stop_[i] < cstart + s_pshape[i] ? stop_[i] : cstart + s_pshape[i];
+                                            fill_shape[i] = rstop - rstart;
+                                            fill_start[i] = rstart - start_[i];
+                                            nbytes_filled *= fill_shape[i];
+                                        }
+                                        caterva_stage_begin(ctx, CATERVA_STAGE_SCATTER, array, nchunk, &t0);
+                                        caterva_fill_region(CATERVA_MAX_DIM, typesize, value, fill_shape, bbuffer,
+                                                            d_pshape_, fill_start);
+                                        caterva_stage_end(ctx, CATERVA_STAGE_SCATTER, array, nchunk, nbytes_filled, &t0,
+                                                          &stats);
+                                        continue;
+                                    }
+                                    int64_t nbytes_copied = 0;
+                                    caterva_stage_begin(ctx, CATERVA_STAGE_SCATTER, array, nchunk, &t0);
                                     for (jj[0] = j_start[0]; jj[0] <= j_stop[0]; ++jj[0]) {
                                         for (jj[1] = j_start[1]; jj[1] <= j_stop[1]; ++jj[1]) {
                                             for (jj[2] = j_start[2]; jj[2] <= j_stop[2]; ++jj[2]) {
@@ -804,6 +2108,7 @@ int caterva_blosc_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t
 
                                                                                                 memcpy(&bbuffer[buf_pointer * typesize], &chunk[(s_start + sp_pointer)
                                                                                                        * typesize], (size_t) (sp_stop[7] - sp_start[7]) * typesize);
+                                                                                                nbytes_copied += (sp_stop[7] - sp_start[7]) * typesize;
                                                                                             }
                                                                                         }
                                                                                     }
@@ -819,6 +2124,8 @@ int caterva_blosc_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t
                                             }
                                         }
                                     }
+                                    caterva_stage_end(ctx, CATERVA_STAGE_SCATTER, array, nchunk, nbytes_copied, &t0,
+                                                      &stats);
                                 }
                             }
                         }
@@ -828,24 +2135,166 @@ int caterva_blosc_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t
         }
     }
 
-    ctx->cfg->free(block_maskout);
+    caterva_free(ctx, block_maskout, (size_t) nblocks, CATERVA_ALLOC_MASKOUT);
     if (local_cache) {
-        ctx->cfg->free(chunk);
+        caterva_free(ctx, chunk, (size_t) array->extchunknitems * typesize, CATERVA_ALLOC_CHUNK);
     }
+    caterva_stats_merge(ctx, array, &stats);
     return CATERVA_SUCCEED;
 }
 
-int caterva_blosc_array_to_buffer(caterva_context_t *ctx, caterva_array_t *array, void *buffer) {
-    int8_t *bbuffer = (int8_t *) buffer;
+// Check whether the chunks of an array (in block layout) are laid out as in a C-ordered buffer of
+// the whole array, so that the chunks not on the edges can be decompressed in place. The first
+// axis where the chunks have more than one item may be split by the blocks (without padding) and
+// the chunks and blocks must span the trailing axes.
+static bool chunks_in_place(caterva_array_t *array) {
+    bool outer = false;
+    for (int i = 0; i < array->ndim; ++i) {
+        if (array->extchunkshape[i] != array->chunkshape[i]) {
+            return false;
+        }
+        if (outer && (array->chunkshape[i] != array->shape[i] ||
+                      array->blockshape[i] != array->chunkshape[i])) {
+            return false;
+        }
+        outer = outer || array->chunkshape[i] > 1;
+    }
+    return true;
+}
+
+// Decompress the chunk nchunk of an array into its place in a C-ordered buffer of the whole array
+static int materialize_chunk(caterva_context_t *ctx, caterva_array_t *array, blosc2_context *dctx,
+                             int64_t nchunk, bool in_place, uint8_t *rchunk, uint8_t *buffer) {
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
     int8_t ndim = array->ndim;
-    int64_t start[CATERVA_MAX_DIM];
-    int64_t stop[CATERVA_MAX_DIM];
-    for (int i = 0; i < ndim; i++) {
-        start[i] = 0;
-        stop[i] = array->shape[i];
+    int32_t itemsize = array->itemsize;
+    size_t rchunksize = (size_t) array->extchunknitems * itemsize;
+
+    int64_t origin[CATERVA_MAX_DIM];
+    int64_t cshape[CATERVA_MAX_DIM];
+    int64_t offset = 0;
+    bool padded = false;
+    int64_t rem = nchunk;
+    for (int i = ndim - 1; i >= 0; --i) {
+        int64_t grid = array->extshape[i] / array->chunkshape[i];
+        origin[i] = rem % grid * array->chunkshape[i];
+        rem /= grid;
+    }
+    caterva_blosc_chunk_shape(array, nchunk, cshape);
+    for (int i = 0; i < ndim; ++i) {
+        offset = offset * array->shape[i] + origin[i];
+        padded = padded || origin[i] + array->extchunkshape[i] > array->shape[i];
+    }
+
+    // A chunk laid out as the buffer (and not padded) is decompressed straight into it
+    uint8_t *dest = in_place && !padded ? buffer + offset * itemsize : rchunk;
+    uint8_t value[CATERVA_MAX_ITEMSIZE];
+    bool uniform;
+    int rc = caterva_blosc_read_chunk(ctx, array, dctx, nchunk, NULL, dest, rchunksize, value,
+                                      &uniform, &stats);
+    if (rc == CATERVA_SUCCEED && (uniform || dest == rchunk)) {
+        caterva_stage_begin(ctx, CATERVA_STAGE_SCATTER, array, nchunk, &t0);
+        if (uniform) {
+            caterva_fill_region(ndim, itemsize, value, cshape, buffer, array->shape, origin);
+        } else {
+            // Copy the rows of the blocks inside the array to their place
+            int64_t nblocks = array->extchunknitems / array->blocknitems;
+            for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+                int64_t bshape[CATERVA_MAX_DIM];
+                int64_t bnitems = caterva_block_extent(array, cshape, nblock, bshape);
+                if (bnitems == 0) {
+                    continue;
+                }
+                int64_t borigin[CATERVA_MAX_DIM];
+                int64_t src_strides[CATERVA_MAX_DIM];
+                int64_t dest_strides[CATERVA_MAX_DIM];
+                int64_t src_stride = itemsize;
+                int64_t dest_stride = itemsize;
+                int64_t brem = nblock;
+                uint8_t *bdest = buffer;
+                for (int i = ndim - 1; i >= 0; --i) {
+                    int64_t bgrid = array->extchunkshape[i] / array->blockshape[i];
+                    borigin[i] = origin[i] + brem % bgrid * array->blockshape[i];
+                    brem /= bgrid;
+                    src_strides[i] = src_stride;
+                    dest_strides[i] = dest_stride;
+                    bdest += borigin[i] * dest_stride;
+                    src_stride *= array->blockshape[i];
+                    dest_stride *= array->shape[i];
+                }
+                const uint8_t *bsrc = rchunk + nblock * array->blocknitems * itemsize;
+                caterva_copy_rows(ndim - 1, bshape, src_strides, dest_strides,
+                                  bshape[ndim - 1] * itemsize, bsrc, bdest, 0,
+                                  bnitems / bshape[ndim - 1]);
+            }
+        }
+        caterva_stage_end(ctx, CATERVA_STAGE_SCATTER, array, nchunk, (int64_t) rchunksize, &t0,
+                          &stats);
+    }
+    caterva_stats_merge(ctx, array, &stats);
+    return rc;
+}
+
+int caterva_blosc_array_to_buffer(caterva_context_t *ctx, caterva_array_t *array, void *buffer) {
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    if (!array->filled) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    // Each worker owns a range of chunks and a decompression context. Without OpenMP the chunks
+    // are decompressed one by one with the (multi-threaded) context of the superchunk.
+#if defined(_OPENMP)
+    int64_t nworkers = ctx->cfg->nthreads < nchunks ? ctx->cfg->nthreads : nchunks;
+#else
+    int64_t nworkers = 1;
+#endif
+    if (nworkers < 1) {
+        nworkers = 1;
+    }
+    size_t rchunksize = (size_t) array->extchunknitems * array->itemsize;
+    blosc2_context **dctx = caterva_malloc(ctx, (size_t) nworkers * sizeof(blosc2_context *),
+                                           CATERVA_ALLOC_SCRATCH);
+    uint8_t **rchunks = caterva_malloc(ctx, (size_t) nworkers * sizeof(uint8_t *),
+                                       CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(dctx);
+    CATERVA_ERROR_NULL(rchunks);
+    blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+    dparams.nthreads = 1;
+    for (int64_t w = 0; w < nworkers; ++w) {
+        dctx[w] = nworkers == 1 ? array->sc->dctx : blosc2_create_dctx(dparams);
+        rchunks[w] = caterva_malloc(ctx, rchunksize, CATERVA_ALLOC_CHUNK);
+        CATERVA_ERROR_NULL(rchunks[w]);
+    }
+
+    bool in_place = chunks_in_place(array);
+    int rc = CATERVA_SUCCEED;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nworkers) if (nworkers > 1)
+#endif
+    for (int64_t part = 0; part < nworkers; ++part) {
+        for (int64_t nchunk = nchunks * part / nworkers;
+             nchunk < nchunks * (part + 1) / nworkers; ++nchunk) {
+            int err = materialize_chunk(ctx, array, dctx[part], nchunk, in_place, rchunks[part],
+                                        buffer);
+            if (err != CATERVA_SUCCEED) {
+#if defined(_OPENMP)
+#pragma omp critical(caterva_to_buffer_rc)
+#endif
+                rc = err;
+            }
+        }
     }
 
-    caterva_blosc_array_get_slice_buffer(ctx, array, start, stop, array->shape, bbuffer);
+    for (int64_t w = 0; w < nworkers; ++w) {
+        if (nworkers > 1) {
+            blosc2_free_ctx(dctx[w]);
+        }
+        caterva_free(ctx, rchunks[w], rchunksize, CATERVA_ALLOC_CHUNK);
+    }
+    caterva_free(ctx, dctx, (size_t) nworkers * sizeof(blosc2_context *), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, rchunks, (size_t) nworkers * sizeof(uint8_t *), CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR(rc);
     return CATERVA_SUCCEED;
 }
 
@@ -853,7 +2302,8 @@ int caterva_blosc_array_get_slice(caterva_context_t *ctx, caterva_array_t *src,
                                   int64_t *stop, caterva_array_t *array) {
     int typesize = src->itemsize;
 
-    uint8_t *chunk = ctx->cfg->alloc((size_t) array->chunknitems * typesize);
+    uint8_t *chunk = caterva_malloc(ctx, (size_t) array->chunknitems * typesize,
+                                    CATERVA_ALLOC_CHUNK);
     CATERVA_ERROR_NULL(chunk);
     int64_t next_chunkshape__[CATERVA_MAX_DIM];
     int64_t start__[CATERVA_MAX_DIM];
@@ -930,7 +2380,7 @@ int caterva_blosc_array_get_slice(caterva_context_t *ctx, caterva_array_t *src,
             }
         }
     }
-    ctx->cfg->free(chunk);
+    caterva_free(ctx, chunk, (size_t) array->chunknitems * typesize, CATERVA_ALLOC_CHUNK);
 
     return CATERVA_SUCCEED;
 }
@@ -975,8 +2425,10 @@ int caterva_blosc_update_shape(caterva_array_t *array, int8_t ndim, int64_t *sha
 
     uint8_t *smeta = NULL;
     // Serialize the dimension info ...
-    int32_t smeta_len =
-        serialize_meta(array->ndim, array->shape, array->chunkshape, array->blockshape, &smeta);
+    int32_t smeta_len = serialize_meta(array->ndim, array->shape, array->chunkshape,
+                                       array->blockshape, array->itemsize, array->fill_value,
+                                       array->predictor, array->delta_axis,
+                                       array->keyframe_interval, array->chunk_order, &smeta);
     if (smeta_len < 0) {
         fprintf(stderr, "error during serializing dims info for Caterva");
         return -1;
@@ -1021,6 +2473,19 @@ int caterva_blosc_array_squeeze(caterva_context_t *ctx, caterva_array_t *array)
         }
     }
 
+    // The delta axis is renumbered. If it is squeezed, all the chunks were keyframes.
+    if (array->keyframe_interval > 0) {
+        int8_t delta_axis = 0;
+        for (int i = 0; i < array->delta_axis; ++i) {
+            delta_axis += array->shape[i] != 1;
+        }
+        if (array->shape[array->delta_axis] == 1) {
+            array->keyframe_interval = 0;
+            delta_axis = 0;
+        }
+        array->delta_axis = delta_axis;
+    }
+
     CATERVA_ERROR(caterva_blosc_update_shape(array, nones, newshape, newchunkshape, newblockshape));
 
     return CATERVA_SUCCEED;
@@ -1043,9 +2508,11 @@ int caterva_blosc_array_copy(caterva_context_t *ctx, caterva_params_t *params,
 }
 
 int caterva_blosc_array_empty(caterva_context_t *ctx, caterva_params_t *params,
-                              caterva_storage_t *storage, caterva_array_t **array) {
+                              caterva_storage_t *storage, const void *fill_value,
+                              caterva_array_t **array) {
     /* Create a caterva_array_t buffer */
-    (*array) = (caterva_array_t *) ctx->cfg->alloc(sizeof(caterva_array_t));
+    (*array) = (caterva_array_t *) caterva_malloc(ctx, sizeof(caterva_array_t),
+                                                   CATERVA_ALLOC_ARRAY);
     if ((*array) == NULL) {
         DEBUG_PRINT("Pointer is null");
         return CATERVA_ERR_NULL_POINTER;
@@ -1100,8 +2567,39 @@ int caterva_blosc_array_empty(caterva_context_t *ctx, caterva_params_t *params,
     // The partition cache (empty initially)
     (*array)->chunk_cache.data = NULL;
     (*array)->chunk_cache.nchunk = -1;  // means no valid cache yet
+    memset(&(*array)->stats, 0, sizeof(caterva_stats_t));
 
     (*array)->buf = NULL;
+    (*array)->mmap.addr = NULL;
+    memset(&(*array)->append_buffer, 0, sizeof(struct append_buffer_s));
+    (*array)->fill_value = NULL;
+    // A prefilter may compute the chunks out of anything, so they are not sampled
+    (*array)->objective = ctx->cfg->prefilter == NULL ? storage->properties.blosc.objective
+                                                      : CATERVA_COMPRESSION_FIXED;
+    (*array)->cspeed = 0;
+    (*array)->predictor = storage->properties.blosc.predictor;
+    (*array)->keyframe_interval = storage->properties.blosc.keyframe_interval;
+    (*array)->delta_axis = storage->properties.blosc.delta_axis;
+    memset(&(*array)->delta_cache, 0, sizeof(struct delta_cache_s));
+    (*array)->lossy_mode = storage->properties.blosc.lossy_mode;
+    (*array)->lossy_tolerance = storage->properties.blosc.lossy_tolerance;
+    (*array)->lossy_bits = storage->properties.blosc.lossy_bits;
+    (*array)->nfields = 0;
+    (*array)->fields = NULL;
+    (*array)->field_arrays = NULL;
+    (*array)->recordsize = 0;
+    (*array)->pyramid_levels = 0;
+    (*array)->pyramid_reduce = CATERVA_PYRAMID_NEAREST;
+    (*array)->pyramid_kind = CATERVA_ITEM_UINT;
+    (*array)->levels = NULL;
+    (*array)->sum_kind = CATERVA_ITEM_UINT;
+    (*array)->block_sums = NULL;
+    (*array)->chunk_sums = NULL;
+    (*array)->indexes_dirty = false;
+    (*array)->bloom_bits = 0;
+    (*array)->blooms = NULL;
+    (*array)->scattered = false;
+    CATERVA_ERROR(caterva_order_new(ctx, *array, storage->properties.blosc.chunk_order));
 
     blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
     cparams.blocksize = (*array)->blocknitems * params->itemsize;
@@ -1144,7 +2642,11 @@ int caterva_blosc_array_empty(caterva_context_t *ctx, caterva_params_t *params,
         return CATERVA_ERR_BLOSC_FAILED;
     }
     uint8_t *smeta = NULL;
-    int32_t smeta_len = serialize_meta(params->ndim, shape, chunkshape, blockshape, &smeta);
+    int32_t smeta_len = serialize_meta(params->ndim, shape, chunkshape, blockshape,
+                                       params->itemsize, fill_value,
+                                       (*array)->predictor, (*array)->delta_axis,
+                                       (*array)->keyframe_interval, (*array)->chunk_order,
+                                       &smeta);
     if (smeta_len < 0) {
         DEBUG_PRINT("error during serializing dims info for Caterva");
         return CATERVA_ERR_BLOSC_FAILED;
@@ -1157,6 +2659,42 @@ int caterva_blosc_array_empty(caterva_context_t *ctx, caterva_params_t *params,
 
     free(smeta);
 
+    // The error bound is recorded for the readers
+    if ((*array)->lossy_mode != CATERVA_LOSSY_NONE) {
+        uint8_t lmeta[16];
+        int32_t lmeta_len = serialize_lossy_meta((*array)->lossy_mode,
+                                                 (*array)->lossy_tolerance,
+                                                 (*array)->lossy_bits, lmeta);
+        if (blosc2_add_metalayer(sc, "caterva_lossy", lmeta, (uint32_t) lmeta_len) < 0) {
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+    }
+
+    // The sum index takes its whole size from the start, so that it can be updated in place
+    if (storage->properties.blosc.sum_index) {
+        CATERVA_ERROR(caterva_sums_new(ctx, *array, storage->properties.blosc.sum_kind));
+        uint8_t *smeta_sums;
+        int32_t smeta_sums_len;
+        CATERVA_ERROR(caterva_sums_serialize(ctx, *array, &smeta_sums, &smeta_sums_len));
+        int rc = blosc2_add_metalayer(sc, "caterva_sums", smeta_sums, (uint32_t) smeta_sums_len);
+        caterva_free(ctx, smeta_sums, (size_t) smeta_sums_len, CATERVA_ALLOC_SCRATCH);
+        if (rc < 0) {
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+    }
+    if (storage->properties.blosc.bloom_index) {
+        CATERVA_ERROR(caterva_bloom_new(ctx, *array, storage->properties.blosc.bloom_bits));
+        uint8_t *smeta_bloom;
+        int32_t smeta_bloom_len;
+        CATERVA_ERROR(caterva_bloom_serialize(ctx, *array, &smeta_bloom, &smeta_bloom_len));
+        int rc = blosc2_add_metalayer(sc, "caterva_bloom", smeta_bloom,
+                                      (uint32_t) smeta_bloom_len);
+        caterva_free(ctx, smeta_bloom, (size_t) smeta_bloom_len, CATERVA_ALLOC_SCRATCH);
+        if (rc < 0) {
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+    }
+
     for (int i = 0; i < storage->properties.blosc.nmetalayers; ++i) {
         char *name = storage->properties.blosc.metalayers[i].name;
         uint8_t *data = storage->properties.blosc.metalayers[i].sdata;
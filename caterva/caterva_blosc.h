@@ -13,7 +13,14 @@
 #define CATERVA_CATERVA_BLOSC_H_
 
 int caterva_blosc_array_empty(caterva_context_t *ctx, caterva_params_t *params,
-                              caterva_storage_t *storage, caterva_array_t **array);
+                              caterva_storage_t *storage, const void *fill_value,
+                              caterva_array_t **array);
+
+int caterva_blosc_array_to_sframe(caterva_context_t *ctx, caterva_array_t *array,
+                                  uint8_t **sframe, int64_t *len, bool *needs_free);
+
+int caterva_blosc_array_save(caterva_context_t *ctx, caterva_array_t *array,
+                             const char *filename);
 
 int caterva_blosc_array_free(caterva_context_t *ctx, caterva_array_t **array);
 
@@ -29,14 +36,42 @@ int caterva_blosc_from_file(caterva_context_t *ctx, const char *filename, bool c
 int caterva_blosc_array_repart_chunk(int8_t *rchunk, int64_t rchunksize, void *chunk,
                                      int64_t chunksize, caterva_array_t *array);
 
-int caterva_blosc_array_append(caterva_context_t *ctx, caterva_array_t *array, void *chunk,
-                               int64_t chunksize);
+int caterva_blosc_read_chunk(caterva_context_t *ctx, caterva_array_t *array,
+                             blosc2_context *dctx, int64_t nchunk, bool *maskout, uint8_t *dest,
+                             size_t destsize, uint8_t *value, bool *uniform,
+                             caterva_stats_t *stats);
+
+int caterva_blosc_encode_rchunk(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                                uint8_t *rchunk, caterva_stats_t *stats);
+
+int caterva_blosc_uniform_cchunk(caterva_array_t *array, const uint8_t *value, uint8_t *cchunk);
+
+int64_t caterva_blosc_chunk_shape(caterva_array_t *array, int64_t nchunk, int64_t *cshape);
+
+int caterva_blosc_array_append_many(caterva_context_t *ctx, caterva_array_t *array, void **chunks,
+                                    int64_t *chunksizes, int64_t nchunks);
+
+int caterva_blosc_select_cparams(caterva_context_t *ctx, caterva_array_t *array,
+                                 const uint8_t *rchunk);
+
+int caterva_blosc_array_flush(caterva_context_t *ctx, caterva_array_t *array);
+
+int caterva_blosc_array_store_indexes(caterva_context_t *ctx, caterva_array_t *array);
+
+int caterva_blosc_array_append_cchunk(caterva_context_t *ctx, caterva_array_t *array,
+                                      uint8_t *cchunk);
+
+int caterva_blosc_index_cchunk(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                               const uint8_t *cchunk);
+
+int caterva_blosc_array_set_chunk(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                                  void *chunk, int64_t chunksize);
 
 int caterva_blosc_array_from_buffer(caterva_context_t *ctx, caterva_array_t *array, void *buffer,
                                     int64_t buffersize);
 
 int caterva_blosc_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t *array,
-                                         int64_t *start, int64_t *stop, int64_t *shape,
+                                         int64_t *start, int64_t *stop, const int64_t *shape,
                                          void *buffer);
 
 int caterva_blosc_array_to_buffer(caterva_context_t *ctx, caterva_array_t *array, void *buffer);
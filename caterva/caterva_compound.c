@@ -0,0 +1,576 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <assert.h>
+#include <caterva.h>
+
+#include "caterva_compound.h"
+#include "caterva_utils.h"
+
+// The items of a compound array are records made of fields. Each field is stored in an array of
+// its own (with the shapes of the compound array), so that it is shuffled and compressed with its
+// own type size and a read only decompresses the fields it asks for.
+
+/* The longest name of a field (it is stored as a msgpack str 8) */
+#define CATERVA_FIELD_NAME_MAXLEN 255
+
+static char fields_metalayer[] = "caterva_fields";
+
+// The metalayer of the array of a field is [nfield, [[name, itemsize], ...]] (smeta is released
+// with caterva_free() as scratch memory)
+static int serialize_fields(caterva_context_t *ctx, int8_t nfield, int8_t nfields,
+                            const caterva_field_t *fields, uint8_t **smeta, int32_t *smeta_len) {
+    *smeta_len = 5;
+    for (int i = 0; i < nfields; ++i) {
+        *smeta_len += 5 + (int32_t) strlen(fields[i].name);
+    }
+    *smeta = caterva_malloc(ctx, (size_t) *smeta_len, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(*smeta);
+    uint8_t *pmeta = *smeta;
+
+    *pmeta++ = 0x90 + 2;  // fixarray with 2 elements
+    *pmeta++ = (uint8_t) nfield;  // positive fixnum (7-bit positive integer)
+    *pmeta++ = 0xdc;  // array 16
+    *pmeta++ = 0;
+    *pmeta++ = (uint8_t) nfields;
+    for (int i = 0; i < nfields; ++i) {
+        uint8_t namelen = (uint8_t) strlen(fields[i].name);
+        *pmeta++ = 0x90 + 2;  // fixarray with 2 elements
+        *pmeta++ = 0xd9;  // str 8
+        *pmeta++ = namelen;
+        memcpy(pmeta, fields[i].name, namelen);
+        pmeta += namelen;
+        *pmeta++ = 0xcc;  // uint 8
+        *pmeta++ = fields[i].itemsize;
+    }
+    assert(pmeta - *smeta == *smeta_len);
+    return CATERVA_SUCCEED;
+}
+
+// Read the metalayer of the array of a field (the names are copied into names)
+static int deserialize_fields(const uint8_t *smeta, uint32_t smeta_len, int8_t *nfield,
+                              int8_t *nfields, caterva_field_t *fields,
+                              char (*names)[CATERVA_FIELD_NAME_MAXLEN + 1]) {
+    const uint8_t *pmeta = smeta;
+    const uint8_t *end = smeta + smeta_len;
+    if (smeta_len < 5 || pmeta[0] != 0x90 + 2 || pmeta[2] != 0xdc) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    *nfield = (int8_t) pmeta[1];
+    int32_t n = pmeta[3] << 8 | pmeta[4];
+    if (n < 1 || n > CATERVA_MAX_FIELDS || *nfield >= n) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    *nfields = (int8_t) n;
+    pmeta += 5;
+    for (int i = 0; i < n; ++i) {
+        if (end - pmeta < 3 || pmeta[0] != 0x90 + 2 || pmeta[1] != 0xd9 ||
+            end - pmeta < 5 + pmeta[2] || pmeta[3 + pmeta[2]] != 0xcc) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        uint8_t namelen = pmeta[2];
+        memcpy(names[i], pmeta + 3, namelen);
+        names[i][namelen] = '\0';
+        fields[i].name = names[i];
+        fields[i].itemsize = pmeta[4 + namelen];
+        pmeta += 5 + namelen;
+    }
+    return CATERVA_SUCCEED;
+}
+
+static int check_fields(int8_t nfields, const caterva_field_t *fields) {
+    if (nfields < 1 || nfields > CATERVA_MAX_FIELDS) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    for (int i = 0; i < nfields; ++i) {
+        CATERVA_ERROR_NULL(fields[i].name);
+        size_t namelen = strlen(fields[i].name);
+        if (namelen == 0 || namelen > CATERVA_FIELD_NAME_MAXLEN || fields[i].itemsize == 0) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        for (int j = 0; j < i; ++j) {
+            if (strcmp(fields[i].name, fields[j].name) == 0) {
+                DEBUG_PRINT("The names of the fields must be unique");
+                return CATERVA_ERR_INVALID_ARGUMENT;
+            }
+        }
+    }
+    return CATERVA_SUCCEED;
+}
+
+// The storage of the array of a field (with the fields metalayer)
+static int field_storage(caterva_storage_t *storage, uint8_t *smeta, int32_t smeta_len,
+                         caterva_storage_t *fstorage) {
+    memcpy(fstorage, storage, sizeof(caterva_storage_t));
+    if (storage->backend == CATERVA_STORAGE_PLAINBUFFER) {
+        if (storage->properties.plainbuffer.filename != NULL) {
+            DEBUG_PRINT("The fields of a compound array are saved on their own");
+            return CATERVA_ERR_INVALID_STORAGE;
+        }
+        return CATERVA_SUCCEED;
+    }
+
+    caterva_storage_properties_blosc_t *blosc = &fstorage->properties.blosc;
+    if (blosc->filename != NULL) {
+        DEBUG_PRINT("The fields of a compound array are saved on their own");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (blosc->nmetalayers >= CATERVA_MAX_METALAYERS) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    caterva_metalayer_t *metalayer = &blosc->metalayers[blosc->nmetalayers++];
+    metalayer->name = fields_metalayer;
+    metalayer->sdata = smeta;
+    metalayer->size = smeta_len;
+    return CATERVA_SUCCEED;
+}
+
+// Copy a field of nitems records into a buffer of its own
+static void gather_field(const uint8_t *records, int64_t nitems, int32_t recordsize,
+                         int32_t offset, int32_t itemsize, uint8_t *dest) {
+    for (int64_t i = 0; i < nitems; ++i) {
+        memcpy(dest + i * itemsize, records + i * recordsize + offset, (size_t) itemsize);
+    }
+}
+
+// Copy a slice of a field (at the origin of a buffer with the given shape) into the records of a
+// buffer with the same shape
+static void scatter_field(int8_t ndim, const int64_t *start, const int64_t *stop,
+                          const int64_t *shape, const uint8_t *src, int32_t itemsize,
+                          uint8_t *dest, int32_t recordsize, int32_t offset) {
+    int64_t slice_shape[CATERVA_MAX_DIM];
+    int64_t nrows = 1;
+    for (int i = 0; i < ndim; ++i) {
+        slice_shape[i] = stop[i] - start[i];
+        if (slice_shape[i] <= 0) {
+            return;
+        }
+        nrows *= i < ndim - 1 ? slice_shape[i] : 1;
+    }
+    int64_t rowlen = ndim > 0 ? slice_shape[ndim - 1] : 1;
+
+    for (int64_t row = 0; row < nrows; ++row) {
+        int64_t index = 0;
+        int64_t r = row;
+        int64_t stride = ndim > 0 ? shape[ndim - 1] : 1;
+        for (int i = ndim - 2; i >= 0; --i) {
+            index += r % slice_shape[i] * stride;
+            r /= slice_shape[i];
+            stride *= shape[i];
+        }
+        for (int64_t j = index; j < index + rowlen; ++j) {
+            memcpy(dest + j * recordsize + offset, src + j * itemsize, (size_t) itemsize);
+        }
+    }
+}
+
+// The shapes and chunk counts of a compound array follow the ones of its fields
+static void sync_fields(caterva_array_t *array) {
+    caterva_array_t *field = array->field_arrays[0];
+    array->ndim = field->ndim;
+    memcpy(array->shape, field->shape, sizeof(array->shape));
+    memcpy(array->chunkshape, field->chunkshape, sizeof(array->chunkshape));
+    memcpy(array->extshape, field->extshape, sizeof(array->extshape));
+    memcpy(array->blockshape, field->blockshape, sizeof(array->blockshape));
+    memcpy(array->extchunkshape, field->extchunkshape, sizeof(array->extchunkshape));
+    memcpy(array->next_chunkshape, field->next_chunkshape, sizeof(array->next_chunkshape));
+    array->nitems = field->nitems;
+    array->chunknitems = field->chunknitems;
+    array->extnitems = field->extnitems;
+    array->blocknitems = field->blocknitems;
+    array->extchunknitems = field->extchunknitems;
+    array->next_chunknitems = field->next_chunknitems;
+    array->empty = field->empty;
+    array->filled = field->filled;
+    array->nchunks = field->nchunks;
+}
+
+// Create a compound array that takes over the arrays of its fields
+static int compound_new(caterva_context_t *ctx, int8_t nfields, const caterva_field_t *fields,
+                        caterva_array_t **field_arrays, caterva_array_t **array) {
+    *array = (caterva_array_t *) caterva_malloc(ctx, sizeof(caterva_array_t),
+                                                CATERVA_ALLOC_ARRAY);
+    CATERVA_ERROR_NULL(*array);
+    memset(*array, 0, sizeof(caterva_array_t));
+    (*array)->storage = field_arrays[0]->storage;
+    (*array)->chunk_cache.nchunk = -1;
+
+    (*array)->fields = caterva_malloc(ctx, nfields * sizeof(caterva_field_t),
+                                      CATERVA_ALLOC_ARRAY);
+    CATERVA_ERROR_NULL((*array)->fields);
+    (*array)->field_arrays = caterva_malloc(ctx, nfields * sizeof(caterva_array_t *),
+                                            CATERVA_ALLOC_ARRAY);
+    CATERVA_ERROR_NULL((*array)->field_arrays);
+    for (int i = 0; i < nfields; ++i) {
+        size_t namesize = strlen(fields[i].name) + 1;
+        (*array)->fields[i].name = caterva_malloc(ctx, namesize, CATERVA_ALLOC_ARRAY);
+        CATERVA_ERROR_NULL((*array)->fields[i].name);
+        memcpy((*array)->fields[i].name, fields[i].name, namesize);
+        (*array)->fields[i].itemsize = fields[i].itemsize;
+        (*array)->field_arrays[i] = field_arrays[i];
+        (*array)->recordsize += fields[i].itemsize;
+        (*array)->nfields++;
+    }
+    sync_fields(*array);
+
+    return CATERVA_SUCCEED;
+}
+
+// Create the arrays of the fields (out of a buffer of records, if it is not NULL, or else filled
+// with a record, if it is not NULL)
+static int compound_create(caterva_context_t *ctx, caterva_compound_params_t *params,
+                           caterva_storage_t *storage, const uint8_t *fill_value,
+                           const uint8_t *buffer, caterva_array_t **array) {
+    CATERVA_ERROR(check_fields(params->nfields, params->fields));
+
+    int64_t nitems = 1;
+    for (int i = 0; i < params->ndim; ++i) {
+        nitems *= params->shape[i];
+    }
+    int32_t recordsize = 0;
+    for (int i = 0; i < params->nfields; ++i) {
+        recordsize += params->fields[i].itemsize;
+    }
+
+    caterva_array_t *field_arrays[CATERVA_MAX_FIELDS] = {0};
+    int rc = CATERVA_SUCCEED;
+    int32_t offset = 0;
+    for (int8_t i = 0; i < params->nfields && rc == CATERVA_SUCCEED; ++i) {
+        uint8_t itemsize = params->fields[i].itemsize;
+        caterva_params_t fparams;
+        fparams.itemsize = itemsize;
+        fparams.ndim = params->ndim;
+        memcpy(fparams.shape, params->shape, sizeof(fparams.shape));
+
+        uint8_t *smeta;
+        int32_t smeta_len;
+        rc = serialize_fields(ctx, i, params->nfields, params->fields, &smeta, &smeta_len);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        caterva_storage_t fstorage;
+        rc = field_storage(storage, smeta, smeta_len, &fstorage);
+        if (rc == CATERVA_SUCCEED && buffer == NULL && fill_value != NULL) {
+            rc = caterva_array_full(ctx, &fparams, &fstorage, fill_value + offset,
+                                    &field_arrays[i]);
+        } else if (rc == CATERVA_SUCCEED && buffer == NULL) {
+            rc = caterva_array_empty(ctx, &fparams, &fstorage, &field_arrays[i]);
+        } else if (rc == CATERVA_SUCCEED) {
+            size_t fbuffersize = (size_t) (nitems * itemsize);
+            uint8_t *fbuffer = caterva_malloc(ctx, fbuffersize, CATERVA_ALLOC_SCRATCH);
+            if (fbuffer == NULL) {
+                rc = CATERVA_ERR_NULL_POINTER;
+            } else {
+                gather_field(buffer, nitems, recordsize, offset, itemsize, fbuffer);
+                rc = caterva_array_from_buffer(ctx, fbuffer, nitems * itemsize, &fparams,
+                                               &fstorage, &field_arrays[i]);
+                caterva_free(ctx, fbuffer, fbuffersize, CATERVA_ALLOC_SCRATCH);
+            }
+        }
+        caterva_free(ctx, smeta, (size_t) smeta_len, CATERVA_ALLOC_SCRATCH);
+        offset += itemsize;
+    }
+    if (rc != CATERVA_SUCCEED) {
+        for (int i = 0; i < params->nfields; ++i) {
+            if (field_arrays[i] != NULL) {
+                caterva_array_free(ctx, &field_arrays[i]);
+            }
+        }
+        CATERVA_ERROR(rc);
+    }
+
+    CATERVA_ERROR(compound_new(ctx, params->nfields, params->fields, field_arrays, array));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_empty_fields(caterva_context_t *ctx, caterva_compound_params_t *params,
+                               caterva_storage_t *storage, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(compound_create(ctx, params, storage, NULL, NULL, array));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_full_fields(caterva_context_t *ctx, caterva_compound_params_t *params,
+                              caterva_storage_t *storage, const void *fill_value,
+                              caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(fill_value);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(compound_create(ctx, params, storage, fill_value, NULL, array));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_from_buffer_fields(caterva_context_t *ctx, void *buffer, int64_t buffersize,
+                                     caterva_compound_params_t *params,
+                                     caterva_storage_t *storage, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(buffer);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(check_fields(params->nfields, params->fields));
+    int64_t nbytes = 0;
+    for (int i = 0; i < params->nfields; ++i) {
+        nbytes += params->fields[i].itemsize;
+    }
+    for (int i = 0; i < params->ndim; ++i) {
+        nbytes *= params->shape[i];
+    }
+    if (buffersize != nbytes) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    CATERVA_ERROR(compound_create(ctx, params, storage, NULL, buffer, array));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_compound_array_free(caterva_context_t *ctx, caterva_array_t **array) {
+    int rc = CATERVA_SUCCEED;
+    for (int i = 0; i < (*array)->nfields; ++i) {
+        // It may fail writing the chunks left in the append buffer of a field
+        int frc = caterva_array_free(ctx, &(*array)->field_arrays[i]);
+        rc = rc == CATERVA_SUCCEED ? frc : rc;
+        caterva_free(ctx, (*array)->fields[i].name, strlen((*array)->fields[i].name) + 1,
+                     CATERVA_ALLOC_ARRAY);
+    }
+    caterva_free(ctx, (*array)->fields, (*array)->nfields * sizeof(caterva_field_t),
+                 CATERVA_ALLOC_ARRAY);
+    caterva_free(ctx, (*array)->field_arrays, (*array)->nfields * sizeof(caterva_array_t *),
+                 CATERVA_ALLOC_ARRAY);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_compound_array_append_many(caterva_context_t *ctx, caterva_array_t *array,
+                                       void **chunks, int64_t *chunksizes, int64_t nchunks) {
+    if (nchunks == 0) {
+        return CATERVA_SUCCEED;
+    }
+    int64_t nbytes = 0;
+    for (int64_t i = 0; i < nchunks; ++i) {
+        CATERVA_ERROR_NULL(chunks[i]);
+        if (chunksizes[i] % array->recordsize != 0) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        nbytes += chunksizes[i];
+    }
+
+    // The chunks of each field are gathered and appended in turn
+    void **fchunks = caterva_malloc(ctx, (size_t) nchunks * sizeof(void *),
+                                    CATERVA_ALLOC_SCRATCH);
+    int64_t *fchunksizes = caterva_malloc(ctx, (size_t) nchunks * sizeof(int64_t),
+                                          CATERVA_ALLOC_SCRATCH);
+    uint8_t *fdata = caterva_malloc(ctx, (size_t) nbytes, CATERVA_ALLOC_SCRATCH);
+    int rc = CATERVA_SUCCEED;
+    if (fchunks == NULL || fchunksizes == NULL || fdata == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    int32_t offset = 0;
+    for (int f = 0; f < array->nfields && rc == CATERVA_SUCCEED; ++f) {
+        int32_t itemsize = array->fields[f].itemsize;
+        uint8_t *pdata = fdata;
+        for (int64_t i = 0; i < nchunks; ++i) {
+            int64_t nitems = chunksizes[i] / array->recordsize;
+            gather_field(chunks[i], nitems, array->recordsize, offset, itemsize, pdata);
+            fchunks[i] = pdata;
+            fchunksizes[i] = nitems * itemsize;
+            pdata += fchunksizes[i];
+        }
+        rc = caterva_array_append_many(ctx, array->field_arrays[f], fchunks, fchunksizes,
+                                       nchunks);
+        offset += itemsize;
+    }
+    caterva_free(ctx, fchunks, (size_t) nchunks * sizeof(void *), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, fchunksizes, (size_t) nchunks * sizeof(int64_t), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, fdata, (size_t) nbytes, CATERVA_ALLOC_SCRATCH);
+    sync_fields(array);
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_compound_array_flush(caterva_context_t *ctx, caterva_array_t *array) {
+    for (int i = 0; i < array->nfields; ++i) {
+        CATERVA_ERROR(caterva_array_flush(ctx, array->field_arrays[i]));
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_compound_array_squeeze(caterva_context_t *ctx, caterva_array_t *array) {
+    for (int i = 0; i < array->nfields; ++i) {
+        CATERVA_ERROR(caterva_array_squeeze(ctx, array->field_arrays[i]));
+    }
+    sync_fields(array);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_compound_array_copy(caterva_context_t *ctx, caterva_array_t *src,
+                                caterva_storage_t *storage, caterva_array_t **array) {
+    caterva_array_t *field_arrays[CATERVA_MAX_FIELDS] = {0};
+    int rc = CATERVA_SUCCEED;
+    for (int8_t i = 0; i < src->nfields && rc == CATERVA_SUCCEED; ++i) {
+        uint8_t *smeta;
+        int32_t smeta_len;
+        rc = serialize_fields(ctx, i, src->nfields, src->fields, &smeta, &smeta_len);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        caterva_storage_t fstorage;
+        rc = field_storage(storage, smeta, smeta_len, &fstorage);
+        if (rc == CATERVA_SUCCEED) {
+            rc = caterva_array_copy(ctx, src->field_arrays[i], &fstorage, &field_arrays[i]);
+        }
+        caterva_free(ctx, smeta, (size_t) smeta_len, CATERVA_ALLOC_SCRATCH);
+    }
+    if (rc != CATERVA_SUCCEED) {
+        for (int i = 0; i < src->nfields; ++i) {
+            if (field_arrays[i] != NULL) {
+                caterva_array_free(ctx, &field_arrays[i]);
+            }
+        }
+        CATERVA_ERROR(rc);
+    }
+
+    CATERVA_ERROR(compound_new(ctx, src->nfields, src->fields, field_arrays, array));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_get_field(caterva_context_t *ctx, caterva_array_t *array, const char *name,
+                            caterva_array_t **field) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(name);
+    CATERVA_ERROR_NULL(field);
+
+    for (int i = 0; i < array->nfields; ++i) {
+        if (strcmp(array->fields[i].name, name) == 0) {
+            *field = array->field_arrays[i];
+            return CATERVA_SUCCEED;
+        }
+    }
+    DEBUG_PRINT("The array has no such field");
+    return CATERVA_ERR_INVALID_ARGUMENT;
+}
+
+int caterva_array_get_fields_slice_buffer(caterva_context_t *ctx, caterva_array_t *src,
+                                          const char **names, int8_t nnames, int64_t *start,
+                                          int64_t *stop, int64_t *shape, void *buffer,
+                                          int64_t buffersize) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(src);
+    CATERVA_ERROR_NULL(names);
+    CATERVA_ERROR_NULL(start);
+    CATERVA_ERROR_NULL(stop);
+    CATERVA_ERROR_NULL(shape);
+    CATERVA_ERROR_NULL(buffer);
+
+    if (nnames < 1) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    caterva_array_t *field_arrays[CATERVA_MAX_FIELDS];
+    int32_t recordsize = 0;
+    for (int i = 0; i < nnames; ++i) {
+        CATERVA_ERROR(caterva_array_get_field(ctx, src, names[i], &field_arrays[i]));
+        recordsize += field_arrays[i]->itemsize;
+    }
+    int64_t nitems = 1;
+    for (int i = 0; i < src->ndim; ++i) {
+        if (stop[i] - start[i] > shape[i]) {
+            DEBUG_PRINT("The buffer shape can not be smaller than the slice shape");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+        nitems *= shape[i];
+    }
+    if (buffersize < nitems * recordsize) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    // Only the fields requested are read
+    int32_t offset = 0;
+    for (int i = 0; i < nnames; ++i) {
+        int32_t itemsize = field_arrays[i]->itemsize;
+        size_t fbuffersize = (size_t) (nitems * itemsize);
+        uint8_t *fbuffer = caterva_malloc(ctx, fbuffersize, CATERVA_ALLOC_SCRATCH);
+        CATERVA_ERROR_NULL(fbuffer);
+        int rc = caterva_array_get_slice_buffer(ctx, field_arrays[i], start, stop, shape, fbuffer,
+                                                nitems * itemsize);
+        if (rc == CATERVA_SUCCEED) {
+            scatter_field(src->ndim, start, stop, shape, fbuffer, itemsize, buffer, recordsize,
+                          offset);
+        }
+        caterva_free(ctx, fbuffer, fbuffersize, CATERVA_ALLOC_SCRATCH);
+        CATERVA_ERROR(rc);
+        offset += itemsize;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_from_fields(caterva_context_t *ctx, caterva_array_t **fields, int8_t nfields,
+                              caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(fields);
+    CATERVA_ERROR_NULL(array);
+
+    if (nfields < 1 || nfields > CATERVA_MAX_FIELDS) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    caterva_field_t expected[CATERVA_MAX_FIELDS];
+    char names[CATERVA_MAX_FIELDS][CATERVA_FIELD_NAME_MAXLEN + 1];
+    for (int8_t i = 0; i < nfields; ++i) {
+        caterva_array_t *field = fields[i];
+        CATERVA_ERROR_NULL(field);
+        if (field->storage != CATERVA_STORAGE_BLOSC || field->nfields > 0 ||
+            blosc2_has_metalayer(field->sc, fields_metalayer) < 0) {
+            DEBUG_PRINT("The array is not the field of a compound array");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+        uint8_t *smeta;
+        uint32_t smeta_len;
+        if (blosc2_get_metalayer(field->sc, fields_metalayer, &smeta, &smeta_len) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        // The list of fields is taken from the first array and checked against the others
+        int8_t nfield;
+        int8_t n;
+        caterva_field_t parsed[CATERVA_MAX_FIELDS];
+        char parsed_names[CATERVA_MAX_FIELDS][CATERVA_FIELD_NAME_MAXLEN + 1];
+        int rc = deserialize_fields(smeta, smeta_len, &nfield, &n, i == 0 ? expected : parsed,
+                                    i == 0 ? names : parsed_names);
+        free(smeta);
+        CATERVA_ERROR(rc);
+        bool same = nfield == i && n == nfields;
+        for (int j = 0; same && i > 0 && j < nfields; ++j) {
+            same = strcmp(parsed[j].name, expected[j].name) == 0 &&
+                   parsed[j].itemsize == expected[j].itemsize;
+        }
+        same = same && field->itemsize == expected[i].itemsize && field->ndim == fields[0]->ndim;
+        for (int j = 0; same && j < field->ndim; ++j) {
+            same = field->shape[j] == fields[0]->shape[j] &&
+                   field->chunkshape[j] == fields[0]->chunkshape[j];
+        }
+        if (!same || field->nchunks != fields[0]->nchunks) {
+            DEBUG_PRINT("The arrays are not the fields of the same compound array");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    CATERVA_ERROR(compound_new(ctx, nfields, expected, fields, array));
+    return CATERVA_SUCCEED;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#ifndef CATERVA_CATERVA_COMPOUND_H_
+#define CATERVA_CATERVA_COMPOUND_H_
+
+int caterva_compound_array_free(caterva_context_t *ctx, caterva_array_t **array);
+
+int caterva_compound_array_append_many(caterva_context_t *ctx, caterva_array_t *array,
+                                       void **chunks, int64_t *chunksizes, int64_t nchunks);
+
+int caterva_compound_array_flush(caterva_context_t *ctx, caterva_array_t *array);
+
+int caterva_compound_array_squeeze(caterva_context_t *ctx, caterva_array_t *array);
+
+int caterva_compound_array_copy(caterva_context_t *ctx, caterva_array_t *src,
+                                caterva_storage_t *storage, caterva_array_t **array);
+
+#endif  // CATERVA_CATERVA_COMPOUND_H_
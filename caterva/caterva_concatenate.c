@@ -0,0 +1,376 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_blosc.h"
+#include "caterva_utils.h"
+
+/* The size of the slabs copied at once when the destination is a plain buffer */
+#define CATERVA_JOIN_SLAB_SIZE (16 * 1024 * 1024)
+
+/*
+ * Concatenation and stacking share the same machinery. Every input is seen through a virtual
+ * geometry with the dimensions of the result: when stacking, a unit dimension is inserted at
+ * the stacking axis (this does not change the layout of the data, nor the one of the chunks).
+ * A destination chunk that matches a whole chunk of one of the inputs, with the same geometry
+ * and compression parameters, is copied compressed; the rest are decompressed and rebuilt.
+ */
+
+typedef struct {
+    caterva_array_t *array;
+    int64_t offset;
+    //!< The position of the input along the axis.
+    int64_t shape[CATERVA_MAX_DIM];
+    //!< The virtual shape.
+    int64_t grid[CATERVA_MAX_DIM];
+    //!< The virtual number of chunks along each axis.
+    bool passthrough;
+    //!< Whether the chunks of the input can be copied compressed.
+} join_input_t;
+
+// Whether the chunks compressed with cparams can be copied into the array
+static bool same_cparams(blosc2_cparams *cparams, blosc2_cparams *dest_cparams) {
+    if (dest_cparams->prefilter != NULL || cparams->compcode != dest_cparams->compcode ||
+        cparams->clevel != dest_cparams->clevel || cparams->use_dict != dest_cparams->use_dict ||
+        cparams->typesize != dest_cparams->typesize ||
+        cparams->blocksize != dest_cparams->blocksize) {
+        return false;
+    }
+    for (int i = 0; i < BLOSC2_MAX_FILTERS; ++i) {
+        if (cparams->filters[i] != dest_cparams->filters[i] ||
+            cparams->filters_meta[i] != dest_cparams->filters_meta[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Convert virtual coordinates of an input into its real ones
+static void real_coords(int8_t ndim, int8_t axis, bool stacked, const int64_t *vcoords,
+                        int64_t *coords) {
+    int n = 0;
+    for (int i = 0; i < ndim; ++i) {
+        if (stacked && i == axis) {
+            continue;
+        }
+        coords[n++] = vcoords[i];
+    }
+}
+
+// Copy the part of an input overlapping [start, stop) into a C-ordered buffer of a given shape
+static int copy_input(caterva_context_t *ctx, join_input_t *input, int8_t ndim, int8_t axis,
+                      bool stacked, const int64_t *start, const int64_t *stop,
+                      const int64_t *shape, uint8_t *buffer, uint8_t *tmp) {
+    int32_t itemsize = input->array->itemsize;
+    int64_t vstart[CATERVA_MAX_DIM];
+    int64_t vstop[CATERVA_MAX_DIM];
+    int64_t vshape[CATERVA_MAX_DIM];
+    int64_t dest_start[CATERVA_MAX_DIM];
+    int64_t tmp_start[CATERVA_MAX_DIM] = {0};
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        int64_t offset = i == axis ? input->offset : 0;
+        int64_t lo = start[i] > offset ? start[i] : offset;
+        int64_t hi = stop[i] < offset + input->shape[i] ? stop[i] : offset + input->shape[i];
+        if (lo >= hi) {
+            return CATERVA_SUCCEED;
+        }
+        vstart[i] = lo - offset;
+        vstop[i] = hi - offset;
+        vshape[i] = hi - lo;
+        dest_start[i] = lo - start[i];
+        nitems *= vshape[i];
+    }
+
+    int64_t rstart[CATERVA_MAX_DIM];
+    int64_t rstop[CATERVA_MAX_DIM];
+    int64_t rshape[CATERVA_MAX_DIM];
+    real_coords(ndim, axis, stacked, vstart, rstart);
+    real_coords(ndim, axis, stacked, vstop, rstop);
+    real_coords(ndim, axis, stacked, vshape, rshape);
+    CATERVA_ERROR(caterva_array_get_slice_buffer(ctx, input->array, rstart, rstop, rshape, tmp,
+                                                 nitems * itemsize));
+    CATERVA_ERROR(caterva_copy_region(ctx, ndim, itemsize, vshape, tmp, vshape, tmp_start,
+                                      buffer, shape, dest_start));
+    return CATERVA_SUCCEED;
+}
+
+static int join_blosc(caterva_context_t *ctx, join_input_t *inputs, int narrays, int8_t axis,
+                      bool stacked, caterva_array_t *array) {
+    int8_t ndim = array->ndim;
+    size_t chunksize = (size_t) array->chunknitems * array->itemsize;
+    uint8_t *chunk = caterva_malloc(ctx, chunksize, CATERVA_ALLOC_CHUNK);
+    uint8_t *tmp = caterva_malloc(ctx, chunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR_NULL(chunk);
+    CATERVA_ERROR_NULL(tmp);
+
+    int64_t grid[CATERVA_MAX_DIM];
+    int64_t nchunks = 1;
+    for (int i = 0; i < ndim; ++i) {
+        grid[i] = array->extshape[i] / array->chunkshape[i];
+        nchunks *= grid[i];
+    }
+
+    int rc = CATERVA_SUCCEED;
+    for (int64_t nchunk = 0; nchunk < nchunks && rc == CATERVA_SUCCEED; ++nchunk) {
+        int64_t index[CATERVA_MAX_DIM];
+        int64_t start[CATERVA_MAX_DIM];
+        int64_t stop[CATERVA_MAX_DIM];
+        int64_t shape[CATERVA_MAX_DIM];
+        int64_t rem = nchunk;
+        for (int i = ndim - 1; i >= 0; --i) {
+            index[i] = rem % grid[i];
+            rem /= grid[i];
+            start[i] = index[i] * array->chunkshape[i];
+            shape[i] = array->next_chunkshape[i];
+            stop[i] = start[i] + shape[i];
+        }
+
+        // Look for an input chunk matching the destination chunk
+        int k = 0;
+        while (k < narrays - 1 && start[axis] >= inputs[k + 1].offset) {
+            k++;
+        }
+        join_input_t *input = &inputs[k];
+        int64_t local = start[axis] - input->offset;
+        int64_t input_stop = input->offset + input->shape[axis];
+        bool aligned = local % array->chunkshape[axis] == 0;
+        int64_t input_len = input_stop - start[axis] < array->chunkshape[axis]
+                                ? input_stop - start[axis] : array->chunkshape[axis];
+        int64_t input_nchunk = -1;
+        if (input->passthrough && aligned && input_len == shape[axis]) {
+            input_nchunk = 0;
+            for (int i = 0; i < ndim; ++i) {
+                int64_t ii = i == axis ? local / array->chunkshape[i] : index[i];
+                input_nchunk = input_nchunk * input->grid[i] + ii;
+            }
+        }
+        // The implicit chunks of an array with a fill value are not stored, so they are rebuilt
+        int64_t input_position = input_nchunk >= 0
+                                     ? caterva_chunk_position(input->array, input_nchunk) : -1;
+        if (input_position >= 0 && input_position < input->array->sc->nchunks) {
+            caterva_stats_t stats = {0};
+            blosc_timestamp_t t0;
+            uint8_t *cchunk;
+            bool needs_free;
+            caterva_stage_begin(ctx, CATERVA_STAGE_IO, input->array, input_nchunk, &t0);
+            int csize = blosc2_schunk_get_chunk(input->array->sc, (int) input_position, &cchunk,
+                                                &needs_free);
+            caterva_stage_end(ctx, CATERVA_STAGE_IO, input->array, input_nchunk, csize, &t0,
+                              &stats);
+            if (csize < 0) {
+                rc = CATERVA_ERR_BLOSC_FAILED;
+                break;
+            }
+            stats.bytes_read = csize;
+            caterva_stats_merge(ctx, input->array, &stats);
+            rc = caterva_blosc_array_append_cchunk(ctx, array, cchunk);
+            // The indexes of the destination are built out of the chunk decompressed
+            if (rc == CATERVA_SUCCEED) {
+                rc = caterva_blosc_index_cchunk(ctx, array, nchunk, cchunk);
+            }
+            if (needs_free) {
+                free(cchunk);
+            }
+            array->nchunks++;
+            array->empty = false;
+            continue;
+        }
+
+        // Rebuild the chunk out of the inputs that overlap it
+        for (int j = k; j < narrays && inputs[j].offset < stop[axis]; ++j) {
+            rc = copy_input(ctx, &inputs[j], ndim, axis, stacked, start, stop, shape, chunk, tmp);
+            if (rc != CATERVA_SUCCEED) {
+                break;
+            }
+        }
+        if (rc == CATERVA_SUCCEED) {
+            rc = caterva_array_append(ctx, array, chunk,
+                                      array->next_chunknitems * array->itemsize);
+        }
+    }
+
+    caterva_free(ctx, chunk, chunksize, CATERVA_ALLOC_CHUNK);
+    caterva_free(ctx, tmp, chunksize, CATERVA_ALLOC_CHUNK);
+    return rc;
+}
+
+static int join_plainbuffer(caterva_context_t *ctx, join_input_t *inputs, int narrays,
+                            int8_t axis, bool stacked, caterva_array_t *array) {
+    int8_t ndim = array->ndim;
+    int64_t strides[CATERVA_MAX_DIM];
+    int64_t stride = array->itemsize;
+    for (int i = ndim - 1; i >= 0; --i) {
+        strides[i] = stride;
+        stride *= array->shape[i];
+    }
+
+    // The inputs are copied in slabs along the first axis
+    int64_t slablen = CATERVA_JOIN_SLAB_SIZE / strides[0];
+    if (slablen < 1) {
+        slablen = 1;
+    }
+    if (slablen > array->shape[0]) {
+        slablen = array->shape[0];
+    }
+    size_t tmpsize = (size_t) (slablen * strides[0]);
+    uint8_t *tmp = caterva_malloc(ctx, tmpsize, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(tmp);
+
+    int rc = CATERVA_SUCCEED;
+    for (int k = 0; k < narrays && rc == CATERVA_SUCCEED; ++k) {
+        int64_t first = axis == 0 ? inputs[k].offset : 0;
+        int64_t last = first + inputs[k].shape[0];
+        for (int64_t i0 = first; i0 < last && rc == CATERVA_SUCCEED; i0 += slablen) {
+            int64_t start[CATERVA_MAX_DIM] = {0};
+            int64_t stop[CATERVA_MAX_DIM];
+            for (int i = 0; i < ndim; ++i) {
+                stop[i] = array->shape[i];
+            }
+            start[0] = i0;
+            stop[0] = last - i0 < slablen ? last : i0 + slablen;
+            rc = copy_input(ctx, &inputs[k], ndim, axis, stacked, start, stop, array->shape,
+                            array->buf, tmp);
+        }
+    }
+
+    caterva_free(ctx, tmp, tmpsize, CATERVA_ALLOC_SCRATCH);
+    return rc;
+}
+
+static int join_arrays(caterva_context_t *ctx, caterva_array_t **arrays, int narrays,
+                       int8_t axis, bool stacked, caterva_storage_t *storage,
+                       caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(arrays);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(array);
+    if (narrays < 1) {
+        DEBUG_PRINT("At least one array is needed");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    for (int k = 0; k < narrays; ++k) {
+        CATERVA_ERROR_NULL(arrays[k]);
+        CATERVA_ERROR_COMPOUND(arrays[k]);
+        CATERVA_ERROR(caterva_array_flush(ctx, arrays[k]));
+    }
+
+    caterva_array_t *first = arrays[0];
+    CATERVA_ERROR_NULL(first);
+    int8_t ndim = (int8_t) (stacked ? first->ndim + 1 : first->ndim);
+    if (axis < 0 || axis >= ndim || ndim > CATERVA_MAX_DIM) {
+        DEBUG_PRINT("The axis is out of range");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    join_input_t *inputs = caterva_malloc(ctx, narrays * sizeof(join_input_t),
+                                          CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(inputs);
+
+    caterva_params_t params = {0};
+    params.itemsize = first->itemsize;
+    params.ndim = ndim;
+    int64_t offset = 0;
+    for (int k = 0; k < narrays; ++k) {
+        caterva_array_t *input = arrays[k];
+        CATERVA_ERROR_NULL(input);
+        if (input->itemsize != first->itemsize || input->ndim != first->ndim) {
+            caterva_free(ctx, inputs, narrays * sizeof(join_input_t), CATERVA_ALLOC_SCRATCH);
+            DEBUG_PRINT("The arrays must have the same itemsize and dimensions");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+        int n = 0;
+        for (int i = 0; i < ndim; ++i) {
+            inputs[k].shape[i] = stacked && i == axis ? 1 : input->shape[n++];
+            if (i != axis && inputs[k].shape[i] != inputs[0].shape[i]) {
+                caterva_free(ctx, inputs, narrays * sizeof(join_input_t), CATERVA_ALLOC_SCRATCH);
+                DEBUG_PRINT("The shapes of the arrays must match out of the axis");
+                return CATERVA_ERR_INVALID_ARGUMENT;
+            }
+        }
+        inputs[k].array = input;
+        inputs[k].offset = offset;
+        inputs[k].passthrough = false;
+        offset += inputs[k].shape[axis];
+    }
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = i == axis ? offset : inputs[0].shape[i];
+    }
+
+    CATERVA_ERROR(caterva_array_empty(ctx, &params, storage, array));
+    caterva_array_t *dest = *array;
+
+    int rc = CATERVA_SUCCEED;
+    if (dest->storage == CATERVA_STORAGE_BLOSC) {
+        blosc2_cparams *dest_cparams;
+        if (blosc2_schunk_get_cparams(dest->sc, &dest_cparams) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        for (int k = 0; k < narrays; ++k) {
+            caterva_array_t *input = inputs[k].array;
+            if (input->storage != CATERVA_STORAGE_BLOSC) {
+                continue;
+            }
+            bool passthrough = true;
+            int n = 0;
+            for (int i = 0; i < ndim; ++i) {
+                int64_t chunklen = stacked && i == axis ? 1 : input->chunkshape[n];
+                int64_t blocklen = stacked && i == axis ? 1 : input->blockshape[n];
+                int64_t extlen = stacked && i == axis ? 1 : input->extshape[n];
+                if (!(stacked && i == axis)) {
+                    n++;
+                }
+                inputs[k].grid[i] = extlen / chunklen;
+                if (chunklen != dest->chunkshape[i] || blocklen != dest->blockshape[i]) {
+                    passthrough = false;
+                }
+            }
+            blosc2_cparams *cparams;
+            if (blosc2_schunk_get_cparams(input->sc, &cparams) < 0) {
+                free(dest_cparams);
+                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+            }
+            // The chunks stored as deltas depend on their neighbours and the levels are reduced
+            // out of the chunks appended, so they are rebuilt
+            inputs[k].passthrough = passthrough && input->predictor == dest->predictor &&
+                                    input->keyframe_interval == 0 &&
+                                    dest->keyframe_interval == 0 && dest->pyramid_levels == 0 &&
+                                    same_cparams(cparams, dest_cparams);
+            free(cparams);
+        }
+        free(dest_cparams);
+        rc = join_blosc(ctx, inputs, narrays, axis, stacked, dest);
+    } else {
+        rc = join_plainbuffer(ctx, inputs, narrays, axis, stacked, dest);
+    }
+
+    caterva_free(ctx, inputs, narrays * sizeof(join_input_t), CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR(rc);
+    dest->filled = true;
+    dest->empty = false;
+    dest->nchunks = dest->extnitems / dest->chunknitems;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_concatenate(caterva_context_t *ctx, caterva_array_t **arrays, int narrays,
+                              int8_t axis, caterva_storage_t *storage,
+                              caterva_array_t **array) {
+    CATERVA_ERROR(join_arrays(ctx, arrays, narrays, axis, false, storage, array));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_stack(caterva_context_t *ctx, caterva_array_t **arrays, int narrays,
+                        int8_t axis, caterva_storage_t *storage, caterva_array_t **array) {
+    CATERVA_ERROR(join_arrays(ctx, arrays, narrays, axis, true, storage, array));
+    return CATERVA_SUCCEED;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_utils.h"
+
+// The distance between a chunk and the previous one along the delta axis
+static int64_t delta_stride(caterva_array_t *array) {
+    int64_t stride = 1;
+    for (int i = array->delta_axis + 1; i < array->ndim; ++i) {
+        stride *= array->extshape[i] / array->chunkshape[i];
+    }
+    return stride;
+}
+
+int64_t caterva_delta_reference(caterva_array_t *array, int64_t nchunk) {
+    if (array->keyframe_interval <= 0) {
+        return -1;
+    }
+    int64_t stride = delta_stride(array);
+    int8_t axis = array->delta_axis;
+    int64_t index = nchunk / stride % (array->extshape[axis] / array->chunkshape[axis]);
+    if (index % array->keyframe_interval == 0) {
+        return -1;
+    }
+    return nchunk - stride;
+}
+
+void caterva_delta_xor(caterva_array_t *array, uint8_t *rchunk, const uint8_t *reference,
+                       const bool *maskout) {
+    int64_t blocksize = array->blocknitems * array->itemsize;
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        if (maskout != NULL && maskout[nblock]) {
+            continue;
+        }
+        uint8_t *dest = rchunk + nblock * blocksize;
+        const uint8_t *src = reference + nblock * blocksize;
+        for (int64_t i = 0; i < blocksize; ++i) {
+            dest[i] ^= src[i];
+        }
+    }
+}
+
+bool caterva_delta_cache_get(caterva_array_t *array, int64_t nchunk, uint8_t *dest) {
+    struct delta_cache_s *cache = &array->delta_cache;
+    size_t rchunksize = (size_t) array->extchunknitems * array->itemsize;
+    bool found = false;
+#if defined(_OPENMP)
+#pragma omp critical(caterva_delta_cache)
+#endif
+    {
+        for (int32_t i = 0; i < cache->nentries; ++i) {
+            if (cache->nchunks[i] == nchunk) {
+                memcpy(dest, cache->chunks[i], rchunksize);
+                found = true;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+int caterva_delta_cache_put(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                            const uint8_t *src) {
+    struct delta_cache_s *cache = &array->delta_cache;
+    size_t rchunksize = (size_t) array->extchunknitems * array->itemsize;
+    int rc = CATERVA_SUCCEED;
+#if defined(_OPENMP)
+#pragma omp critical(caterva_delta_cache)
+#endif
+    {
+        // The chunks cached are the ones that the next chunks along the axis are deltas of
+        if (cache->capacity == 0) {
+            int64_t capacity = delta_stride(array) + 1;
+            cache->capacity = (int32_t) (capacity < CATERVA_DELTA_NCACHED ? capacity
+                                                                          : CATERVA_DELTA_NCACHED);
+        }
+        int32_t slot = -1;
+        for (int32_t i = 0; i < cache->nentries; ++i) {
+            if (cache->nchunks[i] == nchunk) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0 && cache->nentries < cache->capacity) {
+            slot = cache->nentries;
+            cache->chunks[slot] = caterva_malloc(ctx, rchunksize, CATERVA_ALLOC_CHUNK);
+            if (cache->chunks[slot] == NULL) {
+                rc = CATERVA_ERR_NULL_POINTER;
+            } else {
+                cache->nentries++;
+            }
+        } else if (slot < 0) {
+            // The oldest entry is replaced
+            slot = cache->next;
+            cache->next = (cache->next + 1) % cache->capacity;
+        }
+        if (rc == CATERVA_SUCCEED) {
+            memcpy(cache->chunks[slot], src, rchunksize);
+            cache->nchunks[slot] = nchunk;
+        }
+    }
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+void caterva_delta_cache_free(caterva_context_t *ctx, caterva_array_t *array) {
+    struct delta_cache_s *cache = &array->delta_cache;
+    size_t rchunksize = (size_t) array->extchunknitems * array->itemsize;
+    for (int32_t i = 0; i < cache->nentries; ++i) {
+        caterva_free(ctx, cache->chunks[i], rchunksize, CATERVA_ALLOC_CHUNK);
+    }
+    memset(cache, 0, sizeof(struct delta_cache_s));
+}
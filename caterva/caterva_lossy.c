@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_utils.h"
+
+// The items are rounded to nearest on their mantissa, so that the bits dropped are zeros that the
+// codecs (and shuffle or bitshuffle) squeeze out. Keeping k mantissa bits of an item with exponent
+// e bounds its error by 2^(e - k - 1), which is what the number of bits is derived from:
+//
+// - relative tolerance t: 2^(-k - 1) <= t for every item.
+// - absolute tolerance t: 2^(e - k - 1) <= 2^floor(log2(t)) for each item.
+//
+// The infinities and NaNs are kept as they are, and an item is not rounded up to an infinity. The
+// loops are branchless, so that they can be vectorised.
+
+#define DEFINE_ROUNDING(utype, mbits, bias)                                                       \
+    static void round_##utype(utype *x, int64_t nitems, bool absolute, int64_t keep,             \
+                              int64_t tol_exp, utype tol_bits) {                                 \
+        const utype sign = (utype) ((utype) 1 << (sizeof(utype) * 8 - 1));                       \
+        const utype expmax = (utype) ((sign - 1) >> (mbits));                                    \
+        for (int64_t i = 0; i < nitems; ++i) {                                                   \
+            utype bits = x[i];                                                                   \
+            utype abs = bits & (utype) ~sign;                                                    \
+            int64_t e = (int64_t) (abs >> (mbits)) - (bias);                                     \
+            int64_t drop = absolute ? (mbits) - (e - 1 - tol_exp) : (mbits) - keep;              \
+            drop = drop < 0 ? 0 : (drop > (mbits) ? (mbits) : drop);                             \
+            utype mask = (utype) (((utype) 1 << drop) - 1);                                      \
+            utype half = (utype) (((utype) 1 << drop) >> 1);                                     \
+            utype rounded = (utype) ((bits + half) & (utype) ~mask);                             \
+            utype truncated = bits & (utype) ~mask;                                              \
+            rounded = ((rounded & (utype) ~sign) >> (mbits)) == expmax ? truncated : rounded;    \
+            rounded = (abs >> (mbits)) == expmax ? bits : rounded;                               \
+            rounded = absolute && abs <= tol_bits ? (utype) (bits & sign) : rounded;             \
+            x[i] = rounded;                                                                      \
+        }                                                                                        \
+    }
+
+DEFINE_ROUNDING(uint32_t, 23, 127)
+DEFINE_ROUNDING(uint64_t, 52, 1023)
+
+bool caterva_lossy_supported(caterva_lossy_mode_t mode, double tolerance, int8_t bits,
+                             int32_t itemsize) {
+    if (mode == CATERVA_LOSSY_NONE) {
+        return true;
+    }
+    if (itemsize != 4 && itemsize != 8) {
+        return false;
+    }
+    switch (mode) {
+        case CATERVA_LOSSY_ABSOLUTE:
+        case CATERVA_LOSSY_RELATIVE:
+            return tolerance > 0;
+        case CATERVA_LOSSY_PRECISION:
+            return bits >= 0 && bits <= (itemsize == 4 ? 23 : 52);
+        default:
+            return false;
+    }
+}
+
+void caterva_lossy_round(caterva_array_t *array, uint8_t *rchunk) {
+    if (array->lossy_mode == CATERVA_LOSSY_NONE) {
+        return;
+    }
+    int64_t mbits = array->itemsize == 4 ? 23 : 52;
+    double tolerance = array->lossy_tolerance;
+    bool absolute = array->lossy_mode == CATERVA_LOSSY_ABSOLUTE;
+
+    // The number of mantissa bits kept
+    int64_t keep = mbits;
+    if (array->lossy_mode == CATERVA_LOSSY_PRECISION) {
+        keep = array->lossy_bits;
+    } else if (array->lossy_mode == CATERVA_LOSSY_RELATIVE) {
+        double error = 0.5;
+        for (keep = 0; keep < mbits && error > tolerance; ++keep) {
+            error /= 2;
+        }
+    }
+
+    // The exponent of the absolute tolerance (floor(log2(t)))
+    uint64_t tol64;
+    memcpy(&tol64, &tolerance, sizeof(tol64));
+    int64_t tol_exp = (int64_t) ((tol64 >> 52) & 0x7ff) - 1023;
+
+    int64_t nitems = array->extchunknitems;
+    if (array->itemsize == 4) {
+        // The tolerance is rounded down to a float
+        float tol32 = (float) tolerance;
+        if ((double) tol32 > tolerance) {
+            uint32_t bits;
+            memcpy(&bits, &tol32, sizeof(bits));
+            bits--;
+            memcpy(&tol32, &bits, sizeof(bits));
+        }
+        uint32_t tol_bits;
+        memcpy(&tol_bits, &tol32, sizeof(tol_bits));
+        round_uint32_t((uint32_t *) rchunk, nitems, absolute, keep, tol_exp, tol_bits);
+    } else {
+        round_uint64_t((uint64_t *) rchunk, nitems, absolute, keep, tol_exp, tol64);
+    }
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_utils.h"
+
+// The chunks of an array are numbered in C order, but they can be stored in the superchunk in the
+// order of a space-filling curve over the grid of chunks, so that the chunks close to each other
+// in the array are close to each other in the superchunk too. The key of a chunk in the curve is
+// only computed out of the axes with more than one chunk (so that squeezing an array keeps the
+// positions), and the position of a chunk is the rank of its key.
+
+typedef struct {
+    uint64_t key;
+    int64_t nchunk;
+} order_key_t;
+
+static int compare_keys(const void *a, const void *b) {
+    const order_key_t *ka = a;
+    const order_key_t *kb = b;
+    if (ka->key != kb->key) {
+        return ka->key < kb->key ? -1 : 1;
+    }
+    return ka->nchunk < kb->nchunk ? -1 : ka->nchunk > kb->nchunk;
+}
+
+// Interleave the bits of the coordinates (the first one gives the most significant bit of each
+// group of n)
+static uint64_t interleave(const uint64_t *coords, int n, int bits) {
+    uint64_t key = 0;
+    for (int b = bits - 1; b >= 0; --b) {
+        for (int i = 0; i < n; ++i) {
+            key = (key << 1) | ((coords[i] >> b) & 1);
+        }
+    }
+    return key;
+}
+
+// Transform the coordinates into the transposed Hilbert index (Skilling, "Programming the Hilbert
+// curve", 2004), whose interleaved bits are the index
+static void hilbert_transpose(uint64_t *x, int n, int bits) {
+    uint64_t m = (uint64_t) 1 << (bits - 1);
+    // Inverse undo
+    for (uint64_t q = m; q > 1; q >>= 1) {
+        uint64_t p = q - 1;
+        for (int i = 0; i < n; ++i) {
+            if (x[i] & q) {
+                x[0] ^= p;
+            } else {
+                uint64_t t = (x[0] ^ x[i]) & p;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+    // Gray encode
+    for (int i = 1; i < n; ++i) {
+        x[i] ^= x[i - 1];
+    }
+    uint64_t t = 0;
+    for (uint64_t q = m; q > 1; q >>= 1) {
+        if (x[n - 1] & q) {
+            t ^= q - 1;
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        x[i] ^= t;
+    }
+}
+
+int caterva_order_new(caterva_context_t *ctx, caterva_array_t *array,
+                      caterva_chunk_order_t order) {
+    array->chunk_order = order;
+    array->chunk_positions = NULL;
+    if (order == CATERVA_CHUNK_ORDER_C) {
+        return CATERVA_SUCCEED;
+    }
+    if (order != CATERVA_CHUNK_ORDER_MORTON && order != CATERVA_CHUNK_ORDER_HILBERT) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    // The axes with a single chunk do not move the chunks along the curve
+    int64_t grid[CATERVA_MAX_DIM];
+    int axes[CATERVA_MAX_DIM];
+    int naxes = 0;
+    int bits = 1;
+    for (int i = 0; i < array->ndim; ++i) {
+        grid[i] = array->extshape[i] / array->chunkshape[i];
+        if (grid[i] > 1) {
+            axes[naxes++] = i;
+            while (((int64_t) 1 << bits) < grid[i]) {
+                bits++;
+            }
+        }
+    }
+    // Along a single axis every curve is the C order
+    if (naxes < 2) {
+        return CATERVA_SUCCEED;
+    }
+    if (naxes * bits > 64) {
+        DEBUG_PRINT("The grid of chunks is too large for a space-filling curve");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    order_key_t *keys = caterva_malloc(ctx, (size_t) nchunks * sizeof(order_key_t),
+                                       CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(keys);
+    for (int64_t nchunk = 0; nchunk < nchunks; ++nchunk) {
+        int64_t index[CATERVA_MAX_DIM];
+        int64_t rem = nchunk;
+        for (int i = array->ndim - 1; i >= 0; --i) {
+            index[i] = rem % grid[i];
+            rem /= grid[i];
+        }
+        uint64_t coords[CATERVA_MAX_DIM];
+        for (int i = 0; i < naxes; ++i) {
+            coords[i] = (uint64_t) index[axes[i]];
+        }
+        if (order == CATERVA_CHUNK_ORDER_HILBERT) {
+            hilbert_transpose(coords, naxes, bits);
+        }
+        keys[nchunk].key = interleave(coords, naxes, bits);
+        keys[nchunk].nchunk = nchunk;
+    }
+    qsort(keys, (size_t) nchunks, sizeof(order_key_t), compare_keys);
+
+    array->chunk_positions = caterva_malloc(ctx, (size_t) nchunks * sizeof(int64_t),
+                                            CATERVA_ALLOC_ARRAY);
+    if (array->chunk_positions == NULL) {
+        caterva_free(ctx, keys, (size_t) nchunks * sizeof(order_key_t), CATERVA_ALLOC_SCRATCH);
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    for (int64_t position = 0; position < nchunks; ++position) {
+        array->chunk_positions[keys[position].nchunk] = position;
+    }
+    caterva_free(ctx, keys, (size_t) nchunks * sizeof(order_key_t), CATERVA_ALLOC_SCRATCH);
+    return CATERVA_SUCCEED;
+}
+
+void caterva_order_free(caterva_context_t *ctx, caterva_array_t *array) {
+    if (array->chunk_positions == NULL) {
+        return;
+    }
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    caterva_free(ctx, array->chunk_positions, (size_t) nchunks * sizeof(int64_t),
+                 CATERVA_ALLOC_ARRAY);
+    array->chunk_positions = NULL;
+}
+
+int64_t caterva_chunk_position(const caterva_array_t *array, int64_t nchunk) {
+    return array->chunk_positions == NULL ? nchunk : array->chunk_positions[nchunk];
+}
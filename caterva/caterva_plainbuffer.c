@@ -11,9 +11,151 @@
 
 #include <caterva.h>
 
+#include "caterva_utils.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Plain buffers stored on disk start with a fixed-size header followed by the data:
+ *
+ *   |-0..6--|-7-|-8..11---|-12-|-13..15-|-16..79----------------|-80..127-|
+ *   |caterva| v | itemsize |ndim| unused  | shape (8 x int64)     | unused   |
+ *
+ * All the integers are stored in little-endian. The header size keeps the data aligned.
+ */
+#define CATERVA_PLAINBUFFER_MAGIC "caterva"
+#define CATERVA_PLAINBUFFER_MAGIC_LEN 7
+#define CATERVA_PLAINBUFFER_VERSION 0
+#define CATERVA_PLAINBUFFER_HEADER_LEN 128
+
+static void store_le(uint8_t *dest, uint64_t value, int nbytes) {
+    for (int i = 0; i < nbytes; ++i) {
+        dest[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t load_le(const uint8_t *src, int nbytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < nbytes; ++i) {
+        value |= (uint64_t) src[i] << (8 * i);
+    }
+    return value;
+}
+
+static void write_header(caterva_array_t *array, uint8_t *header) {
+    memset(header, 0, CATERVA_PLAINBUFFER_HEADER_LEN);
+    memcpy(header, CATERVA_PLAINBUFFER_MAGIC, CATERVA_PLAINBUFFER_MAGIC_LEN);
+    header[7] = CATERVA_PLAINBUFFER_VERSION;
+    store_le(header + 8, (uint64_t) array->itemsize, 4);
+    header[12] = (uint8_t) array->ndim;
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        store_le(header + 16 + i * 8, (uint64_t) array->shape[i], 8);
+    }
+}
+
+static int plainbuffer_map(const char *filename, bool create, int64_t len,
+                           struct plainbuffer_mmap_s *mmap_) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                              create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        DEBUG_PRINT("Can not open the plain buffer file");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (!create) {
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        len = size.QuadPart;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(len >> 32),
+                                        (DWORD)(len & 0xFFFFFFFF), NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        DEBUG_PRINT("Can not map the plain buffer file");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    void *addr = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T) len);
+    if (addr == NULL) {
+        CloseHandle(mapping);
+        DEBUG_PRINT("Can not map the plain buffer file");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    mmap_->handle = mapping;
+#else
+    int fd = open(filename, create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+    if (fd < 0) {
+        DEBUG_PRINT("Can not open the plain buffer file");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (create) {
+        if (ftruncate(fd, (off_t) len) != 0) {
+            close(fd);
+            DEBUG_PRINT("Can not resize the plain buffer file");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+        len = (int64_t) st.st_size;
+    }
+    void *addr = mmap(NULL, (size_t) len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        DEBUG_PRINT("Can not map the plain buffer file");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    mmap_->handle = NULL;
+#endif
+    mmap_->addr = addr;
+    mmap_->len = len;
+
+    return CATERVA_SUCCEED;
+}
+
+static void plainbuffer_unmap(struct plainbuffer_mmap_s *mmap_) {
+#if defined(_WIN32)
+    FlushViewOfFile(mmap_->addr, 0);
+    UnmapViewOfFile(mmap_->addr);
+    CloseHandle(mmap_->handle);
+#else
+    msync(mmap_->addr, (size_t) mmap_->len, MS_SYNC);
+    munmap(mmap_->addr, (size_t) mmap_->len);
+#endif
+    mmap_->addr = NULL;
+    mmap_->len = 0;
+    mmap_->handle = NULL;
+}
+
+bool caterva_plainbuffer_is_file(const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    char magic[CATERVA_PLAINBUFFER_MAGIC_LEN];
+    size_t nread = fread(magic, 1, CATERVA_PLAINBUFFER_MAGIC_LEN, fp);
+    fclose(fp);
+
+    return nread == CATERVA_PLAINBUFFER_MAGIC_LEN &&
+           memcmp(magic, CATERVA_PLAINBUFFER_MAGIC, CATERVA_PLAINBUFFER_MAGIC_LEN) == 0;
+}
+
 int caterva_plainbuffer_array_free(caterva_context_t *ctx, caterva_array_t **array) {
-    if ((*array)->buf != NULL) {
-        ctx->cfg->free((*array)->buf);
+    if ((*array)->mmap.addr != NULL) {
+        plainbuffer_unmap(&(*array)->mmap);
+    } else if ((*array)->buf != NULL) {
+        caterva_free(ctx, (*array)->buf, (size_t) ((*array)->extnitems * (*array)->itemsize),
+                     CATERVA_ALLOC_PLAINBUFFER);
     }
     return CATERVA_SUCCEED;
 }
@@ -40,133 +182,61 @@ int caterva_plainbuffer_array_from_buffer(caterva_context_t *ctx, caterva_array_
 
 int caterva_plainbuffer_array_to_buffer(caterva_context_t *ctx, caterva_array_t *array,
                                         void *buffer) {
-    CATERVA_UNUSED_PARAM(ctx);
-    memcpy(buffer, array->buf, (size_t) array->nitems * array->itemsize);
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    int64_t nbytes = array->nitems * array->itemsize;
+    caterva_stage_begin(ctx, CATERVA_STAGE_SCATTER, array, 0, &t0);
+    memcpy(buffer, array->buf, (size_t) nbytes);
+    caterva_stage_end(ctx, CATERVA_STAGE_SCATTER, array, 0, nbytes, &t0, &stats);
+    caterva_stats_merge(ctx, array, &stats);
     return CATERVA_SUCCEED;
 }
 
 int caterva_plainbuffer_array_get_slice_buffer(caterva_context_t *ctx, caterva_array_t *array,
                                                int64_t *start, int64_t *stop, int64_t *shape,
                                                void *buffer) {
-    CATERVA_UNUSED_PARAM(ctx);
-
-    int64_t start__[CATERVA_MAX_DIM];
-    int64_t stop__[CATERVA_MAX_DIM];
-    int64_t shape__[CATERVA_MAX_DIM];
-    int64_t shape2__[CATERVA_MAX_DIM];
-
-    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-        start__[i] = (i < array->ndim) ? start[i] : 0;
-        stop__[i] = (i < array->ndim) ? stop[i] : 1;
-        shape__[i] = (i < array->ndim) ? array->shape[i] : 1;
-        shape2__[i] = (i < array->ndim) ? shape[i] : 1;
+    int64_t copy_shape[CATERVA_MAX_DIM];
+    int64_t dest_start[CATERVA_MAX_DIM];
+    int64_t nbytes = array->itemsize;
+    for (int i = 0; i < array->ndim; ++i) {
+        copy_shape[i] = stop[i] - start[i];
+        dest_start[i] = 0;
+        nbytes *= copy_shape[i];
     }
 
-    uint8_t *bdest = buffer;  // for allowing pointer arithmetic
-    int64_t start_[CATERVA_MAX_DIM];
-    int64_t stop_[CATERVA_MAX_DIM];
-    int64_t d_pshape_[CATERVA_MAX_DIM];
-    int8_t s_ndim = array->ndim;
-
-    int64_t s_shape[CATERVA_MAX_DIM];
-    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-        start_[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = start__[i];
-        stop_[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = stop__[i];
-        s_shape[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = shape__[i];
-        d_pshape_[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = shape2__[i];
-    }
-    for (int j = 0; j < CATERVA_MAX_DIM - s_ndim; ++j) {
-        start_[j] = 0;
-    }
-    int64_t jj[CATERVA_MAX_DIM];
-    jj[7] = start_[7];
-    for (jj[0] = start_[0]; jj[0] < stop_[0]; ++jj[0]) {
-        for (jj[1] = start_[1]; jj[1] < stop_[1]; ++jj[1]) {
-            for (jj[2] = start_[2]; jj[2] < stop_[2]; ++jj[2]) {
-                for (jj[3] = start_[3]; jj[3] < stop_[3]; ++jj[3]) {
-                    for (jj[4] = start_[4]; jj[4] < stop_[4]; ++jj[4]) {
-                        for (jj[5] = start_[5]; jj[5] < stop_[5]; ++jj[5]) {
-                            for (jj[6] = start_[6]; jj[6] < stop_[6]; ++jj[6]) {
-                                int64_t chunk_pointer = 0;
-                                int64_t chunk_pointer_inc = 1;
-                                for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
-                                    chunk_pointer += jj[i] * chunk_pointer_inc;
-                                    chunk_pointer_inc *= s_shape[i];
-                                }
-                                int64_t buf_pointer = 0;
-                                int64_t buf_pointer_inc = 1;
-                                for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
-                                    buf_pointer += (jj[i] - start_[i]) * buf_pointer_inc;
-                                    buf_pointer_inc *= d_pshape_[i];
-                                }
-                                memcpy(&bdest[buf_pointer * array->itemsize],
-                                       &array->buf[chunk_pointer * array->itemsize],
-                                       (size_t)(stop_[7] - start_[7]) * array->itemsize);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    caterva_stage_begin(ctx, CATERVA_STAGE_SCATTER, array, 0, &t0);
+    int rc = caterva_copy_region(ctx, array->ndim, array->itemsize, copy_shape, array->buf,
+                                 array->shape, start, buffer, shape, dest_start);
+    caterva_stage_end(ctx, CATERVA_STAGE_SCATTER, array, 0, nbytes, &t0, &stats);
+    caterva_stats_merge(ctx, array, &stats);
+    CATERVA_ERROR(rc);
     return CATERVA_SUCCEED;
 }
 
 int caterva_plainbuffer_array_set_slice_buffer(caterva_context_t *ctx, void *buffer,
                                                int64_t buffersize, int64_t *start, int64_t *stop,
                                                caterva_array_t *array) {
-    CATERVA_UNUSED_PARAM(ctx);
     CATERVA_UNUSED_PARAM(buffersize);
 
-    uint8_t *bbuffer = buffer;  // for allowing pointer arithmetic
-    int64_t start_[CATERVA_MAX_DIM];
-    int64_t stop_[CATERVA_MAX_DIM];
-    int8_t s_ndim = array->ndim;
-
-    int64_t d_shape[CATERVA_MAX_DIM];
-    int64_t s_shape[CATERVA_MAX_DIM];
-    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-        start_[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = start[i];
-        stop_[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = stop[i];
-        d_shape[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = (stop[i] - start[i]);
-        s_shape[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = array->shape[i];
-    }
-    for (int j = 0; j < CATERVA_MAX_DIM - s_ndim; ++j) {
-        start_[j] = 0;
-        stop_[j] = 1;
-        d_shape[j] = 1;
-    }
-    int64_t jj[CATERVA_MAX_DIM];
-    jj[7] = start_[7];
-    for (jj[0] = start_[0]; jj[0] < stop_[0]; ++jj[0]) {
-        for (jj[1] = start_[1]; jj[1] < stop_[1]; ++jj[1]) {
-            for (jj[2] = start_[2]; jj[2] < stop_[2]; ++jj[2]) {
-                for (jj[3] = start_[3]; jj[3] < stop_[3]; ++jj[3]) {
-                    for (jj[4] = start_[4]; jj[4] < stop_[4]; ++jj[4]) {
-                        for (jj[5] = start_[5]; jj[5] < stop_[5]; ++jj[5]) {
-                            for (jj[6] = start_[6]; jj[6] < stop_[6]; ++jj[6]) {
-                                int64_t chunk_pointer = 0;
-                                int64_t chunk_pointer_inc = 1;
-                                for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
-                                    chunk_pointer += jj[i] * chunk_pointer_inc;
-                                    chunk_pointer_inc *= s_shape[i];
-                                }
-                                int64_t buf_pointer = 0;
-                                int64_t buf_pointer_inc = 1;
-                                for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
-                                    buf_pointer += (jj[i] - start_[i]) * buf_pointer_inc;
-                                    buf_pointer_inc *= d_shape[i];
-                                }
-                                memcpy(&array->buf[chunk_pointer * array->itemsize],
-                                       &bbuffer[buf_pointer * array->itemsize],
-                                       (size_t)(stop_[7] - start_[7]) * array->itemsize);
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    int64_t copy_shape[CATERVA_MAX_DIM];
+    int64_t src_start[CATERVA_MAX_DIM];
+    int64_t nbytes = array->itemsize;
+    for (int i = 0; i < array->ndim; ++i) {
+        copy_shape[i] = stop[i] - start[i];
+        src_start[i] = 0;
+        nbytes *= copy_shape[i];
     }
+
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    caterva_stage_begin(ctx, CATERVA_STAGE_SCATTER, array, 0, &t0);
+    int rc = caterva_copy_region(ctx, array->ndim, array->itemsize, copy_shape, buffer,
+                                 copy_shape, src_start, array->buf, array->shape, start);
+    caterva_stage_end(ctx, CATERVA_STAGE_SCATTER, array, 0, nbytes, &t0, &stats);
+    caterva_stats_merge(ctx, array, &stats);
+    CATERVA_ERROR(rc);
     return CATERVA_SUCCEED;
 }
 
@@ -209,6 +279,28 @@ int caterva_plainbuffer_update_shape(caterva_array_t *array, int8_t ndim, int64_
     return CATERVA_SUCCEED;
 }
 
+int caterva_plainbuffer_array_save(caterva_context_t *ctx, caterva_array_t *array,
+                                   const char *filename) {
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    int64_t nbytes = array->nitems * array->itemsize;
+
+    caterva_stage_begin(ctx, CATERVA_STAGE_IO, array, -1, &t0);
+    struct plainbuffer_mmap_s mmap_;
+    int rc = plainbuffer_map(filename, true, CATERVA_PLAINBUFFER_HEADER_LEN + nbytes, &mmap_);
+    if (rc == CATERVA_SUCCEED) {
+        write_header(array, mmap_.addr);
+        memcpy(mmap_.addr + CATERVA_PLAINBUFFER_HEADER_LEN, array->buf, (size_t) nbytes);
+        plainbuffer_unmap(&mmap_);
+    }
+    caterva_stage_end(ctx, CATERVA_STAGE_IO, array, -1, CATERVA_PLAINBUFFER_HEADER_LEN + nbytes,
+                      &t0, &stats);
+    caterva_stats_merge(ctx, array, &stats);
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
 int caterva_plainbuffer_array_squeeze(caterva_context_t *ctx, caterva_array_t *array) {
     CATERVA_UNUSED_PARAM(ctx);
 
@@ -222,6 +314,9 @@ int caterva_plainbuffer_array_squeeze(caterva_context_t *ctx, caterva_array_t *a
     }
 
     CATERVA_ERROR(caterva_plainbuffer_update_shape(array, nones, newshape));
+    if (array->mmap.addr != NULL) {
+        write_header(array, array->mmap.addr);
+    }
 
     return CATERVA_SUCCEED;
 }
@@ -241,7 +336,8 @@ int caterva_plainbuffer_array_copy(caterva_context_t *ctx, caterva_params_t *par
 int caterva_plainbuffer_array_empty(caterva_context_t *ctx, caterva_params_t *params,
                                     caterva_storage_t *storage, caterva_array_t **array) {
     /* Create a caterva_array_t buffer */
-    (*array) = (caterva_array_t *) ctx->cfg->alloc(sizeof(caterva_array_t));
+    (*array) = (caterva_array_t *) caterva_malloc(ctx, sizeof(caterva_array_t),
+                                                   CATERVA_ALLOC_ARRAY);
     if ((*array) == NULL) {
         DEBUG_PRINT("Pointer is null");
         return CATERVA_ERR_NULL_POINTER;
@@ -276,12 +372,105 @@ int caterva_plainbuffer_array_empty(caterva_context_t *ctx, caterva_params_t *pa
     // The partition cache (empty initially)
     (*array)->chunk_cache.data = NULL;
     (*array)->chunk_cache.nchunk = -1;  // means no valid cache yet
+    memset(&(*array)->stats, 0, sizeof(caterva_stats_t));
 
     (*array)->sc = NULL;
+    (*array)->mmap.addr = NULL;
+    (*array)->fill_value = NULL;
+    memset(&(*array)->append_buffer, 0, sizeof(struct append_buffer_s));
+    (*array)->objective = CATERVA_COMPRESSION_FIXED;
+    (*array)->cspeed = 0;
+    (*array)->predictor = CATERVA_PREDICTOR_NONE;
+    (*array)->keyframe_interval = 0;
+    (*array)->delta_axis = 0;
+    memset(&(*array)->delta_cache, 0, sizeof(struct delta_cache_s));
+    (*array)->lossy_mode = CATERVA_LOSSY_NONE;
+    (*array)->lossy_tolerance = 0;
+    (*array)->lossy_bits = 0;
+    (*array)->nfields = 0;
+    (*array)->fields = NULL;
+    (*array)->field_arrays = NULL;
+    (*array)->recordsize = 0;
+    (*array)->pyramid_levels = 0;
+    (*array)->pyramid_reduce = CATERVA_PYRAMID_NEAREST;
+    (*array)->pyramid_kind = CATERVA_ITEM_UINT;
+    (*array)->levels = NULL;
+    (*array)->sum_kind = CATERVA_ITEM_UINT;
+    (*array)->block_sums = NULL;
+    (*array)->chunk_sums = NULL;
+    (*array)->indexes_dirty = false;
+    (*array)->bloom_bits = 0;
+    (*array)->blooms = NULL;
+    (*array)->chunk_order = CATERVA_CHUNK_ORDER_C;
+    (*array)->chunk_positions = NULL;
+    (*array)->scattered = false;
+
+    int64_t nbytes = (*array)->extnitems * params->itemsize;
+    char *filename = storage->properties.plainbuffer.filename;
+    if (filename != NULL) {
+        // The data is placed in a memory-mapped file right after the header
+        CATERVA_ERROR(plainbuffer_map(filename, true, CATERVA_PLAINBUFFER_HEADER_LEN + nbytes,
+                                      &(*array)->mmap));
+        write_header(*array, (*array)->mmap.addr);
+        (*array)->buf = (*array)->mmap.addr + CATERVA_PLAINBUFFER_HEADER_LEN;
+    } else {
+        (*array)->buf = caterva_malloc(ctx, (size_t) nbytes, CATERVA_ALLOC_PLAINBUFFER);
+        CATERVA_ERROR_NULL((*array)->buf);
+    }
+
+    return CATERVA_SUCCEED;
+}
 
-    uint8_t *buf = ctx->cfg->alloc((size_t)(*array)->extnitems * params->itemsize);
+int caterva_plainbuffer_from_file(caterva_context_t *ctx, const char *filename, bool copy,
+                                  caterva_array_t **array) {
+    struct plainbuffer_mmap_s mmap_;
+    CATERVA_ERROR(plainbuffer_map(filename, false, 0, &mmap_));
+
+    uint8_t *header = mmap_.addr;
+    if (mmap_.len < CATERVA_PLAINBUFFER_HEADER_LEN ||
+        memcmp(header, CATERVA_PLAINBUFFER_MAGIC, CATERVA_PLAINBUFFER_MAGIC_LEN) != 0 ||
+        header[7] > CATERVA_PLAINBUFFER_VERSION || header[12] > CATERVA_MAX_DIM) {
+        plainbuffer_unmap(&mmap_);
+        DEBUG_PRINT("The file is not a caterva plain buffer");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    caterva_params_t params = {0};
+    params.itemsize = (uint8_t) load_le(header + 8, 4);
+    params.ndim = header[12];
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        params.shape[i] = (int64_t) load_le(header + 16 + i * 8, 8);
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_PLAINBUFFER;
+    // Build the array container only; the data is attached below
+    storage.properties.plainbuffer.filename = NULL;
+    int rc = caterva_plainbuffer_array_empty(ctx, &params, &storage, array);
+    if (rc != CATERVA_SUCCEED) {
+        plainbuffer_unmap(&mmap_);
+        CATERVA_ERROR(rc);
+    }
+
+    int64_t nbytes = (*array)->extnitems * (*array)->itemsize;
+    if (mmap_.len < CATERVA_PLAINBUFFER_HEADER_LEN + nbytes) {
+        plainbuffer_unmap(&mmap_);
+        caterva_array_free(ctx, array);
+        DEBUG_PRINT("The plain buffer file is truncated");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (copy) {
+        memcpy((*array)->buf, mmap_.addr + CATERVA_PLAINBUFFER_HEADER_LEN, (size_t) nbytes);
+        plainbuffer_unmap(&mmap_);
+    } else {
+        caterva_free(ctx, (*array)->buf, (size_t) nbytes, CATERVA_ALLOC_PLAINBUFFER);
+        (*array)->mmap = mmap_;
+        (*array)->buf = mmap_.addr + CATERVA_PLAINBUFFER_HEADER_LEN;
+    }
 
-    (*array)->buf = buf;
+    (*array)->filled = true;
+    (*array)->empty = false;
+    (*array)->nchunks = 1;
 
     return CATERVA_SUCCEED;
 }
@@ -11,6 +11,11 @@ int caterva_plainbuffer_array_empty(caterva_context_t *ctx, caterva_params_t *pa
 
 int caterva_plainbuffer_array_free(caterva_context_t *ctx, caterva_array_t **array);
 
+bool caterva_plainbuffer_is_file(const char *filename);
+
+int caterva_plainbuffer_from_file(caterva_context_t *ctx, const char *filename, bool copy,
+                                  caterva_array_t **array);
+
 int caterva_plainbuffer_array_append(caterva_context_t *ctx, caterva_array_t *array, void *chunk,
                                      int64_t chunksize);
 
@@ -31,6 +36,9 @@ int caterva_plainbuffer_array_set_slice_buffer(caterva_context_t *ctx, void *buf
 int caterva_plainbuffer_array_get_slice(caterva_context_t *ctx, caterva_array_t *src,
                                         int64_t *start, int64_t *stop, caterva_array_t *array);
 
+int caterva_plainbuffer_array_save(caterva_context_t *ctx, caterva_array_t *array,
+                                   const char *filename);
+
 int caterva_plainbuffer_array_squeeze(caterva_context_t *ctx, caterva_array_t *array);
 
 int caterva_plainbuffer_array_copy(caterva_context_t *ctx, caterva_params_t *params,
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_utils.h"
+
+// The N-D Lorenzo predictor replaces each item of a block by the error of its prediction out of
+// the neighbours that precede it along every axis, which is the backward difference of the block
+// along all of its axes. The items are handled as unsigned integers (wrapping around), so that it
+// is lossless, and the floats are first mapped to integers that keep their order.
+//
+// The inner loops run over contiguous rows of the same type, so that they can be vectorised.
+
+#define DEFINE_PREDICTOR(utype)                                                                  \
+    static void encode_##utype(utype *x, int8_t ndim, const int32_t *bshape, int64_t nitems,     \
+                               bool ordered) {                                                   \
+        const int nbits = (int) sizeof(utype) * 8;                                               \
+        const utype top = (utype) ((utype) 1 << (nbits - 1));                                    \
+        if (ordered) {                                                                           \
+            for (int64_t i = 0; i < nitems; ++i) {                                               \
+                utype negative = (utype) (0 - (x[i] >> (nbits - 1)));                            \
+                x[i] ^= (utype) (negative | top);                                                \
+            }                                                                                    \
+        }                                                                                        \
+        int64_t outer = 1;                                                                       \
+        int64_t inner = nitems;                                                                  \
+        for (int k = 0; k < ndim; ++k) {                                                         \
+            int64_t len = bshape[k];                                                             \
+            inner /= len;                                                                        \
+            for (int64_t o = 0; o < outer; ++o) {                                                \
+                utype *base = x + o * len * inner;                                               \
+                for (int64_t j = len - 1; j > 0; --j) {                                          \
+                    utype *row = base + j * inner;                                               \
+                    const utype *prev = row - inner;                                             \
+                    for (int64_t t = 0; t < inner; ++t) {                                        \
+                        row[t] = (utype) (row[t] - prev[t]);                                     \
+                    }                                                                            \
+                }                                                                                \
+            }                                                                                    \
+            outer *= len;                                                                        \
+        }                                                                                        \
+    }                                                                                            \
+                                                                                                 \
+    static void decode_##utype(utype *x, int8_t ndim, const int32_t *bshape, int64_t nitems,     \
+                               bool ordered) {                                                   \
+        const int nbits = (int) sizeof(utype) * 8;                                               \
+        const utype top = (utype) ((utype) 1 << (nbits - 1));                                    \
+        int64_t outer = 1;                                                                       \
+        int64_t inner = nitems;                                                                  \
+        for (int k = 0; k < ndim; ++k) {                                                         \
+            int64_t len = bshape[k];                                                             \
+            inner /= len;                                                                        \
+            for (int64_t o = 0; o < outer; ++o) {                                                \
+                utype *base = x + o * len * inner;                                               \
+                for (int64_t j = 1; j < len; ++j) {                                              \
+                    utype *row = base + j * inner;                                               \
+                    const utype *prev = row - inner;                                             \
+                    for (int64_t t = 0; t < inner; ++t) {                                        \
+                        row[t] = (utype) (row[t] + prev[t]);                                     \
+                    }                                                                            \
+                }                                                                                \
+            }                                                                                    \
+            outer *= len;                                                                        \
+        }                                                                                        \
+        if (ordered) {                                                                           \
+            for (int64_t i = 0; i < nitems; ++i) {                                               \
+                utype positive = (utype) ((x[i] >> (nbits - 1)) - 1);                            \
+                x[i] ^= (utype) (positive | top);                                                \
+            }                                                                                    \
+        }                                                                                        \
+    }
+
+DEFINE_PREDICTOR(uint8_t)
+DEFINE_PREDICTOR(uint16_t)
+DEFINE_PREDICTOR(uint32_t)
+DEFINE_PREDICTOR(uint64_t)
+
+bool caterva_predictor_supported(caterva_predictor_t predictor, int32_t itemsize) {
+    switch (predictor) {
+        case CATERVA_PREDICTOR_NONE:
+            return true;
+        case CATERVA_PREDICTOR_INT:
+            return itemsize == 1 || itemsize == 2 || itemsize == 4 || itemsize == 8;
+        case CATERVA_PREDICTOR_FLOAT:
+            return itemsize == 4 || itemsize == 8;
+        default:
+            return false;
+    }
+}
+
+static void predict_block(caterva_array_t *array, uint8_t *block, bool encode) {
+    bool ordered = array->predictor == CATERVA_PREDICTOR_FLOAT;
+    int8_t ndim = array->ndim;
+    const int32_t *bshape = array->blockshape;
+    int64_t nitems = array->blocknitems;
+    switch (array->itemsize) {
+        case 1:
+            if (encode) {
+                encode_uint8_t((uint8_t *) block, ndim, bshape, nitems, ordered);
+            } else {
+                decode_uint8_t((uint8_t *) block, ndim, bshape, nitems, ordered);
+            }
+            break;
+        case 2:
+            if (encode) {
+                encode_uint16_t((uint16_t *) block, ndim, bshape, nitems, ordered);
+            } else {
+                decode_uint16_t((uint16_t *) block, ndim, bshape, nitems, ordered);
+            }
+            break;
+        case 4:
+            if (encode) {
+                encode_uint32_t((uint32_t *) block, ndim, bshape, nitems, ordered);
+            } else {
+                decode_uint32_t((uint32_t *) block, ndim, bshape, nitems, ordered);
+            }
+            break;
+        default:
+            if (encode) {
+                encode_uint64_t((uint64_t *) block, ndim, bshape, nitems, ordered);
+            } else {
+                decode_uint64_t((uint64_t *) block, ndim, bshape, nitems, ordered);
+            }
+            break;
+    }
+}
+
+void caterva_predictor_encode(caterva_array_t *array, uint8_t *rchunk) {
+    if (array->predictor == CATERVA_PREDICTOR_NONE) {
+        return;
+    }
+    int64_t blocksize = array->blocknitems * array->itemsize;
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        predict_block(array, rchunk + nblock * blocksize, true);
+    }
+}
+
+void caterva_predictor_decode(caterva_array_t *array, uint8_t *rchunk, const bool *maskout) {
+    if (array->predictor == CATERVA_PREDICTOR_NONE) {
+        return;
+    }
+    int64_t blocksize = array->blocknitems * array->itemsize;
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        if (maskout == NULL || !maskout[nblock]) {
+            predict_block(array, rchunk + nblock * blocksize, false);
+        }
+    }
+}
@@ -0,0 +1,511 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_blosc.h"
+#include "caterva_pyramid.h"
+#include "caterva_utils.h"
+
+// The levels of a pyramid are arrays of their own. Level l has the shape ceil(shape / 2^l) and the
+// chunkshape chunkshape / 2^l, so that each chunk of the array is reduced into the chunk at the
+// same position of every level (the windows never straddle two chunks). The chunks of a level
+// are reduced out of the ones of the previous level as they are appended, and a coarse read only
+// decompresses the chunks of the level it asks for.
+
+static char pyramid_metalayer[] = "caterva_pyramid";
+
+// The metalayer of the arrays of a pyramid is [level, nlevels, reduce, kind]
+static void serialize_pyramid(int8_t level, int8_t nlevels, caterva_pyramid_reduce_t reduce,
+                              caterva_item_kind_t kind, uint8_t *smeta) {
+    smeta[0] = 0x90 + 4;  // fixarray with 4 elements
+    smeta[1] = (uint8_t) level;  // positive fixnum (7-bit positive integer)
+    smeta[2] = (uint8_t) nlevels;  // positive fixnum (7-bit positive integer)
+    smeta[3] = (uint8_t) reduce;  // positive fixnum (7-bit positive integer)
+    smeta[4] = (uint8_t) kind;  // positive fixnum (7-bit positive integer)
+}
+
+static int deserialize_pyramid(const uint8_t *smeta, uint32_t smeta_len, int8_t *level,
+                               int8_t *nlevels, caterva_pyramid_reduce_t *reduce,
+                               caterva_item_kind_t *kind) {
+    if (smeta_len != CATERVA_PYRAMID_METALAYER_LEN || smeta[0] != 0x90 + 4 ||
+        smeta[2] > CATERVA_MAX_LEVELS || smeta[1] > smeta[2] || smeta[3] > CATERVA_PYRAMID_MAX ||
+        smeta[4] > CATERVA_ITEM_FLOAT) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    *level = (int8_t) smeta[1];
+    *nlevels = (int8_t) smeta[2];
+    *reduce = (caterva_pyramid_reduce_t) smeta[3];
+    *kind = (caterva_item_kind_t) smeta[4];
+    return CATERVA_SUCCEED;
+}
+
+static bool pyramid_supported(caterva_pyramid_reduce_t reduce, caterva_item_kind_t kind,
+                              int32_t itemsize) {
+    switch (reduce) {
+        case CATERVA_PYRAMID_NEAREST:
+            return true;
+        case CATERVA_PYRAMID_MEAN:
+        case CATERVA_PYRAMID_MAX:
+            return caterva_item_supported(kind, itemsize);
+        default:
+            return false;
+    }
+}
+
+// The levels of an array on disk are kept in sibling files (level l of filename is
+// filename.level<l>), which are written and opened along with the array
+char *caterva_pyramid_filename(caterva_context_t *ctx, const char *filename, int8_t level) {
+    size_t size = (size_t) snprintf(NULL, 0, "%s.level%d", filename, level) + 1;
+    char *lfilename = caterva_malloc(ctx, size, CATERVA_ALLOC_SCRATCH);
+    if (lfilename != NULL) {
+        snprintf(lfilename, size, "%s.level%d", filename, level);
+    }
+    return lfilename;
+}
+
+void caterva_pyramid_filename_free(caterva_context_t *ctx, char *lfilename) {
+    if (lfilename != NULL) {
+        caterva_free(ctx, lfilename, strlen(lfilename) + 1, CATERVA_ALLOC_SCRATCH);
+    }
+}
+
+// The parameters and the storage of a level of a pyramid (the level 0 is the array itself). The
+// metalayer is serialized into smeta and the file of a level on disk is allocated into lfilename
+// (NULL otherwise); both must outlive the creation of the level.
+int caterva_pyramid_storage(caterva_context_t *ctx, caterva_params_t *params,
+                            caterva_storage_t *storage, int8_t level, uint8_t *smeta,
+                            char **lfilename, caterva_params_t *lparams,
+                            caterva_storage_t *lstorage) {
+    caterva_storage_properties_blosc_t *blosc = &storage->properties.blosc;
+    int8_t nlevels = blosc->pyramid_levels;
+    if (nlevels < 0 || nlevels > CATERVA_MAX_LEVELS || ctx->cfg->prefilter != NULL ||
+        !pyramid_supported(blosc->pyramid_reduce, blosc->pyramid_kind, params->itemsize)) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    for (int i = 0; i < params->ndim; ++i) {
+        if (blosc->chunkshape[i] % (1 << nlevels) != 0) {
+            DEBUG_PRINT("The chunkshape must be divisible by 2^pyramid_levels");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    memcpy(lparams, params, sizeof(caterva_params_t));
+    memcpy(lstorage, storage, sizeof(caterva_storage_t));
+    caterva_storage_properties_blosc_t *lblosc = &lstorage->properties.blosc;
+    lblosc->pyramid_levels = 0;
+    if (level > 0) {
+        // The levels only carry the pyramid metalayer
+        lblosc->nmetalayers = 0;
+        for (int i = 0; i < params->ndim; ++i) {
+            lparams->shape[i] = (params->shape[i] + (1 << level) - 1) >> level;
+            lblosc->chunkshape[i] = blosc->chunkshape[i] >> level;
+            lblosc->blockshape[i] = blosc->blockshape[i] >> level;
+            if (lblosc->blockshape[i] < 1) {
+                lblosc->blockshape[i] = 1;
+            }
+        }
+    }
+    if (lblosc->nmetalayers >= CATERVA_MAX_METALAYERS) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    *lfilename = NULL;
+    if (level > 0 && blosc->filename != NULL) {
+        *lfilename = caterva_pyramid_filename(ctx, blosc->filename, level);
+        CATERVA_ERROR_NULL(*lfilename);
+        lblosc->filename = *lfilename;
+    }
+    serialize_pyramid(level, nlevels, blosc->pyramid_reduce, blosc->pyramid_kind, smeta);
+    caterva_metalayer_t *metalayer = &lblosc->metalayers[lblosc->nmetalayers++];
+    metalayer->name = pyramid_metalayer;
+    metalayer->sdata = smeta;
+    metalayer->size = CATERVA_PYRAMID_METALAYER_LEN;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_pyramid_free(caterva_context_t *ctx, caterva_array_t *array) {
+    int rc = CATERVA_SUCCEED;
+    for (int i = 0; i < array->pyramid_levels; ++i) {
+        // It may fail writing the chunks left in the append buffer of a level
+        int lrc = caterva_array_free(ctx, &array->levels[i]);
+        rc = rc == CATERVA_SUCCEED ? lrc : rc;
+    }
+    caterva_free(ctx, array->levels, array->pyramid_levels * sizeof(caterva_array_t *),
+                 CATERVA_ALLOC_ARRAY);
+    array->levels = NULL;
+    array->pyramid_levels = 0;
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+// The integers are rounded to nearest (the mean of a window is within the range of its items)
+static void store_double(caterva_item_kind_t kind, int32_t itemsize, double value,
+                         uint8_t *item) {
+    double rounded = value < 0 ? -(double) (int64_t) (0.5 - value) : value + 0.5;
+    switch (kind * 16 + itemsize) {
+        case CATERVA_ITEM_UINT * 16 + 1:
+            *item = (uint8_t) rounded;
+            break;
+        case CATERVA_ITEM_UINT * 16 + 2:
+            *(uint16_t *) item = (uint16_t) rounded;
+            break;
+        case CATERVA_ITEM_UINT * 16 + 4:
+            *(uint32_t *) item = (uint32_t) rounded;
+            break;
+        case CATERVA_ITEM_UINT * 16 + 8:
+            *(uint64_t *) item = (uint64_t) rounded;
+            break;
+        case CATERVA_ITEM_INT * 16 + 1:
+            *(int8_t *) item = (int8_t) (int64_t) rounded;
+            break;
+        case CATERVA_ITEM_INT * 16 + 2:
+            *(int16_t *) item = (int16_t) (int64_t) rounded;
+            break;
+        case CATERVA_ITEM_INT * 16 + 4:
+            *(int32_t *) item = (int32_t) (int64_t) rounded;
+            break;
+        case CATERVA_ITEM_INT * 16 + 8:
+            *(int64_t *) item = (int64_t) rounded;
+            break;
+        case CATERVA_ITEM_FLOAT * 16 + 4:
+            *(float *) item = (float) value;
+            break;
+        default:
+            *(double *) item = value;
+    }
+}
+
+// Whether the item a is greater than the item b (the 8-byte integers are not compared as doubles)
+static bool greater(caterva_item_kind_t kind, int32_t itemsize, const uint8_t *a,
+                    const uint8_t *b) {
+    if (kind == CATERVA_ITEM_UINT && itemsize == 8) {
+        return *(const uint64_t *) a > *(const uint64_t *) b;
+    }
+    if (kind == CATERVA_ITEM_INT && itemsize == 8) {
+        return *(const int64_t *) a > *(const int64_t *) b;
+    }
+    return caterva_item_to_double(kind, itemsize, a) > caterva_item_to_double(kind, itemsize, b);
+}
+
+// Reduce the windows of 2 items per axis (clipped on the edges) of a region of shape items, at the
+// origin of a C-ordered buffer of src_shape items, into a buffer of ceil(shape / 2) items
+static void downsample(caterva_array_t *array, const int64_t *shape, const uint8_t *src,
+                       const int64_t *src_shape, uint8_t *dest) {
+    int8_t ndim = array->ndim;
+    int32_t itemsize = array->itemsize;
+    int64_t dshape[CATERVA_MAX_DIM];
+    int64_t strides[CATERVA_MAX_DIM];
+    int64_t dnitems = 1;
+    int64_t stride = 1;
+    for (int i = ndim - 1; i >= 0; --i) {
+        dshape[i] = (shape[i] + 1) / 2;
+        dnitems *= dshape[i];
+        strides[i] = stride;
+        stride *= src_shape[i];
+    }
+
+    for (int64_t n = 0; n < dnitems; ++n) {
+        // The first item of the window and its extent
+        int64_t origin = 0;
+        int64_t wshape[CATERVA_MAX_DIM];
+        int64_t wnitems = 1;
+        int64_t rem = n;
+        for (int i = ndim - 1; i >= 0; --i) {
+            int64_t coord = rem % dshape[i] * 2;
+            rem /= dshape[i];
+            origin += coord * strides[i];
+            wshape[i] = shape[i] - coord < 2 ? 1 : 2;
+            wnitems *= wshape[i];
+        }
+        const uint8_t *first = src + origin * itemsize;
+        uint8_t *item = dest + n * itemsize;
+        if (array->pyramid_reduce == CATERVA_PYRAMID_NEAREST) {
+            memcpy(item, first, (size_t) itemsize);
+            continue;
+        }
+
+        const uint8_t *best = first;
+        double sum = 0;
+        for (int64_t w = 0; w < wnitems; ++w) {
+            int64_t offset = 0;
+            int64_t wrem = w;
+            for (int i = ndim - 1; i >= 0; --i) {
+                offset += wrem % wshape[i] * strides[i];
+                wrem /= wshape[i];
+            }
+            const uint8_t *witem = first + offset * itemsize;
+            if (array->pyramid_reduce == CATERVA_PYRAMID_MAX) {
+                best = greater(array->pyramid_kind, itemsize, witem, best) ? witem : best;
+            } else {
+                sum += caterva_item_to_double(array->pyramid_kind, itemsize, witem);
+            }
+        }
+        if (array->pyramid_reduce == CATERVA_PYRAMID_MAX) {
+            memcpy(item, best, (size_t) itemsize);
+        } else {
+            store_double(array->pyramid_kind, itemsize, sum / (double) wnitems, item);
+        }
+    }
+}
+
+int caterva_pyramid_append(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                           void **chunks, int64_t *chunksizes, int64_t nchunks) {
+    if (array->pyramid_levels == 0 || nchunks == 0) {
+        return CATERVA_SUCCEED;
+    }
+
+    // The chunks of each level are reduced out of the ones of the previous level, so that two
+    // sets of chunks are used in turn
+    size_t datasize = (size_t) (nchunks * array->levels[0]->chunknitems * array->itemsize);
+    uint8_t *data[2];
+    void **lchunks[2];
+    int64_t *lchunksizes[2];
+    int rc = CATERVA_SUCCEED;
+    for (int i = 0; i < 2; ++i) {
+        data[i] = caterva_malloc(ctx, datasize, CATERVA_ALLOC_SCRATCH);
+        lchunks[i] = caterva_malloc(ctx, (size_t) nchunks * sizeof(void *), CATERVA_ALLOC_SCRATCH);
+        lchunksizes[i] = caterva_malloc(ctx, (size_t) nchunks * sizeof(int64_t),
+                                        CATERVA_ALLOC_SCRATCH);
+        if (data[i] == NULL || lchunks[i] == NULL || lchunksizes[i] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+    caterva_array_t *parent = array;
+    void **pchunks = chunks;
+    int64_t *pchunksizes = chunksizes;
+    for (int l = 0; l < array->pyramid_levels && rc == CATERVA_SUCCEED; ++l) {
+        caterva_array_t *level = array->levels[l];
+        uint8_t *pdata = data[l % 2];
+        for (int64_t i = 0; i < nchunks; ++i) {
+            // A chunk has either its own shape or the whole chunkshape (padded)
+            int64_t cshape[CATERVA_MAX_DIM];
+            int64_t src_shape[CATERVA_MAX_DIM];
+            int64_t cnitems = caterva_blosc_chunk_shape(parent, nchunk + i, cshape);
+            bool padded = cnitems != parent->chunknitems &&
+                          pchunksizes[i] == (int64_t) parent->chunknitems * parent->itemsize;
+            for (int j = 0; j < parent->ndim; ++j) {
+                src_shape[j] = padded ? parent->chunkshape[j] : cshape[j];
+            }
+            int64_t lcshape[CATERVA_MAX_DIM];
+            int64_t lcnitems = caterva_blosc_chunk_shape(level, nchunk + i, lcshape);
+            downsample(array, cshape, pchunks[i], src_shape, pdata);
+            lchunks[l % 2][i] = pdata;
+            lchunksizes[l % 2][i] = lcnitems * level->itemsize;
+            pdata += lchunksizes[l % 2][i];
+        }
+        rc = caterva_array_append_many(ctx, level, lchunks[l % 2], lchunksizes[l % 2], nchunks);
+        parent = level;
+        pchunks = lchunks[l % 2];
+        pchunksizes = lchunksizes[l % 2];
+    }
+    for (int i = 0; i < 2; ++i) {
+        caterva_free(ctx, data[i], datasize, CATERVA_ALLOC_SCRATCH);
+        caterva_free(ctx, lchunks[i], (size_t) nchunks * sizeof(void *), CATERVA_ALLOC_SCRATCH);
+        caterva_free(ctx, lchunksizes[i], (size_t) nchunks * sizeof(int64_t),
+                     CATERVA_ALLOC_SCRATCH);
+    }
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_pyramid_from_buffer(caterva_context_t *ctx, caterva_array_t *array,
+                                const uint8_t *buffer) {
+    const uint8_t *src = buffer;
+    const int64_t *shape = array->shape;
+    uint8_t *prev = NULL;
+    int64_t prev_nbytes = 0;
+    int rc = CATERVA_SUCCEED;
+    for (int l = 0; l < array->pyramid_levels && rc == CATERVA_SUCCEED; ++l) {
+        caterva_array_t *level = array->levels[l];
+        int64_t nbytes = level->nitems * level->itemsize;
+        uint8_t *dest = caterva_malloc(ctx, (size_t) nbytes, CATERVA_ALLOC_SCRATCH);
+        if (dest == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+            break;
+        }
+        downsample(array, shape, src, shape, dest);
+        caterva_free(ctx, prev, (size_t) prev_nbytes, CATERVA_ALLOC_SCRATCH);
+        rc = caterva_blosc_array_from_buffer(ctx, level, dest, nbytes);
+        prev = dest;
+        prev_nbytes = nbytes;
+        src = dest;
+        shape = level->shape;
+    }
+    caterva_free(ctx, prev, (size_t) prev_nbytes, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_pyramid_flush(caterva_context_t *ctx, caterva_array_t *array) {
+    for (int i = 0; i < array->pyramid_levels; ++i) {
+        CATERVA_ERROR(caterva_array_flush(ctx, array->levels[i]));
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_get_level(caterva_context_t *ctx, caterva_array_t *array, int8_t level,
+                            caterva_array_t **level_array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(level_array);
+
+    if (level < 0 || level > array->pyramid_levels) {
+        DEBUG_PRINT("The array has no such level");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    *level_array = level == 0 ? array : array->levels[level - 1];
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_get_level_slice_buffer(caterva_context_t *ctx, caterva_array_t *array,
+                                         int8_t level, int64_t *start, int64_t *stop,
+                                         int64_t *shape, void *buffer, int64_t buffersize) {
+    caterva_array_t *level_array;
+    CATERVA_ERROR(caterva_array_get_level(ctx, array, level, &level_array));
+    CATERVA_ERROR(caterva_array_get_slice_buffer(ctx, level_array, start, stop, shape, buffer,
+                                                 buffersize));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_from_levels(caterva_context_t *ctx, caterva_array_t **arrays, int8_t narrays,
+                              caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(arrays);
+    CATERVA_ERROR_NULL(array);
+
+    if (narrays < 2 || narrays > CATERVA_MAX_LEVELS + 1) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    caterva_array_t *base = arrays[0];
+    CATERVA_ERROR_NULL(base);
+    caterva_pyramid_reduce_t reduce = CATERVA_PYRAMID_NEAREST;
+    caterva_item_kind_t kind = CATERVA_ITEM_UINT;
+    for (int8_t i = 0; i < narrays; ++i) {
+        caterva_array_t *level = arrays[i];
+        CATERVA_ERROR_NULL(level);
+        if (level->storage != CATERVA_STORAGE_BLOSC || level->nfields > 0 ||
+            level->pyramid_levels > 0 || blosc2_has_metalayer(level->sc, pyramid_metalayer) < 0) {
+            DEBUG_PRINT("The array is not a level of a pyramid");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+        uint8_t *smeta;
+        uint32_t smeta_len;
+        if (blosc2_get_metalayer(level->sc, pyramid_metalayer, &smeta, &smeta_len) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        int8_t nlevel;
+        int8_t nlevels;
+        caterva_pyramid_reduce_t lreduce;
+        caterva_item_kind_t lkind;
+        int rc = deserialize_pyramid(smeta, smeta_len, &nlevel, &nlevels, &lreduce, &lkind);
+        free(smeta);
+        CATERVA_ERROR(rc);
+        if (i == 0) {
+            reduce = lreduce;
+            kind = lkind;
+        }
+        bool same = nlevel == i && nlevels == narrays - 1 && lreduce == reduce && lkind == kind &&
+                    level->itemsize == base->itemsize && level->ndim == base->ndim &&
+                    level->nchunks == base->nchunks;
+        for (int j = 0; same && j < level->ndim; ++j) {
+            same = level->shape[j] == (base->shape[j] + (1 << i) - 1) >> i &&
+                   level->chunkshape[j] == base->chunkshape[j] >> i;
+        }
+        if (!same) {
+            DEBUG_PRINT("The arrays are not the levels of the same pyramid");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    base->levels = caterva_malloc(ctx, (narrays - 1) * sizeof(caterva_array_t *),
+                                  CATERVA_ALLOC_ARRAY);
+    CATERVA_ERROR_NULL(base->levels);
+    for (int i = 1; i < narrays; ++i) {
+        base->levels[i - 1] = arrays[i];
+    }
+    base->pyramid_levels = (int8_t) (narrays - 1);
+    base->pyramid_reduce = reduce;
+    base->pyramid_kind = kind;
+    *array = base;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_pyramid_save(caterva_context_t *ctx, caterva_array_t *array, const char *filename) {
+    for (int8_t l = 1; l <= array->pyramid_levels; ++l) {
+        char *lfilename = caterva_pyramid_filename(ctx, filename, l);
+        CATERVA_ERROR_NULL(lfilename);
+        int rc = caterva_array_save(ctx, array->levels[l - 1], lfilename);
+        caterva_pyramid_filename_free(ctx, lfilename);
+        CATERVA_ERROR(rc);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Open the levels of an array read from filename out of their sibling files. An array whose
+// levels were not saved along with it is left alone (they can still be joined by hand).
+int caterva_pyramid_from_file(caterva_context_t *ctx, const char *filename, bool copy,
+                              caterva_array_t **array) {
+    caterva_array_t *base = *array;
+    if (base->storage != CATERVA_STORAGE_BLOSC ||
+        blosc2_has_metalayer(base->sc, pyramid_metalayer) < 0) {
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *smeta;
+    uint32_t smeta_len;
+    if (blosc2_get_metalayer(base->sc, pyramid_metalayer, &smeta, &smeta_len) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    int8_t level;
+    int8_t nlevels;
+    caterva_pyramid_reduce_t reduce;
+    caterva_item_kind_t kind;
+    int rc = deserialize_pyramid(smeta, smeta_len, &level, &nlevels, &reduce, &kind);
+    free(smeta);
+    CATERVA_ERROR(rc);
+    if (level != 0 || nlevels == 0) {
+        return CATERVA_SUCCEED;
+    }
+    char *lfilename = caterva_pyramid_filename(ctx, filename, 1);
+    CATERVA_ERROR_NULL(lfilename);
+    FILE *fp = fopen(lfilename, "rb");
+    caterva_pyramid_filename_free(ctx, lfilename);
+    if (fp == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    fclose(fp);
+
+    caterva_array_t *arrays[CATERVA_MAX_LEVELS + 1] = {base};
+    int8_t l = 1;
+    while (l <= nlevels && rc == CATERVA_SUCCEED) {
+        lfilename = caterva_pyramid_filename(ctx, filename, l);
+        rc = lfilename != NULL ? caterva_array_from_file(ctx, lfilename, copy, &arrays[l])
+                               : CATERVA_ERR_NULL_POINTER;
+        caterva_pyramid_filename_free(ctx, lfilename);
+        l = rc == CATERVA_SUCCEED ? (int8_t) (l + 1) : l;
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_array_from_levels(ctx, arrays, (int8_t) (nlevels + 1), array);
+    }
+    if (rc != CATERVA_SUCCEED) {
+        for (int i = 1; i < l; ++i) {
+            caterva_array_free(ctx, &arrays[i]);
+        }
+        CATERVA_ERROR(rc);
+    }
+
+    return CATERVA_SUCCEED;
+}
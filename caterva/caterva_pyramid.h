@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#ifndef CATERVA_CATERVA_PYRAMID_H_
+#define CATERVA_CATERVA_PYRAMID_H_
+
+/* The size of the caterva_pyramid metalayer */
+#define CATERVA_PYRAMID_METALAYER_LEN 5
+
+char *caterva_pyramid_filename(caterva_context_t *ctx, const char *filename, int8_t level);
+
+void caterva_pyramid_filename_free(caterva_context_t *ctx, char *lfilename);
+
+int caterva_pyramid_storage(caterva_context_t *ctx, caterva_params_t *params,
+                            caterva_storage_t *storage, int8_t level, uint8_t *smeta,
+                            char **lfilename, caterva_params_t *lparams,
+                            caterva_storage_t *lstorage);
+
+int caterva_pyramid_free(caterva_context_t *ctx, caterva_array_t *array);
+
+int caterva_pyramid_append(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                           void **chunks, int64_t *chunksizes, int64_t nchunks);
+
+int caterva_pyramid_from_buffer(caterva_context_t *ctx, caterva_array_t *array,
+                                const uint8_t *buffer);
+
+int caterva_pyramid_save(caterva_context_t *ctx, caterva_array_t *array, const char *filename);
+
+int caterva_pyramid_from_file(caterva_context_t *ctx, const char *filename, bool copy,
+                              caterva_array_t **array);
+
+int caterva_pyramid_flush(caterva_context_t *ctx, caterva_array_t *array);
+
+#endif  // CATERVA_CATERVA_PYRAMID_H_
@@ -0,0 +1,600 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_blosc.h"
+#include "caterva_utils.h"
+
+/*
+ * The rechunk streams the source chunks in storage order and scatters each one into the
+ * destination chunks it overlaps. The destination chunks are staged (decompressed, in block
+ * layout) until all their sources have been seen; then they are compressed and appended.
+ *
+ * When the staging window (the destination chunks touched by a row of source chunks along the
+ * first axis) fits in the memory budget, every source chunk is decompressed exactly once.
+ * Otherwise the destination chunks are produced in groups that fit in the budget and each
+ * source chunk is decompressed once per group it overlaps.
+ */
+
+typedef struct {
+    caterva_context_t *ctx;
+    caterva_array_t *src;
+    caterva_array_t *dest;
+    int64_t src_grid[CATERVA_MAX_DIM];
+    //!< The number of source chunks along each axis.
+    int64_t dest_grid[CATERVA_MAX_DIM];
+    //!< The number of destination chunks along each axis.
+    int64_t staged_first;
+    //!< The index of the first staged destination chunk.
+    int64_t nstaged;
+    //!< The number of staged destination chunks.
+    uint8_t **staged;
+    //!< The staged destination chunks.
+    int nworkers;
+    //!< The number of workers.
+    blosc2_context **dctx;
+    //!< The decompression context of each worker.
+    blosc2_context **cctx;
+    //!< The compression context of each worker.
+    uint8_t **chunks;
+    //!< The decompressed source chunk of each worker.
+    uint8_t **cchunks;
+    //!< The compressed destination chunk of each worker.
+    int32_t *csizes;
+    //!< The compressed size of the chunk of each worker.
+    bool *uniform;
+    //!< Whether the chunk of each worker is uniform (decided before it is encoded).
+} rechunk_t;
+
+static void chunk_origin(caterva_array_t *array, int64_t *grid, int64_t nchunk,
+                         int64_t *origin) {
+    for (int i = array->ndim - 1; i >= 0; --i) {
+        origin[i] = (nchunk % grid[i]) * array->chunkshape[i];
+        nchunk /= grid[i];
+    }
+}
+
+// Copy the items of a source chunk that fall in a destination chunk, block by block
+static void scatter_chunk(rechunk_t *r, int64_t src_nchunk, const uint8_t *src_chunk,
+                          int64_t dest_nchunk, uint8_t *dest_chunk) {
+    caterva_array_t *src = r->src;
+    caterva_array_t *dest = r->dest;
+    int8_t ndim = src->ndim;
+    int32_t itemsize = src->itemsize;
+
+    int64_t src_origin[CATERVA_MAX_DIM];
+    int64_t dest_origin[CATERVA_MAX_DIM];
+    chunk_origin(src, r->src_grid, src_nchunk, src_origin);
+    chunk_origin(dest, r->dest_grid, dest_nchunk, dest_origin);
+
+    // The overlap in array coordinates
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = src_origin[i] > dest_origin[i] ? src_origin[i] : dest_origin[i];
+        stop[i] = src_origin[i] + src->chunkshape[i];
+        if (stop[i] > dest_origin[i] + dest->chunkshape[i]) {
+            stop[i] = dest_origin[i] + dest->chunkshape[i];
+        }
+        if (stop[i] > src->shape[i]) {
+            stop[i] = src->shape[i];
+        }
+        if (start[i] >= stop[i]) {
+            return;
+        }
+    }
+
+    int64_t src_bgrid[CATERVA_MAX_DIM];
+    int64_t dest_bgrid[CATERVA_MAX_DIM];
+    int64_t src_bshape[CATERVA_MAX_DIM];
+    int64_t dest_bshape[CATERVA_MAX_DIM];
+    int64_t sb_first[CATERVA_MAX_DIM];
+    int64_t sb_count[CATERVA_MAX_DIM];
+    int64_t nsblocks = 1;
+    for (int i = 0; i < ndim; ++i) {
+        src_bshape[i] = src->blockshape[i];
+        dest_bshape[i] = dest->blockshape[i];
+        src_bgrid[i] = src->extchunkshape[i] / src->blockshape[i];
+        dest_bgrid[i] = dest->extchunkshape[i] / dest->blockshape[i];
+        sb_first[i] = (start[i] - src_origin[i]) / src_bshape[i];
+        sb_count[i] = (stop[i] - 1 - src_origin[i]) / src_bshape[i] - sb_first[i] + 1;
+        nsblocks *= sb_count[i];
+    }
+
+    for (int64_t sb = 0; sb < nsblocks; ++sb) {
+        // The source block and its overlap with the region
+        int64_t sblock = 0;
+        int64_t sb_origin[CATERVA_MAX_DIM];
+        int64_t sstart[CATERVA_MAX_DIM];
+        int64_t sstop[CATERVA_MAX_DIM];
+        int64_t db_first[CATERVA_MAX_DIM];
+        int64_t db_count[CATERVA_MAX_DIM];
+        int64_t ndblocks = 1;
+        int64_t rem = sb;
+        for (int i = ndim - 1; i >= 0; --i) {
+            sb_origin[i] = sb_first[i] + rem % sb_count[i];
+            rem /= sb_count[i];
+        }
+        for (int i = 0; i < ndim; ++i) {
+            sblock = sblock * src_bgrid[i] + sb_origin[i];
+            sb_origin[i] = src_origin[i] + sb_origin[i] * src_bshape[i];
+            sstart[i] = start[i] > sb_origin[i] ? start[i] : sb_origin[i];
+            sstop[i] = stop[i] < sb_origin[i] + src_bshape[i] ? stop[i]
+                                                              : sb_origin[i] + src_bshape[i];
+            db_first[i] = (sstart[i] - dest_origin[i]) / dest_bshape[i];
+            db_count[i] = (sstop[i] - 1 - dest_origin[i]) / dest_bshape[i] - db_first[i] + 1;
+            ndblocks *= db_count[i];
+        }
+        const uint8_t *sblock_data = src_chunk + sblock * src->blocknitems * itemsize;
+
+        for (int64_t db = 0; db < ndblocks; ++db) {
+            int64_t dblock = 0;
+            int64_t db_origin[CATERVA_MAX_DIM];
+            int64_t copy_shape[CATERVA_MAX_DIM];
+            int64_t src_start[CATERVA_MAX_DIM];
+            int64_t dest_start[CATERVA_MAX_DIM];
+            rem = db;
+            for (int i = ndim - 1; i >= 0; --i) {
+                db_origin[i] = db_first[i] + rem % db_count[i];
+                rem /= db_count[i];
+            }
+            for (int i = 0; i < ndim; ++i) {
+                dblock = dblock * dest_bgrid[i] + db_origin[i];
+                db_origin[i] = dest_origin[i] + db_origin[i] * dest_bshape[i];
+                int64_t dstart = sstart[i] > db_origin[i] ? sstart[i] : db_origin[i];
+                int64_t dstop = sstop[i] < db_origin[i] + dest_bshape[i]
+                                    ? sstop[i] : db_origin[i] + dest_bshape[i];
+                copy_shape[i] = dstop - dstart;
+                src_start[i] = dstart - sb_origin[i];
+                dest_start[i] = dstart - db_origin[i];
+            }
+            uint8_t *dblock_data = dest_chunk + dblock * dest->blocknitems * itemsize;
+            caterva_copy_region(r->ctx, ndim, itemsize, copy_shape, sblock_data, src_bshape,
+                                src_start, dblock_data, dest_bshape, dest_start);
+        }
+    }
+}
+
+// Decompress a source chunk and scatter it into the staged destination chunks
+static int process_chunk(rechunk_t *r, int worker, int64_t src_nchunk) {
+    caterva_array_t *src = r->src;
+    caterva_array_t *dest = r->dest;
+    int8_t ndim = src->ndim;
+
+    caterva_stats_t src_stats = {0};
+    caterva_stats_t dest_stats = {0};
+    blosc_timestamp_t t0;
+
+    size_t chunksize = (size_t) src->extchunknitems * src->itemsize;
+    uint8_t value[CATERVA_MAX_ITEMSIZE];
+    bool uniform;
+    int rc = caterva_blosc_read_chunk(r->ctx, src, r->dctx[worker], src_nchunk, NULL,
+                                      r->chunks[worker], chunksize, value, &uniform, &src_stats);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_stats_merge(r->ctx, src, &src_stats);
+        return rc;
+    }
+    if (uniform) {
+        // Broadcast the value, so that the chunk is scattered as any other one
+        caterva_fill_buffer(r->chunks[worker], src->extchunknitems, src->itemsize, value);
+    }
+    caterva_stats_merge(r->ctx, src, &src_stats);
+
+    // The destination chunks overlapping the source chunk
+    int64_t origin[CATERVA_MAX_DIM];
+    int64_t first[CATERVA_MAX_DIM];
+    int64_t count[CATERVA_MAX_DIM];
+    int64_t ndchunks = 1;
+    chunk_origin(src, r->src_grid, src_nchunk, origin);
+    for (int i = 0; i < ndim; ++i) {
+        int64_t stop = origin[i] + src->chunkshape[i];
+        if (stop > src->shape[i]) {
+            stop = src->shape[i];
+        }
+        first[i] = origin[i] / dest->chunkshape[i];
+        count[i] = (stop - 1) / dest->chunkshape[i] - first[i] + 1;
+        ndchunks *= count[i];
+    }
+    caterva_stage_begin(r->ctx, CATERVA_STAGE_SCATTER, src, src_nchunk, &t0);
+    for (int64_t n = 0; n < ndchunks; ++n) {
+        int64_t dest_nchunk = 0;
+        int64_t index[CATERVA_MAX_DIM];
+        int64_t rem = n;
+        for (int i = ndim - 1; i >= 0; --i) {
+            index[i] = first[i] + rem % count[i];
+            rem /= count[i];
+        }
+        for (int i = 0; i < ndim; ++i) {
+            dest_nchunk = dest_nchunk * r->dest_grid[i] + index[i];
+        }
+        if (dest_nchunk >= r->staged_first && dest_nchunk < r->staged_first + r->nstaged) {
+            scatter_chunk(r, src_nchunk, r->chunks[worker], dest_nchunk,
+                          r->staged[dest_nchunk - r->staged_first]);
+        }
+    }
+    caterva_stage_end(r->ctx, CATERVA_STAGE_SCATTER, src, src_nchunk, (int64_t) chunksize, &t0,
+                      &dest_stats);
+    caterva_stats_merge(r->ctx, dest, &dest_stats);
+    return CATERVA_SUCCEED;
+}
+
+static int process_chunks(rechunk_t *r, int64_t *nchunks, int64_t len) {
+    int64_t nparts = r->nworkers < len ? r->nworkers : len;
+    int rc = CATERVA_SUCCEED;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nparts) if (nparts > 1)
+#endif
+    for (int64_t part = 0; part < nparts; ++part) {
+        for (int64_t i = len * part / nparts; i < len * (part + 1) / nparts; ++i) {
+            int err = process_chunk(r, (int) part, nchunks[i]);
+            if (err != CATERVA_SUCCEED) {
+#if defined(_OPENMP)
+#pragma omp critical(caterva_rechunk_rc)
+#endif
+                rc = err;
+            }
+        }
+    }
+    return rc;
+}
+
+// Stage (zeroed) destination chunks up to end
+static int stage_until(rechunk_t *r, int64_t end) {
+    size_t nbytes = (size_t) r->dest->extchunknitems * r->dest->itemsize;
+    while (r->staged_first + r->nstaged < end) {
+        uint8_t *chunk = caterva_malloc(r->ctx, nbytes, CATERVA_ALLOC_CHUNK);
+        CATERVA_ERROR_NULL(chunk);
+        memset(chunk, 0, nbytes);
+        r->staged[r->nstaged++] = chunk;
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Compress and append the staged destination chunks up to end
+static int flush_until(rechunk_t *r, int64_t end) {
+    caterva_array_t *dest = r->dest;
+    size_t nbytes = (size_t) dest->extchunknitems * dest->itemsize;
+    int64_t count = end - r->staged_first;
+
+    for (int64_t first = 0; first < count; first += r->nworkers) {
+        int64_t nbatch = count - first < r->nworkers ? count - first : r->nworkers;
+        // The chunks are checked before they are encoded, as a delta may turn out uniform
+        for (int64_t i = 0; i < nbatch; ++i) {
+            r->uniform[i] = r->ctx->cfg->prefilter == NULL &&
+                            caterva_is_uniform(r->staged[first + i], dest->extchunknitems,
+                                               dest->itemsize);
+        }
+        // The deltas depend on the previous chunks, so they are encoded in order
+        bool deltas = dest->keyframe_interval > 0;
+        for (int64_t i = 0; i < nbatch && deltas; ++i) {
+            if (r->uniform[i]) {
+                continue;
+            }
+            caterva_stats_t stats = {0};
+            int rc = caterva_blosc_encode_rchunk(r->ctx, dest, r->staged_first + first + i,
+                                                 r->staged[first + i], &stats);
+            caterva_stats_merge(r->ctx, dest, &stats);
+            CATERVA_ERROR(rc);
+        }
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nbatch) if (nbatch > 1)
+#endif
+        for (int64_t i = 0; i < nbatch; ++i) {
+            caterva_stats_t stats = {0};
+            blosc_timestamp_t t0;
+            int64_t nchunk = r->staged_first + first + i;
+            // A uniform chunk is stored as a special chunk that only holds its value
+            if (r->uniform[i]) {
+                caterva_sums_uniform(dest, nchunk, r->staged[first + i]);
+                caterva_bloom_uniform(dest, nchunk, r->staged[first + i]);
+                r->csizes[i] = caterva_blosc_uniform_cchunk(dest, r->staged[first + i],
+                                                            r->cchunks[i]);
+                stats.nchunks_uniform_written = 1;
+                caterva_stats_merge(r->ctx, dest, &stats);
+                continue;
+            }
+            caterva_stage_begin(r->ctx, CATERVA_STAGE_COMPRESS, dest, nchunk, &t0);
+            // Without deltas, the chunks are encoded independently (and the cache is not used)
+            int encoded = CATERVA_SUCCEED;
+            if (!deltas) {
+                encoded = caterva_blosc_encode_rchunk(r->ctx, dest, nchunk, r->staged[first + i],
+                                                      &stats);
+            }
+            r->csizes[i] = encoded != CATERVA_SUCCEED
+                               ? -1
+                               : blosc2_compress_ctx(r->cctx[i], nbytes, r->staged[first + i],
+                                                     r->cchunks[i], nbytes + BLOSC_MAX_OVERHEAD);
+            caterva_stage_end(r->ctx, CATERVA_STAGE_COMPRESS, dest, nchunk, (int64_t) nbytes,
+                              &t0, &stats);
+            stats.nchunks_compressed = 1;
+            stats.bytes_compressed = (int64_t) nbytes;
+            caterva_stats_merge(r->ctx, dest, &stats);
+        }
+        // The chunks are appended in order
+        for (int64_t i = 0; i < nbatch; ++i) {
+            if (r->csizes[i] <= 0) {
+                DEBUG_PRINT("Error compressing a chunk");
+                return CATERVA_ERR_BLOSC_FAILED;
+            }
+            CATERVA_ERROR(caterva_blosc_array_append_cchunk(r->ctx, dest, r->cchunks[i]));
+            dest->nchunks++;
+            dest->empty = false;
+            // The chunk is left out of the staging area, which is released on errors
+            caterva_free(r->ctx, r->staged[first + i], nbytes, CATERVA_ALLOC_CHUNK);
+            r->staged[first + i] = NULL;
+        }
+    }
+
+    memmove(r->staged, r->staged + count, (size_t) (r->nstaged - count) * sizeof(uint8_t *));
+    r->nstaged -= count;
+    r->staged_first = end;
+    return CATERVA_SUCCEED;
+}
+
+static int rechunk_window(rechunk_t *r, int64_t *nchunks) {
+    caterva_array_t *src = r->src;
+    caterva_array_t *dest = r->dest;
+    int64_t src_rowlen = src->extnitems / src->chunknitems / r->src_grid[0];
+    int64_t dest_rowlen = dest->extnitems / dest->chunknitems / r->dest_grid[0];
+
+    for (int64_t row = 0; row < r->src_grid[0]; ++row) {
+        int64_t stop = (row + 1) * src->chunkshape[0];
+        if (stop > src->shape[0]) {
+            stop = src->shape[0];
+        }
+        int64_t dest_rows = (stop - 1) / dest->chunkshape[0] + 1;
+        CATERVA_ERROR(stage_until(r, dest_rows * dest_rowlen));
+
+        for (int64_t i = 0; i < src_rowlen; ++i) {
+            nchunks[i] = row * src_rowlen + i;
+        }
+        CATERVA_ERROR(process_chunks(r, nchunks, src_rowlen));
+
+        // The destination rows that end before the next source row are complete
+        int64_t complete = stop == src->shape[0] ? dest_rows : stop / dest->chunkshape[0];
+        CATERVA_ERROR(flush_until(r, complete * dest_rowlen));
+    }
+    return CATERVA_SUCCEED;
+}
+
+static int rechunk_groups(rechunk_t *r, int64_t *nchunks, int64_t group) {
+    caterva_array_t *src = r->src;
+    caterva_array_t *dest = r->dest;
+    int8_t ndim = src->ndim;
+    int64_t src_nchunks = src->extnitems / src->chunknitems;
+    int64_t dest_nchunks = dest->extnitems / dest->chunknitems;
+
+    bool *used = caterva_malloc(r->ctx, (size_t) src_nchunks, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(used);
+    memset(used, 0, (size_t) src_nchunks);
+
+    int rc = CATERVA_SUCCEED;
+    for (int64_t first = 0; first < dest_nchunks && rc == CATERVA_SUCCEED; first += group) {
+        int64_t end = first + group < dest_nchunks ? first + group : dest_nchunks;
+        rc = stage_until(r, end);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+
+        // Collect the source chunks overlapping the group
+        int64_t len = 0;
+        for (int64_t dest_nchunk = first; dest_nchunk < end; ++dest_nchunk) {
+            int64_t origin[CATERVA_MAX_DIM];
+            int64_t sfirst[CATERVA_MAX_DIM];
+            int64_t scount[CATERVA_MAX_DIM];
+            int64_t nschunks = 1;
+            chunk_origin(dest, r->dest_grid, dest_nchunk, origin);
+            for (int i = 0; i < ndim; ++i) {
+                int64_t stop = origin[i] + dest->chunkshape[i];
+                if (stop > dest->shape[i]) {
+                    stop = dest->shape[i];
+                }
+                sfirst[i] = origin[i] / src->chunkshape[i];
+                scount[i] = (stop - 1) / src->chunkshape[i] - sfirst[i] + 1;
+                nschunks *= scount[i];
+            }
+            for (int64_t n = 0; n < nschunks; ++n) {
+                int64_t src_nchunk = 0;
+                int64_t index[CATERVA_MAX_DIM];
+                int64_t rem = n;
+                for (int i = ndim - 1; i >= 0; --i) {
+                    index[i] = sfirst[i] + rem % scount[i];
+                    rem /= scount[i];
+                }
+                for (int i = 0; i < ndim; ++i) {
+                    src_nchunk = src_nchunk * r->src_grid[i] + index[i];
+                }
+                if (!used[src_nchunk]) {
+                    used[src_nchunk] = true;
+                    nchunks[len++] = src_nchunk;
+                }
+            }
+        }
+
+        rc = process_chunks(r, nchunks, len);
+        for (int64_t i = 0; i < len; ++i) {
+            used[nchunks[i]] = false;
+        }
+        if (rc == CATERVA_SUCCEED) {
+            rc = flush_until(r, end);
+        }
+    }
+
+    caterva_free(r->ctx, used, (size_t) src_nchunks, CATERVA_ALLOC_SCRATCH);
+    return rc;
+}
+
+static int rechunk_blosc(caterva_context_t *ctx, caterva_array_t *src, int64_t membudget,
+                         caterva_array_t *dest) {
+    rechunk_t r = {0};
+    r.ctx = ctx;
+    r.src = src;
+    r.dest = dest;
+    int8_t ndim = src->ndim;
+    for (int i = 0; i < ndim; ++i) {
+        r.src_grid[i] = src->extshape[i] / src->chunkshape[i];
+        r.dest_grid[i] = dest->extshape[i] / dest->chunkshape[i];
+    }
+    int64_t src_nchunks = src->extnitems / src->chunknitems;
+    int64_t dest_nchunks = dest->extnitems / dest->chunknitems;
+    int64_t src_rowlen = src_nchunks / r.src_grid[0];
+    int64_t dest_rowlen = dest_nchunks / r.dest_grid[0];
+
+    // Without OpenMP the chunks are processed one by one with multi-threaded Blosc contexts
+#if defined(_OPENMP)
+    r.nworkers = ctx->cfg->nthreads;
+    int ctx_nthreads = 1;
+#else
+    r.nworkers = 1;
+    int ctx_nthreads = ctx->cfg->nthreads;
+#endif
+
+    // Size the staging area
+    int64_t chunkbytes = dest->extchunknitems * dest->itemsize;
+    int64_t workerbytes = src->extchunknitems * src->itemsize + chunkbytes + BLOSC_MAX_OVERHEAD;
+    int64_t window = 0;
+    int64_t flushed = 0;
+    for (int64_t row = 0; row < r.src_grid[0]; ++row) {
+        int64_t stop = (row + 1) * src->chunkshape[0];
+        if (stop > src->shape[0]) {
+            stop = src->shape[0];
+        }
+        int64_t dest_rows = (stop - 1) / dest->chunkshape[0] + 1;
+        if (dest_rows * dest_rowlen - flushed > window) {
+            window = dest_rows * dest_rowlen - flushed;
+        }
+        flushed = (stop == src->shape[0] ? dest_rows : stop / dest->chunkshape[0]) * dest_rowlen;
+    }
+    // The workers are limited to the ones that fit in the budget along with a staged chunk
+    if (membudget < workerbytes + chunkbytes) {
+        DEBUG_PRINT("The memory budget can not hold the chunks of a single worker");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (r.nworkers > (membudget - chunkbytes) / workerbytes) {
+        r.nworkers = (int) ((membudget - chunkbytes) / workerbytes);
+    }
+    int64_t available = membudget - r.nworkers * workerbytes;
+    bool windowed = window * chunkbytes <= available;
+    int64_t group = available / chunkbytes;
+    int64_t capacity = windowed ? window : group;
+    int64_t maxlen = windowed ? src_rowlen : src_nchunks;
+
+    int rc = CATERVA_SUCCEED;
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(dest->sc, &cparams) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    cparams->nthreads = (int16_t) ctx_nthreads;
+    blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+    dparams.nthreads = (int16_t) ctx_nthreads;
+
+    size_t nworkers = (size_t) r.nworkers;
+    r.dctx = caterva_malloc(ctx, nworkers * sizeof(blosc2_context *), CATERVA_ALLOC_SCRATCH);
+    r.cctx = caterva_malloc(ctx, nworkers * sizeof(blosc2_context *), CATERVA_ALLOC_SCRATCH);
+    r.chunks = caterva_malloc(ctx, nworkers * sizeof(uint8_t *), CATERVA_ALLOC_SCRATCH);
+    r.cchunks = caterva_malloc(ctx, nworkers * sizeof(uint8_t *), CATERVA_ALLOC_SCRATCH);
+    r.csizes = caterva_malloc(ctx, nworkers * sizeof(int32_t), CATERVA_ALLOC_SCRATCH);
+    r.uniform = caterva_malloc(ctx, nworkers * sizeof(bool), CATERVA_ALLOC_SCRATCH);
+    r.staged = caterva_malloc(ctx, (size_t) capacity * sizeof(uint8_t *), CATERVA_ALLOC_SCRATCH);
+    int64_t *nchunks = caterva_malloc(ctx, (size_t) maxlen * sizeof(int64_t),
+                                      CATERVA_ALLOC_SCRATCH);
+    bool workers = r.dctx != NULL && r.cctx != NULL && r.chunks != NULL && r.cchunks != NULL;
+    if (!workers || r.csizes == NULL || r.uniform == NULL || r.staged == NULL ||
+        nchunks == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int w = 0; w < r.nworkers && workers; ++w) {
+        r.dctx[w] = blosc2_create_dctx(dparams);
+        r.cctx[w] = blosc2_create_cctx(*cparams);
+        r.chunks[w] = caterva_malloc(ctx, (size_t) src->extchunknitems * src->itemsize,
+                                     CATERVA_ALLOC_CHUNK);
+        r.cchunks[w] = caterva_malloc(ctx, (size_t) (chunkbytes + BLOSC_MAX_OVERHEAD),
+                                      CATERVA_ALLOC_CHUNK);
+        if (r.dctx[w] == NULL || r.cctx[w] == NULL || r.chunks[w] == NULL ||
+            r.cchunks[w] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+    free(cparams);
+
+    if (rc == CATERVA_SUCCEED && windowed) {
+        rc = rechunk_window(&r, nchunks);
+    } else if (rc == CATERVA_SUCCEED) {
+        rc = rechunk_groups(&r, nchunks, group);
+    }
+
+    for (int64_t i = 0; i < r.nstaged; ++i) {
+        caterva_free(ctx, r.staged[i], (size_t) chunkbytes, CATERVA_ALLOC_CHUNK);
+    }
+    for (int w = 0; w < r.nworkers && workers; ++w) {
+        if (r.dctx[w] != NULL) {
+            blosc2_free_ctx(r.dctx[w]);
+        }
+        if (r.cctx[w] != NULL) {
+            blosc2_free_ctx(r.cctx[w]);
+        }
+        caterva_free(ctx, r.chunks[w], (size_t) src->extchunknitems * src->itemsize,
+                     CATERVA_ALLOC_CHUNK);
+        caterva_free(ctx, r.cchunks[w], (size_t) (chunkbytes + BLOSC_MAX_OVERHEAD),
+                     CATERVA_ALLOC_CHUNK);
+    }
+    caterva_free(ctx, r.dctx, nworkers * sizeof(blosc2_context *), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, r.cctx, nworkers * sizeof(blosc2_context *), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, r.chunks, nworkers * sizeof(uint8_t *), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, r.cchunks, nworkers * sizeof(uint8_t *), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, r.csizes, nworkers * sizeof(int32_t), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, r.uniform, nworkers * sizeof(bool), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, r.staged, (size_t) capacity * sizeof(uint8_t *), CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, nchunks, (size_t) maxlen * sizeof(int64_t), CATERVA_ALLOC_SCRATCH);
+
+    return rc;
+}
+
+int caterva_array_rechunk(caterva_context_t *ctx, caterva_array_t *src,
+                          caterva_storage_t *storage, int64_t membudget,
+                          caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(src);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_COMPOUND(src);
+    CATERVA_ERROR(caterva_array_flush(ctx, src));
+
+    // Plain buffers have no chunks to stream, and the levels are built by the regular appends
+    if (src->storage != CATERVA_STORAGE_BLOSC || storage->backend != CATERVA_STORAGE_BLOSC ||
+        src->nitems == 0 || storage->properties.blosc.pyramid_levels != 0) {
+        CATERVA_ERROR(caterva_array_copy(ctx, src, storage, array));
+        return CATERVA_SUCCEED;
+    }
+
+    if (membudget <= 0) {
+        membudget = CATERVA_RECHUNK_MEMBUDGET_DEFAULT;
+    }
+
+    caterva_params_t params = {0};
+    params.itemsize = src->itemsize;
+    params.ndim = src->ndim;
+    for (int i = 0; i < src->ndim; ++i) {
+        params.shape[i] = src->shape[i];
+    }
+    CATERVA_ERROR(caterva_array_empty(ctx, &params, storage, array));
+
+    int rc = rechunk_blosc(ctx, src, membudget, *array);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_array_free(ctx, array);
+        CATERVA_ERROR(rc);
+    }
+    (*array)->filled = true;
+    (*array)->empty = false;
+
+    return CATERVA_SUCCEED;
+}
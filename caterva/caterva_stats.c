@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_utils.h"
+
+/* All the fields of caterva_stats_t are 64-bit counters */
+#define CATERVA_STATS_NFIELDS (sizeof(caterva_stats_t) / sizeof(int64_t))
+
+#if defined(CATERVA_TRACING)
+void caterva_trace(caterva_context_t *ctx, caterva_stage_t stage, caterva_trace_phase_t phase,
+                   caterva_array_t *array, int64_t nchunk, int64_t nbytes) {
+    caterva_trace_event_t event;
+    event.stage = stage;
+    event.phase = phase;
+    event.array = array;
+    event.nchunk = nchunk;
+    event.nbytes = nbytes;
+    ctx->cfg->trace(&event, ctx->cfg->trace_data);
+}
+#endif
+
+static void stats_add(caterva_stats_t *dest, const caterva_stats_t *delta) {
+    int64_t *dest_ = (int64_t *) dest;
+    const int64_t *delta_ = (const int64_t *) delta;
+    for (size_t i = 0; i < CATERVA_STATS_NFIELDS; ++i) {
+        dest_[i] += delta_[i];
+    }
+}
+
+void caterva_stats_merge(caterva_context_t *ctx, caterva_array_t *array,
+                         const caterva_stats_t *delta) {
+    if (!ctx->cfg->stats) {
+        return;
+    }
+    // Workers of the parallel operations merge their own statistics when they finish
+#if defined(_OPENMP)
+#pragma omp critical(caterva_stats)
+#endif
+    {
+        if (array != NULL) {
+            stats_add(&array->stats, delta);
+        }
+        stats_add(&ctx->stats, delta);
+    }
+}
+
+int caterva_context_get_stats(caterva_context_t *ctx, caterva_stats_t *stats, bool reset) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(stats);
+
+    memcpy(stats, &ctx->stats, sizeof(caterva_stats_t));
+    if (reset) {
+        memset(&ctx->stats, 0, sizeof(caterva_stats_t));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_get_stats(caterva_context_t *ctx, caterva_array_t *array,
+                            caterva_stats_t *stats, bool reset) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(stats);
+
+    if (array->nfields > 0) {
+        // A compound array reads and writes through the arrays of its fields
+        memset(stats, 0, sizeof(caterva_stats_t));
+        for (int i = 0; i < array->nfields; ++i) {
+            caterva_stats_t fstats;
+            CATERVA_ERROR(caterva_array_get_stats(ctx, array->field_arrays[i], &fstats, reset));
+            stats_add(stats, &fstats);
+        }
+        return CATERVA_SUCCEED;
+    }
+
+    memcpy(stats, &array->stats, sizeof(caterva_stats_t));
+    if (reset) {
+        memset(&array->stats, 0, sizeof(caterva_stats_t));
+    }
+
+    return CATERVA_SUCCEED;
+}
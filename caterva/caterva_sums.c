@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_blosc.h"
+#include "caterva_utils.h"
+
+// The sum index keeps the sum of the items of every block (and chunk) of an array, which is
+// recorded when the chunk is written. Only the items inside the shape of the array are summed, so
+// that the padding of the chunks on the edges does not count. A box sum adds the chunks and blocks
+// that the box covers out of the index and only reads the blocks on its boundary.
+
+static char sums_metalayer[] = "caterva_sums";
+
+static int64_t nblocks_per_chunk(caterva_array_t *array) {
+    return array->extchunknitems / array->blocknitems;
+}
+
+int caterva_sums_new(caterva_context_t *ctx, caterva_array_t *array, caterva_item_kind_t kind) {
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    size_t block_sums_size = (size_t) (nchunks * nblocks_per_chunk(array)) * sizeof(double);
+    array->sum_kind = kind;
+    array->block_sums = caterva_malloc(ctx, block_sums_size, CATERVA_ALLOC_ARRAY);
+    CATERVA_ERROR_NULL(array->block_sums);
+    array->chunk_sums = caterva_malloc(ctx, (size_t) nchunks * sizeof(double),
+                                       CATERVA_ALLOC_ARRAY);
+    if (array->chunk_sums == NULL) {
+        caterva_free(ctx, array->block_sums, block_sums_size, CATERVA_ALLOC_ARRAY);
+        array->block_sums = NULL;
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    memset(array->block_sums, 0, block_sums_size);
+    memset(array->chunk_sums, 0, (size_t) nchunks * sizeof(double));
+    return CATERVA_SUCCEED;
+}
+
+void caterva_sums_free(caterva_context_t *ctx, caterva_array_t *array) {
+    if (array->block_sums == NULL) {
+        return;
+    }
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    caterva_free(ctx, array->block_sums,
+                 (size_t) (nchunks * nblocks_per_chunk(array)) * sizeof(double),
+                 CATERVA_ALLOC_ARRAY);
+    caterva_free(ctx, array->chunk_sums, (size_t) nchunks * sizeof(double), CATERVA_ALLOC_ARRAY);
+    array->block_sums = NULL;
+    array->chunk_sums = NULL;
+}
+
+#define DEFINE_SUM(type)                                                   \
+    static double sum_##type(const uint8_t *items, int64_t nitems) {       \
+        const type *x = (const type *) items;                              \
+        double sum = 0;                                                    \
+        for (int64_t i = 0; i < nitems; ++i) {                             \
+            sum += (double) x[i];                                          \
+        }                                                                  \
+        return sum;                                                        \
+    }
+
+DEFINE_SUM(uint8_t)
+DEFINE_SUM(uint16_t)
+DEFINE_SUM(uint32_t)
+DEFINE_SUM(uint64_t)
+DEFINE_SUM(int8_t)
+DEFINE_SUM(int16_t)
+DEFINE_SUM(int32_t)
+DEFINE_SUM(int64_t)
+DEFINE_SUM(float)
+DEFINE_SUM(double)
+
+static double sum_items(caterva_item_kind_t kind, int32_t itemsize, const uint8_t *items,
+                        int64_t nitems) {
+    switch (kind * 16 + itemsize) {
+        case CATERVA_ITEM_UINT * 16 + 1:
+            return sum_uint8_t(items, nitems);
+        case CATERVA_ITEM_UINT * 16 + 2:
+            return sum_uint16_t(items, nitems);
+        case CATERVA_ITEM_UINT * 16 + 4:
+            return sum_uint32_t(items, nitems);
+        case CATERVA_ITEM_UINT * 16 + 8:
+            return sum_uint64_t(items, nitems);
+        case CATERVA_ITEM_INT * 16 + 1:
+            return sum_int8_t(items, nitems);
+        case CATERVA_ITEM_INT * 16 + 2:
+            return sum_int16_t(items, nitems);
+        case CATERVA_ITEM_INT * 16 + 4:
+            return sum_int32_t(items, nitems);
+        case CATERVA_ITEM_INT * 16 + 8:
+            return sum_int64_t(items, nitems);
+        case CATERVA_ITEM_FLOAT * 16 + 4:
+            return sum_float(items, nitems);
+        default:
+            return sum_double(items, nitems);
+    }
+}
+
+void caterva_sums_rchunk(caterva_array_t *array, int64_t nchunk, const uint8_t *rchunk) {
+    if (array->block_sums == NULL) {
+        return;
+    }
+    int32_t itemsize = array->itemsize;
+    int64_t cshape[CATERVA_MAX_DIM];
+    caterva_blosc_chunk_shape(array, nchunk, cshape);
+    int64_t nblocks = nblocks_per_chunk(array);
+    double *block_sums = array->block_sums + nchunk * nblocks;
+    double chunk_sum = 0;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        const uint8_t *block = rchunk + nblock * array->blocknitems * itemsize;
+        int64_t bshape[CATERVA_MAX_DIM];
+        int64_t bnitems = caterva_block_extent(array, cshape, nblock, bshape);
+        double sum = 0;
+        if (bnitems == array->blocknitems) {
+            sum = sum_items(array->sum_kind, itemsize, block, bnitems);
+        } else if (bnitems > 0) {
+            // The rows of the block inside the array
+            int64_t rowlen = bshape[array->ndim - 1];
+            int64_t nrows = bnitems / rowlen;
+            for (int64_t row = 0; row < nrows; ++row) {
+                int64_t offset = caterva_block_row_offset(array, bshape, row);
+                sum += sum_items(array->sum_kind, itemsize, block + offset * itemsize, rowlen);
+            }
+        }
+        block_sums[nblock] = sum;
+        chunk_sum += sum;
+    }
+    array->chunk_sums[nchunk] = chunk_sum;
+    array->indexes_dirty = true;
+}
+
+void caterva_sums_uniform(caterva_array_t *array, int64_t nchunk, const uint8_t *value) {
+    if (array->block_sums == NULL) {
+        return;
+    }
+    double item = caterva_item_to_double(array->sum_kind, array->itemsize, value);
+    int64_t cshape[CATERVA_MAX_DIM];
+    caterva_blosc_chunk_shape(array, nchunk, cshape);
+    int64_t nblocks = nblocks_per_chunk(array);
+    double *block_sums = array->block_sums + nchunk * nblocks;
+    double chunk_sum = 0;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        int64_t bshape[CATERVA_MAX_DIM];
+        block_sums[nblock] = item * (double) caterva_block_extent(array, cshape, nblock, bshape);
+        chunk_sum += block_sums[nblock];
+    }
+    array->chunk_sums[nchunk] = chunk_sum;
+    array->indexes_dirty = true;
+}
+
+// The metalayer is [kind, bin 32 with the block sums as big-endian doubles]
+int caterva_sums_serialize(caterva_context_t *ctx, caterva_array_t *array, uint8_t **smeta,
+                           int32_t *smeta_len) {
+    int64_t nsums = array->extnitems / array->chunknitems * nblocks_per_chunk(array);
+    uint32_t nbytes = (uint32_t) nsums * sizeof(double);
+    *smeta_len = 7 + (int32_t) nbytes;
+    *smeta = caterva_malloc(ctx, (size_t) *smeta_len, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(*smeta);
+    uint8_t *pmeta = *smeta;
+
+    *pmeta++ = 0x90 + 2;  // fixarray with 2 elements
+    *pmeta++ = (uint8_t) array->sum_kind;  // positive fixnum (7-bit positive integer)
+    *pmeta++ = 0xc6;  // bin 32
+    for (int i = 3; i >= 0; --i) {
+        *pmeta++ = (uint8_t) (nbytes >> (8 * i));
+    }
+    for (int64_t n = 0; n < nsums; ++n) {
+        uint64_t bits;
+        memcpy(&bits, &array->block_sums[n], sizeof(bits));
+        for (int i = 7; i >= 0; --i) {
+            *pmeta++ = (uint8_t) (bits >> (8 * i));
+        }
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sums_deserialize(caterva_context_t *ctx, caterva_array_t *array,
+                             const uint8_t *smeta, uint32_t smeta_len) {
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    int64_t nblocks = nblocks_per_chunk(array);
+    uint32_t nbytes = (uint32_t) (nchunks * nblocks) * sizeof(double);
+    if (smeta_len != 7 + nbytes || smeta[0] != 0x90 + 2 || smeta[1] > CATERVA_ITEM_FLOAT ||
+        smeta[2] != 0xc6 ||
+        (uint32_t) (smeta[3] << 24 | smeta[4] << 16 | smeta[5] << 8 | smeta[6]) != nbytes) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    CATERVA_ERROR(caterva_sums_new(ctx, array, (caterva_item_kind_t) smeta[1]));
+    const uint8_t *pmeta = smeta + 7;
+    for (int64_t c = 0; c < nchunks; ++c) {
+        for (int64_t b = 0; b < nblocks; ++b) {
+            uint64_t bits = 0;
+            for (int i = 0; i < 8; ++i) {
+                bits = bits << 8 | *pmeta++;
+            }
+            double *sum = &array->block_sums[c * nblocks + b];
+            memcpy(sum, &bits, sizeof(bits));
+            array->chunk_sums[c] += *sum;
+        }
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sums_store(caterva_context_t *ctx, caterva_array_t *array) {
+    if (array->block_sums == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *smeta;
+    int32_t smeta_len;
+    CATERVA_ERROR(caterva_sums_serialize(ctx, array, &smeta, &smeta_len));
+    int rc = blosc2_update_metalayer(array->sc, sums_metalayer, smeta, (uint32_t) smeta_len);
+    caterva_free(ctx, smeta, (size_t) smeta_len, CATERVA_ALLOC_SCRATCH);
+    if (rc < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Add the sum of the items of the box [start, stop) that lie in the block nblock (with the given
+// origin and shape in the array) of the chunk nchunk
+static int add_block(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                     int64_t nblock, const int64_t *origin, const int64_t *bshape,
+                     const int64_t *start, const int64_t *stop, uint8_t *scratch,
+                     double *sum) {
+    int64_t bstart[CATERVA_MAX_DIM];
+    int64_t bstop[CATERVA_MAX_DIM];
+    int64_t shape[CATERVA_MAX_DIM];
+    bool covered = true;
+    int64_t nitems = 1;
+    for (int i = 0; i < array->ndim; ++i) {
+        bstart[i] = start[i] > origin[i] ? start[i] : origin[i];
+        bstop[i] = stop[i] < origin[i] + bshape[i] ? stop[i] : origin[i] + bshape[i];
+        if (bstart[i] >= bstop[i]) {
+            return CATERVA_SUCCEED;
+        }
+        covered = covered && bstart[i] == origin[i] && bstop[i] == origin[i] + bshape[i];
+        shape[i] = bstop[i] - bstart[i];
+        nitems *= shape[i];
+    }
+    if (covered) {
+        *sum += array->block_sums[nchunk * nblocks_per_chunk(array) + nblock];
+        return CATERVA_SUCCEED;
+    }
+    // Only the block on the boundary of the box is decompressed
+    CATERVA_ERROR(caterva_array_get_slice_buffer(ctx, array, bstart, bstop, shape, scratch,
+                                                 nitems * array->itemsize));
+    *sum += sum_items(array->sum_kind, array->itemsize, scratch, nitems);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_array_get_box_sum(caterva_context_t *ctx, caterva_array_t *array, int64_t *start,
+                              int64_t *stop, double *sum) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(start);
+    CATERVA_ERROR_NULL(stop);
+    CATERVA_ERROR_NULL(sum);
+
+    if (array->block_sums == NULL) {
+        DEBUG_PRINT("The array has no sum index");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    *sum = 0;
+    int8_t ndim = array->ndim;
+    int64_t first[CATERVA_MAX_DIM];
+    int64_t last[CATERVA_MAX_DIM];
+    int64_t grid[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        if (start[i] < 0 || start[i] > stop[i] || stop[i] > array->shape[i]) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        if (start[i] == stop[i]) {
+            return CATERVA_SUCCEED;
+        }
+        first[i] = start[i] / array->chunkshape[i];
+        last[i] = (stop[i] - 1) / array->chunkshape[i];
+        grid[i] = array->extshape[i] / array->chunkshape[i];
+    }
+
+    size_t scratchsize = (size_t) array->blocknitems * array->itemsize;
+    uint8_t *scratch = caterva_malloc(ctx, scratchsize, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(scratch);
+    int64_t nblocks = nblocks_per_chunk(array);
+    int rc = CATERVA_SUCCEED;
+    // The chunks that overlap the box, in order
+    int64_t coords[CATERVA_MAX_DIM];
+    memcpy(coords, first, sizeof(coords));
+    bool done = false;
+    while (!done && rc == CATERVA_SUCCEED) {
+        int64_t nchunk = 0;
+        int64_t corigin[CATERVA_MAX_DIM];
+        int64_t cshape[CATERVA_MAX_DIM];
+        bool covered = true;
+        for (int i = 0; i < ndim; ++i) {
+            nchunk = nchunk * grid[i] + coords[i];
+            corigin[i] = coords[i] * array->chunkshape[i];
+            cshape[i] = array->shape[i] - corigin[i] < array->chunkshape[i]
+                            ? array->shape[i] - corigin[i] : array->chunkshape[i];
+            covered = covered && start[i] <= corigin[i] && stop[i] >= corigin[i] + cshape[i];
+        }
+        if (covered) {
+            *sum += array->chunk_sums[nchunk];
+        } else {
+            for (int64_t nblock = 0; nblock < nblocks && rc == CATERVA_SUCCEED; ++nblock) {
+                int64_t bshape[CATERVA_MAX_DIM];
+                int64_t borigin[CATERVA_MAX_DIM];
+                if (caterva_block_extent(array, cshape, nblock, bshape) == 0) {
+                    continue;
+                }
+                int64_t rem = nblock;
+                for (int i = ndim - 1; i >= 0; --i) {
+                    int64_t bgrid = array->extchunkshape[i] / array->blockshape[i];
+                    borigin[i] = corigin[i] + rem % bgrid * array->blockshape[i];
+                    rem /= bgrid;
+                }
+                rc = add_block(ctx, array, nchunk, nblock, borigin, bshape, start, stop, scratch,
+                               sum);
+            }
+        }
+
+        // The next chunk
+        int i = ndim - 1;
+        while (i >= 0 && coords[i] == last[i]) {
+            coords[i] = first[i];
+            i--;
+        }
+        if (i < 0) {
+            done = true;
+        } else {
+            coords[i]++;
+        }
+    }
+    caterva_free(ctx, scratch, scratchsize, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
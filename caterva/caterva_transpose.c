@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_utils.h"
+
+/* The side (in items) of the square tiles used by the transposition kernels */
+#define CATERVA_TRANSPOSE_TILE 32
+
+/* The size of the slabs transposed at once when the destination is a plain buffer */
+#define CATERVA_TRANSPOSE_SLAB_SIZE (16 * 1024 * 1024)
+
+// Copy a tile of nq x nr items whose axes are swapped between the source and the destination
+#define TRANSPOSE_TILE(size)                                                                  \
+    for (int64_t iq = 0; iq < nq; ++iq) {                                                     \
+        const uint8_t *psrc = src + iq * (size);                                              \
+        uint8_t *pdest = dest + iq * dest_stride_q;                                           \
+        for (int64_t ir = 0; ir < nr; ++ir) {                                                 \
+            memcpy(pdest + ir * (size), psrc + ir * src_stride_r, (size));                    \
+        }                                                                                     \
+    }
+
+static void transpose_tile(int32_t itemsize, const uint8_t *src, int64_t src_stride_r,
+                           uint8_t *dest, int64_t dest_stride_q, int64_t nq, int64_t nr) {
+    // Specialize the kernel for the usual itemsizes so that the copies become plain moves
+    switch (itemsize) {
+        case 1:
+            TRANSPOSE_TILE(1)
+            break;
+        case 2:
+            TRANSPOSE_TILE(2)
+            break;
+        case 4:
+            TRANSPOSE_TILE(4)
+            break;
+        case 8:
+            TRANSPOSE_TILE(8)
+            break;
+        case 16:
+            TRANSPOSE_TILE(16)
+            break;
+        default:
+            TRANSPOSE_TILE((size_t) itemsize)
+    }
+}
+
+// Copy the tiles [work_start, work_stop) of a transposition; each unit of work is a band of
+// tiles sharing the outer index and the tile position along the q axis
+static void transpose_tiles(int nouter, const int64_t *outer_shape,
+                            const int64_t *outer_src_strides, const int64_t *outer_dest_strides,
+                            int32_t itemsize, int64_t nq, int64_t nr, int64_t src_stride_r,
+                            int64_t dest_stride_q,
+                            const uint8_t *src, uint8_t *dest, int64_t work_start,
+                            int64_t work_stop) {
+    int64_t ntiles_q = (nq + CATERVA_TRANSPOSE_TILE - 1) / CATERVA_TRANSPOSE_TILE;
+    for (int64_t work = work_start; work < work_stop; ++work) {
+        int64_t rem = work / ntiles_q;
+        int64_t iq = (work % ntiles_q) * CATERVA_TRANSPOSE_TILE;
+        const uint8_t *psrc = src + iq * itemsize;
+        uint8_t *pdest = dest + iq * dest_stride_q;
+        for (int i = nouter - 1; i >= 0; --i) {
+            int64_t index = rem % outer_shape[i];
+            rem /= outer_shape[i];
+            psrc += index * outer_src_strides[i];
+            pdest += index * outer_dest_strides[i];
+        }
+        int64_t tile_q = nq - iq < CATERVA_TRANSPOSE_TILE ? nq - iq : CATERVA_TRANSPOSE_TILE;
+        for (int64_t ir = 0; ir < nr; ir += CATERVA_TRANSPOSE_TILE) {
+            int64_t tile_r = nr - ir < CATERVA_TRANSPOSE_TILE ? nr - ir : CATERVA_TRANSPOSE_TILE;
+            transpose_tile(itemsize, psrc + ir * src_stride_r, src_stride_r,
+                           pdest + ir * itemsize, dest_stride_q, tile_q, tile_r);
+        }
+    }
+}
+
+/*
+ * Copy a region of the given shape (in destination order) reading the source with permuted
+ * strides. All the strides are in bytes.
+ */
+static void permute_region(caterva_context_t *ctx, int8_t ndim, int32_t itemsize,
+                           const int64_t *shape, const uint8_t *src, const int64_t *src_strides,
+                           uint8_t *dest, const int64_t *dest_strides) {
+    // Unit dimensions do not move anything
+    int n = 0;
+    int64_t shape_[CATERVA_MAX_DIM];
+    int64_t src_strides_[CATERVA_MAX_DIM];
+    int64_t dest_strides_[CATERVA_MAX_DIM];
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        if (shape[i] == 1) {
+            continue;
+        }
+        shape_[n] = shape[i];
+        src_strides_[n] = src_strides[i];
+        dest_strides_[n] = dest_strides[i];
+        nitems *= shape[i];
+        n++;
+    }
+    if (nitems == 0) {
+        return;
+    }
+    if (n == 0) {
+        memcpy(dest, src, (size_t) itemsize);
+        return;
+    }
+
+    int64_t nthreads = ctx->cfg->nthreads;
+    int64_t maxthreads = nitems * itemsize / CATERVA_COPY_MIN_THREAD_SIZE;
+    if (nthreads > maxthreads) {
+        nthreads = maxthreads > 0 ? maxthreads : 1;
+    }
+
+    int r = n - 1;
+    int q = -1;
+    for (int i = 0; i < r; ++i) {
+        if (src_strides_[i] == itemsize) {
+            q = i;
+        }
+    }
+
+    if (dest_strides_[r] != itemsize || (src_strides_[r] != itemsize && q < 0)) {
+        // No contiguous axis to exploit; copy item by item
+        int64_t nparts = nthreads;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nparts) if (nparts > 1)
+#endif
+        for (int64_t part = 0; part < nparts; ++part) {
+            caterva_copy_rows(n, shape_, src_strides_, dest_strides_, itemsize, src, dest,
+                              nitems * part / nparts, nitems * (part + 1) / nparts);
+        }
+        return;
+    }
+
+    if (src_strides_[r] == itemsize) {
+        // The innermost axis is kept; copy whole rows
+        int64_t nrows = nitems / shape_[r];
+        int64_t nparts = nthreads < nrows ? nthreads : nrows;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nparts) if (nparts > 1)
+#endif
+        for (int64_t part = 0; part < nparts; ++part) {
+            caterva_copy_rows(r, shape_, src_strides_, dest_strides_, shape_[r] * itemsize, src,
+                              dest, nrows * part / nparts, nrows * (part + 1) / nparts);
+        }
+        return;
+    }
+
+    // The innermost source axis (q) and the innermost destination axis (r) are swapped; go
+    // through them in tiles that fit in the L1 cache
+    int nouter = 0;
+    int64_t outer_shape[CATERVA_MAX_DIM];
+    int64_t outer_src_strides[CATERVA_MAX_DIM];
+    int64_t outer_dest_strides[CATERVA_MAX_DIM];
+    int64_t nouter_items = 1;
+    for (int i = 0; i < r; ++i) {
+        if (i == q) {
+            continue;
+        }
+        outer_shape[nouter] = shape_[i];
+        outer_src_strides[nouter] = src_strides_[i];
+        outer_dest_strides[nouter] = dest_strides_[i];
+        nouter_items *= shape_[i];
+        nouter++;
+    }
+    int64_t ntiles_q = (shape_[q] + CATERVA_TRANSPOSE_TILE - 1) / CATERVA_TRANSPOSE_TILE;
+    int64_t nwork = nouter_items * ntiles_q;
+    int64_t nparts = nthreads < nwork ? nthreads : nwork;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nparts) if (nparts > 1)
+#endif
+    for (int64_t part = 0; part < nparts; ++part) {
+        transpose_tiles(nouter, outer_shape, outer_src_strides, outer_dest_strides, itemsize,
+                        shape_[q], shape_[r], src_strides_[r], dest_strides_[q], src, dest,
+                        nwork * part / nparts, nwork * (part + 1) / nparts);
+    }
+}
+
+// Read the source region that maps to a destination region and permute it into dest
+static int transpose_region(caterva_context_t *ctx, caterva_array_t *src, int8_t *perm,
+                            int64_t *start, int64_t *shape, uint8_t *buffer, uint8_t *dest,
+                            int64_t *dest_strides) {
+    int8_t ndim = src->ndim;
+    int64_t src_start[CATERVA_MAX_DIM];
+    int64_t src_stop[CATERVA_MAX_DIM];
+    int64_t src_shape[CATERVA_MAX_DIM];
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        src_start[perm[i]] = start[i];
+        src_stop[perm[i]] = start[i] + shape[i];
+        src_shape[perm[i]] = shape[i];
+        nitems *= shape[i];
+    }
+    CATERVA_ERROR(caterva_array_get_slice_buffer(ctx, src, src_start, src_stop, src_shape,
+                                                 buffer, nitems * src->itemsize));
+
+    int64_t strides[CATERVA_MAX_DIM];
+    int64_t stride = src->itemsize;
+    for (int i = ndim - 1; i >= 0; --i) {
+        strides[i] = stride;
+        stride *= src_shape[i];
+    }
+    int64_t src_strides[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        src_strides[i] = strides[perm[i]];
+    }
+
+    permute_region(ctx, ndim, src->itemsize, shape, buffer, src_strides, dest, dest_strides);
+    return CATERVA_SUCCEED;
+}
+
+static int transpose_blosc(caterva_context_t *ctx, caterva_array_t *src, int8_t *perm,
+                           caterva_array_t *array) {
+    int8_t ndim = array->ndim;
+    size_t chunksize = (size_t) array->chunknitems * array->itemsize;
+    uint8_t *buffer = caterva_malloc(ctx, chunksize, CATERVA_ALLOC_CHUNK);
+    uint8_t *chunk = caterva_malloc(ctx, chunksize, CATERVA_ALLOC_CHUNK);
+    CATERVA_ERROR_NULL(buffer);
+    CATERVA_ERROR_NULL(chunk);
+
+    int64_t nchunks_dim[CATERVA_MAX_DIM];
+    int64_t nchunks = 1;
+    for (int i = 0; i < ndim; ++i) {
+        nchunks_dim[i] = (array->shape[i] + array->chunkshape[i] - 1) / array->chunkshape[i];
+        nchunks *= nchunks_dim[i];
+    }
+
+    // The chunks are appended in C order, which is the order expected by append
+    int rc = CATERVA_SUCCEED;
+    for (int64_t nchunk = 0; nchunk < nchunks && rc == CATERVA_SUCCEED; ++nchunk) {
+        int64_t start[CATERVA_MAX_DIM];
+        int64_t shape[CATERVA_MAX_DIM];
+        int64_t strides[CATERVA_MAX_DIM];
+        int64_t rem = nchunk;
+        for (int i = ndim - 1; i >= 0; --i) {
+            start[i] = (rem % nchunks_dim[i]) * array->chunkshape[i];
+            rem /= nchunks_dim[i];
+        }
+        int64_t stride = array->itemsize;
+        for (int i = ndim - 1; i >= 0; --i) {
+            shape[i] = array->next_chunkshape[i];
+            strides[i] = stride;
+            stride *= shape[i];
+        }
+        rc = transpose_region(ctx, src, perm, start, shape, buffer, chunk, strides);
+        if (rc == CATERVA_SUCCEED) {
+            rc = caterva_array_append(ctx, array, chunk, stride);
+        }
+    }
+
+    caterva_free(ctx, buffer, chunksize, CATERVA_ALLOC_CHUNK);
+    caterva_free(ctx, chunk, chunksize, CATERVA_ALLOC_CHUNK);
+    return rc;
+}
+
+static int transpose_plainbuffer(caterva_context_t *ctx, caterva_array_t *src, int8_t *perm,
+                                 caterva_array_t *array) {
+    int8_t ndim = array->ndim;
+    if (array->nitems == 0) {
+        return CATERVA_SUCCEED;
+    }
+
+    // The data is permuted in place into slabs along the first axis
+    int64_t strides[CATERVA_MAX_DIM];
+    int64_t stride = array->itemsize;
+    for (int i = ndim - 1; i >= 0; --i) {
+        strides[i] = stride;
+        stride *= array->shape[i];
+    }
+    int64_t slablen = CATERVA_TRANSPOSE_SLAB_SIZE / strides[0];
+    if (slablen < 1) {
+        slablen = 1;
+    }
+    if (slablen > array->shape[0]) {
+        slablen = array->shape[0];
+    }
+    size_t buffersize = (size_t) (slablen * strides[0]);
+    uint8_t *buffer = caterva_malloc(ctx, buffersize, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(buffer);
+
+    int rc = CATERVA_SUCCEED;
+    for (int64_t i0 = 0; i0 < array->shape[0] && rc == CATERVA_SUCCEED; i0 += slablen) {
+        int64_t start[CATERVA_MAX_DIM] = {0};
+        int64_t shape[CATERVA_MAX_DIM];
+        for (int i = 0; i < ndim; ++i) {
+            shape[i] = array->shape[i];
+        }
+        start[0] = i0;
+        shape[0] = array->shape[0] - i0 < slablen ? array->shape[0] - i0 : slablen;
+        rc = transpose_region(ctx, src, perm, start, shape, buffer, array->buf + i0 * strides[0],
+                              strides);
+    }
+
+    caterva_free(ctx, buffer, buffersize, CATERVA_ALLOC_SCRATCH);
+    return rc;
+}
+
+int caterva_array_transpose(caterva_context_t *ctx, caterva_array_t *src, int8_t *perm,
+                            caterva_storage_t *storage, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(src);
+    CATERVA_ERROR_NULL(perm);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_COMPOUND(src);
+    CATERVA_ERROR(caterva_array_flush(ctx, src));
+
+    bool used[CATERVA_MAX_DIM] = {false};
+    for (int i = 0; i < src->ndim; ++i) {
+        if (perm[i] < 0 || perm[i] >= src->ndim || used[perm[i]]) {
+            DEBUG_PRINT("The axes are not a permutation of the array dimensions");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+        used[perm[i]] = true;
+    }
+
+    caterva_params_t params = {0};
+    params.itemsize = src->itemsize;
+    params.ndim = src->ndim;
+    for (int i = 0; i < src->ndim; ++i) {
+        params.shape[i] = src->shape[perm[i]];
+    }
+
+    CATERVA_ERROR(caterva_array_empty(ctx, &params, storage, array));
+
+    switch ((*array)->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            CATERVA_ERROR(transpose_blosc(ctx, src, perm, *array));
+            break;
+        case CATERVA_STORAGE_PLAINBUFFER:
+            CATERVA_ERROR(transpose_plainbuffer(ctx, src, perm, *array));
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+    (*array)->filled = true;
+    (*array)->empty = false;
+    (*array)->nchunks = (*array)->extnitems / (*array)->chunknitems;
+
+    return CATERVA_SUCCEED;
+}
@@ -0,0 +1,453 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_blosc.h"
+#include "caterva_utils.h"
+
+/* The number of candidates benchmarked by the calibration mode */
+#define CATERVA_TUNE_NCANDIDATES 5
+
+/* The number of reads done on each candidate during the calibration */
+#define CATERVA_TUNE_NREADS 3
+
+/* The number of blocks compressed with each candidate by the automatic compression mode */
+#define CATERVA_TUNE_NSAMPLES 4
+
+/* The codecs tried by the automatic compression mode */
+static const uint8_t tune_codecs[] = {BLOSC_BLOSCLZ, BLOSC_LZ4, BLOSC_LZ4HC, BLOSC_ZLIB,
+                                      BLOSC_ZSTD};
+
+/* The filters (the last two slots of the pipeline) tried by the automatic compression mode */
+static const uint8_t tune_filters[][2] = {
+    {BLOSC_NOFILTER, BLOSC_NOSHUFFLE},
+    {BLOSC_NOFILTER, BLOSC_SHUFFLE},
+    {BLOSC_NOFILTER, BLOSC_BITSHUFFLE},
+    {BLOSC_DELTA, BLOSC_SHUFFLE},
+};
+
+// Grow shape (up to limit) until it holds about target items. The preferred axes are grown first
+// and, inside each group, the smallest axis is doubled (the innermost one on ties) so that the
+// shape is kept as balanced as possible.
+static void grow_shape(int8_t ndim, const int64_t *limit, const bool *preferred, int64_t target,
+                       int32_t *shape) {
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        shape[i] = 1;
+    }
+    for (int phase = 0; phase < 2; ++phase) {
+        while (nitems < target) {
+            int axis = -1;
+            for (int i = ndim - 1; i >= 0; --i) {
+                if ((phase == 0 && !preferred[i]) || shape[i] >= limit[i]) {
+                    continue;
+                }
+                if (axis < 0 || shape[i] < shape[axis]) {
+                    axis = i;
+                }
+            }
+            if (axis < 0) {
+                break;
+            }
+            int64_t rest = nitems / shape[axis];
+            int64_t grown = (int64_t) shape[axis] * 2;
+            if (grown > limit[axis]) {
+                grown = limit[axis];
+            }
+            if (rest * grown > target) {
+                // Take just what is left to reach the target and stop
+                grown = target / rest;
+                if (grown > shape[axis]) {
+                    shape[axis] = (int32_t) grown;
+                }
+                return;
+            }
+            shape[axis] = (int32_t) grown;
+            nitems = rest * grown;
+        }
+    }
+}
+
+static void tune_shapes(int8_t ndim, const int64_t *shape, const bool *access_axes,
+                        int64_t block_nitems, int64_t chunk_nitems, int32_t *chunkshape,
+                        int32_t *blockshape) {
+    int64_t limit[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        limit[i] = shape[i] < 1 ? 1 : shape[i];
+        if (limit[i] > INT32_MAX) {
+            limit[i] = INT32_MAX;
+        }
+    }
+    if (block_nitems > chunk_nitems) {
+        block_nitems = chunk_nitems;
+    }
+
+    grow_shape(ndim, limit, access_axes, chunk_nitems, chunkshape);
+    for (int i = 0; i < ndim; ++i) {
+        limit[i] = chunkshape[i];
+    }
+    grow_shape(ndim, limit, access_axes, block_nitems, blockshape);
+
+    // Avoid padded blocks inside the chunks that do not span the whole dimension
+    for (int i = 0; i < ndim; ++i) {
+        if (chunkshape[i] < shape[i]) {
+            chunkshape[i] -= chunkshape[i] % blockshape[i];
+        }
+    }
+}
+
+static void tune_nitems(caterva_context_t *ctx, caterva_params_t *params,
+                        caterva_tune_params_t *tparams, int64_t *block_nitems,
+                        int64_t *chunk_nitems) {
+    int64_t l1_size, l2_size, l3_size;
+    caterva_get_cache_sizes(&l1_size, &l2_size, &l3_size);
+    if (tparams->l1_size > 0) {
+        l1_size = tparams->l1_size;
+    }
+    if (tparams->l2_size > 0) {
+        l2_size = tparams->l2_size;
+    }
+    if (tparams->l3_size > 0) {
+        l3_size = tparams->l3_size;
+    }
+    int64_t nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+
+    // A block (and its decompressed copy) should stay in L2, but it should not be smaller than L1
+    int64_t blocksize = l2_size / 2;
+    if (blocksize < l1_size) {
+        blocksize = l1_size;
+    }
+    // A chunk should stay in L3 while providing a few blocks to each thread
+    int64_t chunksize = l3_size / 2;
+    if (chunksize < 4 * nthreads * blocksize) {
+        chunksize = 4 * nthreads * blocksize;
+    }
+    if (chunksize > BLOSC_MAX_BUFFERSIZE) {
+        chunksize = BLOSC_MAX_BUFFERSIZE;
+    }
+
+    *block_nitems = blocksize / params->itemsize > 0 ? blocksize / params->itemsize : 1;
+    *chunk_nitems = chunksize / params->itemsize > 0 ? chunksize / params->itemsize : 1;
+}
+
+int caterva_storage_tune(caterva_context_t *ctx, caterva_params_t *params,
+                         caterva_tune_params_t *tparams, caterva_storage_t *storage) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(tparams);
+    CATERVA_ERROR_NULL(storage);
+
+    if (storage->backend != CATERVA_STORAGE_BLOSC) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+    if (params->itemsize == 0 || params->ndim > CATERVA_MAX_DIM) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    int64_t block_nitems, chunk_nitems;
+    tune_nitems(ctx, params, tparams, &block_nitems, &chunk_nitems);
+    tune_shapes(params->ndim, params->shape, tparams->access_axes, block_nitems, chunk_nitems,
+                storage->properties.blosc.chunkshape, storage->properties.blosc.blockshape);
+
+    return CATERVA_SUCCEED;
+}
+
+// Read the array the way it is expected to be read (along the access axes) and return the time
+static int benchmark_reads(caterva_context_t *ctx, caterva_array_t *array,
+                           caterva_tune_params_t *tparams, uint8_t *buffer, int64_t buffersize,
+                           double *elapsed) {
+    bool hinted = false;
+    for (int i = 0; i < array->ndim; ++i) {
+        hinted |= tparams->access_axes[i];
+    }
+
+    blosc_timestamp_t t0, t1;
+    blosc_set_timestamp(&t0);
+    if (!hinted) {
+        CATERVA_ERROR(caterva_array_to_buffer(ctx, array, buffer, buffersize));
+    }
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t shape[CATERVA_MAX_DIM];
+    for (int n = 0; n < CATERVA_TUNE_NREADS; ++n) {
+        for (int i = 0; i < array->ndim; ++i) {
+            if (tparams->access_axes[i]) {
+                // The whole axis is read
+                start[i] = 0;
+                stop[i] = array->shape[i];
+            } else if (hinted) {
+                // Pencils along the access axes
+                start[i] = (n + 1) * array->shape[i] / (CATERVA_TUNE_NREADS + 1);
+                stop[i] = start[i] + 1;
+            } else {
+                // Small boxes spread along the array
+                int64_t len = array->shape[i] / 4 + 1;
+                start[i] = n * (array->shape[i] - len) / CATERVA_TUNE_NREADS;
+                stop[i] = start[i] + len;
+            }
+            if (stop[i] > array->shape[i]) {
+                stop[i] = array->shape[i];
+                start[i] = stop[i] - 1;
+            }
+            shape[i] = stop[i] - start[i];
+        }
+        CATERVA_ERROR(
+            caterva_array_get_slice_buffer(ctx, array, start, stop, shape, buffer, buffersize));
+    }
+    blosc_set_timestamp(&t1);
+    *elapsed = blosc_elapsed_secs(t0, t1);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_storage_calibrate(caterva_context_t *ctx, caterva_params_t *params,
+                              caterva_tune_params_t *tparams, void *sample, int64_t *sampleshape,
+                              int64_t samplesize, caterva_storage_t *storage) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(tparams);
+    CATERVA_ERROR_NULL(sample);
+    CATERVA_ERROR_NULL(sampleshape);
+    CATERVA_ERROR_NULL(storage);
+
+    if (storage->backend != CATERVA_STORAGE_BLOSC) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+    if (params->itemsize == 0 || params->ndim > CATERVA_MAX_DIM) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    caterva_params_t sparams = *params;
+    int64_t snitems = 1;
+    for (int i = 0; i < params->ndim; ++i) {
+        if (sampleshape[i] < 1) {
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        sparams.shape[i] = sampleshape[i];
+        snitems *= sampleshape[i];
+    }
+    if (samplesize < snitems * params->itemsize) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    int64_t block_nitems, chunk_nitems;
+    tune_nitems(ctx, params, tparams, &block_nitems, &chunk_nitems);
+
+    // Scale factors (block, chunk) applied to the proposed sizes
+    const double factors[CATERVA_TUNE_NCANDIDATES][2] = {
+        {1, 1}, {0.5, 1}, {2, 1}, {1, 0.5}, {1, 2}};
+
+    uint8_t *buffer = caterva_malloc(ctx, (size_t) samplesize, CATERVA_ALLOC_SCRATCH);
+    CATERVA_ERROR_NULL(buffer);
+
+    int32_t chunkshapes[CATERVA_TUNE_NCANDIDATES][CATERVA_MAX_DIM];
+    int32_t blockshapes[CATERVA_TUNE_NCANDIDATES][CATERVA_MAX_DIM];
+    int best = -1;
+    double best_time = 0;
+    for (int n = 0; n < CATERVA_TUNE_NCANDIDATES; ++n) {
+        int64_t bnitems = (int64_t)(block_nitems * factors[n][0]);
+        int64_t cnitems = (int64_t)(chunk_nitems * factors[n][1]);
+        tune_shapes(params->ndim, params->shape, tparams->access_axes, bnitems > 0 ? bnitems : 1,
+                    cnitems > 0 ? cnitems : 1, chunkshapes[n], blockshapes[n]);
+
+        // Skip the candidates that have already been benchmarked
+        bool repeated = false;
+        for (int m = 0; m < n && !repeated; ++m) {
+            repeated = true;
+            for (int i = 0; i < params->ndim; ++i) {
+                if (chunkshapes[m][i] != chunkshapes[n][i] ||
+                    blockshapes[m][i] != blockshapes[n][i]) {
+                    repeated = false;
+                    break;
+                }
+            }
+        }
+        if (repeated) {
+            continue;
+        }
+
+        // The candidate is evaluated in memory and clipped to the sample shape
+        caterva_storage_t cstorage = {0};
+        cstorage.backend = CATERVA_STORAGE_BLOSC;
+        for (int i = 0; i < params->ndim; ++i) {
+            int32_t chunklen = chunkshapes[n][i];
+            if (chunklen > sampleshape[i]) {
+                chunklen = (int32_t) sampleshape[i];
+            }
+            int32_t blocklen = blockshapes[n][i];
+            if (blocklen > chunklen) {
+                blocklen = chunklen;
+            }
+            cstorage.properties.blosc.chunkshape[i] = chunklen;
+            cstorage.properties.blosc.blockshape[i] = blocklen;
+        }
+
+        blosc_timestamp_t t0, t1;
+        caterva_array_t *array;
+        blosc_set_timestamp(&t0);
+        int rc = caterva_array_from_buffer(ctx, sample, snitems * params->itemsize, &sparams,
+                                           &cstorage, &array);
+        blosc_set_timestamp(&t1);
+        double elapsed = 0;
+        if (rc == CATERVA_SUCCEED) {
+            rc = benchmark_reads(ctx, array, tparams, buffer, samplesize, &elapsed);
+            elapsed += blosc_elapsed_secs(t0, t1);
+            int frc = caterva_array_free(ctx, &array);
+            rc = rc == CATERVA_SUCCEED ? frc : rc;
+        }
+        if (rc != CATERVA_SUCCEED) {
+            caterva_free(ctx, buffer, (size_t) samplesize, CATERVA_ALLOC_SCRATCH);
+            CATERVA_ERROR(rc);
+        }
+
+        if (best < 0 || elapsed < best_time) {
+            best = n;
+            best_time = elapsed;
+        }
+    }
+    caterva_free(ctx, buffer, (size_t) samplesize, CATERVA_ALLOC_SCRATCH);
+
+    for (int i = 0; i < params->ndim; ++i) {
+        storage->properties.blosc.chunkshape[i] = chunkshapes[best][i];
+        storage->properties.blosc.blockshape[i] = blockshapes[best][i];
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Choose the codec and filters of an array out of some blocks of rchunk (a chunk in block layout)
+// and set them in its superchunk
+int caterva_blosc_select_cparams(caterva_context_t *ctx, caterva_array_t *array,
+                                 const uint8_t *rchunk) {
+    caterva_stats_t stats = {0};
+    blosc_timestamp_t t0;
+    caterva_stage_begin(ctx, CATERVA_STAGE_SETUP, array, -1, &t0);
+
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(array->sc, &cparams) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    // A truncation is lossy, so it is never added by the selection but it is kept if present
+    int trunc = -1;
+    for (int i = 0; i < BLOSC2_MAX_FILTERS; ++i) {
+        if (cparams->filters[i] == BLOSC_TRUNC_PREC) {
+            trunc = i;
+        }
+    }
+
+    int32_t blocksize = array->blocknitems * array->itemsize;
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    int64_t nsamples = nblocks < CATERVA_TUNE_NSAMPLES ? nblocks : CATERVA_TUNE_NSAMPLES;
+    size_t cblocksize = (size_t) blocksize + BLOSC_MAX_OVERHEAD;
+    uint8_t *cblock = caterva_malloc(ctx, cblocksize, CATERVA_ALLOC_SCRATCH);
+    uint8_t *dblock = caterva_malloc(ctx, (size_t) blocksize, CATERVA_ALLOC_SCRATCH);
+    blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+    blosc2_context *dctx = blosc2_create_dctx(dparams);
+    if (cblock == NULL || dblock == NULL || dctx == NULL) {
+        if (dctx != NULL) {
+            blosc2_free_ctx(dctx);
+        }
+        caterva_free(ctx, cblock, cblocksize, CATERVA_ALLOC_SCRATCH);
+        caterva_free(ctx, dblock, (size_t) blocksize, CATERVA_ALLOC_SCRATCH);
+        free(cparams);
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+
+    blosc2_cparams best = *cparams;
+    double best_score = -1;
+    int ncodecs = (int) (sizeof(tune_codecs) / sizeof(tune_codecs[0]));
+    int nfilters = (int) (sizeof(tune_filters) / sizeof(tune_filters[0]));
+    for (int c = 0; c < ncodecs; ++c) {
+        for (int f = 0; f < nfilters; ++f) {
+            blosc2_cparams candidate = *cparams;
+            candidate.compcode = tune_codecs[c];
+            candidate.nthreads = 1;
+            for (int i = 0; i < BLOSC2_MAX_FILTERS; ++i) {
+                candidate.filters[i] = BLOSC_NOFILTER;
+                candidate.filters_meta[i] = 0;
+            }
+            if (trunc >= 0) {
+                candidate.filters[0] = BLOSC_TRUNC_PREC;
+                candidate.filters_meta[0] = cparams->filters_meta[trunc];
+            }
+            candidate.filters[BLOSC2_MAX_FILTERS - 2] = tune_filters[f][0];
+            candidate.filters[BLOSC2_MAX_FILTERS - 1] = tune_filters[f][1];
+
+            // The codecs that are not available fail and are skipped
+            blosc2_context *cctx = blosc2_create_cctx(candidate);
+            if (cctx == NULL) {
+                continue;
+            }
+            int64_t csize = 0;
+            double ctime = 0;
+            double dtime = 0;
+            bool failed = false;
+            for (int64_t n = 0; n < nsamples && !failed; ++n) {
+                const uint8_t *block = rchunk + n * nblocks / nsamples * blocksize;
+                blosc_timestamp_t t1, t2, t3;
+                blosc_set_timestamp(&t1);
+                int cbytes = blosc2_compress_ctx(cctx, (size_t) blocksize, block, cblock,
+                                                 cblocksize);
+                blosc_set_timestamp(&t2);
+                int dbytes = cbytes > 0 ? blosc2_decompress_ctx(dctx, cblock, dblock,
+                                                                (size_t) blocksize) : -1;
+                blosc_set_timestamp(&t3);
+                failed = cbytes <= 0 || dbytes < 0;
+                csize += cbytes;
+                ctime += blosc_elapsed_secs(t1, t2);
+                dtime += blosc_elapsed_secs(t2, t3);
+            }
+            blosc2_free_ctx(cctx);
+            if (failed) {
+                continue;
+            }
+
+            double score;
+            switch (array->objective) {
+                case CATERVA_COMPRESSION_CSPEED:
+                    score = ctime;
+                    break;
+                case CATERVA_COMPRESSION_DSPEED:
+                    score = dtime;
+                    break;
+                default:
+                    score = (double) csize;
+                    break;
+            }
+            if (best_score < 0 || score < best_score) {
+                best = candidate;
+                best_score = score;
+            }
+        }
+    }
+    blosc2_free_ctx(dctx);
+    caterva_free(ctx, cblock, cblocksize, CATERVA_ALLOC_SCRATCH);
+    caterva_free(ctx, dblock, (size_t) blocksize, CATERVA_ALLOC_SCRATCH);
+
+    // The chosen codec and filters replace the ones of the superchunk
+    best.nthreads = cparams->nthreads;
+    free(cparams);
+    blosc2_schunk *sc = array->sc;
+    sc->compcode = best.compcode;
+    for (int i = 0; i < BLOSC2_MAX_FILTERS; ++i) {
+        sc->filters[i] = best.filters[i];
+        sc->filters_meta[i] = best.filters_meta[i];
+    }
+    blosc2_free_ctx(sc->cctx);
+    sc->cctx = blosc2_create_cctx(best);
+    CATERVA_ERROR_NULL(sc->cctx);
+    array->objective = CATERVA_COMPRESSION_FIXED;
+
+    caterva_stage_end(ctx, CATERVA_STAGE_SETUP, array, -1, nsamples * blocksize, &t0, &stats);
+    caterva_stats_merge(ctx, array, &stats);
+    return CATERVA_SUCCEED;
+}
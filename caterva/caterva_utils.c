@@ -0,0 +1,392 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+#include <inttypes.h>
+
+#include "caterva_utils.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#include <sys/types.h>
+#else
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+// Read the size of a data/unified cache of a given level from sysfs (Linux)
+static int64_t sysfs_cache_size(int level) {
+    for (int index = 0; index < 8; ++index) {
+        char path[128];
+        char value[64];
+        FILE *fp;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        fp = fopen(path, "r");
+        if (fp == NULL) {
+            break;
+        }
+        int clevel = 0;
+        if (fscanf(fp, "%d", &clevel) != 1) {
+            clevel = 0;
+        }
+        fclose(fp);
+        if (clevel != level) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        fp = fopen(path, "r");
+        if (fp == NULL) {
+            continue;
+        }
+        if (fscanf(fp, "%63s", value) != 1) {
+            value[0] = '\0';
+        }
+        fclose(fp);
+        if (strcmp(value, "Instruction") == 0) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        fp = fopen(path, "r");
+        if (fp == NULL) {
+            continue;
+        }
+        int64_t size = 0;
+        char unit = '\0';
+        int nread = fscanf(fp, "%" SCNd64 "%c", &size, &unit);
+        fclose(fp);
+        if (nread < 1) {
+            continue;
+        }
+        if (unit == 'K') {
+            size *= 1024;
+        } else if (unit == 'M') {
+            size *= 1024 * 1024;
+        }
+        return size;
+    }
+    return 0;
+}
+#endif
+
+int caterva_get_cache_sizes(int64_t *l1_size, int64_t *l2_size, int64_t *l3_size) {
+    int64_t sizes[3] = {0, 0, 0};
+
+#if defined(_WIN32)
+    DWORD len = 0;
+    GetLogicalProcessorInformation(NULL, &len);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info = malloc(len);
+    if (info != NULL && GetLogicalProcessorInformation(info, &len)) {
+        DWORD ninfo = len / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+        for (DWORD i = 0; i < ninfo; ++i) {
+            if (info[i].Relationship != RelationCache) {
+                continue;
+            }
+            CACHE_DESCRIPTOR *cache = &info[i].Cache;
+            if (cache->Level < 1 || cache->Level > 3 || cache->Type == CacheInstruction) {
+                continue;
+            }
+            if (sizes[cache->Level - 1] == 0) {
+                sizes[cache->Level - 1] = cache->Size;
+            }
+        }
+    }
+    free(info);
+#elif defined(__APPLE__)
+    const char *names[3] = {"hw.l1dcachesize", "hw.l2cachesize", "hw.l3cachesize"};
+    for (int i = 0; i < 3; ++i) {
+        int64_t value = 0;
+        size_t len = sizeof(value);
+        if (sysctlbyname(names[i], &value, &len, NULL, 0) == 0) {
+            sizes[i] = value;
+        }
+    }
+#else
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    sizes[0] = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    sizes[1] = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    sizes[2] = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    for (int i = 0; i < 3; ++i) {
+        if (sizes[i] <= 0) {
+            sizes[i] = sysfs_cache_size(i + 1);
+        }
+    }
+#endif
+
+    // Fall back to conservative values for the levels that can not be detected
+    *l1_size = sizes[0] > 0 ? sizes[0] : CATERVA_L1_SIZE_DEFAULT;
+    *l2_size = sizes[1] > 0 ? sizes[1] : CATERVA_L2_SIZE_DEFAULT;
+    *l3_size = sizes[2] > 0 ? sizes[2] : CATERVA_L3_SIZE_DEFAULT;
+
+    return CATERVA_SUCCEED;
+}
+
+void caterva_copy_rows(int ndim, const int64_t *shape, const int64_t *src_strides,
+                       const int64_t *dest_strides, int64_t copylen, const uint8_t *src,
+                       uint8_t *dest, int64_t row_start, int64_t row_stop) {
+    int64_t index[CATERVA_MAX_DIM];
+    int64_t rem = row_start;
+    for (int i = ndim - 1; i >= 0; --i) {
+        index[i] = rem % shape[i];
+        rem /= shape[i];
+        src += index[i] * src_strides[i];
+        dest += index[i] * dest_strides[i];
+    }
+
+    for (int64_t row = row_start; row < row_stop; ++row) {
+        memcpy(dest, src, (size_t) copylen);
+        // Move to the next row updating the offsets incrementally
+        for (int i = ndim - 1; i >= 0; --i) {
+            index[i]++;
+            src += src_strides[i];
+            dest += dest_strides[i];
+            if (index[i] < shape[i]) {
+                break;
+            }
+            index[i] = 0;
+            src -= shape[i] * src_strides[i];
+            dest -= shape[i] * dest_strides[i];
+        }
+    }
+}
+
+int caterva_copy_region(caterva_context_t *ctx, int8_t ndim, int32_t itemsize,
+                        const int64_t *copy_shape, const uint8_t *src, const int64_t *src_shape,
+                        const int64_t *src_start, uint8_t *dest, const int64_t *dest_shape,
+                        const int64_t *dest_start) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(src);
+    CATERVA_ERROR_NULL(dest);
+
+    if (ndim == 0) {
+        memcpy(dest, src, (size_t) itemsize);
+        return CATERVA_SUCCEED;
+    }
+
+    int64_t src_strides[CATERVA_MAX_DIM];
+    int64_t dest_strides[CATERVA_MAX_DIM];
+    int64_t src_stride = itemsize;
+    int64_t dest_stride = itemsize;
+    for (int i = ndim - 1; i >= 0; --i) {
+        if (copy_shape[i] == 0) {
+            return CATERVA_SUCCEED;
+        }
+        src_strides[i] = src_stride;
+        dest_strides[i] = dest_stride;
+        src += src_start[i] * src_stride;
+        dest += dest_start[i] * dest_stride;
+        src_stride *= src_shape[i];
+        dest_stride *= dest_shape[i];
+    }
+
+    // Merge the trailing dimensions fully selected in both buffers into a single run
+    int inner = ndim - 1;
+    int64_t copylen = copy_shape[inner] * itemsize;
+    while (inner > 0 && copy_shape[inner] == src_shape[inner] &&
+           copy_shape[inner] == dest_shape[inner]) {
+        inner--;
+        copylen *= copy_shape[inner];
+    }
+
+    // The remaining dimensions (skipping the unit ones) are iterated row by row
+    int nouter = 0;
+    int64_t outer_shape[CATERVA_MAX_DIM];
+    int64_t outer_src_strides[CATERVA_MAX_DIM];
+    int64_t outer_dest_strides[CATERVA_MAX_DIM];
+    int64_t nrows = 1;
+    for (int i = 0; i < inner; ++i) {
+        if (copy_shape[i] == 1) {
+            continue;
+        }
+        outer_shape[nouter] = copy_shape[i];
+        outer_src_strides[nouter] = src_strides[i];
+        outer_dest_strides[nouter] = dest_strides[i];
+        nouter++;
+        nrows *= copy_shape[i];
+    }
+
+    // The configured threads may be 0 (or negative); the copy is done by a thread at least
+    int64_t nthreads = ctx->cfg->nthreads > 1 ? ctx->cfg->nthreads : 1;
+    int64_t maxthreads = nrows * copylen / CATERVA_COPY_MIN_THREAD_SIZE;
+    if (nthreads > maxthreads) {
+        nthreads = maxthreads > 0 ? maxthreads : 1;
+    }
+
+    if (nrows == 1) {
+        // A single contiguous run; split it between the threads
+        int64_t partlen = (copylen + nthreads - 1) / nthreads;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1)
+#endif
+        for (int64_t part = 0; part < nthreads; ++part) {
+            int64_t offset = part * partlen;
+            int64_t len = copylen - offset < partlen ? copylen - offset : partlen;
+            if (len > 0) {
+                memcpy(dest + offset, src + offset, (size_t) len);
+            }
+        }
+        return CATERVA_SUCCEED;
+    }
+
+    if (nthreads > nrows) {
+        nthreads = nrows;
+    }
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1)
+#endif
+    for (int64_t part = 0; part < nthreads; ++part) {
+        caterva_copy_rows(nouter, outer_shape, outer_src_strides, outer_dest_strides, copylen,
+                          src, dest, nrows * part / nthreads, nrows * (part + 1) / nthreads);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+bool caterva_is_uniform(const uint8_t *buffer, int64_t nitems, int32_t itemsize) {
+    if (nitems <= 1) {
+        return true;
+    }
+    // Every item equals the next one iff the buffer equals itself shifted by one item
+    return memcmp(buffer, buffer + itemsize, (size_t) ((nitems - 1) * itemsize)) == 0;
+}
+
+void caterva_fill_buffer(uint8_t *dest, int64_t nitems, int32_t itemsize, const uint8_t *value) {
+    int64_t nbytes = nitems * itemsize;
+    if (nbytes <= 0) {
+        return;
+    }
+    bool bytes_equal = true;
+    for (int32_t i = 1; i < itemsize; ++i) {
+        if (value[i] != value[0]) {
+            bytes_equal = false;
+            break;
+        }
+    }
+    if (bytes_equal) {
+        memset(dest, value[0], (size_t) nbytes);
+        return;
+    }
+    // Double the filled part on each copy
+    memcpy(dest, value, (size_t) itemsize);
+    int64_t filled = itemsize;
+    while (filled < nbytes) {
+        int64_t len = nbytes - filled < filled ? nbytes - filled : filled;
+        memcpy(dest + filled, dest, (size_t) len);
+        filled += len;
+    }
+}
+
+void caterva_fill_region(int8_t ndim, int32_t itemsize, const uint8_t *value,
+                         const int64_t *fill_shape, uint8_t *dest, const int64_t *dest_shape,
+                         const int64_t *dest_start) {
+    if (ndim == 0) {
+        memcpy(dest, value, (size_t) itemsize);
+        return;
+    }
+
+    int64_t dest_strides[CATERVA_MAX_DIM];
+    int64_t src_strides[CATERVA_MAX_DIM];
+    int64_t dest_stride = itemsize;
+    int64_t nrows = 1;
+    for (int i = ndim - 1; i >= 0; --i) {
+        if (fill_shape[i] == 0) {
+            return;
+        }
+        dest_strides[i] = dest_stride;
+        src_strides[i] = 0;
+        dest += dest_start[i] * dest_stride;
+        dest_stride *= dest_shape[i];
+        if (i < ndim - 1) {
+            nrows *= fill_shape[i];
+        }
+    }
+
+    // Fill the first row and replicate it into the rest
+    int64_t rowlen = fill_shape[ndim - 1] * itemsize;
+    caterva_fill_buffer(dest, fill_shape[ndim - 1], itemsize, value);
+    if (nrows > 1) {
+        caterva_copy_rows(ndim - 1, fill_shape, src_strides, dest_strides, rowlen, dest, dest, 1,
+                          nrows);
+    }
+}
+
+bool caterva_item_supported(caterva_item_kind_t kind, int32_t itemsize) {
+    switch (kind) {
+        case CATERVA_ITEM_UINT:
+        case CATERVA_ITEM_INT:
+            return itemsize == 1 || itemsize == 2 || itemsize == 4 || itemsize == 8;
+        case CATERVA_ITEM_FLOAT:
+            return itemsize == 4 || itemsize == 8;
+        default:
+            return false;
+    }
+}
+
+double caterva_item_to_double(caterva_item_kind_t kind, int32_t itemsize, const uint8_t *item) {
+    switch (kind * 16 + itemsize) {
+        case CATERVA_ITEM_UINT * 16 + 1:
+            return *item;
+        case CATERVA_ITEM_UINT * 16 + 2:
+            return (double) *(const uint16_t *) item;
+        case CATERVA_ITEM_UINT * 16 + 4:
+            return (double) *(const uint32_t *) item;
+        case CATERVA_ITEM_UINT * 16 + 8:
+            return (double) *(const uint64_t *) item;
+        case CATERVA_ITEM_INT * 16 + 1:
+            return *(const int8_t *) item;
+        case CATERVA_ITEM_INT * 16 + 2:
+            return (double) *(const int16_t *) item;
+        case CATERVA_ITEM_INT * 16 + 4:
+            return (double) *(const int32_t *) item;
+        case CATERVA_ITEM_INT * 16 + 8:
+            return (double) *(const int64_t *) item;
+        case CATERVA_ITEM_FLOAT * 16 + 4:
+            return *(const float *) item;
+        default:
+            return *(const double *) item;
+    }
+}
+
+// The shape of the items of the block nblock of a chunk of shape cshape that are inside the array.
+// Returns their number.
+int64_t caterva_block_extent(caterva_array_t *array, const int64_t *cshape, int64_t nblock,
+                             int64_t *bshape) {
+    int64_t nitems = 1;
+    int64_t rem = nblock;
+    for (int i = array->ndim - 1; i >= 0; --i) {
+        int64_t grid = array->extchunkshape[i] / array->blockshape[i];
+        int64_t origin = rem % grid * array->blockshape[i];
+        rem /= grid;
+        int64_t extent = cshape[i] - origin;
+        bshape[i] = extent < 0 ? 0 : (extent < array->blockshape[i] ? extent
+                                                                    : array->blockshape[i]);
+        nitems *= bshape[i];
+    }
+    return nitems;
+}
+
+// The offset (in items) within a block of the row number row of the region of shape bshape at the
+// origin of the block
+int64_t caterva_block_row_offset(caterva_array_t *array, const int64_t *bshape, int64_t row) {
+    int64_t offset = 0;
+    int64_t stride = array->blockshape[array->ndim - 1];
+    for (int i = array->ndim - 2; i >= 0; --i) {
+        offset += row % bshape[i] * stride;
+        row /= bshape[i];
+        stride *= array->blockshape[i];
+    }
+    return offset;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#ifndef CATERVA_CATERVA_UTILS_H_
+#define CATERVA_CATERVA_UTILS_H_
+
+/* Fallback cache sizes used when they can not be detected */
+#define CATERVA_L1_SIZE_DEFAULT (32 * 1024)
+#define CATERVA_L2_SIZE_DEFAULT (256 * 1024)
+#define CATERVA_L3_SIZE_DEFAULT (8 * 1024 * 1024)
+
+/* The largest item size (it is stored in a byte) */
+#define CATERVA_MAX_ITEMSIZE 255
+
+/* The largest compressed size of a uniform chunk (a special chunk that only holds its value) */
+#define CATERVA_UNIFORM_CCHUNK_SIZE (BLOSC_EXTENDED_HEADER_LENGTH + CATERVA_MAX_ITEMSIZE)
+
+/* The minimum number of bytes handed to each thread by caterva_copy_region() */
+#define CATERVA_COPY_MIN_THREAD_SIZE (1024 * 1024)
+
+/* Fail for the operations that are not supported by the compound arrays (their fields are) */
+#define CATERVA_ERROR_COMPOUND(array)                                               \
+    do {                                                                            \
+        if ((array)->nfields > 0) {                                                 \
+            DEBUG_PRINT("Not supported by compound arrays (use their fields instead)"); \
+            return CATERVA_ERR_INVALID_ARGUMENT;                                    \
+        }                                                                           \
+    } while (0)
+
+int caterva_get_cache_sizes(int64_t *l1_size, int64_t *l2_size, int64_t *l3_size);
+
+/* Allocate and release memory with the hooks of the context */
+void *caterva_malloc(caterva_context_t *ctx, size_t size, caterva_alloc_purpose_t purpose);
+
+void caterva_free(caterva_context_t *ctx, void *ptr, size_t size,
+                  caterva_alloc_purpose_t purpose);
+
+/* Copy the rows [row_start, row_stop) of copylen bytes of a region with the given outer shape */
+void caterva_copy_rows(int ndim, const int64_t *shape, const int64_t *src_strides,
+                       const int64_t *dest_strides, int64_t copylen, const uint8_t *src,
+                       uint8_t *dest, int64_t row_start, int64_t row_stop);
+
+/* Copy a region of copy_shape items between two C-ordered buffers */
+int caterva_copy_region(caterva_context_t *ctx, int8_t ndim, int32_t itemsize,
+                        const int64_t *copy_shape, const uint8_t *src, const int64_t *src_shape,
+                        const int64_t *src_start, uint8_t *dest, const int64_t *dest_shape,
+                        const int64_t *dest_start);
+
+/* Check whether all the nitems items of a buffer are equal */
+bool caterva_is_uniform(const uint8_t *buffer, int64_t nitems, int32_t itemsize);
+
+/* Check whether a predictor can be applied to items of itemsize bytes */
+bool caterva_predictor_supported(caterva_predictor_t predictor, int32_t itemsize);
+
+/* Apply the predictor of an array to all the blocks of a chunk (in block layout) */
+void caterva_predictor_encode(caterva_array_t *array, uint8_t *rchunk);
+
+/* Undo the predictor of an array in the blocks of a chunk that are not masked out (all if maskout
+ * is NULL) */
+void caterva_predictor_decode(caterva_array_t *array, uint8_t *rchunk, const bool *maskout);
+
+/* Check whether a lossy mode can be applied to items of itemsize bytes */
+bool caterva_lossy_supported(caterva_lossy_mode_t mode, double tolerance, int8_t bits,
+                             int32_t itemsize);
+
+/* Round the items of a chunk (in block layout) within the error bound of an array */
+void caterva_lossy_round(caterva_array_t *array, uint8_t *rchunk);
+
+/* The chunk that a chunk is a delta of (or -1 if it is a keyframe or there are no deltas) */
+int64_t caterva_delta_reference(caterva_array_t *array, int64_t nchunk);
+
+/* XOR the blocks of a chunk (in block layout) that are not masked out with the reference ones */
+void caterva_delta_xor(caterva_array_t *array, uint8_t *rchunk, const uint8_t *reference,
+                       const bool *maskout);
+
+/* Copy a chunk out of the delta cache of an array. Returns whether it was found. */
+bool caterva_delta_cache_get(caterva_array_t *array, int64_t nchunk, uint8_t *dest);
+
+/* Keep a copy of a chunk in the delta cache of an array (replacing the oldest one if full) */
+int caterva_delta_cache_put(caterva_context_t *ctx, caterva_array_t *array, int64_t nchunk,
+                            const uint8_t *src);
+
+/* Release the delta cache of an array */
+void caterva_delta_cache_free(caterva_context_t *ctx, caterva_array_t *array);
+
+/* Broadcast a value of itemsize bytes into the nitems items of a buffer */
+void caterva_fill_buffer(uint8_t *dest, int64_t nitems, int32_t itemsize, const uint8_t *value);
+
+/* Broadcast a value into a region of fill_shape items of a C-ordered buffer */
+void caterva_fill_region(int8_t ndim, int32_t itemsize, const uint8_t *value,
+                         const int64_t *fill_shape, uint8_t *dest, const int64_t *dest_shape,
+                         const int64_t *dest_start);
+
+/* Check whether the items of a kind can be read as numbers (integers of 1, 2, 4 or 8 bytes or
+ * floats of 4 or 8 bytes) */
+bool caterva_item_supported(caterva_item_kind_t kind, int32_t itemsize);
+
+/* Read an item of a kind as a double */
+double caterva_item_to_double(caterva_item_kind_t kind, int32_t itemsize, const uint8_t *item);
+
+/* Get the shape of the items of the block nblock of a chunk of shape cshape that are inside the
+ * array. Returns their number. */
+int64_t caterva_block_extent(caterva_array_t *array, const int64_t *cshape, int64_t nblock,
+                             int64_t *bshape);
+
+/* Get the offset (in items) within a block of a row of the region of shape bshape at its origin */
+int64_t caterva_block_row_offset(caterva_array_t *array, const int64_t *bshape, int64_t row);
+
+/* Allocate the sum index of an array (with no chunk recorded yet) */
+int caterva_sums_new(caterva_context_t *ctx, caterva_array_t *array, caterva_item_kind_t kind);
+
+/* Release the sum index of an array */
+void caterva_sums_free(caterva_context_t *ctx, caterva_array_t *array);
+
+/* Record the sums of the blocks of the chunk nchunk (in block layout, before it is predicted) */
+void caterva_sums_rchunk(caterva_array_t *array, int64_t nchunk, const uint8_t *rchunk);
+
+/* Record the sums of the blocks of the chunk nchunk, whose items are all equal to value */
+void caterva_sums_uniform(caterva_array_t *array, int64_t nchunk, const uint8_t *value);
+
+/* Serialize the sum index of an array for its metalayer (smeta is scratch memory of the context) */
+int caterva_sums_serialize(caterva_context_t *ctx, caterva_array_t *array, uint8_t **smeta,
+                           int32_t *smeta_len);
+
+/* Load the sum index of an array out of its metalayer */
+int caterva_sums_deserialize(caterva_context_t *ctx, caterva_array_t *array,
+                             const uint8_t *smeta, uint32_t smeta_len);
+
+/* Write the sum index of an array to its metalayer */
+int caterva_sums_store(caterva_context_t *ctx, caterva_array_t *array);
+
+/* Allocate the Bloom index of an array (with no chunk recorded yet) */
+int caterva_bloom_new(caterva_context_t *ctx, caterva_array_t *array, uint8_t bits);
+
+/* Release the Bloom index of an array */
+void caterva_bloom_free(caterva_context_t *ctx, caterva_array_t *array);
+
+/* Build the filters of the blocks of the chunk nchunk (in block layout, before it is predicted) */
+void caterva_bloom_rchunk(caterva_array_t *array, int64_t nchunk, const uint8_t *rchunk);
+
+/* Build the filters of the blocks of the chunk nchunk, whose items are all equal to value */
+void caterva_bloom_uniform(caterva_array_t *array, int64_t nchunk, const uint8_t *value);
+
+/* Serialize the Bloom index of an array for its metalayer (smeta is scratch memory of the
+ * context) */
+int caterva_bloom_serialize(caterva_context_t *ctx, caterva_array_t *array, uint8_t **smeta,
+                            int32_t *smeta_len);
+
+/* Load the Bloom index of an array out of its metalayer */
+int caterva_bloom_deserialize(caterva_context_t *ctx, caterva_array_t *array,
+                              const uint8_t *smeta, uint32_t smeta_len);
+
+/* Write the Bloom index of an array to its metalayer */
+int caterva_bloom_store(caterva_context_t *ctx, caterva_array_t *array);
+
+/* Set the chunk order of an array and compute the positions of its chunks in the superchunk */
+int caterva_order_new(caterva_context_t *ctx, caterva_array_t *array,
+                      caterva_chunk_order_t order);
+
+/* Release the chunk positions of an array */
+void caterva_order_free(caterva_context_t *ctx, caterva_array_t *array);
+
+/* Get the position in the superchunk of the chunk nchunk (in C order) of an array */
+int64_t caterva_chunk_position(const caterva_array_t *array, int64_t nchunk);
+
+/* Report a stage boundary to the tracing function of the context (if any) */
+#if defined(CATERVA_TRACING)
+void caterva_trace(caterva_context_t *ctx, caterva_stage_t stage, caterva_trace_phase_t phase,
+                   caterva_array_t *array, int64_t nchunk, int64_t nbytes);
+
+#define CATERVA_TRACE(ctx, stage, phase, array, nchunk, nbytes)         \
+    do {                                                                \
+        if ((ctx)->cfg->trace != NULL) {                                \
+            caterva_trace(ctx, stage, phase, array, nchunk, nbytes);    \
+        }                                                               \
+    } while (0)
+#else
+#define CATERVA_TRACE(ctx, stage, phase, array, nchunk, nbytes) \
+    do {                                                        \
+        CATERVA_UNUSED_PARAM(stage);                            \
+        CATERVA_UNUSED_PARAM(array);                            \
+        CATERVA_UNUSED_PARAM(nchunk);                           \
+        CATERVA_UNUSED_PARAM(nbytes);                           \
+    } while (0)
+#endif
+
+/* Time a stage; the elapsed time is added to stats when the context collects statistics */
+static inline void caterva_stage_begin(caterva_context_t *ctx, caterva_stage_t stage,
+                                       caterva_array_t *array, int64_t nchunk,
+                                       blosc_timestamp_t *t0) {
+    CATERVA_TRACE(ctx, stage, CATERVA_TRACE_BEGIN, array, nchunk, 0);
+    if (ctx->cfg->stats) {
+        blosc_set_timestamp(t0);
+    }
+}
+
+static inline void caterva_stage_end(caterva_context_t *ctx, caterva_stage_t stage,
+                                     caterva_array_t *array, int64_t nchunk, int64_t nbytes,
+                                     blosc_timestamp_t *t0, caterva_stats_t *stats) {
+    if (ctx->cfg->stats) {
+        blosc_timestamp_t t1;
+        blosc_set_timestamp(&t1);
+        stats->time_ns[stage] += (int64_t) blosc_elapsed_nsecs(*t0, t1);
+    }
+    CATERVA_TRACE(ctx, stage, CATERVA_TRACE_END, array, nchunk, nbytes);
+}
+
+/* Add the statistics of an operation to the ones of the array (if not NULL) and the context */
+void caterva_stats_merge(caterva_context_t *ctx, caterva_array_t *array,
+                         const caterva_stats_t *delta);
+
+#endif  // CATERVA_CATERVA_UTILS_H_
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static char* test_adaptive_clevel(double target_speed, int nthreads, bool append,
+                                  int expected_clevel) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.target_speed = target_speed;
+    cfg.nthreads = nthreads;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 2;
+    params.shape[0] = 200;
+    params.shape[1] = 90;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 30;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    size_t buffersize = 200 * 90 * sizeof(int32_t);
+    int32_t *buffer = malloc(buffersize);
+    for (int i = 0; i < 200 * 90; ++i) {
+        buffer[i] = i * 7 % 1001;
+    }
+
+    caterva_array_t *array;
+    if (append) {
+        MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+        int32_t chunk[20 * 30];
+        for (int64_t n = 0; !array->filled; ++n) {
+            for (int64_t i = 0; i < array->next_chunknitems; ++i) {
+                chunk[i] = (int32_t) (n * 31 + i % 17);
+            }
+            MU_ASSERT_CATERVA(caterva_array_append(ctx, array, chunk,
+                                                   array->next_chunknitems * sizeof(int32_t)));
+        }
+        MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer, buffersize));
+    } else {
+        MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                    &array));
+    }
+    MU_ASSERT("The compression level has not been adapted",
+              array->sc->clevel == expected_clevel);
+
+    int32_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    free(buffer);
+    free(buffer_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+/* An unreachable speed drives the level down to the fastest one */
+static char* adaptive_clevel_1_down() {
+    return test_adaptive_clevel(1e12, 1, false, 1);
+}
+
+static char* adaptive_clevel_2_down_append() {
+    return test_adaptive_clevel(1e12, 2, true, 1);
+}
+
+/* A negligible speed drives the level up to the strongest one */
+static char* adaptive_clevel_3_up() {
+    return test_adaptive_clevel(1e-12, 1, false, 9);
+}
+
+static char* adaptive_clevel_4_up_append() {
+    return test_adaptive_clevel(1e-12, 2, true, 9);
+}
+
+/* Without a target the level of the context is kept */
+static char* adaptive_clevel_off() {
+    return test_adaptive_clevel(0, 2, true, 5);
+}
+
+/* Doubles the items of a block while they are compressed */
+static int double_items(blosc2_prefilter_params *pparams) {
+    const int32_t *in = (const int32_t *) pparams->in;
+    int32_t *out = (int32_t *) pparams->out;
+    for (int32_t i = 0; i < pparams->out_size / (int32_t) sizeof(int32_t); ++i) {
+        out[i] = 2 * in[i];
+    }
+    return 0;
+}
+
+/* The prefilter of the context is kept when the level changes */
+static char* adaptive_clevel_prefilter() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.target_speed = 1e12;
+    cfg.prefilter = double_items;
+    blosc2_prefilter_params pparams = {0};
+    cfg.pparams = &pparams;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 2;
+    params.shape[0] = 200;
+    params.shape[1] = 90;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 30;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    size_t buffersize = 200 * 90 * sizeof(int32_t);
+    int32_t *buffer = malloc(buffersize);
+    for (int i = 0; i < 200 * 90; ++i) {
+        buffer[i] = i * 7 % 1001;
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                &array));
+    MU_ASSERT("The compression level has not been adapted", array->sc->clevel == 1);
+
+    int32_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer_dest, buffersize));
+    for (int i = 0; i < 200 * 90; ++i) {
+        MU_ASSERT("The prefilter has not been applied", buffer_dest[i] == 2 * buffer[i]);
+    }
+
+    free(buffer);
+    free(buffer_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_TEST(adaptive_clevel_1_down)
+    MU_RUN_TEST(adaptive_clevel_2_down_append)
+    MU_RUN_TEST(adaptive_clevel_3_up)
+    MU_RUN_TEST(adaptive_clevel_4_up_append)
+    MU_RUN_TEST(adaptive_clevel_off)
+    MU_RUN_TEST(adaptive_clevel_prefilter)
+
+    return 0;
+}
+
+MU_RUN_SUITE("ADAPTIVE CLEVEL")
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+#define NPURPOSES (CATERVA_ALLOC_SCRATCH + 1)
+
+/* Keeps track of the memory requested through the aligned hooks */
+typedef struct {
+    void *(*alloc)(size_t, size_t, caterva_alloc_purpose_t, void *);
+    void (*free)(void *, size_t, caterva_alloc_purpose_t, void *);
+    int64_t nallocs[NPURPOSES];
+    int64_t live[NPURPOSES];
+    bool misaligned;
+} tracker_t;
+
+static void *tracker_alloc(size_t size, size_t alignment, caterva_alloc_purpose_t purpose,
+                           void *alloc_data) {
+    tracker_t *tracker = (tracker_t *) alloc_data;
+    void *ptr = tracker->alloc(size, alignment, purpose, NULL);
+    if (ptr != NULL) {
+        tracker->nallocs[purpose]++;
+        tracker->live[purpose] += (int64_t) size;
+        if ((uintptr_t) ptr % alignment != 0) {
+            tracker->misaligned = true;
+        }
+    }
+    return ptr;
+}
+
+static void tracker_free(void *ptr, size_t size, caterva_alloc_purpose_t purpose,
+                         void *alloc_data) {
+    tracker_t *tracker = (tracker_t *) alloc_data;
+    tracker->live[purpose] -= (int64_t) size;
+    tracker->free(ptr, size, purpose, NULL);
+}
+
+static char* test_alloc(caterva_storage_backend_t backend, uint8_t itemsize, uint8_t ndim,
+                        int64_t *shape, int32_t *chunkshape, int32_t *blockshape,
+                        bool hugepage) {
+    tracker_t tracker = {0};
+    tracker.alloc = hugepage ? caterva_alloc_hugepage : caterva_alloc_numa;
+    tracker.free = hugepage ? caterva_free_hugepage : caterva_free_numa;
+
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.alloc_aligned = tracker_alloc;
+    cfg.free_aligned = tracker_free;
+    cfg.alloc_data = &tracker;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend;
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        for (int i = 0; i < ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = chunkshape[i];
+            storage.properties.blosc.blockshape[i] = blockshape[i];
+        }
+    }
+
+    /* Create original data */
+    size_t buffersize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        buffersize *= (size_t) shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize);
+    MU_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    /* Roundtrip through the hooks */
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage, &src));
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, src, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+    /* A slice across several blocks masks out the blocks it does not need */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t slicesize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        stop[i] = backend == CATERVA_STORAGE_BLOSC ? blockshape[i] + 1 : 1;
+        slicesize *= stop[i];
+    }
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, src, start, stop, stop, buffer_dest,
+                                                     slicesize));
+
+    MU_ASSERT("Array not allocated through the hooks", tracker.nallocs[CATERVA_ALLOC_ARRAY] > 0);
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        MU_ASSERT("Chunks not allocated through the hooks",
+                  tracker.nallocs[CATERVA_ALLOC_CHUNK] > 0);
+        MU_ASSERT("Masks not allocated through the hooks",
+                  tracker.nallocs[CATERVA_ALLOC_MASKOUT] > 0);
+    } else {
+        MU_ASSERT("Plain buffer not allocated through the hooks",
+                  tracker.live[CATERVA_ALLOC_PLAINBUFFER] == (int64_t) buffersize);
+    }
+    MU_ASSERT("Memory is not aligned", !tracker.misaligned);
+
+    /* Free mallocs */
+    free(buffer);
+    free(buffer_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    for (int i = 0; i < NPURPOSES; ++i) {
+        MU_ASSERT("Memory released with a wrong size or leaked", tracker.live[i] == 0);
+    }
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+
+static char* alloc_2_double_blosc_hugepage() {
+    int64_t shape[] = {400, 300};
+    int32_t chunkshape[] = {400, 200};
+    int32_t blockshape[] = {50, 100};
+
+    return test_alloc(CATERVA_STORAGE_BLOSC, sizeof(double), 2, shape, chunkshape, blockshape,
+                      true);
+}
+
+static char* alloc_3_float_blosc_numa() {
+    int64_t shape[] = {40, 55, 23};
+    int32_t chunkshape[] = {31, 5, 22};
+    int32_t blockshape[] = {4, 4, 4};
+
+    return test_alloc(CATERVA_STORAGE_BLOSC, sizeof(float), 3, shape, chunkshape, blockshape,
+                      false);
+}
+
+static char* alloc_3_double_plainbuffer_hugepage() {
+    int64_t shape[] = {100, 80, 40};
+
+    return test_alloc(CATERVA_STORAGE_PLAINBUFFER, sizeof(double), 3, shape, NULL, NULL, true);
+}
+
+static char* alloc_2_uint16_plainbuffer_numa() {
+    int64_t shape[] = {300, 250};
+
+    return test_alloc(CATERVA_STORAGE_PLAINBUFFER, sizeof(uint16_t), 2, shape, NULL, NULL,
+                      false);
+}
+
+static char* alloc_unpaired_hooks() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.alloc_aligned = caterva_alloc_numa;
+    caterva_context_t *ctx;
+    MU_ASSERT("Unpaired hooks are accepted",
+              caterva_context_new(&cfg, &ctx) == CATERVA_ERR_INVALID_ARGUMENT);
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_TEST(alloc_2_double_blosc_hugepage)
+    MU_RUN_TEST(alloc_3_float_blosc_numa)
+    MU_RUN_TEST(alloc_3_double_plainbuffer_hugepage)
+    MU_RUN_TEST(alloc_2_uint16_plainbuffer_numa)
+    MU_RUN_TEST(alloc_unpaired_hooks)
+
+    return 0;
+}
+
+MU_RUN_SUITE("ALLOC")
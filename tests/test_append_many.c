@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+#ifdef __GNUC__
+#include <unistd.h>
+#define FILE_EXISTS(filename) access(filename, F_OK)
+#else
+#include <io.h>
+#define FILE_EXISTS(filename) _access(filename, 0)
+#endif
+
+/* Copy the chunk nchunk of the array out of buffer (with the shape of the chunk on the edges) */
+static int64_t extract_chunk(caterva_array_t *array, const uint8_t *buffer, int64_t nchunk,
+                             uint8_t *chunk) {
+    int8_t ndim = array->ndim;
+    int64_t origin[CATERVA_MAX_DIM];
+    int64_t cshape[CATERVA_MAX_DIM];
+    int64_t cnitems = 1;
+    int64_t rem = nchunk;
+    for (int i = ndim - 1; i >= 0; --i) {
+        int64_t grid = array->extshape[i] / array->chunkshape[i];
+        origin[i] = rem % grid * array->chunkshape[i];
+        rem /= grid;
+        cshape[i] = array->shape[i] - origin[i] < array->chunkshape[i]
+                        ? array->shape[i] - origin[i] : array->chunkshape[i];
+        cnitems *= cshape[i];
+    }
+    for (int64_t n = 0; n < cnitems; ++n) {
+        int64_t index = 0;
+        int64_t r = n;
+        int64_t stride = 1;
+        for (int i = ndim - 1; i >= 0; --i) {
+            index += (origin[i] + r % cshape[i]) * stride;
+            r /= cshape[i];
+            stride *= array->shape[i];
+        }
+        memcpy(chunk + n * array->itemsize, buffer + index * array->itemsize,
+               (size_t) array->itemsize);
+    }
+    return cnitems * array->itemsize;
+}
+
+static char* test_append_many(caterva_context_t *ctx, uint8_t itemsize, uint8_t ndim,
+                              int64_t *shape, int32_t *chunkshape, int32_t *blockshape,
+                              bool enforceframe, char *filename, int64_t batch) {
+    if (filename != NULL && FILE_EXISTS(filename) != -1) {
+        remove(filename);
+    }
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = enforceframe;
+    storage.properties.blosc.filename = filename;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+
+    size_t buffersize = (size_t) array->nitems * itemsize;
+    uint8_t *buffer = malloc(buffersize);
+    MU_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    /* Split the data into chunks */
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    void **chunks = malloc((size_t) nchunks * sizeof(void *));
+    int64_t *chunksizes = malloc((size_t) nchunks * sizeof(int64_t));
+    for (int64_t n = 0; n < nchunks; ++n) {
+        chunks[n] = malloc((size_t) array->chunknitems * itemsize);
+        chunksizes[n] = extract_chunk(array, buffer, n, chunks[n]);
+    }
+
+    /* Append them in batches */
+    for (int64_t first = 0; first < nchunks; first += batch) {
+        int64_t nbatch = nchunks - first < batch ? nchunks - first : batch;
+        MU_ASSERT_CATERVA(caterva_array_append_many(ctx, array, chunks + first, chunksizes + first,
+                                                    nbatch));
+        if (ctx->cfg->flush_policy == CATERVA_FLUSH_ON_APPEND) {
+            MU_ASSERT("The chunks are not written", array->sc->nchunks == array->nchunks);
+        }
+    }
+    MU_ASSERT("The array is not filled", array->filled);
+
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer_dest, (int64_t) buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+    MU_ASSERT("The chunks are not written", array->sc->nchunks == nchunks);
+
+    if (filename != NULL) {
+        caterva_array_t *dest;
+        MU_ASSERT_CATERVA(caterva_array_from_file(ctx, filename, true, &dest));
+        memset(buffer_dest, 0, buffersize);
+        MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer_dest, (int64_t) buffersize));
+        MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    }
+
+    for (int64_t n = 0; n < nchunks; ++n) {
+        free(chunks[n]);
+    }
+    free(chunks);
+    free(chunksizes);
+    free(buffer);
+    free(buffer_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    if (filename != NULL && FILE_EXISTS(filename) != -1) {
+        remove(filename);
+    }
+    return 0;
+}
+
+static char* append_many_1() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    int64_t shape[] = {1000};
+    int32_t chunkshape[] = {70};
+    int32_t blockshape[] = {20};
+    char *msg = test_append_many(ctx, 8, 1, shape, chunkshape, blockshape, false, NULL, 15);
+
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return msg;
+}
+
+static char* append_many_2_file_threads() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 4;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    int64_t shape[] = {53, 31};
+    int32_t chunkshape[] = {10, 8};
+    int32_t blockshape[] = {5, 4};
+    char *msg = test_append_many(ctx, 4, 2, shape, chunkshape, blockshape, true,
+                                 "append_many.caterva", 7);
+
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return msg;
+}
+
+static char* append_many_3_buffered() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.flush_policy = CATERVA_FLUSH_BUFFERED;
+    cfg.append_buffersize = 4096;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    int64_t shape[] = {21, 17, 30};
+    int32_t chunkshape[] = {8, 8, 8};
+    int32_t blockshape[] = {4, 4, 8};
+    char *msg = test_append_many(ctx, 2, 3, shape, chunkshape, blockshape, true,
+                                 "append_many.caterva", 5);
+
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return msg;
+}
+
+static char* append_many_flush() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.stats = true;
+    cfg.flush_policy = CATERVA_FLUSH_BUFFERED;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 1;
+    params.shape[0] = 100;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = true;
+    storage.properties.blosc.chunkshape[0] = 30;
+    storage.properties.blosc.blockshape[0] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    int32_t chunk[30];
+    for (int i = 0; i < 30; ++i) {
+        chunk[i] = i;
+    }
+    MU_ASSERT_CATERVA(caterva_array_append(ctx, array, chunk, sizeof(chunk)));
+    MU_ASSERT_CATERVA(caterva_array_append(ctx, array, chunk, sizeof(chunk)));
+
+    /* The chunks wait in the append buffer until they are flushed */
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("The chunks are written", array->sc->nchunks == 0);
+    MU_ASSERT("Bytes written before flushing", stats.bytes_written == 0);
+    MU_ASSERT("Wrong number of buffered chunks", array->append_buffer.nchunks == 2);
+    MU_ASSERT_CATERVA(caterva_array_flush(ctx, array));
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("The chunks are not written", array->sc->nchunks == 2);
+    MU_ASSERT("No bytes written", stats.bytes_written > 0);
+
+    /* A wrong size makes the whole batch fail */
+    void *chunks[] = {chunk, chunk};
+    int64_t chunksizes[] = {sizeof(chunk), 20 * sizeof(int32_t)};
+    MU_ASSERT("A chunk with a wrong size appended",
+              caterva_array_append_many(ctx, array, chunks, chunksizes, 2) != CATERVA_SUCCEED);
+    MU_ASSERT("A failed batch is partially appended", array->nchunks == 2);
+    MU_ASSERT("Too many chunks appended",
+              caterva_array_append_many(ctx, array, chunks, chunksizes, 3) != CATERVA_SUCCEED);
+    chunksizes[1] = 10 * sizeof(int32_t);
+    MU_ASSERT_CATERVA(caterva_array_append_many(ctx, array, chunks, chunksizes, 2));
+    MU_ASSERT("The array is not filled", array->filled);
+
+    /* The chunks left in the buffer are written when the array is freed */
+    caterva_array_t *dest;
+    MU_ASSERT_CATERVA(caterva_array_copy(ctx, array, &storage, &dest));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    int32_t buffer[100];
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer, sizeof(buffer)));
+    for (int i = 0; i < 100; ++i) {
+        MU_ASSERT("Wrong value", buffer[i] == i % 30);
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_TEST(append_many_1)
+    MU_RUN_TEST(append_many_2_file_threads)
+    MU_RUN_TEST(append_many_3_buffered)
+    MU_RUN_TEST(append_many_flush)
+
+    return 0;
+}
+
+MU_RUN_SUITE("APPEND MANY")
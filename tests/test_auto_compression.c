@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+/* Check that the codec and filters of an array have been chosen among the candidates */
+static char* check_cparams(caterva_array_t *array, bool trunc) {
+    MU_ASSERT("The selection is still pending", array->objective == CATERVA_COMPRESSION_FIXED);
+    blosc2_cparams *cparams;
+    MU_ASSERT("Blosc error", blosc2_schunk_get_cparams(array->sc, &cparams) >= 0);
+    MU_ASSERT("Unknown codec", cparams->compcode == BLOSC_BLOSCLZ ||
+              cparams->compcode == BLOSC_LZ4 || cparams->compcode == BLOSC_LZ4HC ||
+              cparams->compcode == BLOSC_ZLIB || cparams->compcode == BLOSC_ZSTD);
+    uint8_t last = cparams->filters[BLOSC2_MAX_FILTERS - 1];
+    MU_ASSERT("Unknown filter", last == BLOSC_NOSHUFFLE || last == BLOSC_SHUFFLE ||
+              last == BLOSC_BITSHUFFLE);
+    MU_ASSERT("The truncation is not kept", (cparams->filters[0] == BLOSC_TRUNC_PREC) == trunc);
+    free(cparams);
+    return 0;
+}
+
+static char* test_auto_compression(caterva_context_t *ctx, caterva_compression_objective_t
+                                   objective, bool append, bool enforceframe) {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 2;
+    params.shape[0] = 70;
+    params.shape[1] = 45;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = enforceframe;
+    storage.properties.blosc.objective = objective;
+    storage.properties.blosc.chunkshape[0] = 30;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 7;
+
+    size_t buffersize = 70 * 45 * sizeof(double);
+    double *buffer = malloc(buffersize);
+    for (int i = 0; i < 70 * 45; ++i) {
+        buffer[i] = (double) (i / 3);
+    }
+
+    caterva_array_t *array;
+    if (append) {
+        MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+        MU_ASSERT("The selection is not pending", array->objective == objective);
+        double chunk[30 * 20];
+        for (int64_t n = 0; !array->filled; ++n) {
+            // The first chunk is uniform, so the second one chooses the codec and filters
+            for (int64_t i = 0; i < array->next_chunknitems; ++i) {
+                chunk[i] = n == 0 ? -1 : (double) (n * 1000 + i);
+            }
+            MU_ASSERT_CATERVA(caterva_array_append(ctx, array, chunk,
+                                                   array->next_chunknitems * sizeof(double)));
+            if (n == 0) {
+                MU_ASSERT("A uniform chunk was sampled", array->objective == objective);
+            }
+        }
+        MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer, buffersize));
+    } else {
+        MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                    &array));
+    }
+    char *msg = check_cparams(array, false);
+    if (msg != 0) {
+        return msg;
+    }
+
+    caterva_array_t *dest = array;
+    if (enforceframe) {
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, array->sc->frame->sdata,
+                                                    array->sc->frame->len, true, &dest));
+    }
+    double *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    free(buffer);
+    free(buffer_dest);
+    if (dest != array) {
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    }
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* auto_compression_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.stats = true;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* auto_compression_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* auto_compression_1_ratio() {
+    return test_auto_compression(ctx, CATERVA_COMPRESSION_RATIO, false, false);
+}
+
+static char* auto_compression_2_cspeed_frame() {
+    return test_auto_compression(ctx, CATERVA_COMPRESSION_CSPEED, false, true);
+}
+
+static char* auto_compression_3_dspeed_append() {
+    return test_auto_compression(ctx, CATERVA_COMPRESSION_DSPEED, true, false);
+}
+
+static char* auto_compression_4_ratio_append_frame() {
+    return test_auto_compression(ctx, CATERVA_COMPRESSION_RATIO, true, true);
+}
+
+static char* auto_compression_trunc() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.filters[0] = BLOSC_TRUNC_PREC;
+    cfg.filtersmeta[0] = 20;
+    caterva_context_t *tctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &tctx));
+
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(float);
+    params.ndim = 1;
+    params.shape[0] = 500;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.objective = CATERVA_COMPRESSION_RATIO;
+    storage.properties.blosc.chunkshape[0] = 200;
+    storage.properties.blosc.blockshape[0] = 50;
+
+    float buffer[500];
+    for (int i = 0; i < 500; ++i) {
+        buffer[i] = (float) i / 7;
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(tctx, buffer, sizeof(buffer), &params, &storage,
+                                                &array));
+    char *msg = check_cparams(array, true);
+    if (msg != 0) {
+        return msg;
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(tctx, &array));
+    MU_ASSERT_CATERVA(caterva_context_free(&tctx));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(auto_compression_setup)
+
+    MU_RUN_TEST(auto_compression_1_ratio)
+    MU_RUN_TEST(auto_compression_2_cspeed_frame)
+    MU_RUN_TEST(auto_compression_3_dspeed_append)
+    MU_RUN_TEST(auto_compression_4_ratio_append_frame)
+    MU_RUN_TEST(auto_compression_trunc)
+
+    MU_RUN_TEARDOWN(auto_compression_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("AUTO COMPRESSION")
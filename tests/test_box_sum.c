@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static double load(caterva_item_kind_t kind, int32_t itemsize, const uint8_t *item) {
+    if (kind == CATERVA_ITEM_FLOAT) {
+        return itemsize == 4 ? *(const float *) item : *(const double *) item;
+    }
+    if (kind == CATERVA_ITEM_INT) {
+        return itemsize == 4 ? *(const int32_t *) item : *(const int16_t *) item;
+    }
+    return itemsize == 4 ? *(const uint32_t *) item : *(const uint16_t *) item;
+}
+
+/* The sum of the items of a C buffer inside the box [start, stop) */
+static double brute_sum(const uint8_t *buffer, caterva_item_kind_t kind, int32_t itemsize,
+                        int8_t ndim, const int64_t *shape, const int64_t *start,
+                        const int64_t *stop) {
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        nitems *= shape[i];
+    }
+    double sum = 0;
+    for (int64_t n = 0; n < nitems; ++n) {
+        int64_t rem = n;
+        bool inside = true;
+        for (int i = ndim - 1; i >= 0; --i) {
+            int64_t coord = rem % shape[i];
+            rem /= shape[i];
+            inside = inside && coord >= start[i] && coord < stop[i];
+        }
+        if (inside) {
+            sum += load(kind, itemsize, buffer + n * itemsize);
+        }
+    }
+    return sum;
+}
+
+static char* check_boxes(caterva_context_t *ctx, caterva_array_t *array, const uint8_t *buffer,
+                         caterva_item_kind_t kind) {
+    uint32_t seed = 12345;
+    for (int box = 0; box < 50; ++box) {
+        int64_t start[CATERVA_MAX_DIM];
+        int64_t stop[CATERVA_MAX_DIM];
+        for (int i = 0; i < array->ndim; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            int64_t a = (seed >> 8) % (array->shape[i] + 1);
+            seed = seed * 1103515245u + 12345u;
+            int64_t b = (seed >> 8) % (array->shape[i] + 1);
+            start[i] = a < b ? a : b;
+            stop[i] = a < b ? b : a;
+        }
+        /* The whole array is one of the boxes */
+        if (box == 0) {
+            for (int i = 0; i < array->ndim; ++i) {
+                start[i] = 0;
+                stop[i] = array->shape[i];
+            }
+        }
+        double sum;
+        MU_ASSERT_CATERVA(caterva_array_get_box_sum(ctx, array, start, stop, &sum));
+        double expected = brute_sum(buffer, kind, array->itemsize, array->ndim, array->shape,
+                                    start, stop);
+        double error = sum > expected ? sum - expected : expected - sum;
+        MU_ASSERT("The box sum is wrong",
+                  error <= 1e-9 * (expected > 0 ? expected : -expected) + 1e-9);
+    }
+    return 0;
+}
+
+static char* test_box_sum(caterva_context_t *ctx, caterva_item_kind_t kind, int32_t itemsize,
+                          int8_t ndim, int64_t *shape, int32_t *chunkshape, int32_t *blockshape) {
+    caterva_params_t params = {0};
+    params.itemsize = (uint8_t) itemsize;
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.sum_index = true;
+    storage.properties.blosc.sum_kind = kind;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    size_t buffersize = (size_t) (nitems * itemsize);
+    uint8_t *buffer = malloc(buffersize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        double value = (double) ((i * 7919) % 1000) - 300;
+        if (kind == CATERVA_ITEM_FLOAT && itemsize == 8) {
+            ((double *) buffer)[i] = value / 8;
+        } else if (kind == CATERVA_ITEM_FLOAT) {
+            ((float *) buffer)[i] = (float) value / 8;
+        } else if (itemsize == 4) {
+            ((int32_t *) buffer)[i] = (int32_t) value;
+        } else {
+            ((int16_t *) buffer)[i] = (int16_t) value;
+        }
+    }
+    /* A uniform chunk (the first one) */
+    for (int64_t i = 0; i < nitems; ++i) {
+        int64_t rem = i;
+        bool inside = true;
+        for (int j = ndim - 1; j >= 0; --j) {
+            inside = inside && rem % shape[j] < chunkshape[j];
+            rem /= shape[j];
+        }
+        if (inside) {
+            memset(buffer + i * itemsize, 0, (size_t) itemsize);
+        }
+    }
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                &array));
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, false));
+    MU_ASSERT("The uniform chunk is missing", stats.nchunks_uniform_written >= 1);
+    char *msg = check_boxes(ctx, array, buffer, kind);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* Appending the chunks records the same index */
+    caterva_array_t *copy;
+    MU_ASSERT_CATERVA(caterva_array_copy(ctx, array, &storage, &copy));
+    msg = check_boxes(ctx, copy, buffer, kind);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* The index travels with the frame */
+    uint8_t *sframe;
+    int64_t len;
+    bool needs_free;
+    MU_ASSERT_CATERVA(caterva_array_to_sframe(ctx, copy, &sframe, &len, &needs_free));
+    caterva_array_t *loaded;
+    MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, sframe, len, true, &loaded));
+    msg = check_boxes(ctx, loaded, buffer, kind);
+    if (msg != 0) {
+        return msg;
+    }
+    /* The reads leave the index as it was loaded, so it is not written again */
+    MU_ASSERT("The index is changed by the reads", !loaded->indexes_dirty);
+    if (needs_free) {
+        free(sframe);
+    }
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &loaded));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &copy));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* box_sum_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.stats = true;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* box_sum_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* box_sum_1_int32() {
+    int64_t shape[] = {100, 75};
+    int32_t chunkshape[] = {20, 16};
+    int32_t blockshape[] = {10, 8};
+
+    return test_box_sum(ctx, CATERVA_ITEM_INT, 4, 2, shape, chunkshape, blockshape);
+}
+
+static char* box_sum_2_float64() {
+    int64_t shape[] = {21, 30, 17};
+    int32_t chunkshape[] = {8, 8, 8};
+    int32_t blockshape[] = {4, 3, 2};
+
+    return test_box_sum(ctx, CATERVA_ITEM_FLOAT, 8, 3, shape, chunkshape, blockshape);
+}
+
+static char* box_sum_3_int16() {
+    int64_t shape[] = {1001};
+    int32_t chunkshape[] = {128};
+    int32_t blockshape[] = {32};
+
+    return test_box_sum(ctx, CATERVA_ITEM_INT, 2, 1, shape, chunkshape, blockshape);
+}
+
+static char* box_sum_decompression() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(float);
+    params.ndim = 2;
+    params.shape[0] = 100;
+    params.shape[1] = 100;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.sum_index = true;
+    storage.properties.blosc.sum_kind = CATERVA_ITEM_FLOAT;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    float buffer[100 * 100];
+    for (int i = 0; i < 100 * 100; ++i) {
+        buffer[i] = (float) (i % 13);
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, sizeof(buffer), &params, &storage,
+                                                &array));
+
+    /* A box aligned with the chunks is added out of the index */
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    int64_t start[] = {20, 40};
+    int64_t stop[] = {80, 100};
+    double sum;
+    MU_ASSERT_CATERVA(caterva_array_get_box_sum(ctx, array, start, stop, &sum));
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("An aligned box is decompressed", stats.nchunks_decompressed == 0);
+    MU_ASSERT("The aligned box sum is wrong",
+              sum == brute_sum((uint8_t *) buffer, CATERVA_ITEM_FLOAT, 4, 2, params.shape,
+                               start, stop));
+
+    /* A box aligned with the blocks is added out of the index too */
+    start[0] = 10;
+    stop[0] = 90;
+    MU_ASSERT_CATERVA(caterva_array_get_box_sum(ctx, array, start, stop, &sum));
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("A box aligned with the blocks is decompressed", stats.nchunks_decompressed == 0);
+
+    /* Only the blocks on the boundary of another box are decompressed */
+    start[0] = 5;
+    start[1] = 5;
+    stop[0] = 95;
+    stop[1] = 15;
+    MU_ASSERT_CATERVA(caterva_array_get_box_sum(ctx, array, start, stop, &sum));
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("The inner blocks are decompressed", stats.nblocks_decompressed <= 2 * 10);
+    MU_ASSERT("The box sum is wrong",
+              sum == brute_sum((uint8_t *) buffer, CATERVA_ITEM_FLOAT, 4, 2, params.shape,
+                               start, stop));
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* box_sum_fill_value() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 2;
+    params.shape[0] = 50;
+    params.shape[1] = 50;
+    int32_t fill_value = 3;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.sum_index = true;
+    storage.properties.blosc.sum_kind = CATERVA_ITEM_INT;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &array));
+    int64_t start[] = {0, 0};
+    int64_t stop[] = {50, 50};
+    double sum;
+    MU_ASSERT_CATERVA(caterva_array_get_box_sum(ctx, array, start, stop, &sum));
+    MU_ASSERT("The fill value is not summed", sum == 3 * 50 * 50);
+
+    /* Setting a chunk updates its sums */
+    int32_t chunk[20 * 20];
+    for (int i = 0; i < 20 * 20; ++i) {
+        chunk[i] = i;
+    }
+    MU_ASSERT_CATERVA(caterva_array_set_chunk(ctx, array, 0, chunk, sizeof(chunk)));
+    MU_ASSERT_CATERVA(caterva_array_get_box_sum(ctx, array, start, stop, &sum));
+    MU_ASSERT("The chunk set is not summed",
+              sum == 3 * (50 * 50 - 20 * 20) + 20 * 20 * (20 * 20 - 1) / 2);
+    stop[0] = 20;
+    stop[1] = 15;
+    MU_ASSERT_CATERVA(caterva_array_get_box_sum(ctx, array, start, stop, &sum));
+    double expected = 0;
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 15; ++j) {
+            expected += chunk[i * 20 + j];
+        }
+    }
+    MU_ASSERT("The part of the chunk set is not summed", sum == expected);
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* box_sum_rechunk_concatenate() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 40;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.sum_index = true;
+    storage.properties.blosc.sum_kind = CATERVA_ITEM_INT;
+    storage.properties.blosc.chunkshape[0] = 10;
+    storage.properties.blosc.chunkshape[1] = 10;
+    storage.properties.blosc.blockshape[0] = 5;
+    storage.properties.blosc.blockshape[1] = 5;
+
+    /* The first rows make uniform chunks */
+    int32_t buffer[2 * 40 * 40];
+    for (int i = 0; i < 40 * 40; ++i) {
+        buffer[i] = i < 20 * 40 ? 5 : (i * 7919) % 1000 - 300;
+        buffer[40 * 40 + i] = buffer[i];
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, 40 * 40 * sizeof(int32_t), &params,
+                                                &storage, &array));
+
+    /* The rechunked chunks record their sums */
+    caterva_storage_t rstorage = storage;
+    rstorage.properties.blosc.chunkshape[0] = 20;
+    rstorage.properties.blosc.chunkshape[1] = 8;
+    rstorage.properties.blosc.blockshape[0] = 10;
+    rstorage.properties.blosc.blockshape[1] = 4;
+    caterva_array_t *rechunked;
+    MU_ASSERT_CATERVA(caterva_array_rechunk(ctx, array, &rstorage, 0, &rechunked));
+    char *msg = check_boxes(ctx, rechunked, (uint8_t *) buffer, CATERVA_ITEM_INT);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* So do the chunks passed through when concatenating */
+    caterva_array_t *arrays[2] = {array, array};
+    caterva_array_t *joined;
+    MU_ASSERT_CATERVA(caterva_array_concatenate(ctx, arrays, 2, 0, &storage, &joined));
+    msg = check_boxes(ctx, joined, (uint8_t *) buffer, CATERVA_ITEM_INT);
+    if (msg != 0) {
+        return msg;
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &joined));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &rechunked));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* box_sum_errors() {
+    caterva_params_t params = {0};
+    params.itemsize = 3;
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 40;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.sum_index = true;
+    storage.properties.blosc.sum_kind = CATERVA_ITEM_UINT;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT("The sums of 3-byte items",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    params.itemsize = 4;
+    storage.properties.blosc.sum_index = false;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    int64_t start[] = {0, 0};
+    int64_t stop[] = {10, 10};
+    double sum;
+    MU_ASSERT("A box sum without an index",
+              caterva_array_get_box_sum(ctx, array, start, stop, &sum) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+
+    storage.properties.blosc.sum_index = true;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    stop[0] = 41;
+    MU_ASSERT("A box out of the array",
+              caterva_array_get_box_sum(ctx, array, start, stop, &sum) != CATERVA_SUCCEED);
+    start[0] = 5;
+    stop[0] = 4;
+    MU_ASSERT("A reversed box",
+              caterva_array_get_box_sum(ctx, array, start, stop, &sum) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(box_sum_setup)
+
+    MU_RUN_TEST(box_sum_1_int32)
+    MU_RUN_TEST(box_sum_2_float64)
+    MU_RUN_TEST(box_sum_3_int16)
+    MU_RUN_TEST(box_sum_decompression)
+    MU_RUN_TEST(box_sum_fill_value)
+    MU_RUN_TEST(box_sum_rechunk_concatenate)
+    MU_RUN_TEST(box_sum_errors)
+
+    MU_RUN_TEARDOWN(box_sum_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("BOX SUM")
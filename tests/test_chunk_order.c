@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static void set_storage(caterva_storage_t *storage, caterva_chunk_order_t order, int8_t ndim,
+                        int32_t *chunkshape, int32_t *blockshape) {
+    caterva_storage_t storage_ = {0};
+    *storage = storage_;
+    storage->backend = CATERVA_STORAGE_BLOSC;
+    storage->properties.blosc.chunk_order = order;
+    for (int i = 0; i < ndim; ++i) {
+        storage->properties.blosc.chunkshape[i] = chunkshape[i];
+        storage->properties.blosc.blockshape[i] = blockshape[i];
+    }
+}
+
+static char* check_buffer(caterva_context_t *ctx, caterva_array_t *array, double *buffer) {
+    size_t buffersize = (size_t) array->nitems * sizeof(double);
+    double *dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, dest, (int64_t) buffersize));
+    MU_ASSERT_BUFFER(buffer, dest, (int64_t) buffersize);
+    free(dest);
+    return 0;
+}
+
+static char* test_chunk_order(caterva_context_t *ctx, caterva_chunk_order_t order, int8_t ndim,
+                              int64_t *shape, int32_t *chunkshape, int32_t *blockshape) {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+    caterva_storage_t storage;
+    set_storage(&storage, order, ndim, chunkshape, blockshape);
+
+    size_t buffersize = (size_t) nitems * sizeof(double);
+    double *buffer = malloc(buffersize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        buffer[i] = (double) i;
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, (int64_t) buffersize, &params,
+                                                &storage, &array));
+    MU_ASSERT("The chunk order is not kept", array->chunk_order == order);
+    char *msg = check_buffer(ctx, array, buffer);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* A slice across several chunks */
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t slice_shape[CATERVA_MAX_DIM];
+    int64_t slice_nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = shape[i] / 4;
+        stop[i] = shape[i] - shape[i] / 5;
+        slice_shape[i] = stop[i] - start[i];
+        slice_nitems *= slice_shape[i];
+    }
+    double *slice = malloc((size_t) slice_nitems * sizeof(double));
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, start, stop, slice_shape, slice,
+                                                     slice_nitems * (int64_t) sizeof(double)));
+    for (int64_t n = 0; n < slice_nitems; ++n) {
+        int64_t rem = n;
+        int64_t index = 0;
+        int64_t stride = 1;
+        for (int i = ndim - 1; i >= 0; --i) {
+            index += (start[i] + rem % slice_shape[i]) * stride;
+            rem /= slice_shape[i];
+            stride *= shape[i];
+        }
+        MU_ASSERT("Wrong item in the slice", slice[n] == buffer[index]);
+    }
+    free(slice);
+
+    /* A copy in C order and back holds the same items */
+    caterva_storage_t storage_c;
+    set_storage(&storage_c, CATERVA_CHUNK_ORDER_C, ndim, chunkshape, blockshape);
+    caterva_array_t *copy_c;
+    MU_ASSERT_CATERVA(caterva_array_copy(ctx, array, &storage_c, &copy_c));
+    caterva_array_t *copy;
+    MU_ASSERT_CATERVA(caterva_array_copy(ctx, copy_c, &storage, &copy));
+    msg = check_buffer(ctx, copy, buffer);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* The order travels with the frame */
+    uint8_t *sframe;
+    int64_t len;
+    bool needs_free;
+    MU_ASSERT_CATERVA(caterva_array_to_sframe(ctx, copy, &sframe, &len, &needs_free));
+    caterva_array_t *loaded;
+    MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, sframe, len, true, &loaded));
+    MU_ASSERT("The chunk order is not loaded", loaded->chunk_order == order);
+    MU_ASSERT("The array is not filled", loaded->filled);
+    msg = check_buffer(ctx, loaded, buffer);
+    if (msg != 0) {
+        return msg;
+    }
+    if (needs_free) {
+        free(sframe);
+    }
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &loaded));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &copy));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &copy_c));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* chunk_order_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* chunk_order_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* chunk_order_morton_2() {
+    int64_t shape[] = {100, 75};
+    int32_t chunkshape[] = {20, 16};
+    int32_t blockshape[] = {10, 8};
+
+    return test_chunk_order(ctx, CATERVA_CHUNK_ORDER_MORTON, 2, shape, chunkshape, blockshape);
+}
+
+static char* chunk_order_hilbert_2() {
+    int64_t shape[] = {100, 75};
+    int32_t chunkshape[] = {20, 16};
+    int32_t blockshape[] = {10, 8};
+
+    return test_chunk_order(ctx, CATERVA_CHUNK_ORDER_HILBERT, 2, shape, chunkshape, blockshape);
+}
+
+static char* chunk_order_hilbert_3() {
+    int64_t shape[] = {21, 30, 17};
+    int32_t chunkshape[] = {8, 8, 8};
+    int32_t blockshape[] = {4, 3, 2};
+
+    return test_chunk_order(ctx, CATERVA_CHUNK_ORDER_HILBERT, 3, shape, chunkshape, blockshape);
+}
+
+static char* chunk_order_morton_4() {
+    int64_t shape[] = {9, 1, 12, 10};
+    int32_t chunkshape[] = {4, 1, 5, 3};
+    int32_t blockshape[] = {2, 1, 2, 2};
+
+    return test_chunk_order(ctx, CATERVA_CHUNK_ORDER_MORTON, 4, shape, chunkshape, blockshape);
+}
+
+static char* chunk_order_curves() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 40;
+    int32_t chunkshape[] = {10, 10};
+    int32_t blockshape[] = {5, 5};
+    caterva_storage_t storage;
+
+    /* The Morton order of a 4 x 4 grid visits the quadrants one after the other */
+    caterva_array_t *array;
+    set_storage(&storage, CATERVA_CHUNK_ORDER_MORTON, 2, chunkshape, blockshape);
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    int64_t morton[] = {0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15};
+    MU_ASSERT_BUFFER(morton, array->chunk_positions, (int64_t) sizeof(morton));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+
+    /* The consecutive chunks along a Hilbert curve are neighbours */
+    set_storage(&storage, CATERVA_CHUNK_ORDER_HILBERT, 2, chunkshape, blockshape);
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    int64_t chunks[16];
+    for (int64_t nchunk = 0; nchunk < 16; ++nchunk) {
+        chunks[array->chunk_positions[nchunk]] = nchunk;
+    }
+    for (int p = 1; p < 16; ++p) {
+        int64_t distance = llabs(chunks[p] / 4 - chunks[p - 1] / 4) +
+                           llabs(chunks[p] % 4 - chunks[p - 1] % 4);
+        MU_ASSERT("The Hilbert curve jumps", distance == 1);
+    }
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+
+    /* Along a single axis every curve is the C order */
+    params.shape[0] = 1;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    MU_ASSERT("The chunks are reordered", array->chunk_positions == NULL);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* chunk_order_partial_append() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 40;
+    int32_t chunkshape[] = {10, 10};
+    int32_t blockshape[] = {5, 5};
+    caterva_storage_t storage;
+    set_storage(&storage, CATERVA_CHUNK_ORDER_HILBERT, 2, chunkshape, blockshape);
+    storage.properties.blosc.enforceframe = true;
+
+    double buffer[40 * 40];
+    for (int i = 0; i < 40 * 40; ++i) {
+        buffer[i] = (double) i;
+    }
+    double chunk[10 * 10];
+
+    /* Some positions only hold placeholders while the chunks are appended */
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    for (int64_t nchunk = 0; nchunk < 16; ++nchunk) {
+        for (int i = 0; i < 10; ++i) {
+            memcpy(&chunk[i * 10], &buffer[((nchunk / 4) * 10 + i) * 40 + (nchunk % 4) * 10],
+                   10 * sizeof(double));
+        }
+        MU_ASSERT_CATERVA(caterva_array_append(ctx, array, chunk, sizeof(chunk)));
+        if (nchunk != 4) {
+            continue;
+        }
+        /* The chunks appended so far are found when the frame is loaded */
+        MU_ASSERT_CATERVA(caterva_array_flush(ctx, array));
+        MU_ASSERT("Some positions are not placeholders", array->sc->nchunks > 5);
+        /* The placeholders have the size of a whole chunk, like the chunks appended */
+        for (int position = 0; position < array->sc->nchunks; ++position) {
+            uint8_t *cchunk;
+            bool cneeds_free;
+            MU_ASSERT("Error getting a chunk",
+                      blosc2_schunk_get_chunk(array->sc, position, &cchunk, &cneeds_free) >= 0);
+            size_t nbytes, cbytes, blocksize;
+            blosc_cbuffer_sizes(cchunk, &nbytes, &cbytes, &blocksize);
+            if (cneeds_free) {
+                free(cchunk);
+            }
+            MU_ASSERT("Wrong size of a chunk", nbytes == sizeof(chunk));
+        }
+        uint8_t *sframe;
+        int64_t len;
+        bool needs_free;
+        MU_ASSERT_CATERVA(caterva_array_to_sframe(ctx, array, &sframe, &len, &needs_free));
+        caterva_array_t *loaded;
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, sframe, len, true, &loaded));
+        MU_ASSERT("Wrong number of chunks loaded", loaded->nchunks == 5 && !loaded->filled);
+        if (needs_free) {
+            free(sframe);
+        }
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &loaded));
+    }
+    MU_ASSERT("The array is not filled", array->filled);
+    char *msg = check_buffer(ctx, array, buffer);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* The chunks are passed through when joined with a copy in the same order */
+    caterva_array_t *arrays[2] = {array, array};
+    caterva_array_t *joined;
+    storage.properties.blosc.enforceframe = false;
+    MU_ASSERT_CATERVA(caterva_array_concatenate(ctx, arrays, 2, 1, &storage, &joined));
+    double *row = malloc(80 * sizeof(double));
+    for (int64_t i = 0; i < 40; ++i) {
+        int64_t start[] = {i, 0};
+        int64_t stop[] = {i + 1, 80};
+        int64_t shape[] = {1, 80};
+        MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, joined, start, stop, shape, row,
+                                                         80 * sizeof(double)));
+        MU_ASSERT_BUFFER(&buffer[i * 40], row, 40 * sizeof(double));
+        MU_ASSERT_BUFFER(&buffer[i * 40], row + 40, 40 * sizeof(double));
+    }
+    free(row);
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &joined));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* chunk_order_fill_value_squeeze() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 3;
+    params.shape[0] = 1;
+    params.shape[1] = 30;
+    params.shape[2] = 30;
+    double fill_value = -1;
+    int32_t chunkshape[] = {1, 10, 10};
+    int32_t blockshape[] = {1, 5, 5};
+    caterva_storage_t storage;
+    set_storage(&storage, CATERVA_CHUNK_ORDER_MORTON, 3, chunkshape, blockshape);
+
+    /* A chunk set past the stored ones */
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &array));
+    double chunk[10 * 10];
+    for (int i = 0; i < 10 * 10; ++i) {
+        chunk[i] = (double) i;
+    }
+    MU_ASSERT_CATERVA(caterva_array_set_chunk(ctx, array, 5, chunk, sizeof(chunk)));
+    MU_ASSERT("The chunk is not stored in its position",
+              array->sc->nchunks == array->chunk_positions[5] + 1);
+
+    double buffer[30 * 30];
+    for (int i = 0; i < 30 * 30; ++i) {
+        int64_t row = i / 30;
+        int64_t col = i % 30;
+        bool inside = row >= 10 && row < 20 && col >= 20;
+        buffer[i] = inside ? (double) ((row - 10) * 10 + col - 20) : fill_value;
+    }
+    char *msg = check_buffer(ctx, array, buffer);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* Squeezing keeps the positions of the chunks */
+    int64_t positions[9];
+    memcpy(positions, array->chunk_positions, sizeof(positions));
+    MU_ASSERT_CATERVA(caterva_array_squeeze(ctx, array));
+    MU_ASSERT_BUFFER(positions, array->chunk_positions, (int64_t) sizeof(positions));
+    msg = check_buffer(ctx, array, buffer);
+    if (msg != 0) {
+        return msg;
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+/* Check that the chunks of an array are laid out by position in a serialized frame */
+static char* check_layout(caterva_array_t *array, const uint8_t *sframe, int64_t len) {
+    int64_t offset = 0;
+    for (int position = 0; position < array->sc->nchunks; ++position) {
+        uint8_t *cchunk;
+        bool needs_free;
+        int csize = blosc2_schunk_get_chunk(array->sc, position, &cchunk, &needs_free);
+        MU_ASSERT("Error getting a chunk", csize > 0);
+        while (offset + csize <= len && memcmp(sframe + offset, cchunk, (size_t) csize) != 0) {
+            offset++;
+        }
+        if (needs_free) {
+            free(cchunk);
+        }
+        MU_ASSERT("A chunk is laid out before the previous position", offset + csize <= len);
+        offset += csize;
+    }
+    return 0;
+}
+
+static char* chunk_order_layout() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 40;
+    int32_t chunkshape[] = {10, 10};
+    int32_t blockshape[] = {5, 5};
+    char *filename = "chunk_order_layout.b2frame";
+    char *savename = "chunk_order_layout_saved.b2frame";
+
+    double chunk[10 * 10];
+    for (int backed = 0; backed < 2; ++backed) {
+        caterva_storage_t storage;
+        set_storage(&storage, CATERVA_CHUNK_ORDER_HILBERT, 2, chunkshape, blockshape);
+        storage.properties.blosc.enforceframe = true;
+        storage.properties.blosc.filename = backed ? filename : NULL;
+        remove(filename);
+
+        /* The chunks appended in C order fill the placeholders of the curve */
+        caterva_array_t *array;
+        MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+        for (int64_t nchunk = 0; nchunk < 16; ++nchunk) {
+            for (int i = 0; i < 10 * 10; ++i) {
+                chunk[i] = (double) (nchunk * 100 + i);
+            }
+            MU_ASSERT_CATERVA(caterva_array_append(ctx, array, chunk, sizeof(chunk)));
+        }
+
+        /* Yet they are serialized (or saved into another file) by position */
+        uint8_t *sframe;
+        int64_t len;
+        bool needs_free;
+        if (backed) {
+            remove(savename);
+            MU_ASSERT_CATERVA(caterva_array_save(ctx, array, savename));
+            MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+            FILE *fp = fopen(savename, "rb");
+            MU_ASSERT("The file is missing", fp != NULL);
+            fseek(fp, 0, SEEK_END);
+            len = ftell(fp);
+            fseek(fp, 0, SEEK_SET);
+            sframe = malloc((size_t) len);
+            MU_ASSERT("Error reading the file", fread(sframe, 1, (size_t) len, fp) == (size_t) len);
+            fclose(fp);
+            needs_free = true;
+            MU_ASSERT_CATERVA(caterva_array_from_file(ctx, savename, true, &array));
+        } else {
+            MU_ASSERT_CATERVA(caterva_array_to_sframe(ctx, array, &sframe, &len, &needs_free));
+        }
+        char *msg = check_layout(array, sframe, len);
+        if (needs_free) {
+            free(sframe);
+        }
+        if (msg != 0) {
+            return msg;
+        }
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    }
+    remove(filename);
+    remove(savename);
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(chunk_order_setup)
+
+    MU_RUN_TEST(chunk_order_morton_2)
+    MU_RUN_TEST(chunk_order_hilbert_2)
+    MU_RUN_TEST(chunk_order_hilbert_3)
+    MU_RUN_TEST(chunk_order_morton_4)
+    MU_RUN_TEST(chunk_order_curves)
+    MU_RUN_TEST(chunk_order_partial_append)
+    MU_RUN_TEST(chunk_order_fill_value_squeeze)
+    MU_RUN_TEST(chunk_order_layout)
+
+    MU_RUN_TEARDOWN(chunk_order_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("CHUNK ORDER")
@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+/* A record larger than the largest item size */
+typedef struct {
+    int8_t flag;
+    double x;
+    int32_t v[3];
+    uint8_t payload[250];
+} record_t;
+
+#define RECORD_SIZE (1 + 8 + 12 + 250)
+
+static void set_fields(caterva_compound_params_t *params) {
+    params->nfields = 4;
+    params->fields[0].name = "flag";
+    params->fields[0].itemsize = 1;
+    params->fields[1].name = "x";
+    params->fields[1].itemsize = 8;
+    params->fields[2].name = "v";
+    params->fields[2].itemsize = 12;
+    params->fields[3].name = "payload";
+    params->fields[3].itemsize = 250;
+}
+
+/* Pack nitems records (with no padding) starting at the item first */
+static void fill_records(uint8_t *buffer, int64_t first, int64_t nitems) {
+    for (int64_t i = 0; i < nitems; ++i) {
+        record_t record;
+        int64_t n = first + i;
+        record.flag = (int8_t) (n % 3 - 1);
+        record.x = (double) n / 4;
+        for (int j = 0; j < 3; ++j) {
+            record.v[j] = (int32_t) (n * 10 + j);
+        }
+        memset(record.payload, (int) (n % 7), sizeof(record.payload));
+        uint8_t *precord = buffer + i * RECORD_SIZE;
+        memcpy(precord, &record.flag, 1);
+        memcpy(precord + 1, &record.x, 8);
+        memcpy(precord + 9, record.v, 12);
+        memcpy(precord + 21, record.payload, 250);
+    }
+}
+
+static char* test_compound(caterva_context_t *ctx, caterva_storage_backend_t backend,
+                           uint8_t ndim, int64_t *shape, int32_t *chunkshape,
+                           int32_t *blockshape) {
+    caterva_compound_params_t params = {0};
+    params.ndim = ndim;
+    set_fields(&params);
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend;
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        for (int i = 0; i < ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = chunkshape[i];
+            storage.properties.blosc.blockshape[i] = blockshape[i];
+        }
+    }
+
+    size_t buffersize = (size_t) nitems * RECORD_SIZE;
+    uint8_t *buffer = malloc(buffersize);
+    fill_records(buffer, 0, nitems);
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer_fields(ctx, buffer, (int64_t) buffersize,
+                                                       &params, &storage, &array));
+    MU_ASSERT("Wrong record size", array->recordsize == RECORD_SIZE);
+    MU_ASSERT("Wrong number of items", array->nitems == nitems);
+
+    /* Each field is stored with its own type size */
+    for (int i = 0; i < params.nfields; ++i) {
+        caterva_array_t *field;
+        MU_ASSERT_CATERVA(caterva_array_get_field(ctx, array, params.fields[i].name, &field));
+        MU_ASSERT("Wrong field size", field->itemsize == params.fields[i].itemsize);
+        if (backend == CATERVA_STORAGE_BLOSC) {
+            MU_ASSERT("Wrong type size", field->sc->typesize == params.fields[i].itemsize);
+        }
+    }
+
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer_dest, (int64_t) buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    /* A slice of two fields, in another order than the records */
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t slice_shape[CATERVA_MAX_DIM];
+    int64_t slice_nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = shape[i] / 3;
+        stop[i] = shape[i] / 3 + 1 + shape[i] / 4;
+        slice_shape[i] = stop[i] - start[i];
+        slice_nitems *= slice_shape[i];
+    }
+    const char *names[] = {"x", "flag"};
+    uint8_t *slice = malloc((size_t) slice_nitems * 9);
+    MU_ASSERT_CATERVA(caterva_array_get_fields_slice_buffer(ctx, array, names, 2, start, stop,
+                                                            slice_shape, slice,
+                                                            slice_nitems * 9));
+    for (int64_t n = 0; n < slice_nitems; ++n) {
+        int64_t index = 0;
+        int64_t r = n;
+        int64_t stride = 1;
+        for (int i = ndim - 1; i >= 0; --i) {
+            index += (start[i] + r % slice_shape[i]) * stride;
+            r /= slice_shape[i];
+            stride *= shape[i];
+        }
+        uint8_t *precord = buffer + index * RECORD_SIZE;
+        MU_ASSERT("Wrong x", memcmp(slice + n * 9, precord + 1, 8) == 0);
+        MU_ASSERT("Wrong flag", slice[n * 9 + 8] == precord[0]);
+    }
+
+    /* The copy keeps the fields */
+    caterva_array_t *copy;
+    MU_ASSERT_CATERVA(caterva_array_copy(ctx, array, &storage, &copy));
+    MU_ASSERT("The fields are lost", copy->nfields == params.nfields);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, copy, buffer_dest, (int64_t) buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    free(buffer);
+    free(buffer_dest);
+    free(slice);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &copy));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* compound_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.stats = true;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* compound_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* compound_1() {
+    int64_t shape[] = {100};
+    int32_t chunkshape[] = {30};
+    int32_t blockshape[] = {8};
+
+    return test_compound(ctx, CATERVA_STORAGE_BLOSC, 1, shape, chunkshape, blockshape);
+}
+
+static char* compound_2() {
+    int64_t shape[] = {25, 17, 9};
+    int32_t chunkshape[] = {10, 10, 5};
+    int32_t blockshape[] = {5, 3, 5};
+
+    return test_compound(ctx, CATERVA_STORAGE_BLOSC, 3, shape, chunkshape, blockshape);
+}
+
+static char* compound_3_plainbuffer() {
+    int64_t shape[] = {20, 31};
+
+    return test_compound(ctx, CATERVA_STORAGE_PLAINBUFFER, 2, shape, NULL, NULL);
+}
+
+static char* compound_partial_read() {
+    caterva_compound_params_t params = {0};
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 30;
+    set_fields(&params);
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 15;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 5;
+
+    /* The chunks of records are appended */
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_empty_fields(ctx, &params, &storage, &array));
+    uint8_t chunk[20 * 15 * RECORD_SIZE];
+    for (int64_t n = 0; !array->filled; ++n) {
+        fill_records(chunk, n * 20 * 15, 20 * 15);
+        MU_ASSERT_CATERVA(caterva_array_append(ctx, array, chunk, sizeof(chunk)));
+    }
+    MU_ASSERT("Wrong number of chunks", array->nchunks == 4);
+
+    /* Only the array of the field read is decompressed */
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    const char *names[] = {"v"};
+    int64_t start[] = {0, 0};
+    int64_t stop[] = {40, 30};
+    int32_t v[40 * 30 * 3];
+    MU_ASSERT_CATERVA(caterva_array_get_fields_slice_buffer(ctx, array, names, 1, start, stop,
+                                                            stop, v, sizeof(v)));
+    for (int64_t i = 0; i < 40 * 30; ++i) {
+        int64_t n = (i / 30 / 20 * 2 + i % 30 / 15) * 300 + (i / 30 % 20) * 15 + i % 15;
+        MU_ASSERT("Wrong v", v[i * 3] == n * 10 && v[i * 3 + 2] == n * 10 + 2);
+    }
+    for (int i = 0; i < params.nfields; ++i) {
+        caterva_array_t *field;
+        MU_ASSERT_CATERVA(caterva_array_get_field(ctx, array, params.fields[i].name, &field));
+        MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, field, &stats, false));
+        MU_ASSERT("Wrong number of chunks decompressed",
+                  stats.nchunks_decompressed == (i == 2 ? 4 : 0));
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* compound_fields_sframe() {
+    caterva_compound_params_t params = {0};
+    params.ndim = 1;
+    params.shape[0] = 50;
+    set_fields(&params);
+    uint8_t fill_value[RECORD_SIZE];
+    fill_records(fill_value, 3, 1);
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = true;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_full_fields(ctx, &params, &storage, fill_value, &array));
+    MU_ASSERT("The array is not filled", array->filled);
+
+    /* The arrays of the fields are serialized on their own and joined again */
+    caterva_array_t *fields[4];
+    for (int i = 0; i < params.nfields; ++i) {
+        caterva_array_t *field;
+        MU_ASSERT_CATERVA(caterva_array_get_field(ctx, array, params.fields[i].name, &field));
+        uint8_t *sframe;
+        int64_t len;
+        bool needs_free;
+        MU_ASSERT_CATERVA(caterva_array_to_sframe(ctx, field, &sframe, &len, &needs_free));
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, sframe, len, true, &fields[i]));
+        if (needs_free) {
+            free(sframe);
+        }
+    }
+    caterva_array_t *swapped[] = {fields[1], fields[0], fields[2], fields[3]};
+    caterva_array_t *dest;
+    MU_ASSERT("The fields are joined out of order",
+              caterva_array_from_fields(ctx, swapped, 4, &dest) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_from_fields(ctx, fields, 4, &dest));
+    MU_ASSERT("Wrong field name", strcmp(dest->fields[3].name, "payload") == 0);
+
+    uint8_t buffer[50 * RECORD_SIZE];
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer, sizeof(buffer)));
+    for (int i = 0; i < 50; ++i) {
+        MU_ASSERT("Wrong fill value",
+                  memcmp(buffer + i * RECORD_SIZE, fill_value, RECORD_SIZE) == 0);
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* compound_errors() {
+    caterva_compound_params_t params = {0};
+    params.ndim = 1;
+    params.shape[0] = 100;
+    set_fields(&params);
+    params.fields[3].name = "x";
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 30;
+    storage.properties.blosc.blockshape[0] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT("Two fields with the same name",
+              caterva_array_empty_fields(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    params.fields[3].name = "payload";
+    MU_ASSERT_CATERVA(caterva_array_empty_fields(ctx, &params, &storage, &array));
+
+    caterva_array_t *field;
+    MU_ASSERT("A missing field", caterva_array_get_field(ctx, array, "y", &field) !=
+                                 CATERVA_SUCCEED);
+    caterva_array_t *rechunked;
+    MU_ASSERT("A compound array rechunked",
+              caterva_array_rechunk(ctx, array, &storage, 0, &rechunked) != CATERVA_SUCCEED);
+    uint8_t chunk[30 * RECORD_SIZE];
+    MU_ASSERT("A chunk with a partial record",
+              caterva_array_append(ctx, array, chunk, sizeof(chunk) - 1) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(compound_setup)
+
+    MU_RUN_TEST(compound_1)
+    MU_RUN_TEST(compound_2)
+    MU_RUN_TEST(compound_3_plainbuffer)
+    MU_RUN_TEST(compound_partial_read)
+    MU_RUN_TEST(compound_fields_sframe)
+    MU_RUN_TEST(compound_errors)
+
+    MU_RUN_TEARDOWN(compound_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("COMPOUND")
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+#define MAX_ARRAYS 4
+
+static char* test_concatenate(caterva_context_t *ctx, uint8_t ndim, int64_t shapes[][CATERVA_MAX_DIM],
+                              int narrays, int8_t axis, bool stack,
+                              caterva_storage_backend_t backend, int32_t *chunkshape,
+                              int32_t *blockshape, caterva_storage_backend_t backend2,
+                              int32_t *chunkshape2, int32_t *blockshape2) {
+    uint8_t itemsize = sizeof(double);
+    caterva_array_t *arrays[MAX_ARRAYS];
+    double *buffers[MAX_ARRAYS];
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend;
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        for (int i = 0; i < ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = chunkshape[i];
+            storage.properties.blosc.blockshape[i] = blockshape[i];
+        }
+    }
+
+    /* Create the inputs; the items of the input k are k * 1e6 + i */
+    for (int k = 0; k < narrays; ++k) {
+        caterva_params_t params = {0};
+        params.itemsize = itemsize;
+        params.ndim = ndim;
+        int64_t nitems = 1;
+        for (int i = 0; i < ndim; ++i) {
+            params.shape[i] = shapes[k][i];
+            nitems *= shapes[k][i];
+        }
+        buffers[k] = malloc((size_t) nitems * itemsize);
+        for (int64_t i = 0; i < nitems; ++i) {
+            buffers[k][i] = k * 1e6 + (double) i;
+        }
+        MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffers[k], nitems * itemsize, &params,
+                                                    &storage, &arrays[k]));
+    }
+
+    /* Join them */
+    int8_t dndim = (int8_t) (stack ? ndim + 1 : ndim);
+    caterva_storage_t storage2 = {0};
+    storage2.backend = backend2;
+    if (backend2 == CATERVA_STORAGE_BLOSC) {
+        for (int i = 0; i < dndim; ++i) {
+            storage2.properties.blosc.chunkshape[i] = chunkshape2[i];
+            storage2.properties.blosc.blockshape[i] = blockshape2[i];
+        }
+    }
+    caterva_array_t *dest;
+    if (stack) {
+        MU_ASSERT_CATERVA(caterva_array_stack(ctx, arrays, narrays, axis, &storage2, &dest));
+    } else {
+        MU_ASSERT_CATERVA(caterva_array_concatenate(ctx, arrays, narrays, axis, &storage2,
+                                                    &dest));
+    }
+    MU_ASSERT("Wrong number of dimensions", dest->ndim == dndim);
+
+    int64_t destsize = dest->nitems * itemsize;
+    double *buffer_dest = malloc((size_t) destsize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer_dest, destsize));
+
+    /* Assert results */
+    for (int64_t nitem = 0; nitem < dest->nitems; ++nitem) {
+        int64_t index[CATERVA_MAX_DIM];
+        int64_t rem = nitem;
+        for (int i = dndim - 1; i >= 0; --i) {
+            index[i] = rem % dest->shape[i];
+            rem /= dest->shape[i];
+        }
+        // Locate the input and the item inside of it
+        int k = 0;
+        if (stack) {
+            k = (int) index[axis];
+        } else {
+            while (index[axis] >= shapes[k][axis]) {
+                index[axis] -= shapes[k][axis];
+                k++;
+            }
+        }
+        int64_t src_nitem = 0;
+        int n = 0;
+        for (int i = 0; i < dndim; ++i) {
+            if (stack && i == axis) {
+                continue;
+            }
+            src_nitem = src_nitem * shapes[k][n++] + index[i];
+        }
+        MU_ASSERT("Item not joined correctly", buffer_dest[nitem] == buffers[k][src_nitem]);
+    }
+
+    /* Free mallocs */
+    for (int k = 0; k < narrays; ++k) {
+        free(buffers[k]);
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &arrays[k]));
+    }
+    free(buffer_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* concatenate_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* concatenate_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+
+static char* concatenate_2_passthrough_axis0() {
+    int64_t shapes[][CATERVA_MAX_DIM] = {{20, 17}, {30, 17}, {13, 17}};
+    int32_t chunkshape[] = {10, 6};
+    int32_t blockshape[] = {5, 3};
+
+    return test_concatenate(ctx, 2, shapes, 3, 0, false, CATERVA_STORAGE_BLOSC, chunkshape,
+                            blockshape, CATERVA_STORAGE_BLOSC, chunkshape, blockshape);
+}
+
+static char* concatenate_3_passthrough_axis1() {
+    int64_t shapes[][CATERVA_MAX_DIM] = {{9, 8, 11}, {9, 12, 11}, {9, 5, 11}};
+    int32_t chunkshape[] = {4, 4, 6};
+    int32_t blockshape[] = {2, 2, 3};
+
+    return test_concatenate(ctx, 3, shapes, 3, 1, false, CATERVA_STORAGE_BLOSC, chunkshape,
+                            blockshape, CATERVA_STORAGE_BLOSC, chunkshape, blockshape);
+}
+
+static char* concatenate_2_misaligned() {
+    int64_t shapes[][CATERVA_MAX_DIM] = {{15, 12}, {20, 12}, {7, 12}, {10, 12}};
+    int32_t chunkshape[] = {10, 5};
+    int32_t blockshape[] = {5, 5};
+
+    return test_concatenate(ctx, 2, shapes, 4, 0, false, CATERVA_STORAGE_BLOSC, chunkshape,
+                            blockshape, CATERVA_STORAGE_BLOSC, chunkshape, blockshape);
+}
+
+static char* concatenate_3_rechunked() {
+    int64_t shapes[][CATERVA_MAX_DIM] = {{6, 7, 8}, {6, 7, 3}};
+    int32_t chunkshape[] = {3, 7, 4};
+    int32_t blockshape[] = {3, 2, 2};
+    int32_t chunkshape2[] = {4, 4, 5};
+    int32_t blockshape2[] = {2, 2, 5};
+
+    return test_concatenate(ctx, 3, shapes, 2, 2, false, CATERVA_STORAGE_BLOSC, chunkshape,
+                            blockshape, CATERVA_STORAGE_BLOSC, chunkshape2, blockshape2);
+}
+
+static char* concatenate_2_plainbuffer() {
+    int64_t shapes[][CATERVA_MAX_DIM] = {{11, 4}, {11, 9}};
+    int32_t chunkshape[] = {5, 5};
+    int32_t blockshape[] = {5, 2};
+
+    return test_concatenate(ctx, 2, shapes, 2, 1, false, CATERVA_STORAGE_BLOSC, chunkshape,
+                            blockshape, CATERVA_STORAGE_PLAINBUFFER, NULL, NULL);
+}
+
+static char* stack_2_passthrough_axis0() {
+    int64_t shapes[][CATERVA_MAX_DIM] = {{21, 13}, {21, 13}, {21, 13}};
+    int32_t chunkshape[] = {10, 6};
+    int32_t blockshape[] = {5, 3};
+    int32_t chunkshape2[] = {1, 10, 6};
+    int32_t blockshape2[] = {1, 5, 3};
+
+    return test_concatenate(ctx, 2, shapes, 3, 0, true, CATERVA_STORAGE_BLOSC, chunkshape,
+                            blockshape, CATERVA_STORAGE_BLOSC, chunkshape2, blockshape2);
+}
+
+static char* stack_2_passthrough_axis1() {
+    int64_t shapes[][CATERVA_MAX_DIM] = {{12, 10}, {12, 10}};
+    int32_t chunkshape[] = {5, 10};
+    int32_t blockshape[] = {5, 5};
+    int32_t chunkshape2[] = {5, 1, 10};
+    int32_t blockshape2[] = {5, 1, 5};
+
+    return test_concatenate(ctx, 2, shapes, 2, 1, true, CATERVA_STORAGE_BLOSC, chunkshape,
+                            blockshape, CATERVA_STORAGE_BLOSC, chunkshape2, blockshape2);
+}
+
+static char* stack_2_rebuilt() {
+    int64_t shapes[][CATERVA_MAX_DIM] = {{9, 14}, {9, 14}, {9, 14}, {9, 14}};
+    int32_t chunkshape[] = {4, 5};
+    int32_t blockshape[] = {2, 5};
+    int32_t chunkshape2[] = {3, 3, 2};
+    int32_t blockshape2[] = {3, 1, 2};
+
+    return test_concatenate(ctx, 2, shapes, 4, 2, true, CATERVA_STORAGE_BLOSC, chunkshape,
+                            blockshape, CATERVA_STORAGE_BLOSC, chunkshape2, blockshape2);
+}
+
+static char* stack_2_plainbuffer() {
+    int64_t shapes[][CATERVA_MAX_DIM] = {{7, 5}, {7, 5}};
+
+    return test_concatenate(ctx, 2, shapes, 2, 1, true, CATERVA_STORAGE_PLAINBUFFER, NULL, NULL,
+                            CATERVA_STORAGE_PLAINBUFFER, NULL, NULL);
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(concatenate_setup)
+
+    MU_RUN_TEST(concatenate_2_passthrough_axis0)
+    MU_RUN_TEST(concatenate_3_passthrough_axis1)
+    MU_RUN_TEST(concatenate_2_misaligned)
+    MU_RUN_TEST(concatenate_3_rechunked)
+    MU_RUN_TEST(concatenate_2_plainbuffer)
+    MU_RUN_TEST(stack_2_passthrough_axis0)
+    MU_RUN_TEST(stack_2_passthrough_axis1)
+    MU_RUN_TEST(stack_2_rebuilt)
+    MU_RUN_TEST(stack_2_plainbuffer)
+
+    MU_RUN_TEARDOWN(concatenate_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("CONCATENATE")
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+/* A slowly varying series with some uniform chunks */
+static double series(int64_t index, int64_t chunk) {
+    return chunk % 5 == 3 ? -1 : (double) (index % 97) + (double) chunk / 8;
+}
+
+static char* test_delta(caterva_context_t *ctx, uint8_t ndim, int64_t *shape, int32_t *chunkshape,
+                        int32_t *blockshape, int8_t delta_axis, int32_t keyframe_interval,
+                        caterva_predictor_t predictor, bool append, bool enforceframe) {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = enforceframe;
+    storage.properties.blosc.predictor = predictor;
+    storage.properties.blosc.delta_axis = delta_axis;
+    storage.properties.blosc.keyframe_interval = keyframe_interval;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    size_t buffersize = (size_t) nitems * sizeof(double);
+    double *buffer = malloc(buffersize);
+    caterva_array_t *src;
+    if (append) {
+        MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &src));
+        double *chunk = malloc((size_t) src->chunknitems * sizeof(double));
+        for (int64_t n = 0; !src->filled; ++n) {
+            for (int64_t i = 0; i < src->next_chunknitems; ++i) {
+                chunk[i] = series(i, n);
+            }
+            MU_ASSERT_CATERVA(caterva_array_append(ctx, src, chunk,
+                                                   src->next_chunknitems * sizeof(double)));
+        }
+        free(chunk);
+        MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, src, buffer, buffersize));
+    } else {
+        for (int64_t i = 0; i < nitems; ++i) {
+            buffer[i] = series(i % 1000, i / 1000);
+        }
+        MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                    &src));
+    }
+
+    /* The deltas are kept in the metalayer, and the array is decoded without any cache */
+    caterva_array_t *array = src;
+    if (enforceframe) {
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, src->sc->frame->sdata,
+                                                    src->sc->frame->len, true, &array));
+        MU_ASSERT("The deltas are lost", array->keyframe_interval == keyframe_interval &&
+                  array->delta_axis == delta_axis);
+    }
+
+    double *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    /* Random access to a slice in the middle */
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t slice_shape[CATERVA_MAX_DIM];
+    int64_t slice_nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = shape[i] / 2;
+        stop[i] = shape[i] / 2 + 1 + shape[i] / 5;
+        slice_shape[i] = stop[i] - start[i];
+        slice_nitems *= slice_shape[i];
+    }
+    caterva_array_t *fresh;
+    if (enforceframe) {
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, src->sc->frame->sdata,
+                                                    src->sc->frame->len, true, &fresh));
+    } else {
+        fresh = array;
+    }
+    double *slice = malloc((size_t) slice_nitems * sizeof(double));
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, fresh, start, stop, slice_shape, slice,
+                                                     slice_nitems * (int64_t) sizeof(double)));
+    for (int64_t n = 0; n < slice_nitems; ++n) {
+        int64_t index = 0;
+        int64_t r = n;
+        int64_t stride = 1;
+        for (int i = ndim - 1; i >= 0; --i) {
+            index += (start[i] + r % slice_shape[i]) * stride;
+            r /= slice_shape[i];
+            stride *= shape[i];
+        }
+        MU_ASSERT("Wrong slice", slice[n] == buffer[index]);
+    }
+
+    /* Rechunking into (and out of) deltas */
+    caterva_array_t *rechunked;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = blockshape[i];
+    }
+    storage.properties.blosc.enforceframe = false;
+    MU_ASSERT_CATERVA(caterva_array_rechunk(ctx, array, &storage, 0, &rechunked));
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, rechunked, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    free(buffer);
+    free(buffer_dest);
+    free(slice);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &rechunked));
+    if (fresh != array) {
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &fresh));
+    }
+    if (array != src) {
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    }
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* delta_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* delta_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* delta_1_append() {
+    int64_t shape[] = {200, 50};
+    int32_t chunkshape[] = {10, 50};
+    int32_t blockshape[] = {5, 25};
+
+    return test_delta(ctx, 2, shape, chunkshape, blockshape, 0, 4, CATERVA_PREDICTOR_NONE, true,
+                      false);
+}
+
+static char* delta_2_append_frame() {
+    int64_t shape[] = {120, 33};
+    int32_t chunkshape[] = {10, 11};
+    int32_t blockshape[] = {5, 11};
+
+    return test_delta(ctx, 2, shape, chunkshape, blockshape, 0, 5, CATERVA_PREDICTOR_FLOAT, true,
+                      true);
+}
+
+static char* delta_3_axis1() {
+    int64_t shape[] = {20, 35, 30};
+    int32_t chunkshape[] = {10, 4, 15};
+    int32_t blockshape[] = {5, 2, 15};
+
+    return test_delta(ctx, 3, shape, chunkshape, blockshape, 1, 3, CATERVA_PREDICTOR_NONE, false,
+                      false);
+}
+
+static char* delta_4_frame() {
+    int64_t shape[] = {100, 10};
+    int32_t chunkshape[] = {3, 10};
+    int32_t blockshape[] = {3, 5};
+
+    return test_delta(ctx, 2, shape, chunkshape, blockshape, 0, 1000, CATERVA_PREDICTOR_FLOAT,
+                      false, true);
+}
+
+static char* delta_repeated() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 16;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.keyframe_interval = 10;
+    storage.properties.blosc.chunkshape[0] = 4;
+    storage.properties.blosc.chunkshape[1] = 16;
+    storage.properties.blosc.blockshape[0] = 2;
+    storage.properties.blosc.blockshape[1] = 16;
+
+    /* The chunks repeat, so all but the keyframes are stored as zeros */
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    int32_t chunk[4 * 16];
+    for (int i = 0; i < 4 * 16; ++i) {
+        chunk[i] = i * i;
+    }
+    while (!array->filled) {
+        MU_ASSERT_CATERVA(caterva_array_append(ctx, array, chunk, sizeof(chunk)));
+    }
+    int32_t stored[4 * 16];
+    for (int nchunk = 0; nchunk < 10; ++nchunk) {
+        MU_ASSERT("Blosc error", blosc2_schunk_decompress_chunk(array->sc, nchunk, stored,
+                                                                sizeof(stored)) >= 0);
+        MU_ASSERT("Wrong delta", (stored[5] == 0) == (nchunk != 0));
+    }
+
+    MU_ASSERT("A chunk set in an array of deltas",
+              caterva_array_set_chunk(ctx, array, 3, chunk, sizeof(chunk)) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+
+    storage.properties.blosc.delta_axis = 2;
+    MU_ASSERT("A delta axis out of the array",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    return 0;
+}
+
+static char* delta_rechunk_repeated() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 2;
+    params.shape[0] = 8;
+    params.shape[1] = 16;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 4;
+    storage.properties.blosc.chunkshape[1] = 16;
+    storage.properties.blosc.blockshape[0] = 2;
+    storage.properties.blosc.blockshape[1] = 8;
+
+    /* All the rows are equal, so every delta is all zeros (but it is not a uniform chunk) */
+    double buffer[8 * 16];
+    for (int i = 0; i < 8 * 16; ++i) {
+        buffer[i] = (double) (i % 16);
+    }
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, sizeof(buffer), &params, &storage,
+                                                &src));
+
+    storage.properties.blosc.keyframe_interval = 8;
+    storage.properties.blosc.delta_axis = 0;
+    storage.properties.blosc.chunkshape[0] = 1;
+    storage.properties.blosc.blockshape[0] = 1;
+    caterva_array_t *rechunked;
+    MU_ASSERT_CATERVA(caterva_array_rechunk(ctx, src, &storage, 0, &rechunked));
+
+    /* The array is decoded without any cache */
+    uint8_t *sframe;
+    int64_t len;
+    bool needs_free;
+    MU_ASSERT_CATERVA(caterva_array_to_sframe(ctx, rechunked, &sframe, &len, &needs_free));
+    caterva_array_t *loaded;
+    MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, sframe, len, true, &loaded));
+    if (needs_free) {
+        free(sframe);
+    }
+    double buffer_dest[8 * 16];
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, loaded, buffer_dest, sizeof(buffer_dest)));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, sizeof(buffer));
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &loaded));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &rechunked));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(delta_setup)
+
+    MU_RUN_TEST(delta_1_append)
+    MU_RUN_TEST(delta_2_append_frame)
+    MU_RUN_TEST(delta_3_axis1)
+    MU_RUN_TEST(delta_4_frame)
+    MU_RUN_TEST(delta_repeated)
+    MU_RUN_TEST(delta_rechunk_repeated)
+
+    MU_RUN_TEARDOWN(delta_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("DELTA")
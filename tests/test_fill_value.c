@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static char* fill_value_huge() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.stats = true;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    /* 8 TB of doubles */
+    double fill_value = 3.25;
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 2;
+    params.shape[0] = 1 << 20;
+    params.shape[1] = 1 << 20;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 1024;
+    storage.properties.blosc.chunkshape[1] = 1024;
+    storage.properties.blosc.blockshape[0] = 256;
+    storage.properties.blosc.blockshape[1] = 256;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &array));
+    MU_ASSERT("The array is not filled", array->filled);
+    MU_ASSERT("Chunks stored for a fill value", array->sc->nchunks == 0);
+
+    /* A slice spanning a few chunks */
+    int64_t start[] = {5000, 700000};
+    int64_t stop[] = {5010, 702050};
+    int64_t shape[] = {10, 2050};
+    size_t slicesize = 10 * 2050 * sizeof(double);
+    double *slice = malloc(slicesize);
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, start, stop, shape, slice,
+                                                     slicesize));
+    for (int i = 0; i < 10 * 2050; ++i) {
+        MU_ASSERT("Wrong fill value", slice[i] == fill_value);
+    }
+
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, false));
+    MU_ASSERT("Chunks decompressed for a fill value", stats.nchunks_decompressed == 0);
+    MU_ASSERT("Bytes read for a fill value", stats.bytes_read == 0);
+    MU_ASSERT("Wrong number of uniform reads", stats.nchunks_uniform_read == 3);
+
+    free(slice);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+static char* fill_value_uniform_chunks() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.stats = true;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int64_t);
+    params.ndim = 2;
+    params.shape[0] = 100;
+    params.shape[1] = 80;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 30;
+    storage.properties.blosc.chunkshape[1] = 40;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 20;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+
+    /* The even chunks are uniform */
+    int64_t chunk[30 * 40];
+    int64_t nuniform = 0;
+    for (int64_t n = 0; !array->filled; ++n) {
+        for (int64_t i = 0; i < array->next_chunknitems; ++i) {
+            chunk[i] = n % 2 == 0 ? n : n * 1000 + i;
+        }
+        nuniform += n % 2 == 0;
+        MU_ASSERT_CATERVA(caterva_array_append(ctx, array, chunk,
+                                               array->next_chunknitems * sizeof(int64_t)));
+    }
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("Wrong number of uniform chunks", stats.nchunks_uniform_written == nuniform);
+
+    /* The uniform chunks have the size of a whole chunk, but they only hold their value */
+    for (int64_t n = 0; n < array->sc->nchunks; n += 2) {
+        uint8_t *cchunk;
+        bool needs_free;
+        MU_ASSERT("Error getting a chunk",
+                  blosc2_schunk_get_chunk(array->sc, (int) n, &cchunk, &needs_free) >= 0);
+        size_t nbytes, cbytes, blocksize;
+        blosc_cbuffer_sizes(cchunk, &nbytes, &cbytes, &blocksize);
+        if (needs_free) {
+            free(cchunk);
+        }
+        MU_ASSERT("Wrong size of a uniform chunk",
+                  (int64_t) nbytes == array->extchunknitems * array->itemsize);
+        MU_ASSERT("A uniform chunk holds more than its value",
+                  cbytes <= BLOSC_EXTENDED_HEADER_LENGTH + sizeof(int64_t));
+    }
+
+    int64_t buffer[100 * 80];
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer, sizeof(buffer)));
+    for (int64_t r = 0; r < 100; ++r) {
+        for (int64_t c = 0; c < 80; ++c) {
+            int64_t n = (r / 30) * 2 + c / 40;
+            int64_t i = (r % 30) * 40 + c % 40;
+            int64_t expected = n % 2 == 0 ? n : n * 1000 + i;
+            MU_ASSERT("Wrong value", buffer[r * 80 + c] == expected);
+        }
+    }
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("Wrong number of uniform reads", stats.nchunks_uniform_read == nuniform);
+    MU_ASSERT("Wrong number of chunks decompressed",
+              stats.nchunks_decompressed == array->nchunks - nuniform);
+
+    /* The uniform chunks are broadcast when rechunking too */
+    storage.properties.blosc.chunkshape[0] = 25;
+    storage.properties.blosc.chunkshape[1] = 80;
+    caterva_array_t *rechunked;
+    MU_ASSERT_CATERVA(caterva_array_rechunk(ctx, array, &storage, 0, &rechunked));
+    int64_t buffer2[100 * 80];
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, rechunked, buffer2, sizeof(buffer2)));
+    MU_ASSERT_BUFFER(buffer, buffer2, sizeof(buffer));
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &rechunked));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+static char* fill_value_sframe() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    uint16_t fill_value = 0xbeef;
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(uint16_t);
+    params.ndim = 3;
+    params.shape[0] = 40;
+    params.shape[1] = 31;
+    params.shape[2] = 17;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = true;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 16;
+    storage.properties.blosc.chunkshape[2] = 9;
+    storage.properties.blosc.blockshape[0] = 5;
+    storage.properties.blosc.blockshape[1] = 8;
+    storage.properties.blosc.blockshape[2] = 9;
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &src));
+
+    /* The fill value is kept in the metalayer */
+    caterva_array_t *dest;
+    MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, src->sc->frame->sdata, src->sc->frame->len,
+                                                true, &dest));
+    MU_ASSERT("The fill value is lost", dest->fill_value != NULL);
+    MU_ASSERT("The array is not filled", dest->filled);
+
+    size_t buffersize = 40 * 31 * 17 * sizeof(uint16_t);
+    uint16_t *buffer = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer, buffersize));
+    for (int i = 0; i < 40 * 31 * 17; ++i) {
+        MU_ASSERT("Wrong fill value", buffer[i] == fill_value);
+    }
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+static char* fill_value_plainbuffer() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    float fill_value = -1.5f;
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(float);
+    params.ndim = 2;
+    params.shape[0] = 70;
+    params.shape[1] = 33;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_PLAINBUFFER;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &array));
+    MU_ASSERT("The array is not filled", array->filled);
+
+    float buffer[70 * 33];
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer, sizeof(buffer)));
+    for (int i = 0; i < 70 * 33; ++i) {
+        MU_ASSERT("Wrong fill value", buffer[i] == fill_value);
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_TEST(fill_value_huge)
+    MU_RUN_TEST(fill_value_uniform_chunks)
+    MU_RUN_TEST(fill_value_sframe)
+    MU_RUN_TEST(fill_value_plainbuffer)
+
+    return 0;
+}
+
+MU_RUN_SUITE("FILL VALUE")
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+/* A label array: runs of equal labels, with a few rare ones */
+static int64_t label(int64_t i) {
+    return i % 997 == 0 ? 1000 + i / 997 : (i / 23) % 40;
+}
+
+static char* check_find(caterva_context_t *ctx, caterva_array_t *array, const uint8_t *buffer,
+                        const void *value) {
+    int32_t itemsize = array->itemsize;
+    int64_t *indexes;
+    int64_t nindexes;
+    MU_ASSERT_CATERVA(caterva_array_find_equal(ctx, array, value, &indexes, &nindexes));
+    int64_t n = 0;
+    for (int64_t i = 0; i < array->nitems; ++i) {
+        if (memcmp(buffer + i * itemsize, value, (size_t) itemsize) == 0) {
+            MU_ASSERT("An item is not found", n < nindexes && indexes[n] == i);
+            n++;
+        }
+    }
+    MU_ASSERT("Too many items are found", n == nindexes);
+    free(indexes);
+    return 0;
+}
+
+static char* test_find_equal(caterva_context_t *ctx, int32_t itemsize, int8_t ndim,
+                             int64_t *shape, int32_t *chunkshape, int32_t *blockshape) {
+    caterva_params_t params = {0};
+    params.itemsize = (uint8_t) itemsize;
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.bloom_index = true;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    size_t buffersize = (size_t) (nitems * itemsize);
+    uint8_t *buffer = malloc(buffersize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        if (itemsize == 8) {
+            ((int64_t *) buffer)[i] = label(i);
+        } else {
+            ((int32_t *) buffer)[i] = (int32_t) label(i);
+        }
+    }
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                &array));
+    /* A frequent label, a rare one and a missing one */
+    int64_t values[] = {7, 1003, 12345};
+    uint8_t value[8];
+    for (int v = 0; v < 3; ++v) {
+        if (itemsize == 8) {
+            memcpy(value, &values[v], sizeof(int64_t));
+        } else {
+            int32_t value32 = (int32_t) values[v];
+            memcpy(value, &value32, sizeof(int32_t));
+        }
+        char *msg = check_find(ctx, array, buffer, value);
+        if (msg != 0) {
+            return msg;
+        }
+    }
+
+    /* Appending the chunks builds the same filters */
+    caterva_array_t *copy;
+    MU_ASSERT_CATERVA(caterva_array_copy(ctx, array, &storage, &copy));
+    int64_t nfilters = array->extnitems / array->blocknitems;
+    int64_t filtersize = (array->blocknitems * array->bloom_bits + 7) / 8;
+    MU_ASSERT_BUFFER(array->blooms, copy->blooms, nfilters * filtersize);
+
+    /* The filters travel with the frame */
+    uint8_t *sframe;
+    int64_t len;
+    bool needs_free;
+    MU_ASSERT_CATERVA(caterva_array_to_sframe(ctx, copy, &sframe, &len, &needs_free));
+    caterva_array_t *loaded;
+    MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, sframe, len, true, &loaded));
+    MU_ASSERT("The filters are not loaded", loaded->blooms != NULL);
+    MU_ASSERT_BUFFER(array->blooms, loaded->blooms, nfilters * filtersize);
+    char *msg = check_find(ctx, loaded, buffer, value);
+    if (msg != 0) {
+        return msg;
+    }
+    /* The lookups leave the filters as they were loaded, so they are not written again */
+    MU_ASSERT("The filters are changed by the lookups", !loaded->indexes_dirty);
+    if (needs_free) {
+        free(sframe);
+    }
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &loaded));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &copy));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* find_equal_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.stats = true;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* find_equal_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* find_equal_1_int32() {
+    int64_t shape[] = {100, 75};
+    int32_t chunkshape[] = {20, 16};
+    int32_t blockshape[] = {10, 8};
+
+    return test_find_equal(ctx, 4, 2, shape, chunkshape, blockshape);
+}
+
+static char* find_equal_2_int64() {
+    int64_t shape[] = {21, 30, 17};
+    int32_t chunkshape[] = {8, 8, 8};
+    int32_t blockshape[] = {4, 3, 2};
+
+    return test_find_equal(ctx, 8, 3, shape, chunkshape, blockshape);
+}
+
+static char* find_equal_3_int32() {
+    int64_t shape[] = {10001};
+    int32_t chunkshape[] = {1000};
+    int32_t blockshape[] = {100};
+
+    return test_find_equal(ctx, 4, 1, shape, chunkshape, blockshape);
+}
+
+static char* find_equal_masked_blocks() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 1;
+    params.shape[0] = 100000;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.bloom_index = true;
+    storage.properties.blosc.chunkshape[0] = 10000;
+    storage.properties.blosc.blockshape[0] = 1000;
+
+    int32_t *buffer = malloc(100000 * sizeof(int32_t));
+    for (int i = 0; i < 100000; ++i) {
+        buffer[i] = i;
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, 100000 * sizeof(int32_t), &params,
+                                                &storage, &array));
+
+    /* Only the block holding the value is decompressed (the filters rule out the others) */
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    int32_t value = 54321;
+    int64_t *indexes;
+    int64_t nindexes;
+    MU_ASSERT_CATERVA(caterva_array_find_equal(ctx, array, &value, &indexes, &nindexes));
+    MU_ASSERT("The item is not found", nindexes == 1 && indexes[0] == 54321);
+    free(indexes);
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("Too many blocks are decompressed", stats.nblocks_decompressed <= 5);
+
+    value = -1;
+    MU_ASSERT_CATERVA(caterva_array_find_equal(ctx, array, &value, &indexes, &nindexes));
+    MU_ASSERT("A missing item is found", nindexes == 0);
+    free(indexes);
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("Too many blocks are decompressed", stats.nblocks_decompressed <= 4);
+
+    /* Without filters every block is read */
+    caterva_array_t *plain;
+    storage.properties.blosc.bloom_index = false;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, 100000 * sizeof(int32_t), &params,
+                                                &storage, &plain));
+    value = 54321;
+    MU_ASSERT_CATERVA(caterva_array_find_equal(ctx, plain, &value, &indexes, &nindexes));
+    MU_ASSERT("The item is not found", nindexes == 1 && indexes[0] == 54321);
+    free(indexes);
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &plain));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* find_equal_fill_value() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 2;
+    params.shape[0] = 50;
+    params.shape[1] = 50;
+    int32_t fill_value = 3;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.bloom_index = true;
+    storage.properties.blosc.bloom_bits = 16;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &array));
+    int64_t *indexes;
+    int64_t nindexes;
+    MU_ASSERT_CATERVA(caterva_array_find_equal(ctx, array, &fill_value, &indexes, &nindexes));
+    MU_ASSERT("The fill value is not found", nindexes == 50 * 50 && indexes[2499] == 2499);
+    free(indexes);
+
+    /* Setting a chunk updates its filters */
+    int32_t chunk[20 * 20];
+    for (int i = 0; i < 20 * 20; ++i) {
+        chunk[i] = i;
+    }
+    MU_ASSERT_CATERVA(caterva_array_set_chunk(ctx, array, 0, chunk, sizeof(chunk)));
+    int32_t value = 21;
+    MU_ASSERT_CATERVA(caterva_array_find_equal(ctx, array, &value, &indexes, &nindexes));
+    MU_ASSERT("The item set is not found", nindexes == 1 && indexes[0] == 1 * 50 + 1);
+    free(indexes);
+    MU_ASSERT_CATERVA(caterva_array_find_equal(ctx, array, &fill_value, &indexes, &nindexes));
+    MU_ASSERT("The fill value is not found", nindexes == 50 * 50 - 20 * 20 + 1);
+    free(indexes);
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* find_equal_rechunk_concatenate() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 40;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.bloom_index = true;
+    storage.properties.blosc.chunkshape[0] = 10;
+    storage.properties.blosc.chunkshape[1] = 10;
+    storage.properties.blosc.blockshape[0] = 5;
+    storage.properties.blosc.blockshape[1] = 5;
+
+    /* The first rows make uniform chunks */
+    int32_t buffer[2 * 40 * 40];
+    for (int i = 0; i < 40 * 40; ++i) {
+        buffer[i] = i < 20 * 40 ? 5 : (int32_t) label(i);
+        buffer[40 * 40 + i] = buffer[i];
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, 40 * 40 * sizeof(int32_t), &params,
+                                                &storage, &array));
+    int32_t values[] = {5, 7, 1001, 12345};
+
+    /* The rechunked chunks get the filters of the chunks built out of the buffer */
+    caterva_storage_t rstorage = storage;
+    rstorage.properties.blosc.chunkshape[0] = 20;
+    rstorage.properties.blosc.chunkshape[1] = 8;
+    rstorage.properties.blosc.blockshape[0] = 10;
+    rstorage.properties.blosc.blockshape[1] = 4;
+    caterva_array_t *rechunked;
+    MU_ASSERT_CATERVA(caterva_array_rechunk(ctx, array, &rstorage, 0, &rechunked));
+    caterva_array_t *expected;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, 40 * 40 * sizeof(int32_t), &params,
+                                                &rstorage, &expected));
+    int64_t nfilters = expected->extnitems / expected->blocknitems;
+    int64_t filtersize = (expected->blocknitems * expected->bloom_bits + 7) / 8;
+    MU_ASSERT_BUFFER(expected->blooms, rechunked->blooms, nfilters * filtersize);
+    for (int v = 0; v < 4; ++v) {
+        char *msg = check_find(ctx, rechunked, (uint8_t *) buffer, &values[v]);
+        if (msg != 0) {
+            return msg;
+        }
+    }
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &expected));
+
+    /* So do the chunks passed through when concatenating */
+    caterva_array_t *arrays[2] = {array, array};
+    caterva_array_t *joined;
+    MU_ASSERT_CATERVA(caterva_array_concatenate(ctx, arrays, 2, 0, &storage, &joined));
+    params.shape[0] = 80;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, sizeof(buffer), &params, &storage,
+                                                &expected));
+    nfilters = expected->extnitems / expected->blocknitems;
+    filtersize = (expected->blocknitems * expected->bloom_bits + 7) / 8;
+    MU_ASSERT_BUFFER(expected->blooms, joined->blooms, nfilters * filtersize);
+    for (int v = 0; v < 4; ++v) {
+        char *msg = check_find(ctx, joined, (uint8_t *) buffer, &values[v]);
+        if (msg != 0) {
+            return msg;
+        }
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &expected));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &joined));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &rechunked));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* find_equal_errors() {
+    caterva_params_t params = {0};
+    params.itemsize = 16;
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 40;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.bloom_index = true;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT("The filters of 16-byte items",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    params.itemsize = 4;
+    storage.properties.blosc.bloom_bits = CATERVA_BLOOM_BITS_MAX + 1;
+    MU_ASSERT("Too many bits per item",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+
+    /* An array being appended cannot be looked up */
+    storage.properties.blosc.bloom_bits = 0;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    int32_t value = 0;
+    int64_t *indexes;
+    int64_t nindexes;
+    MU_ASSERT("A lookup in an array without data",
+              caterva_array_find_equal(ctx, array, &value, &indexes, &nindexes) !=
+                  CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(find_equal_setup)
+
+    MU_RUN_TEST(find_equal_1_int32)
+    MU_RUN_TEST(find_equal_2_int64)
+    MU_RUN_TEST(find_equal_3_int32)
+    MU_RUN_TEST(find_equal_masked_blocks)
+    MU_RUN_TEST(find_equal_fill_value)
+    MU_RUN_TEST(find_equal_rechunk_concatenate)
+    MU_RUN_TEST(find_equal_errors)
+
+    MU_RUN_TEARDOWN(find_equal_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("FIND EQUAL")
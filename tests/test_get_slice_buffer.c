@@ -441,6 +441,94 @@ static char* get_slice_buffer_8_float_blosc() {
                    start, stop, destshape, result);
 }
 
+static char* get_slice_buffer_3_uint16_plainbuffer_contiguous() {
+    int64_t start[] = {2, 0, 0};
+    int64_t stop[] = {4, 4, 5};
+
+    uint16_t result[1024] = {40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59,
+                             60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79};
+
+    uint8_t itemsize = sizeof(uint16_t);
+    uint8_t ndim = 3;
+    int64_t shape[] = {6, 4, 5};
+
+    caterva_storage_backend_t backend = CATERVA_STORAGE_PLAINBUFFER;
+    int32_t chunkshape[] = {0};
+    int32_t blockshape[] = {0};
+    bool enforceframe = false;
+    char *filename = NULL;
+
+    int64_t destshape[] = {0, 0, 0};
+    for (int i = 0; i < ndim; ++i) {
+        destshape[i] = stop[i] - start[i];
+    }
+
+    return test_get_slice(ctx, ndim, itemsize, shape, backend, chunkshape, blockshape, enforceframe, filename,
+                   start, stop, destshape, result);
+}
+
+static char* get_slice_buffer_4_double_plainbuffer_threads() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 4;
+    caterva_context_t *tctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &tctx));
+
+    uint8_t itemsize = sizeof(double);
+    uint8_t ndim = 4;
+    int64_t shape[] = {40, 30, 40, 40};
+    /* A single contiguous run and a set of coalesced rows, both large enough for threads */
+    int64_t starts[2][4] = {{5, 0, 0, 0}, {1, 2, 0, 0}};
+    int64_t stops[2][4] = {{35, 30, 40, 40}, {39, 28, 40, 40}};
+
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_PLAINBUFFER;
+
+    double *buffer = malloc((size_t) nitems * itemsize);
+    MU_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, (size_t) nitems));
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(tctx, buffer, nitems * itemsize, &params, &storage,
+                                                &src));
+
+    double *destbuffer = malloc((size_t) nitems * itemsize);
+    for (int k = 0; k < 2; ++k) {
+        int64_t *start = starts[k];
+        int64_t *stop = stops[k];
+        int64_t destshape[4];
+        int64_t destnitems = 1;
+        for (int i = 0; i < ndim; ++i) {
+            destshape[i] = stop[i] - start[i];
+            destnitems *= destshape[i];
+        }
+        MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(tctx, src, start, stop, destshape,
+                                                         destbuffer, destnitems * itemsize));
+        int64_t n = 0;
+        for (int64_t i0 = start[0]; i0 < stop[0]; ++i0) {
+            for (int64_t i1 = start[1]; i1 < stop[1]; ++i1) {
+                for (int64_t i2 = start[2]; i2 < stop[2]; ++i2) {
+                    for (int64_t i3 = start[3]; i3 < stop[3]; ++i3) {
+                        int64_t index = ((i0 * shape[1] + i1) * shape[2] + i2) * shape[3] + i3;
+                        MU_ASSERT("Slice copied incorrectly", destbuffer[n++] == (double) index);
+                    }
+                }
+            }
+        }
+    }
+
+    free(buffer);
+    free(destbuffer);
+    MU_ASSERT_CATERVA(caterva_array_free(tctx, &src));
+    MU_ASSERT_CATERVA(caterva_context_free(&tctx));
+    return 0;
+}
+
 static char* all_tests() {
     MU_RUN_SETUP(get_slice_buffer_setup)
 
@@ -451,7 +539,9 @@ static char* all_tests() {
     MU_RUN_TEST(get_slice_buffer_3_double_blosc)
     MU_RUN_TEST(get_slice_buffer_3_float_blosc)
     MU_RUN_TEST(get_slice_buffer_3_float_plainbuffer)
+    MU_RUN_TEST(get_slice_buffer_3_uint16_plainbuffer_contiguous)
     MU_RUN_TEST(get_slice_buffer_4_float_blosc)
+    MU_RUN_TEST(get_slice_buffer_4_double_plainbuffer_threads)
     MU_RUN_TEST(get_slice_buffer_5_double_plainbuffer)
     MU_RUN_TEST(get_slice_buffer_6_double_blosc)
     MU_RUN_TEST(get_slice_buffer_7_float_plainbuffer)
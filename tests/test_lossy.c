@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <float.h>
+#include <math.h>
+
+#include "test_common.h"
+
+/* A smooth field spanning a few orders of magnitude (with negative values) */
+static double field(int64_t i) {
+    double x = (double) (i % 997) / 997;
+    return (1 - 2 * x + 7 * x * x * x) * (double) (1 + i % 5) * 123.456;
+}
+
+static double error_of(double value, double expected, caterva_lossy_mode_t mode) {
+    double error = value > expected ? value - expected : expected - value;
+    if (mode == CATERVA_LOSSY_RELATIVE && expected != 0) {
+        error /= expected > 0 ? expected : -expected;
+    }
+    return error;
+}
+
+static char* test_lossy(caterva_context_t *ctx, caterva_lossy_mode_t mode, double tolerance,
+                        int32_t itemsize, uint8_t ndim, int64_t *shape, int32_t *chunkshape,
+                        int32_t *blockshape, bool enforceframe) {
+    caterva_params_t params = {0};
+    params.itemsize = (uint8_t) itemsize;
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = enforceframe;
+    storage.properties.blosc.lossy_mode = mode;
+    storage.properties.blosc.lossy_tolerance = tolerance;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    size_t buffersize = (size_t) (nitems * itemsize);
+    uint8_t *buffer = malloc(buffersize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        if (itemsize == 4) {
+            ((float *) buffer)[i] = (float) field(i);
+        } else {
+            ((double *) buffer)[i] = field(i);
+        }
+    }
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                &src));
+
+    /* The error bound is kept in its own metalayer */
+    caterva_array_t *array = src;
+    if (enforceframe) {
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, src->sc->frame->sdata,
+                                                    src->sc->frame->len, true, &array));
+        MU_ASSERT("The lossy mode is lost", array->lossy_mode == mode);
+        MU_ASSERT("The tolerance is lost", array->lossy_tolerance == tolerance);
+    }
+
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer_dest, buffersize));
+    bool lossy = false;
+    for (int64_t i = 0; i < nitems; ++i) {
+        double value = itemsize == 4 ? ((float *) buffer_dest)[i] : ((double *) buffer_dest)[i];
+        double expected = itemsize == 4 ? ((float *) buffer)[i] : ((double *) buffer)[i];
+        MU_ASSERT("The error bound is exceeded", error_of(value, expected, mode) <= tolerance);
+        lossy |= value != expected;
+    }
+    MU_ASSERT("The items are not rounded", lossy);
+
+    /* The rounding is idempotent, so copying the array does not add up errors */
+    caterva_array_t *copy;
+    MU_ASSERT_CATERVA(caterva_array_copy(ctx, array, &storage, &copy));
+    uint8_t *buffer_copy = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, copy, buffer_copy, buffersize));
+    MU_ASSERT_BUFFER(buffer_dest, buffer_copy, buffersize);
+
+    free(buffer);
+    free(buffer_dest);
+    free(buffer_copy);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &copy));
+    if (array != src) {
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    }
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* lossy_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* lossy_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* lossy_1_relative_float64() {
+    int64_t shape[] = {100, 83};
+    int32_t chunkshape[] = {30, 40};
+    int32_t blockshape[] = {11, 20};
+
+    return test_lossy(ctx, CATERVA_LOSSY_RELATIVE, 1e-4, 8, 2, shape, chunkshape, blockshape,
+                      false);
+}
+
+static char* lossy_2_absolute_float64_frame() {
+    int64_t shape[] = {40, 37, 25};
+    int32_t chunkshape[] = {20, 20, 10};
+    int32_t blockshape[] = {10, 7, 5};
+
+    return test_lossy(ctx, CATERVA_LOSSY_ABSOLUTE, 1e-3, 8, 3, shape, chunkshape, blockshape,
+                      true);
+}
+
+static char* lossy_3_relative_float32_frame() {
+    int64_t shape[] = {1000};
+    int32_t chunkshape[] = {300};
+    int32_t blockshape[] = {64};
+
+    return test_lossy(ctx, CATERVA_LOSSY_RELATIVE, 1e-3, 4, 1, shape, chunkshape, blockshape,
+                      true);
+}
+
+static char* lossy_4_absolute_float32() {
+    int64_t shape[] = {50, 60};
+    int32_t chunkshape[] = {25, 30};
+    int32_t blockshape[] = {25, 15};
+
+    return test_lossy(ctx, CATERVA_LOSSY_ABSOLUTE, 0.05, 4, 2, shape, chunkshape, blockshape,
+                      false);
+}
+
+static char* lossy_precision() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(float);
+    params.ndim = 1;
+    params.shape[0] = 64;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.lossy_mode = CATERVA_LOSSY_PRECISION;
+    storage.properties.blosc.lossy_bits = 7;
+    storage.properties.blosc.chunkshape[0] = 64;
+    storage.properties.blosc.blockshape[0] = 16;
+
+    /* The special values are kept as they are */
+    float buffer[64];
+    for (int i = 0; i < 64; ++i) {
+        buffer[i] = (float) field(i);
+    }
+    buffer[3] = INFINITY;
+    buffer[4] = -INFINITY;
+    buffer[5] = NAN;
+    buffer[6] = 0;
+    buffer[7] = -0.f;
+    buffer[8] = FLT_MAX;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, sizeof(buffer), &params, &storage,
+                                                &array));
+
+    /* Only the 7 upper bits of the mantissas are stored */
+    uint32_t stored[64];
+    MU_ASSERT("Blosc error", blosc2_schunk_decompress_chunk(array->sc, 0, stored,
+                                                            sizeof(stored)) >= 0);
+    for (int i = 0; i < 64; ++i) {
+        if (i != 5) {
+            MU_ASSERT("The mantissa is not rounded", (stored[i] & ((1u << 16) - 1)) == 0);
+        }
+    }
+
+    float dest[64];
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, dest, sizeof(dest)));
+    MU_ASSERT("An infinity is lost", dest[3] == INFINITY && dest[4] == -INFINITY);
+    MU_ASSERT("A NaN is lost", isnan(dest[5]));
+    MU_ASSERT("A zero is lost", dest[6] == 0 && !signbit(dest[6]) && signbit(dest[7]));
+    MU_ASSERT("The largest float is rounded up to an infinity", !isinf(dest[8]));
+    for (int i = 9; i < 64; ++i) {
+        MU_ASSERT("The error bound is exceeded",
+                  error_of(dest[i], buffer[i], CATERVA_LOSSY_RELATIVE) <= 1. / 256);
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* lossy_errors() {
+    caterva_params_t params = {0};
+    params.itemsize = 2;
+    params.ndim = 1;
+    params.shape[0] = 100;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.lossy_mode = CATERVA_LOSSY_RELATIVE;
+    storage.properties.blosc.lossy_tolerance = 1e-3;
+    storage.properties.blosc.chunkshape[0] = 30;
+    storage.properties.blosc.blockshape[0] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT("A lossy mode for 2-byte items",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    params.itemsize = sizeof(double);
+    storage.properties.blosc.lossy_tolerance = 0;
+    MU_ASSERT("A zero tolerance",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    params.itemsize = sizeof(float);
+    storage.properties.blosc.lossy_mode = CATERVA_LOSSY_PRECISION;
+    storage.properties.blosc.lossy_bits = 24;
+    MU_ASSERT("More bits than a float mantissa",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(lossy_setup)
+
+    MU_RUN_TEST(lossy_1_relative_float64)
+    MU_RUN_TEST(lossy_2_absolute_float64_frame)
+    MU_RUN_TEST(lossy_3_relative_float32_frame)
+    MU_RUN_TEST(lossy_4_absolute_float32)
+    MU_RUN_TEST(lossy_precision)
+    MU_RUN_TEST(lossy_errors)
+
+    MU_RUN_TEARDOWN(lossy_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("LOSSY")
@@ -36,6 +36,7 @@ static char* test_persistency(caterva_context_t *ctx, uint8_t itemsize, uint8_t
     storage.backend = backend;
     switch (backend) {
         case CATERVA_STORAGE_PLAINBUFFER:
+            storage.properties.plainbuffer.filename = filename;
             break;
         case CATERVA_STORAGE_BLOSC:
             storage.properties.blosc.filename = filename;
@@ -71,11 +72,19 @@ static char* test_persistency(caterva_context_t *ctx, uint8_t itemsize, uint8_t
     /* Testing */
     MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
 
+    /* Reopen without copies */
+    caterva_array_t *view;
+    MU_ASSERT_CATERVA(caterva_array_from_file(ctx, filename, false, &view));
+    memset(buffer_dest, 0, buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, view, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
     /* Free mallocs */
     free(buffer);
     free(buffer_dest);
     MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
     MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &view));
     if (FILE_EXISTS(filename) != -1) {
         remove(filename);
     }
@@ -216,6 +225,32 @@ static  char* persistency_8_uint8() {
     return test_persistency(ctx, itemsize, ndim, shape, backend, chunkshape, blockshape, enforceframe, filename);
 }
 
+static  char* persistency_3_float_plainbuffer() {
+    uint8_t itemsize = sizeof(float);
+    uint8_t ndim = 3;
+    int64_t shape[] = {34, 56, 21};
+
+    caterva_storage_backend_t backend = CATERVA_STORAGE_PLAINBUFFER;
+    int32_t chunkshape[] = {0};
+    int32_t blockshape[] = {0};
+    bool enforceframe = false;
+
+    return test_persistency(ctx, itemsize, ndim, shape, backend, chunkshape, blockshape, enforceframe, filename);
+}
+
+static  char* persistency_6_uint16_plainbuffer() {
+    uint8_t itemsize = sizeof(uint16_t);
+    uint8_t ndim = 6;
+    int64_t shape[] = {4, 3, 8, 5, 10, 12};
+
+    caterva_storage_backend_t backend = CATERVA_STORAGE_PLAINBUFFER;
+    int32_t chunkshape[] = {0};
+    int32_t blockshape[] = {0};
+    bool enforceframe = false;
+
+    return test_persistency(ctx, itemsize, ndim, shape, backend, chunkshape, blockshape, enforceframe, filename);
+}
+
 static char* all_tests() {
     MU_RUN_SETUP(persistency_setup)
 
@@ -228,6 +263,8 @@ static char* all_tests() {
     MU_RUN_TEST(persistency_6_uint16)
     MU_RUN_TEST(persistency_7_uint64)
     MU_RUN_TEST(persistency_8_uint8)
+    MU_RUN_TEST(persistency_3_float_plainbuffer)
+    MU_RUN_TEST(persistency_6_uint16_plainbuffer)
 
     MU_RUN_TEARDOWN(persistency_teardown)
     return 0;
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+/* Read the region [start, start + rshape) into a buffer of shape bshape and check it */
+static char* check_region(caterva_context_t *ctx, caterva_array_t *array, const double *buffer,
+                          const int64_t *start, const int64_t *rshape, const int64_t *bshape) {
+    int8_t ndim = array->ndim;
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t bnitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        stop[i] = start[i] + rshape[i];
+        bnitems *= bshape[i];
+    }
+    double *region = malloc((size_t) bnitems * sizeof(double));
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, (int64_t *) start, stop,
+                                                     (int64_t *) bshape, region,
+                                                     bnitems * (int64_t) sizeof(double)));
+    for (int64_t n = 0; n < bnitems; ++n) {
+        int64_t rem = n;
+        int64_t index = 0;
+        int64_t stride = 1;
+        bool inside = true;
+        for (int i = ndim - 1; i >= 0; --i) {
+            int64_t k = rem % bshape[i];
+            inside = inside && k < rshape[i];
+            index += (start[i] + k) * stride;
+            rem /= bshape[i];
+            stride *= array->shape[i];
+        }
+        if (inside) {
+            MU_ASSERT("Wrong item in the region", region[n] == buffer[index]);
+        }
+    }
+    free(region);
+    return 0;
+}
+
+static char* test_point_read(caterva_context_t *ctx, caterva_predictor_t predictor, int8_t ndim,
+                             int64_t *shape, int32_t *chunkshape, int32_t *blockshape) {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.predictor = predictor;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    size_t buffersize = (size_t) nitems * sizeof(double);
+    double *buffer = malloc(buffersize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        buffer[i] = (double) (i % 1013);
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, (int64_t) buffersize, &params,
+                                                &storage, &array));
+
+    /* Every item on its own */
+    int64_t ones[CATERVA_MAX_DIM] = {1, 1, 1, 1, 1, 1, 1, 1};
+    for (int64_t n = 0; n < nitems; n += 7) {
+        int64_t start[CATERVA_MAX_DIM];
+        int64_t rem = n;
+        for (int i = ndim - 1; i >= 0; --i) {
+            start[i] = rem % shape[i];
+            rem /= shape[i];
+        }
+        char *msg = check_region(ctx, array, buffer, start, ones, ones);
+        if (msg != 0) {
+            return msg;
+        }
+    }
+
+    /* A region inside the last block of the first chunk, into a larger buffer */
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t rshape[CATERVA_MAX_DIM];
+    int64_t bshape[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = (chunkshape[i] - 1) / blockshape[i] * blockshape[i];
+        rshape[i] = chunkshape[i] - start[i] > 1 ? 2 : 1;
+        bshape[i] = rshape[i] + 1;
+    }
+    char *msg = check_region(ctx, array, buffer, start, rshape, bshape);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* The region and the last item of the array */
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = shape[i] - 1;
+    }
+    msg = check_region(ctx, array, buffer, start, ones, ones);
+    if (msg != 0) {
+        return msg;
+    }
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* point_read_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.stats = true;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* point_read_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* point_read_2() {
+    int64_t shape[] = {100, 75};
+    int32_t chunkshape[] = {20, 16};
+    int32_t blockshape[] = {10, 7};
+
+    return test_point_read(ctx, CATERVA_PREDICTOR_NONE, 2, shape, chunkshape, blockshape);
+}
+
+static char* point_read_3() {
+    int64_t shape[] = {21, 30, 17};
+    int32_t chunkshape[] = {8, 8, 8};
+    int32_t blockshape[] = {4, 3, 2};
+
+    return test_point_read(ctx, CATERVA_PREDICTOR_NONE, 3, shape, chunkshape, blockshape);
+}
+
+static char* point_read_3_predictor() {
+    int64_t shape[] = {21, 30, 17};
+    int32_t chunkshape[] = {8, 8, 8};
+    int32_t blockshape[] = {4, 3, 2};
+
+    return test_point_read(ctx, CATERVA_PREDICTOR_FLOAT, 3, shape, chunkshape, blockshape);
+}
+
+static char* point_read_decoded_items() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 2;
+    params.shape[0] = 100;
+    params.shape[1] = 100;
+    double fill_value = 2;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 50;
+    storage.properties.blosc.chunkshape[1] = 50;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &array));
+    double chunk[50 * 50];
+    for (int i = 0; i < 50 * 50; ++i) {
+        chunk[i] = (double) i;
+    }
+    MU_ASSERT_CATERVA(caterva_array_set_chunk(ctx, array, 1, chunk, sizeof(chunk)));
+    for (int i = 0; i < 50 * 50; ++i) {
+        chunk[i] = 5;
+    }
+    MU_ASSERT_CATERVA(caterva_array_set_chunk(ctx, array, 2, chunk, sizeof(chunk)));
+
+    /* A single item of a block is decoded */
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    int64_t start[] = {17, 73};
+    int64_t stop[] = {18, 74};
+    int64_t shape[] = {1, 1};
+    double item;
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, start, stop, shape, &item,
+                                                     sizeof(double)));
+    MU_ASSERT("Wrong item", item == 17 * 50 + 23);
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("A whole block is decoded",
+              stats.nblocks_decompressed == 1 && stats.bytes_decompressed == sizeof(double));
+
+    /* Only the items from the first to the last one of a region are decoded */
+    double region[2 * 3];
+    start[1] = 71;
+    stop[0] = 19;
+    stop[1] = 74;
+    shape[0] = 2;
+    shape[1] = 3;
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, start, stop, shape, region,
+                                                     sizeof(region)));
+    for (int i = 0; i < 2 * 3; ++i) {
+        MU_ASSERT("Wrong item in the region", region[i] == (17 + i / 3) * 50 + 21 + i % 3);
+    }
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("Too many items are decoded", stats.bytes_decompressed == 13 * sizeof(double));
+
+    /* The uniform chunks and the chunks not stored are not decoded at all */
+    start[0] = 60;
+    stop[0] = 61;
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, start, stop, shape, region,
+                                                     sizeof(region)));
+    MU_ASSERT("Wrong fill value", region[0] == fill_value && region[2] == fill_value);
+    start[1] = 21;
+    stop[1] = 24;
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, start, stop, shape, region,
+                                                     sizeof(region)));
+    MU_ASSERT("Wrong uniform value", region[0] == 5 && region[2] == 5);
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("A uniform chunk is decoded",
+              stats.nblocks_decompressed == 0 && stats.nchunks_uniform_read == 2);
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(point_read_setup)
+
+    MU_RUN_TEST(point_read_2)
+    MU_RUN_TEST(point_read_3)
+    MU_RUN_TEST(point_read_3_predictor)
+    MU_RUN_TEST(point_read_decoded_items)
+
+    MU_RUN_TEARDOWN(point_read_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("POINT READ")
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+/* Fill a buffer with a smooth field (with negative values) of the given type */
+static void fill_field(uint8_t *buffer, int64_t nitems, int32_t itemsize, bool floating) {
+    for (int64_t i = 0; i < nitems; ++i) {
+        double value = (double) (i % 500 - 250) * 4 - 3 * (double) (i % 7);
+        if (floating && itemsize == 4) {
+            ((float *) buffer)[i] = (float) value;
+        } else if (floating) {
+            ((double *) buffer)[i] = value / 3;
+        } else if (itemsize == 1) {
+            ((int8_t *) buffer)[i] = (int8_t) (value / 10);
+        } else if (itemsize == 2) {
+            ((int16_t *) buffer)[i] = (int16_t) value;
+        } else if (itemsize == 4) {
+            ((int32_t *) buffer)[i] = (int32_t) (value * 1000);
+        } else {
+            ((int64_t *) buffer)[i] = (int64_t) (value * 1e9);
+        }
+    }
+}
+
+static char* test_predictor(caterva_context_t *ctx, caterva_predictor_t predictor,
+                            int32_t itemsize, uint8_t ndim, int64_t *shape, int32_t *chunkshape,
+                            int32_t *blockshape, bool enforceframe) {
+    caterva_params_t params = {0};
+    params.itemsize = (uint8_t) itemsize;
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = enforceframe;
+    storage.properties.blosc.predictor = predictor;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    size_t buffersize = (size_t) (nitems * itemsize);
+    uint8_t *buffer = malloc(buffersize);
+    fill_field(buffer, nitems, itemsize, predictor == CATERVA_PREDICTOR_FLOAT);
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                &src));
+
+    /* The predictor is kept in the metalayer */
+    caterva_array_t *array = src;
+    if (enforceframe) {
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, src->sc->frame->sdata,
+                                                    src->sc->frame->len, true, &array));
+        MU_ASSERT("The predictor is lost", array->predictor == predictor);
+    }
+
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, array, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    /* A slice only decompresses (and unpredicts) some of the blocks */
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t slice_shape[CATERVA_MAX_DIM];
+    int64_t slice_nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = shape[i] / 3;
+        stop[i] = shape[i] / 3 + 1 + shape[i] / 4;
+        slice_shape[i] = stop[i] - start[i];
+        slice_nitems *= slice_shape[i];
+    }
+    uint8_t *slice = malloc((size_t) (slice_nitems * itemsize));
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, start, stop, slice_shape, slice,
+                                                     slice_nitems * itemsize));
+    for (int64_t n = 0; n < slice_nitems; ++n) {
+        int64_t index = 0;
+        int64_t r = n;
+        int64_t stride = 1;
+        for (int i = ndim - 1; i >= 0; --i) {
+            index += (start[i] + r % slice_shape[i]) * stride;
+            r /= slice_shape[i];
+            stride *= shape[i];
+        }
+        MU_ASSERT("Wrong slice", memcmp(slice + n * itemsize, buffer + index * itemsize,
+                                        (size_t) itemsize) == 0);
+    }
+
+    /* The appended chunks are predicted too */
+    caterva_array_t *copy;
+    MU_ASSERT_CATERVA(caterva_array_copy(ctx, array, &storage, &copy));
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, copy, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    free(buffer);
+    free(buffer_dest);
+    free(slice);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &copy));
+    if (array != src) {
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    }
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* predictor_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* predictor_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* predictor_1_float32() {
+    int64_t shape[] = {40, 37, 25};
+    int32_t chunkshape[] = {20, 20, 10};
+    int32_t blockshape[] = {10, 7, 5};
+
+    return test_predictor(ctx, CATERVA_PREDICTOR_FLOAT, 4, 3, shape, chunkshape, blockshape,
+                          false);
+}
+
+static char* predictor_2_float64_frame() {
+    int64_t shape[] = {100, 83};
+    int32_t chunkshape[] = {30, 40};
+    int32_t blockshape[] = {11, 20};
+
+    return test_predictor(ctx, CATERVA_PREDICTOR_FLOAT, 8, 2, shape, chunkshape, blockshape,
+                          true);
+}
+
+static char* predictor_3_int8() {
+    int64_t shape[] = {1000};
+    int32_t chunkshape[] = {300};
+    int32_t blockshape[] = {64};
+
+    return test_predictor(ctx, CATERVA_PREDICTOR_INT, 1, 1, shape, chunkshape, blockshape,
+                          false);
+}
+
+static char* predictor_4_int16_frame() {
+    int64_t shape[] = {13, 22, 31, 9};
+    int32_t chunkshape[] = {5, 10, 16, 9};
+    int32_t blockshape[] = {2, 5, 8, 3};
+
+    return test_predictor(ctx, CATERVA_PREDICTOR_INT, 2, 4, shape, chunkshape, blockshape,
+                          true);
+}
+
+static char* predictor_5_int32() {
+    int64_t shape[] = {50, 60};
+    int32_t chunkshape[] = {25, 30};
+    int32_t blockshape[] = {25, 30};
+
+    return test_predictor(ctx, CATERVA_PREDICTOR_INT, 4, 2, shape, chunkshape, blockshape,
+                          false);
+}
+
+static char* predictor_6_int64() {
+    int64_t shape[] = {20, 20, 20};
+    int32_t chunkshape[] = {10, 10, 10};
+    int32_t blockshape[] = {3, 4, 10};
+
+    return test_predictor(ctx, CATERVA_PREDICTOR_INT, 8, 3, shape, chunkshape, blockshape,
+                          false);
+}
+
+static char* predictor_residuals() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 2;
+    params.shape[0] = 8;
+    params.shape[1] = 8;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.predictor = CATERVA_PREDICTOR_INT;
+    storage.properties.blosc.chunkshape[0] = 8;
+    storage.properties.blosc.chunkshape[1] = 8;
+    storage.properties.blosc.blockshape[0] = 4;
+    storage.properties.blosc.blockshape[1] = 8;
+
+    /* A plane is predicted exactly, so only the first row and column of each block are kept */
+    int32_t buffer[8 * 8];
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            buffer[i * 8 + j] = 5 * i - 2 * j + 7;
+        }
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, sizeof(buffer), &params, &storage,
+                                                &array));
+    int32_t stored[8 * 8];
+    MU_ASSERT("Blosc error", blosc2_schunk_decompress_chunk(array->sc, 0, stored,
+                                                            sizeof(stored)) >= 0);
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            int32_t residual = i % 4 == 0 ? (j == 0 ? buffer[i * 8] : -2) : (j == 0 ? 5 : 0);
+            MU_ASSERT("Wrong residual", stored[i * 8 + j] == residual);
+        }
+    }
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* predictor_errors() {
+    caterva_params_t params = {0};
+    params.itemsize = 2;
+    params.ndim = 1;
+    params.shape[0] = 100;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.predictor = CATERVA_PREDICTOR_FLOAT;
+    storage.properties.blosc.chunkshape[0] = 30;
+    storage.properties.blosc.blockshape[0] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT("A float predictor for 2-byte items",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    params.itemsize = 3;
+    storage.properties.blosc.predictor = CATERVA_PREDICTOR_INT;
+    MU_ASSERT("An int predictor for 3-byte items",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(predictor_setup)
+
+    MU_RUN_TEST(predictor_1_float32)
+    MU_RUN_TEST(predictor_2_float64_frame)
+    MU_RUN_TEST(predictor_3_int8)
+    MU_RUN_TEST(predictor_4_int16_frame)
+    MU_RUN_TEST(predictor_5_int32)
+    MU_RUN_TEST(predictor_6_int64)
+    MU_RUN_TEST(predictor_residuals)
+    MU_RUN_TEST(predictor_errors)
+
+    MU_RUN_TEARDOWN(predictor_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("PREDICTOR")
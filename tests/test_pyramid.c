@@ -0,0 +1,536 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <math.h>
+
+#include "test_common.h"
+
+static double load(caterva_item_kind_t kind, int32_t itemsize, const uint8_t *item) {
+    if (kind == CATERVA_ITEM_FLOAT) {
+        return itemsize == 4 ? *(const float *) item : *(const double *) item;
+    }
+    if (kind == CATERVA_ITEM_INT) {
+        return itemsize == 4 ? *(const int32_t *) item : *(const int16_t *) item;
+    }
+    return itemsize == 4 ? *(const uint32_t *) item : *(const uint16_t *) item;
+}
+
+static void store(caterva_item_kind_t kind, int32_t itemsize, double value, uint8_t *item) {
+    if (kind != CATERVA_ITEM_FLOAT) {
+        value = value < 0 ? -(double) (int64_t) (0.5 - value) : (double) (int64_t) (value + 0.5);
+    }
+    if (kind == CATERVA_ITEM_FLOAT) {
+        if (itemsize == 4) {
+            *(float *) item = (float) value;
+        } else {
+            *(double *) item = value;
+        }
+    } else if (kind == CATERVA_ITEM_INT) {
+        if (itemsize == 4) {
+            *(int32_t *) item = (int32_t) value;
+        } else {
+            *(int16_t *) item = (int16_t) value;
+        }
+    } else if (itemsize == 4) {
+        *(uint32_t *) item = (uint32_t) value;
+    } else {
+        *(uint16_t *) item = (uint16_t) value;
+    }
+}
+
+/* The next level of a C buffer (each item reduces a window of 2 items per axis) */
+static int64_t reduce_level(uint8_t ndim, const int64_t *shape, const uint8_t *src,
+                            caterva_pyramid_reduce_t reduce, caterva_item_kind_t kind,
+                            int32_t itemsize, int64_t *dshape, uint8_t *dest) {
+    int64_t dnitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        dshape[i] = (shape[i] + 1) / 2;
+        dnitems *= dshape[i];
+    }
+    for (int64_t n = 0; n < dnitems; ++n) {
+        int64_t coords[CATERVA_MAX_DIM];
+        int64_t rem = n;
+        for (int i = ndim - 1; i >= 0; --i) {
+            coords[i] = rem % dshape[i] * 2;
+            rem /= dshape[i];
+        }
+        double sum = 0;
+        double best = -INFINITY;
+        int64_t count = 0;
+        int64_t first = -1;
+        for (int64_t w = 0; w < (1 << ndim); ++w) {
+            int64_t index = 0;
+            bool inside = true;
+            for (int i = 0; i < ndim; ++i) {
+                int64_t coord = coords[i] + (w >> (ndim - 1 - i) & 1);
+                inside = inside && coord < shape[i];
+                index = index * shape[i] + coord;
+            }
+            if (!inside) {
+                continue;
+            }
+            first = first < 0 ? index : first;
+            double value = load(kind, itemsize, src + index * itemsize);
+            sum += value;
+            best = value > best ? value : best;
+            count++;
+        }
+        uint8_t *item = dest + n * itemsize;
+        if (reduce == CATERVA_PYRAMID_NEAREST) {
+            memcpy(item, src + first * itemsize, (size_t) itemsize);
+        } else {
+            store(kind, itemsize, reduce == CATERVA_PYRAMID_MAX ? best : sum / (double) count,
+                  item);
+        }
+    }
+    return dnitems;
+}
+
+static char* check_levels(caterva_context_t *ctx, caterva_array_t *array, const uint8_t *buffer,
+                          caterva_pyramid_reduce_t reduce, caterva_item_kind_t kind) {
+    int32_t itemsize = array->itemsize;
+    int64_t shape[CATERVA_MAX_DIM];
+    for (int i = 0; i < array->ndim; ++i) {
+        shape[i] = array->shape[i];
+    }
+    uint8_t *prev = malloc((size_t) array->nitems * itemsize);
+    memcpy(prev, buffer, (size_t) array->nitems * itemsize);
+    for (int8_t l = 1; l <= array->pyramid_levels; ++l) {
+        int64_t lshape[CATERVA_MAX_DIM];
+        uint8_t *expected = malloc((size_t) array->nitems * itemsize);
+        int64_t nitems = reduce_level(array->ndim, shape, prev, reduce, kind, itemsize, lshape,
+                                      expected);
+        caterva_array_t *level;
+        MU_ASSERT_CATERVA(caterva_array_get_level(ctx, array, l, &level));
+        for (int i = 0; i < array->ndim; ++i) {
+            MU_ASSERT("The shape of the level is wrong", level->shape[i] == lshape[i]);
+        }
+
+        int64_t start[CATERVA_MAX_DIM] = {0};
+        uint8_t *dest = malloc((size_t) nitems * itemsize);
+        MU_ASSERT_CATERVA(caterva_array_get_level_slice_buffer(
+            ctx, array, l, start, lshape, lshape, dest, nitems * itemsize));
+        for (int64_t i = 0; i < nitems; ++i) {
+            double value = load(kind, itemsize, dest + i * itemsize);
+            double reference = load(kind, itemsize, expected + i * itemsize);
+            double error = value > reference ? value - reference : reference - value;
+            MU_ASSERT("The level is not reduced",
+                      error <= 1e-12 * (reference > 0 ? reference : -reference));
+        }
+        free(dest);
+        free(prev);
+        prev = expected;
+        memcpy(shape, lshape, sizeof(shape));
+    }
+    free(prev);
+    return 0;
+}
+
+static char* test_pyramid(caterva_context_t *ctx, caterva_pyramid_reduce_t reduce,
+                          caterva_item_kind_t kind, int32_t itemsize, uint8_t ndim,
+                          int64_t *shape, int32_t *chunkshape, int32_t *blockshape,
+                          int8_t nlevels) {
+    caterva_params_t params = {0};
+    params.itemsize = (uint8_t) itemsize;
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        nitems *= shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.pyramid_levels = nlevels;
+    storage.properties.blosc.pyramid_reduce = reduce;
+    storage.properties.blosc.pyramid_kind = kind;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    size_t buffersize = (size_t) (nitems * itemsize);
+    uint8_t *buffer = malloc(buffersize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        double value = (double) ((i * 7919) % 1000) - (kind == CATERVA_ITEM_INT ? 500 : 0);
+        store(kind, itemsize, kind == CATERVA_ITEM_FLOAT ? value / 8 : value,
+              buffer + i * itemsize);
+    }
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                &array));
+    MU_ASSERT("The levels are missing", array->pyramid_levels == nlevels);
+    char *msg = check_levels(ctx, array, buffer, reduce, kind);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* Appending the chunks builds the same levels */
+    caterva_array_t *src;
+    storage.properties.blosc.pyramid_levels = 0;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                &src));
+    storage.properties.blosc.pyramid_levels = nlevels;
+    caterva_array_t *copy;
+    MU_ASSERT_CATERVA(caterva_array_copy(ctx, src, &storage, &copy));
+    for (int8_t l = 1; l <= nlevels; ++l) {
+        caterva_array_t *level;
+        caterva_array_t *level_copy;
+        MU_ASSERT_CATERVA(caterva_array_get_level(ctx, array, l, &level));
+        MU_ASSERT_CATERVA(caterva_array_get_level(ctx, copy, l, &level_copy));
+        int64_t lsize = level->nitems * itemsize;
+        uint8_t *lbuffer = malloc((size_t) lsize);
+        uint8_t *lbuffer_copy = malloc((size_t) lsize);
+        MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, level, lbuffer, lsize));
+        MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, level_copy, lbuffer_copy, lsize));
+        MU_ASSERT_BUFFER(lbuffer, lbuffer_copy, lsize);
+        free(lbuffer);
+        free(lbuffer_copy);
+    }
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &copy));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* pyramid_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.stats = true;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* pyramid_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* pyramid_1_mean_uint16() {
+    int64_t shape[] = {100, 75};
+    int32_t chunkshape[] = {20, 16};
+    int32_t blockshape[] = {10, 8};
+
+    return test_pyramid(ctx, CATERVA_PYRAMID_MEAN, CATERVA_ITEM_UINT, 2, 2, shape, chunkshape,
+                        blockshape, 2);
+}
+
+static char* pyramid_2_max_int32() {
+    int64_t shape[] = {21, 30, 17};
+    int32_t chunkshape[] = {8, 8, 8};
+    int32_t blockshape[] = {4, 8, 2};
+
+    return test_pyramid(ctx, CATERVA_PYRAMID_MAX, CATERVA_ITEM_INT, 4, 3, shape, chunkshape,
+                        blockshape, 3);
+}
+
+static char* pyramid_3_mean_float64() {
+    int64_t shape[] = {1001};
+    int32_t chunkshape[] = {128};
+    int32_t blockshape[] = {32};
+
+    return test_pyramid(ctx, CATERVA_PYRAMID_MEAN, CATERVA_ITEM_FLOAT, 8, 1, shape, chunkshape,
+                        blockshape, 4);
+}
+
+static char* pyramid_4_nearest_float32() {
+    int64_t shape[] = {37, 41};
+    int32_t chunkshape[] = {12, 20};
+    int32_t blockshape[] = {6, 5};
+
+    return test_pyramid(ctx, CATERVA_PYRAMID_NEAREST, CATERVA_ITEM_FLOAT, 4, 2, shape, chunkshape,
+                        blockshape, 2);
+}
+
+static char* pyramid_coarse_read() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(uint16_t);
+    params.ndim = 2;
+    params.shape[0] = 256;
+    params.shape[1] = 256;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = true;
+    storage.properties.blosc.pyramid_levels = 3;
+    storage.properties.blosc.pyramid_reduce = CATERVA_PYRAMID_MEAN;
+    storage.properties.blosc.pyramid_kind = CATERVA_ITEM_UINT;
+    storage.properties.blosc.chunkshape[0] = 64;
+    storage.properties.blosc.chunkshape[1] = 64;
+    storage.properties.blosc.blockshape[0] = 16;
+    storage.properties.blosc.blockshape[1] = 16;
+
+    uint16_t *buffer = malloc(256 * 256 * sizeof(uint16_t));
+    for (int i = 0; i < 256 * 256; ++i) {
+        buffer[i] = (uint16_t) (i / 256 + i % 256);
+    }
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, 256 * 256 * sizeof(uint16_t),
+                                                &params, &storage, &array));
+
+    /* A view of the whole array at level 3 only reads the 16 small chunks of the level */
+    int64_t start[] = {0, 0};
+    int64_t stop[] = {32, 32};
+    uint16_t view[32 * 32];
+    MU_ASSERT_CATERVA(caterva_array_get_level_slice_buffer(ctx, array, 3, start, stop, stop, view,
+                                                           sizeof(view)));
+    caterva_array_t *level;
+    MU_ASSERT_CATERVA(caterva_array_get_level(ctx, array, 3, &level));
+    caterva_stats_t stats;
+    caterva_stats_t level_stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, false));
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, level, &level_stats, false));
+    MU_ASSERT("The array is read", stats.nchunks_decompressed == 0);
+    MU_ASSERT("The level is not read", level_stats.nchunks_decompressed == 16);
+    MU_ASSERT("The bytes decompressed are not the ones of the view",
+              level_stats.bytes_decompressed <= (int64_t) sizeof(view));
+    /* The mean of a 8x8 window (i + j from 8r to 8r + 7 on both axes) is 8r + 8c + 7 */
+    MU_ASSERT("The view is wrong", view[0] == 7 && view[33] == 23 && view[32 * 32 - 1] == 503);
+
+    /* The levels are saved on their own and joined again */
+    caterva_array_t *frames[4];
+    for (int8_t l = 0; l < 4; ++l) {
+        caterva_array_t *larray;
+        MU_ASSERT_CATERVA(caterva_array_get_level(ctx, array, l, &larray));
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, larray->sc->frame->sdata,
+                                                    larray->sc->frame->len, true, &frames[l]));
+    }
+    caterva_array_t *joined;
+    MU_ASSERT("The levels are out of order",
+              caterva_array_from_levels(ctx, frames + 1, 3, &joined) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_from_levels(ctx, frames, 4, &joined));
+    MU_ASSERT("The reduction is lost", joined->pyramid_levels == 3 &&
+                                           joined->pyramid_reduce == CATERVA_PYRAMID_MEAN);
+    uint16_t joined_view[32 * 32];
+    MU_ASSERT_CATERVA(caterva_array_get_level_slice_buffer(ctx, joined, 3, start, stop, stop,
+                                                           joined_view, sizeof(joined_view)));
+    MU_ASSERT_BUFFER(view, joined_view, sizeof(view));
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &joined));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* pyramid_rechunk_concatenate() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(uint16_t);
+    params.ndim = 2;
+    params.shape[0] = 64;
+    params.shape[1] = 48;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 16;
+    storage.properties.blosc.chunkshape[1] = 16;
+    storage.properties.blosc.blockshape[0] = 8;
+    storage.properties.blosc.blockshape[1] = 8;
+
+    uint16_t *buffer = malloc(2 * 64 * 48 * sizeof(uint16_t));
+    for (int i = 0; i < 64 * 48; ++i) {
+        buffer[i] = (uint16_t) ((i * 7919) % 1000);
+        buffer[64 * 48 + i] = buffer[i];
+    }
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, 64 * 48 * sizeof(uint16_t), &params,
+                                                &storage, &src));
+
+    /* The levels are built when rechunking into an array with levels */
+    storage.properties.blosc.pyramid_levels = 2;
+    storage.properties.blosc.pyramid_reduce = CATERVA_PYRAMID_MEAN;
+    storage.properties.blosc.pyramid_kind = CATERVA_ITEM_UINT;
+    storage.properties.blosc.chunkshape[0] = 32;
+    caterva_array_t *rechunked;
+    MU_ASSERT_CATERVA(caterva_array_rechunk(ctx, src, &storage, 0, &rechunked));
+    MU_ASSERT("The levels are missing", rechunked->pyramid_levels == 2);
+    char *msg = check_levels(ctx, rechunked, (uint8_t *) buffer, CATERVA_PYRAMID_MEAN,
+                             CATERVA_ITEM_UINT);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* And when joining arrays whose chunks could be copied as they are */
+    storage.properties.blosc.chunkshape[0] = 16;
+    caterva_array_t *inputs[] = {src, src};
+    caterva_array_t *joined;
+    MU_ASSERT_CATERVA(caterva_array_concatenate(ctx, inputs, 2, 0, &storage, &joined));
+    MU_ASSERT("The levels are missing", joined->pyramid_levels == 2);
+    msg = check_levels(ctx, joined, (uint8_t *) buffer, CATERVA_PYRAMID_MEAN, CATERVA_ITEM_UINT);
+    if (msg != 0) {
+        return msg;
+    }
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &joined));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &rechunked));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    return 0;
+}
+
+static char* pyramid_fill_value() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(float);
+    params.ndim = 2;
+    params.shape[0] = 50;
+    params.shape[1] = 50;
+    float fill_value = 2.5f;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.pyramid_levels = 2;
+    storage.properties.blosc.pyramid_reduce = CATERVA_PYRAMID_MAX;
+    storage.properties.blosc.pyramid_kind = CATERVA_ITEM_FLOAT;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &array));
+    float dest[13 * 13];
+    int64_t start[] = {0, 0};
+    int64_t stop[] = {13, 13};
+    MU_ASSERT_CATERVA(caterva_array_get_level_slice_buffer(ctx, array, 2, start, stop, stop, dest,
+                                                           sizeof(dest)));
+    for (int i = 0; i < 13 * 13; ++i) {
+        MU_ASSERT("The level is not filled", dest[i] == fill_value);
+    }
+
+    /* The chunks of an array with levels can only be appended */
+    float chunk[20 * 20] = {0};
+    MU_ASSERT("A chunk of an array with levels is set",
+              caterva_array_set_chunk(ctx, array, 0, chunk, sizeof(chunk)) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* pyramid_file() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(uint16_t);
+    params.ndim = 2;
+    params.shape[0] = 60;
+    params.shape[1] = 70;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = true;
+    storage.properties.blosc.filename = "test_pyramid.b2frame";
+    storage.properties.blosc.pyramid_levels = 2;
+    storage.properties.blosc.pyramid_reduce = CATERVA_PYRAMID_MEAN;
+    storage.properties.blosc.pyramid_kind = CATERVA_ITEM_UINT;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    uint16_t buffer[60 * 70];
+    for (int i = 0; i < 60 * 70; ++i) {
+        buffer[i] = (uint16_t) ((i * 7919) % 1000);
+    }
+
+    /* The levels are written to their own files while the array is ingested on disk */
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, sizeof(buffer), &params, &storage,
+                                                &array));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    MU_ASSERT_CATERVA(caterva_array_from_file(ctx, "test_pyramid.b2frame", false, &array));
+    MU_ASSERT("The levels are not opened", array->pyramid_levels == 2 &&
+                                               array->pyramid_reduce == CATERVA_PYRAMID_MEAN);
+    char *msg = check_levels(ctx, array, (uint8_t *) buffer, CATERVA_PYRAMID_MEAN,
+                             CATERVA_ITEM_UINT);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* The levels are saved along with the array */
+    MU_ASSERT_CATERVA(caterva_array_save(ctx, array, "test_pyramid_saved.b2frame"));
+    caterva_array_t *saved;
+    MU_ASSERT_CATERVA(caterva_array_from_file(ctx, "test_pyramid_saved.b2frame", true, &saved));
+    MU_ASSERT("The levels are not saved", saved->pyramid_levels == 2);
+    msg = check_levels(ctx, saved, (uint8_t *) buffer, CATERVA_PYRAMID_MEAN, CATERVA_ITEM_UINT);
+    if (msg != 0) {
+        return msg;
+    }
+
+    /* An array whose levels are missing is opened alone */
+    remove("test_pyramid_saved.b2frame.level1");
+    caterva_array_t *alone;
+    MU_ASSERT_CATERVA(caterva_array_from_file(ctx, "test_pyramid_saved.b2frame", true, &alone));
+    MU_ASSERT("The levels are opened", alone->pyramid_levels == 0);
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &alone));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &saved));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    remove("test_pyramid.b2frame");
+    remove("test_pyramid.b2frame.level1");
+    remove("test_pyramid.b2frame.level2");
+    remove("test_pyramid_saved.b2frame");
+    remove("test_pyramid_saved.b2frame.level2");
+    return 0;
+}
+
+static char* pyramid_errors() {
+    caterva_params_t params = {0};
+    params.itemsize = 3;
+    params.ndim = 2;
+    params.shape[0] = 40;
+    params.shape[1] = 40;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.pyramid_levels = 2;
+    storage.properties.blosc.pyramid_reduce = CATERVA_PYRAMID_MEAN;
+    storage.properties.blosc.pyramid_kind = CATERVA_ITEM_UINT;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    caterva_array_t *array;
+    MU_ASSERT("The mean of 3-byte items",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    storage.properties.blosc.pyramid_reduce = CATERVA_PYRAMID_NEAREST;
+    storage.properties.blosc.pyramid_levels = 3;
+    MU_ASSERT("A chunkshape not divisible by 2^levels",
+              caterva_array_empty(ctx, &params, &storage, &array) != CATERVA_SUCCEED);
+    storage.properties.blosc.pyramid_levels = 2;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    caterva_array_t *level;
+    MU_ASSERT("A level out of range",
+              caterva_array_get_level(ctx, array, 3, &level) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(pyramid_setup)
+
+    MU_RUN_TEST(pyramid_1_mean_uint16)
+    MU_RUN_TEST(pyramid_2_max_int32)
+    MU_RUN_TEST(pyramid_3_mean_float64)
+    MU_RUN_TEST(pyramid_4_nearest_float32)
+    MU_RUN_TEST(pyramid_coarse_read)
+    MU_RUN_TEST(pyramid_rechunk_concatenate)
+    MU_RUN_TEST(pyramid_fill_value)
+    MU_RUN_TEST(pyramid_file)
+    MU_RUN_TEST(pyramid_errors)
+
+    MU_RUN_TEARDOWN(pyramid_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("PYRAMID")
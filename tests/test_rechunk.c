@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static char* test_rechunk(caterva_context_t *ctx, uint8_t itemsize, uint8_t ndim, int64_t *shape,
+                          caterva_storage_backend_t backend, int32_t *chunkshape,
+                          int32_t *blockshape, int32_t *chunkshape2, int32_t *blockshape2,
+                          int64_t membudget) {
+
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend;
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        for (int i = 0; i < ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = chunkshape[i];
+            storage.properties.blosc.blockshape[i] = blockshape[i];
+        }
+    }
+
+    caterva_storage_t storage2 = {0};
+    storage2.backend = CATERVA_STORAGE_BLOSC;
+    for (int i = 0; i < ndim; ++i) {
+        storage2.properties.blosc.chunkshape[i] = chunkshape2[i];
+        storage2.properties.blosc.blockshape[i] = blockshape2[i];
+    }
+
+    /* Create original data */
+    size_t buffersize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        buffersize *= (size_t) shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize);
+    MU_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage, &src));
+
+    /* Rechunk */
+    caterva_array_t *dest;
+    MU_ASSERT_CATERVA(caterva_array_rechunk(ctx, src, &storage2, membudget, &dest));
+    for (int i = 0; i < ndim; ++i) {
+        MU_ASSERT("Chunkshape not changed", dest->chunkshape[i] == chunkshape2[i]);
+        MU_ASSERT("Blockshape not changed", dest->blockshape[i] == blockshape2[i]);
+    }
+    MU_ASSERT("Array not filled", dest->filled);
+
+    /* Assert results */
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    /* A slice of the new array (exercises the block layout of the chunks) */
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t slice_shape[CATERVA_MAX_DIM];
+    int64_t slice_size = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = shape[i] / 3;
+        stop[i] = shape[i] - shape[i] / 4;
+        slice_shape[i] = stop[i] - start[i];
+        slice_size *= slice_shape[i];
+    }
+    uint8_t *slice_src = malloc((size_t) slice_size);
+    uint8_t *slice_dest = malloc((size_t) slice_size);
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, src, start, stop, slice_shape,
+                                                     slice_src, slice_size));
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, dest, start, stop, slice_shape,
+                                                     slice_dest, slice_size));
+    MU_ASSERT_BUFFER(slice_src, slice_dest, slice_size);
+
+    /* Free mallocs */
+    free(buffer);
+    free(buffer_dest);
+    free(slice_src);
+    free(slice_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* rechunk_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* rechunk_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+
+static char* rechunk_2_double_window() {
+    int64_t shape[] = {130, 90};
+    int32_t chunkshape[] = {7, 90};
+    int32_t blockshape[] = {7, 30};
+    int32_t chunkshape2[] = {130, 6};
+    int32_t blockshape2[] = {20, 6};
+
+    return test_rechunk(ctx, sizeof(double), 2, shape, CATERVA_STORAGE_BLOSC, chunkshape,
+                        blockshape, chunkshape2, blockshape2, 0);
+}
+
+static char* rechunk_2_double_groups() {
+    int64_t shape[] = {130, 90};
+    int32_t chunkshape[] = {7, 90};
+    int32_t blockshape[] = {7, 30};
+    int32_t chunkshape2[] = {130, 6};
+    int32_t blockshape2[] = {20, 6};
+
+    return test_rechunk(ctx, sizeof(double), 2, shape, CATERVA_STORAGE_BLOSC, chunkshape,
+                        blockshape, chunkshape2, blockshape2, 20 * 1024);
+}
+
+static char* rechunk_3_float_window() {
+    int64_t shape[] = {45, 31, 27};
+    int32_t chunkshape[] = {10, 12, 11};
+    int32_t blockshape[] = {4, 5, 6};
+    int32_t chunkshape2[] = {14, 9, 27};
+    int32_t blockshape2[] = {7, 3, 10};
+
+    return test_rechunk(ctx, sizeof(float), 3, shape, CATERVA_STORAGE_BLOSC, chunkshape,
+                        blockshape, chunkshape2, blockshape2, 0);
+}
+
+static char* rechunk_3_uint16_groups() {
+    int64_t shape[] = {33, 20, 41};
+    int32_t chunkshape[] = {33, 4, 9};
+    int32_t blockshape[] = {11, 4, 3};
+    int32_t chunkshape2[] = {5, 20, 13};
+    int32_t blockshape2[] = {5, 7, 13};
+
+    return test_rechunk(ctx, sizeof(uint16_t), 3, shape, CATERVA_STORAGE_BLOSC, chunkshape,
+                        blockshape, chunkshape2, blockshape2, 16 * 1024);
+}
+
+static char* rechunk_4_uint8_window() {
+    int64_t shape[] = {9, 8, 13, 10};
+    int32_t chunkshape[] = {2, 8, 5, 5};
+    int32_t blockshape[] = {2, 3, 5, 2};
+    int32_t chunkshape2[] = {4, 3, 13, 4};
+    int32_t blockshape2[] = {1, 3, 4, 4};
+
+    return test_rechunk(ctx, sizeof(uint8_t), 4, shape, CATERVA_STORAGE_BLOSC, chunkshape,
+                        blockshape, chunkshape2, blockshape2, 0);
+}
+
+static char* rechunk_2_float_plainbuffer() {
+    int64_t shape[] = {40, 50};
+    int32_t chunkshape2[] = {16, 15};
+    int32_t blockshape2[] = {8, 5};
+
+    return test_rechunk(ctx, sizeof(float), 2, shape, CATERVA_STORAGE_PLAINBUFFER, NULL, NULL,
+                        chunkshape2, blockshape2, 0);
+}
+
+static char* rechunk_small_membudget() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 2;
+    params.shape[0] = 130;
+    params.shape[1] = 90;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 7;
+    storage.properties.blosc.chunkshape[1] = 90;
+    storage.properties.blosc.blockshape[0] = 7;
+    storage.properties.blosc.blockshape[1] = 30;
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &src));
+    double chunk[7 * 90] = {0};
+    while (!src->filled) {
+        MU_ASSERT_CATERVA(caterva_array_append(ctx, src, chunk,
+                                               src->next_chunknitems * sizeof(double)));
+    }
+
+    /* The budget can not hold a source and a destination chunk */
+    storage.properties.blosc.chunkshape[0] = 130;
+    storage.properties.blosc.chunkshape[1] = 6;
+    storage.properties.blosc.blockshape[0] = 20;
+    storage.properties.blosc.blockshape[1] = 6;
+    caterva_array_t *dest;
+    MU_ASSERT("A budget too small",
+              caterva_array_rechunk(ctx, src, &storage, 1024, &dest) != CATERVA_SUCCEED);
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(rechunk_setup)
+
+    MU_RUN_TEST(rechunk_2_double_window)
+    MU_RUN_TEST(rechunk_2_double_groups)
+    MU_RUN_TEST(rechunk_3_float_window)
+    MU_RUN_TEST(rechunk_3_uint16_groups)
+    MU_RUN_TEST(rechunk_4_uint8_window)
+    MU_RUN_TEST(rechunk_2_float_plainbuffer)
+    MU_RUN_TEST(rechunk_small_membudget)
+
+    MU_RUN_TEARDOWN(rechunk_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("RECHUNK")
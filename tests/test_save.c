@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+#ifdef __GNUC__
+#include <unistd.h>
+#define FILE_EXISTS(filename) access(filename, F_OK)
+#else
+#include <io.h>
+#define FILE_EXISTS(filename) _access(filename, 0)
+#endif
+
+static char* test_save(caterva_context_t *ctx, uint8_t itemsize, uint8_t ndim, int64_t *shape,
+                       caterva_storage_backend_t backend, int32_t *chunkshape,
+                       int32_t *blockshape, bool enforceframe, char *filename) {
+    if (FILE_EXISTS(filename) != -1) {
+        remove(filename);
+    }
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend;
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        storage.properties.blosc.enforceframe = enforceframe;
+        for (int i = 0; i < ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = chunkshape[i];
+            storage.properties.blosc.blockshape[i] = blockshape[i];
+        }
+    }
+
+    /* Create original data */
+    size_t buffersize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        buffersize *= (size_t) shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize);
+    MU_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage, &src));
+    uint8_t *buffer_dest = malloc(buffersize);
+
+    /* Serialize into a contiguous frame */
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        uint8_t *sframe;
+        int64_t len;
+        bool needs_free;
+        MU_ASSERT_CATERVA(caterva_array_to_sframe(ctx, src, &sframe, &len, &needs_free));
+        MU_ASSERT("The frame of the array is copied", needs_free != enforceframe);
+        caterva_array_t *dest;
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, sframe, len, true, &dest));
+        MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer_dest, buffersize));
+        MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+        if (needs_free) {
+            free(sframe);
+        }
+    } else {
+        uint8_t *sframe;
+        int64_t len;
+        bool needs_free;
+        MU_ASSERT("A plain buffer serialized into a frame",
+                  caterva_array_to_sframe(ctx, src, &sframe, &len, &needs_free) !=
+                  CATERVA_SUCCEED);
+    }
+
+    /* Save to disk and reopen */
+    MU_ASSERT_CATERVA(caterva_array_save(ctx, src, filename));
+    caterva_array_t *dest;
+    MU_ASSERT_CATERVA(caterva_array_from_file(ctx, filename, true, &dest));
+    MU_ASSERT("Wrong storage", dest->storage == backend);
+    memset(buffer_dest, 0, buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    free(buffer);
+    free(buffer_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    if (FILE_EXISTS(filename) != -1) {
+        remove(filename);
+    }
+    return 0;
+}
+
+caterva_context_t *ctx;
+char *filename;
+
+static char* save_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    caterva_context_new(&cfg, &ctx);
+    filename = "save.caterva";
+    return 0;
+}
+
+static char* save_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* save_1_blosc() {
+    int64_t shape[] = {1033};
+    int32_t chunkshape[] = {100};
+    int32_t blockshape[] = {25};
+
+    return test_save(ctx, 8, 1, shape, CATERVA_STORAGE_BLOSC, chunkshape, blockshape, false,
+                     filename);
+}
+
+static char* save_2_blosc_frame() {
+    int64_t shape[] = {45, 61};
+    int32_t chunkshape[] = {20, 20};
+    int32_t blockshape[] = {10, 5};
+
+    return test_save(ctx, 4, 2, shape, CATERVA_STORAGE_BLOSC, chunkshape, blockshape, true,
+                     filename);
+}
+
+static char* save_3_plainbuffer() {
+    int64_t shape[] = {12, 13, 7};
+
+    return test_save(ctx, 2, 3, shape, CATERVA_STORAGE_PLAINBUFFER, NULL, NULL, false,
+                     filename);
+}
+
+static char* save_sparse() {
+    if (FILE_EXISTS(filename) != -1) {
+        remove(filename);
+    }
+    int32_t fill_value = 42;
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = 2;
+    params.shape[0] = 50;
+    params.shape[1] = 50;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 20;
+    storage.properties.blosc.chunkshape[1] = 20;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &src));
+    int32_t chunk[20 * 20];
+    for (int i = 0; i < 20 * 20; ++i) {
+        chunk[i] = i;
+    }
+    MU_ASSERT_CATERVA(caterva_array_set_chunk(ctx, src, 4, chunk, sizeof(chunk)));
+
+    /* The chunks never written are not stored in the file either */
+    MU_ASSERT_CATERVA(caterva_array_save(ctx, src, filename));
+    caterva_array_t *dest;
+    MU_ASSERT_CATERVA(caterva_array_from_file(ctx, filename, true, &dest));
+    MU_ASSERT("The fill value is lost", dest->fill_value != NULL);
+    MU_ASSERT("Wrong number of chunks stored", dest->sc->nchunks == src->sc->nchunks);
+
+    int32_t buffer[50 * 50];
+    int32_t buffer_dest[50 * 50];
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, src, buffer, sizeof(buffer)));
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer_dest, sizeof(buffer_dest)));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, sizeof(buffer));
+
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    remove(filename);
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(save_setup)
+
+    MU_RUN_TEST(save_1_blosc)
+    MU_RUN_TEST(save_2_blosc_frame)
+    MU_RUN_TEST(save_3_plainbuffer)
+    MU_RUN_TEST(save_sparse)
+
+    MU_RUN_TEARDOWN(save_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("SAVE")
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+/* Write the chunk nchunk (with its items set to nchunk * 10000 + i) into the array and buffer */
+static char* write_chunk(caterva_context_t *ctx, caterva_array_t *array, double *buffer,
+                         int64_t nchunk, bool uniform) {
+    int8_t ndim = array->ndim;
+    int64_t origin[CATERVA_MAX_DIM];
+    int64_t cshape[CATERVA_MAX_DIM];
+    int64_t cnitems = 1;
+    int64_t rem = nchunk;
+    for (int i = ndim - 1; i >= 0; --i) {
+        int64_t grid = array->extshape[i] / array->chunkshape[i];
+        origin[i] = rem % grid * array->chunkshape[i];
+        rem /= grid;
+        cshape[i] = array->shape[i] - origin[i] < array->chunkshape[i]
+                        ? array->shape[i] - origin[i] : array->chunkshape[i];
+        cnitems *= cshape[i];
+    }
+
+    double *chunk = malloc((size_t) cnitems * sizeof(double));
+    for (int64_t n = 0; n < cnitems; ++n) {
+        chunk[n] = (double) (nchunk * 10000 + (uniform ? 0 : n));
+        // Position of the item in the whole array
+        int64_t index = 0;
+        int64_t r = n;
+        int64_t stride = 1;
+        for (int i = ndim - 1; i >= 0; --i) {
+            index += (origin[i] + r % cshape[i]) * stride;
+            r /= cshape[i];
+            stride *= array->shape[i];
+        }
+        buffer[index] = chunk[n];
+    }
+    MU_ASSERT_CATERVA(caterva_array_set_chunk(ctx, array, nchunk, chunk,
+                                              cnitems * (int64_t) sizeof(double)));
+    free(chunk);
+    return 0;
+}
+
+static char* test_sparse(caterva_context_t *ctx, uint8_t ndim, int64_t *shape,
+                         int32_t *chunkshape, int32_t *blockshape, int64_t *nchunks,
+                         int nwrites, bool enforceframe) {
+    double fill_value = -7;
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = enforceframe;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &array));
+
+    int64_t nitems = array->nitems;
+    double *buffer = malloc((size_t) nitems * sizeof(double));
+    for (int64_t i = 0; i < nitems; ++i) {
+        buffer[i] = fill_value;
+    }
+
+    /* Write some chunks out of order (the odd writes are uniform) */
+    int64_t max_nchunk = -1;
+    for (int i = 0; i < nwrites; ++i) {
+        char *msg = write_chunk(ctx, array, buffer, nchunks[i], i % 2 == 1);
+        if (msg != 0) {
+            return msg;
+        }
+        max_nchunk = nchunks[i] > max_nchunk ? nchunks[i] : max_nchunk;
+    }
+    MU_ASSERT("The chunks after the last one written are stored",
+              array->sc->nchunks == max_nchunk + 1);
+
+    caterva_array_t *dest = array;
+    if (enforceframe) {
+        MU_ASSERT_CATERVA(caterva_array_from_sframe(ctx, array->sc->frame->sdata,
+                                                    array->sc->frame->len, true, &dest));
+    }
+
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, dest, &stats, true));
+    double *buffer_dest = malloc((size_t) nitems * sizeof(double));
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer_dest,
+                                              nitems * (int64_t) sizeof(double)));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, (size_t) nitems * sizeof(double));
+
+    /* Only the chunks with data (at most the even writes) are decompressed */
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, dest, &stats, true));
+    MU_ASSERT("Missing chunks decompressed", stats.nchunks_decompressed <= (nwrites + 1) / 2);
+    MU_ASSERT("Wrong number of chunks read", stats.nchunks_decompressed +
+              stats.nchunks_uniform_read == dest->extnitems / dest->chunknitems);
+
+    free(buffer);
+    free(buffer_dest);
+    if (dest != array) {
+        MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    }
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* sparse_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.stats = true;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* sparse_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+static char* sparse_1() {
+    int64_t shape[] = {1000};
+    int32_t chunkshape[] = {64};
+    int32_t blockshape[] = {16};
+    int64_t nchunks[] = {7, 2, 15, 2};
+
+    return test_sparse(ctx, 1, shape, chunkshape, blockshape, nchunks, 4, false);
+}
+
+static char* sparse_2_frame() {
+    int64_t shape[] = {100, 73};
+    int32_t chunkshape[] = {20, 20};
+    int32_t blockshape[] = {10, 10};
+    int64_t nchunks[] = {19, 0, 3, 11, 19};
+
+    return test_sparse(ctx, 2, shape, chunkshape, blockshape, nchunks, 5, true);
+}
+
+static char* sparse_3() {
+    int64_t shape[] = {30, 25, 17};
+    int32_t chunkshape[] = {10, 10, 10};
+    int32_t blockshape[] = {5, 5, 5};
+    int64_t nchunks[] = {17, 5};
+
+    return test_sparse(ctx, 3, shape, chunkshape, blockshape, nchunks, 2, false);
+}
+
+static char* sparse_errors() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 1;
+    params.shape[0] = 100;
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.chunkshape[0] = 30;
+    storage.properties.blosc.blockshape[0] = 10;
+
+    double chunk[30] = {0};
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &array));
+    MU_ASSERT("A chunk set without a fill value",
+              caterva_array_set_chunk(ctx, array, 0, chunk, sizeof(chunk)) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+
+    double fill_value = 0;
+    MU_ASSERT_CATERVA(caterva_array_full(ctx, &params, &storage, &fill_value, &array));
+    MU_ASSERT("A chunk set out of the array",
+              caterva_array_set_chunk(ctx, array, 4, chunk, sizeof(chunk)) != CATERVA_SUCCEED);
+    MU_ASSERT("An edge chunk set with a wrong size",
+              caterva_array_set_chunk(ctx, array, 3, chunk, sizeof(chunk)) != CATERVA_SUCCEED);
+    MU_ASSERT_CATERVA(caterva_array_set_chunk(ctx, array, 3, chunk, 10 * sizeof(double)));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(sparse_setup)
+
+    MU_RUN_TEST(sparse_1)
+    MU_RUN_TEST(sparse_2_frame)
+    MU_RUN_TEST(sparse_3)
+    MU_RUN_TEST(sparse_errors)
+
+    MU_RUN_TEARDOWN(sparse_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("SPARSE")
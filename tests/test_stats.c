@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static int64_t total_time(caterva_stats_t *stats) {
+    int64_t time = 0;
+    for (int i = 0; i < CATERVA_NSTAGES; ++i) {
+        time += stats->time_ns[i];
+    }
+    return time;
+}
+
+static char* test_stats(caterva_storage_backend_t backend, uint8_t itemsize, uint8_t ndim,
+                        int64_t *shape, int32_t *chunkshape, int32_t *blockshape,
+                        bool enabled) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.stats = enabled;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend;
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        for (int i = 0; i < ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = chunkshape[i];
+            storage.properties.blosc.blockshape[i] = blockshape[i];
+        }
+    }
+
+    /* Create original data */
+    size_t buffersize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        buffersize *= (size_t) shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize);
+    MU_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage, &src));
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, src, &stats, true));
+
+    int64_t nchunks = 1;
+    int64_t nblocks = 1;
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        nchunks = src->extnitems / src->chunknitems;
+        nblocks = nchunks * (src->extchunknitems / src->blocknitems);
+    }
+    int64_t nbytes = nchunks * src->extchunknitems * itemsize;
+
+    if (!enabled) {
+        MU_ASSERT("Statistics collected while disabled", total_time(&stats) == 0);
+        MU_ASSERT("Statistics collected while disabled", stats.nchunks_compressed == 0);
+    } else if (backend == CATERVA_STORAGE_BLOSC) {
+        MU_ASSERT("Wrong number of chunks compressed", stats.nchunks_compressed == nchunks);
+        MU_ASSERT("Wrong number of bytes compressed", stats.bytes_compressed == nbytes);
+        MU_ASSERT("Wrong number of bytes written", stats.bytes_written > 0);
+        MU_ASSERT("Compression time not measured", stats.time_ns[CATERVA_STAGE_COMPRESS] > 0);
+    } else {
+        MU_ASSERT("Chunks compressed in a plain buffer", stats.nchunks_compressed == 0);
+        MU_ASSERT("Copy time not measured", stats.time_ns[CATERVA_STAGE_SCATTER] > 0);
+    }
+
+    /* Read everything back */
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, src, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, src, &stats, false));
+
+    if (enabled && backend == CATERVA_STORAGE_BLOSC) {
+        MU_ASSERT("Wrong number of chunks decompressed", stats.nchunks_decompressed == nchunks);
+        // The blocks of the padding are not decompressed
+        MU_ASSERT("Wrong number of blocks decompressed", stats.nblocks_decompressed <= nblocks);
+        MU_ASSERT("Wrong number of bytes decompressed", stats.bytes_decompressed ==
+                  stats.nblocks_decompressed * src->blocknitems * itemsize);
+        MU_ASSERT("Wrong number of bytes read", stats.bytes_read > 0);
+        MU_ASSERT("Chunks compressed while reading", stats.nchunks_compressed == 0);
+    } else {
+        MU_ASSERT("Chunks decompressed in a plain buffer", stats.nchunks_decompressed == 0);
+    }
+
+    /* The context accumulates the statistics of all the arrays */
+    caterva_stats_t ctx_stats;
+    MU_ASSERT_CATERVA(caterva_context_get_stats(ctx, &ctx_stats, true));
+    MU_ASSERT("Context statistics are wrong",
+              ctx_stats.nchunks_decompressed == stats.nchunks_decompressed);
+    MU_ASSERT("Context statistics are wrong", total_time(&ctx_stats) >= total_time(&stats));
+    MU_ASSERT_CATERVA(caterva_context_get_stats(ctx, &ctx_stats, false));
+    MU_ASSERT("Context statistics not reset", total_time(&ctx_stats) == 0);
+
+    /* Free mallocs */
+    free(buffer);
+    free(buffer_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+
+static char* stats_2_double_blosc() {
+    int64_t shape[] = {120, 100};
+    int32_t chunkshape[] = {50, 40};
+    int32_t blockshape[] = {20, 20};
+
+    return test_stats(CATERVA_STORAGE_BLOSC, sizeof(double), 2, shape, chunkshape, blockshape,
+                      true);
+}
+
+static char* stats_3_uint16_blosc_disabled() {
+    int64_t shape[] = {20, 31, 17};
+    int32_t chunkshape[] = {10, 16, 17};
+    int32_t blockshape[] = {5, 4, 9};
+
+    return test_stats(CATERVA_STORAGE_BLOSC, sizeof(uint16_t), 3, shape, chunkshape, blockshape,
+                      false);
+}
+
+static char* stats_2_float_plainbuffer() {
+    int64_t shape[] = {200, 150};
+
+    return test_stats(CATERVA_STORAGE_PLAINBUFFER, sizeof(float), 2, shape, NULL, NULL, true);
+}
+
+static char* stats_slice_cache() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.stats = true;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    caterva_params_t params = {.itemsize = sizeof(double), .ndim = 2, .shape = {100, 100}};
+    caterva_storage_t storage = {.backend = CATERVA_STORAGE_BLOSC};
+    storage.properties.blosc.chunkshape[0] = 50;
+    storage.properties.blosc.chunkshape[1] = 50;
+    storage.properties.blosc.blockshape[0] = 10;
+    storage.properties.blosc.blockshape[1] = 10;
+
+    size_t buffersize = 100 * 100 * sizeof(double);
+    double *buffer = malloc(buffersize);
+    fill_buf(buffer, sizeof(double), 100 * 100);
+    caterva_array_t *array;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage,
+                                                &array));
+    caterva_stats_t stats;
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+
+    /* A slice inside a block only decompresses that block */
+    int64_t start[] = {12, 63};
+    int64_t stop[] = {18, 69};
+    int64_t shape[] = {6, 6};
+    double slice[36];
+    MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, start, stop, shape, slice,
+                                                     sizeof(slice)));
+    MU_ASSERT("Wrong slice", slice[7] == buffer[13 * 100 + 64]);
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("Wrong number of chunks decompressed", stats.nchunks_decompressed == 1);
+    MU_ASSERT("Wrong number of blocks decompressed", stats.nblocks_decompressed == 1);
+    MU_ASSERT("Cache used without a cache", stats.cache_hits + stats.cache_misses == 0);
+
+    /* With a chunk cache, the second read of the same chunk does not decompress it again */
+    array->chunk_cache.data = malloc((size_t) array->extchunknitems * sizeof(double));
+    for (int i = 0; i < 2; ++i) {
+        memset(slice, 0, sizeof(slice));
+        MU_ASSERT_CATERVA(caterva_array_get_slice_buffer(ctx, array, start, stop, shape, slice,
+                                                         sizeof(slice)));
+        MU_ASSERT("Wrong slice", slice[35] == buffer[17 * 100 + 68]);
+    }
+    MU_ASSERT_CATERVA(caterva_array_get_stats(ctx, array, &stats, true));
+    MU_ASSERT("Wrong number of cache misses", stats.cache_misses == 1);
+    MU_ASSERT("Wrong number of cache hits", stats.cache_hits == 1);
+    MU_ASSERT("Wrong number of chunks decompressed", stats.nchunks_decompressed == 1);
+    MU_ASSERT("Wrong number of blocks decompressed", stats.nblocks_decompressed == 25);
+    free(array->chunk_cache.data);
+    array->chunk_cache.data = NULL;
+
+    free(buffer);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &array));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_TEST(stats_2_double_blosc)
+    MU_RUN_TEST(stats_3_uint16_blosc_disabled)
+    MU_RUN_TEST(stats_2_float_plainbuffer)
+    MU_RUN_TEST(stats_slice_cache)
+
+    return 0;
+}
+
+MU_RUN_SUITE("STATS")
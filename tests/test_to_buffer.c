@@ -343,6 +343,103 @@ static char* to_buffer_ndim_3_hard() {
     return message;
  }
 
+/* Counts the chunks scattered into the buffer (the ones not decompressed in place) */
+static void count_scatters(const caterva_trace_event_t *event, void *trace_data) {
+    if (event->stage == CATERVA_STAGE_SCATTER && event->phase == CATERVA_TRACE_END) {
+        (*(int64_t *) trace_data)++;
+    }
+}
+
+/* The chunks are decompressed by several threads, in place when their layout allows it */
+static char* test_to_buffer_parallel(int8_t ndim, int64_t *shape, int32_t *chunkshape,
+                                     int32_t *blockshape, bool in_place) {
+    int64_t nscatters = 0;
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 4;
+    cfg.trace = count_scatters;
+    cfg.trace_data = &nscatters;
+    caterva_context_t *pctx;
+    caterva_context_new(&cfg, &pctx);
+
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(int32_t);
+    params.ndim = ndim;
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    int64_t buf_size = 1;
+    int64_t nchunks = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+        buf_size *= shape[i];
+        nchunks *= (shape[i] + chunkshape[i] - 1) / chunkshape[i];
+    }
+    int64_t buffersize = buf_size * (int64_t) sizeof(int32_t);
+    int32_t *result = (int32_t *) pctx->cfg->alloc((size_t) buffersize);
+    for (int64_t i = 0; i < buf_size; ++i) {
+        /* Some uniform chunks among the others */
+        result[i] = i < buf_size / 3 ? (int32_t) i : 7;
+    }
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(pctx, result, buffersize, &params, &storage,
+                                                &src));
+
+    int32_t *destbuffer = (int32_t *) pctx->cfg->alloc((size_t) buffersize);
+    nscatters = 0;
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(pctx, src, destbuffer, buffersize));
+    MU_ASSERT_BUFFER(destbuffer, result, buffersize);
+#if defined(CATERVA_TRACING)
+    /* The chunks with different items (a third of them at least) are not scattered in place */
+    if (in_place) {
+        MU_ASSERT("The chunks are not decompressed in place", nscatters <= nchunks * 2 / 3);
+    } else {
+        MU_ASSERT("The chunks are decompressed in place", nscatters == nchunks);
+    }
+#else
+    CATERVA_UNUSED_PARAM(in_place);
+    CATERVA_UNUSED_PARAM(nchunks);
+#endif
+
+    pctx->cfg->free(destbuffer);
+    pctx->cfg->free(result);
+    MU_ASSERT_CATERVA(caterva_array_free(pctx, &src));
+    caterva_context_free(&pctx);
+    return 0;
+}
+
+static char* to_buffer_parallel_in_place() {
+    int64_t shape_[] = {103, 40};
+    int32_t pshape_[] = {10, 40};
+    int32_t spshape_[] = {5, 40};
+
+    return test_to_buffer_parallel(2, shape_, pshape_, spshape_, true);
+}
+
+static char* to_buffer_parallel_in_place_unit() {
+    int64_t shape_[] = {9, 20, 12};
+    int32_t pshape_[] = {1, 4, 12};
+    int32_t spshape_[] = {1, 2, 12};
+
+    return test_to_buffer_parallel(3, shape_, pshape_, spshape_, true);
+}
+
+static char* to_buffer_parallel_blocks() {
+    int64_t shape_[] = {21, 30, 17};
+    int32_t pshape_[] = {8, 8, 8};
+    int32_t spshape_[] = {4, 3, 2};
+
+    return test_to_buffer_parallel(3, shape_, pshape_, spshape_, false);
+}
+
+static char* to_buffer_parallel_padded_blocks() {
+    int64_t shape_[] = {50, 30};
+    int32_t pshape_[] = {10, 30};
+    int32_t spshape_[] = {4, 30};
+
+    return test_to_buffer_parallel(2, shape_, pshape_, spshape_, false);
+}
+
 
 static char* all_tests() {
     MU_RUN_SETUP(to_buffer_setup)
@@ -358,6 +455,10 @@ static char* all_tests() {
     MU_RUN_TEST(to_buffer_ndim_6)
     MU_RUN_TEST(to_buffer_ndim_7_uint16)
     MU_RUN_TEST(to_buffer_ndim_8_float_plain)
+    MU_RUN_TEST(to_buffer_parallel_in_place)
+    MU_RUN_TEST(to_buffer_parallel_in_place_unit)
+    MU_RUN_TEST(to_buffer_parallel_blocks)
+    MU_RUN_TEST(to_buffer_parallel_padded_blocks)
 
     MU_RUN_TEARDOWN(to_buffer_teardown)
     return 0;
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+#define MAX_EVENTS 4096
+
+#if defined(CATERVA_TRACING)
+#define TRACING true
+#else
+#define TRACING false
+#endif
+
+/* Records the events reported by caterva */
+typedef struct {
+    caterva_trace_event_t events[MAX_EVENTS];
+    int nevents;
+} recorder_t;
+
+static void recorder_trace(const caterva_trace_event_t *event, void *trace_data) {
+    recorder_t *recorder = (recorder_t *) trace_data;
+    if (recorder->nevents < MAX_EVENTS) {
+        recorder->events[recorder->nevents++] = *event;
+    }
+}
+
+// Check that each stage is closed by the event following its beginning
+static char* check_pairs(recorder_t *recorder) {
+    MU_ASSERT("Too many events", recorder->nevents < MAX_EVENTS);
+    MU_ASSERT("Unbalanced events", recorder->nevents % 2 == 0);
+    for (int i = 0; i < recorder->nevents; i += 2) {
+        caterva_trace_event_t *begin = &recorder->events[i];
+        caterva_trace_event_t *end = &recorder->events[i + 1];
+        MU_ASSERT("Stage does not begin", begin->phase == CATERVA_TRACE_BEGIN);
+        MU_ASSERT("Stage does not end", end->phase == CATERVA_TRACE_END);
+        MU_ASSERT("Mismatched stage", begin->stage == end->stage);
+        MU_ASSERT("Mismatched array", begin->array == end->array);
+        MU_ASSERT("Mismatched chunk", begin->nchunk == end->nchunk);
+    }
+    return 0;
+}
+
+static int count_events(recorder_t *recorder, caterva_stage_t stage, caterva_array_t *array) {
+    int count = 0;
+    for (int i = 0; i < recorder->nevents; ++i) {
+        caterva_trace_event_t *event = &recorder->events[i];
+        if (event->phase == CATERVA_TRACE_END && event->stage == stage &&
+            event->array == array) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static char* test_trace(uint8_t itemsize, uint8_t ndim, int64_t *shape, int32_t *chunkshape,
+                        int32_t *blockshape, char *filename) {
+    remove(filename);
+    recorder_t *recorder = calloc(1, sizeof(recorder_t));
+
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.trace = recorder_trace;
+    cfg.trace_data = recorder;
+    caterva_context_t *ctx;
+    MU_ASSERT_CATERVA(caterva_context_new(&cfg, &ctx));
+
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.enforceframe = true;
+    storage.properties.blosc.filename = filename;
+    for (int i = 0; i < ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = chunkshape[i];
+        storage.properties.blosc.blockshape[i] = blockshape[i];
+    }
+
+    /* Create original data */
+    size_t buffersize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        buffersize *= (size_t) shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize);
+    MU_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    /* Write the array; the chunks are compressed in order */
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage, &src));
+    int64_t nchunks = src->extnitems / src->chunknitems;
+    char *msg;
+    if (TRACING) {
+        msg = check_pairs(recorder);
+        if (msg != 0) {
+            return msg;
+        }
+        MU_ASSERT("Wrong number of compressions",
+                  count_events(recorder, CATERVA_STAGE_COMPRESS, src) == nchunks);
+        int64_t nchunk = 0;
+        for (int i = 0; i < recorder->nevents; ++i) {
+            caterva_trace_event_t *event = &recorder->events[i];
+            if (event->phase == CATERVA_TRACE_END && event->stage == CATERVA_STAGE_COMPRESS) {
+                MU_ASSERT("Chunks compressed out of order", event->nchunk == nchunk++);
+                MU_ASSERT("Wrong number of bytes",
+                          event->nbytes == src->extchunknitems * itemsize);
+            }
+        }
+    } else {
+        MU_ASSERT("Events reported without tracing support", recorder->nevents == 0);
+    }
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+
+    /* Open it again and read it */
+    recorder->nevents = 0;
+    MU_ASSERT_CATERVA(caterva_array_from_file(ctx, filename, false, &src));
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, src, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+    if (TRACING) {
+        msg = check_pairs(recorder);
+        if (msg != 0) {
+            return msg;
+        }
+        caterva_trace_event_t *open = &recorder->events[1];
+        MU_ASSERT("Frame opening not traced", open->stage == CATERVA_STAGE_IO &&
+                                              open->array == NULL && open->nbytes > 0);
+        MU_ASSERT("Wrong number of decompressions",
+                  count_events(recorder, CATERVA_STAGE_DECOMPRESS, src) == nchunks);
+        MU_ASSERT("Wrong number of chunk reads",
+                  count_events(recorder, CATERVA_STAGE_IO, src) >= nchunks);
+        MU_ASSERT("Scatter not traced",
+                  count_events(recorder, CATERVA_STAGE_SCATTER, src) == nchunks);
+    } else {
+        MU_ASSERT("Events reported without tracing support", recorder->nevents == 0);
+    }
+
+    /* Free mallocs */
+    free(buffer);
+    free(buffer_dest);
+    free(recorder);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    MU_ASSERT_CATERVA(caterva_context_free(&ctx));
+    remove(filename);
+    return 0;
+}
+
+
+static char* trace_2_double() {
+    int64_t shape[] = {60, 45};
+    int32_t chunkshape[] = {25, 20};
+    int32_t blockshape[] = {10, 10};
+
+    return test_trace(sizeof(double), 2, shape, chunkshape, blockshape, "test_trace_2.b2frame");
+}
+
+static char* trace_3_uint16() {
+    int64_t shape[] = {14, 9, 33};
+    int32_t chunkshape[] = {7, 9, 10};
+    int32_t blockshape[] = {3, 4, 10};
+
+    return test_trace(sizeof(uint16_t), 3, shape, chunkshape, blockshape, "test_trace_3.b2frame");
+}
+
+static char* all_tests() {
+    MU_RUN_TEST(trace_2_double)
+    MU_RUN_TEST(trace_3_uint16)
+
+    return 0;
+}
+
+MU_RUN_SUITE("TRACE")
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static char* test_transpose(caterva_context_t *ctx, uint8_t itemsize, uint8_t ndim, int64_t *shape,
+                            int8_t *perm, caterva_storage_backend_t backend, int32_t *chunkshape,
+                            int32_t *blockshape, caterva_storage_backend_t backend2,
+                            int32_t *chunkshape2, int32_t *blockshape2) {
+
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend;
+    if (backend == CATERVA_STORAGE_BLOSC) {
+        for (int i = 0; i < ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = chunkshape[i];
+            storage.properties.blosc.blockshape[i] = blockshape[i];
+        }
+    }
+
+    caterva_storage_t storage2 = {0};
+    storage2.backend = backend2;
+    if (backend2 == CATERVA_STORAGE_BLOSC) {
+        for (int i = 0; i < ndim; ++i) {
+            storage2.properties.blosc.chunkshape[i] = chunkshape2[i];
+            storage2.properties.blosc.blockshape[i] = blockshape2[i];
+        }
+    }
+
+    /* Create original data */
+    size_t buffersize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        buffersize *= (size_t) shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize);
+    MU_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage, &src));
+
+    /* Permute the axes */
+    caterva_array_t *dest;
+    MU_ASSERT_CATERVA(caterva_array_transpose(ctx, src, perm, &storage2, &dest));
+    for (int i = 0; i < ndim; ++i) {
+        MU_ASSERT("Shape not permuted", dest->shape[i] == shape[perm[i]]);
+    }
+
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, dest, buffer_dest, buffersize));
+
+    /* Assert results */
+    int64_t nitems = (int64_t) buffersize / itemsize;
+    for (int64_t nitem = 0; nitem < nitems; ++nitem) {
+        int64_t index[CATERVA_MAX_DIM];
+        int64_t rem = nitem;
+        for (int i = ndim - 1; i >= 0; --i) {
+            index[perm[i]] = rem % shape[perm[i]];
+            rem /= shape[perm[i]];
+        }
+        int64_t src_nitem = 0;
+        for (int i = 0; i < ndim; ++i) {
+            src_nitem = src_nitem * shape[i] + index[i];
+        }
+        MU_ASSERT("Item not transposed correctly",
+                  memcmp(&buffer_dest[nitem * itemsize], &buffer[src_nitem * itemsize],
+                         itemsize) == 0);
+    }
+
+    /* Free mallocs */
+    free(buffer);
+    free(buffer_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &dest));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* transpose_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* transpose_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+
+static char* transpose_2_double_blosc() {
+    uint8_t itemsize = sizeof(double);
+    uint8_t ndim = 2;
+    int64_t shape[] = {70, 45};
+    int8_t perm[] = {1, 0};
+    int32_t chunkshape[] = {30, 20};
+    int32_t blockshape[] = {10, 10};
+    int32_t chunkshape2[] = {25, 40};
+    int32_t blockshape2[] = {5, 20};
+
+    return test_transpose(ctx, itemsize, ndim, shape, perm, CATERVA_STORAGE_BLOSC, chunkshape,
+                          blockshape, CATERVA_STORAGE_BLOSC, chunkshape2, blockshape2);
+}
+
+static char* transpose_3_float_blosc() {
+    uint8_t itemsize = sizeof(float);
+    uint8_t ndim = 3;
+    int64_t shape[] = {23, 41, 37};
+    int8_t perm[] = {2, 1, 0};
+    int32_t chunkshape[] = {10, 17, 20};
+    int32_t blockshape[] = {5, 8, 7};
+    int32_t chunkshape2[] = {19, 12, 13};
+    int32_t blockshape2[] = {6, 6, 6};
+
+    return test_transpose(ctx, itemsize, ndim, shape, perm, CATERVA_STORAGE_BLOSC, chunkshape,
+                          blockshape, CATERVA_STORAGE_BLOSC, chunkshape2, blockshape2);
+}
+
+static char* transpose_3_uint8_plainbuffer_blosc() {
+    uint8_t itemsize = sizeof(uint8_t);
+    uint8_t ndim = 3;
+    int64_t shape[] = {12, 50, 33};
+    int8_t perm[] = {1, 2, 0};
+    int32_t chunkshape2[] = {20, 11, 12};
+    int32_t blockshape2[] = {10, 5, 4};
+
+    return test_transpose(ctx, itemsize, ndim, shape, perm, CATERVA_STORAGE_PLAINBUFFER, NULL,
+                          NULL, CATERVA_STORAGE_BLOSC, chunkshape2, blockshape2);
+}
+
+static char* transpose_4_uint16_blosc_plainbuffer() {
+    uint8_t itemsize = sizeof(uint16_t);
+    uint8_t ndim = 4;
+    int64_t shape[] = {9, 14, 1, 21};
+    int8_t perm[] = {2, 0, 1, 3};
+    int32_t chunkshape[] = {4, 7, 1, 10};
+    int32_t blockshape[] = {2, 3, 1, 5};
+
+    return test_transpose(ctx, itemsize, ndim, shape, perm, CATERVA_STORAGE_BLOSC, chunkshape,
+                          blockshape, CATERVA_STORAGE_PLAINBUFFER, NULL, NULL);
+}
+
+static char* transpose_2_double_plainbuffer_threads() {
+    uint8_t itemsize = sizeof(double);
+    uint8_t ndim = 2;
+    int64_t shape[] = {610, 530};
+    int8_t perm[] = {1, 0};
+
+    return test_transpose(ctx, itemsize, ndim, shape, perm, CATERVA_STORAGE_PLAINBUFFER, NULL,
+                          NULL, CATERVA_STORAGE_PLAINBUFFER, NULL, NULL);
+}
+
+static char* transpose_invalid_perm() {
+    caterva_params_t params = {0};
+    params.itemsize = sizeof(double);
+    params.ndim = 3;
+    for (int i = 0; i < 3; ++i) {
+        params.shape[i] = 10;
+    }
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_PLAINBUFFER;
+
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_empty(ctx, &params, &storage, &src));
+    int8_t perm[] = {0, 2, 0};
+    caterva_array_t *dest;
+    MU_ASSERT("Repeated axes are accepted",
+              caterva_array_transpose(ctx, src, perm, &storage, &dest) ==
+              CATERVA_ERR_INVALID_ARGUMENT);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    return 0;
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(transpose_setup)
+
+    MU_RUN_TEST(transpose_2_double_blosc)
+    MU_RUN_TEST(transpose_3_float_blosc)
+    MU_RUN_TEST(transpose_3_uint8_plainbuffer_blosc)
+    MU_RUN_TEST(transpose_4_uint16_blosc_plainbuffer)
+    MU_RUN_TEST(transpose_2_double_plainbuffer_threads)
+    MU_RUN_TEST(transpose_invalid_perm)
+
+    MU_RUN_TEARDOWN(transpose_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("TRANSPOSE")
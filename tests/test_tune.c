@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static char* test_tune(caterva_context_t *ctx, uint8_t itemsize, uint8_t ndim, int64_t *shape,
+                       bool *access_axes, int64_t l2_size, int64_t l3_size, bool calibrate) {
+
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    caterva_tune_params_t tparams = CATERVA_TUNE_PARAMS_DEFAULTS;
+    tparams.l1_size = 1024;
+    tparams.l2_size = l2_size;
+    tparams.l3_size = l3_size;
+    for (int i = 0; i < ndim; ++i) {
+        tparams.access_axes[i] = access_axes[i];
+    }
+
+    /* Create original data */
+    size_t buffersize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        buffersize *= (size_t) shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize);
+    MU_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    if (calibrate) {
+        MU_ASSERT_CATERVA(caterva_storage_calibrate(ctx, &params, &tparams, buffer, shape,
+                                                    (int64_t) buffersize, &storage));
+    } else {
+        MU_ASSERT_CATERVA(caterva_storage_tune(ctx, &params, &tparams, &storage));
+    }
+
+    /* Check the proposal */
+    int64_t blocksize = itemsize;
+    int64_t chunksize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        int32_t chunklen = storage.properties.blosc.chunkshape[i];
+        int32_t blocklen = storage.properties.blosc.blockshape[i];
+        MU_ASSERT("Chunkshape out of bounds", chunklen >= 1 && chunklen <= shape[i]);
+        MU_ASSERT("Blockshape out of bounds", blocklen >= 1 && blocklen <= chunklen);
+        if (access_axes[i] && !calibrate) {
+            MU_ASSERT("Access axis is not favored", chunklen == shape[i]);
+        }
+        blocksize *= blocklen;
+        chunksize *= chunklen;
+    }
+    if (!calibrate) {
+        MU_ASSERT("Block does not fit in L2", blocksize <= l2_size);
+        MU_ASSERT("Chunk does not fit in L3", chunksize <= l3_size);
+    }
+
+    /* Roundtrip with the proposed storage */
+    caterva_array_t *src;
+    MU_ASSERT_CATERVA(caterva_array_from_buffer(ctx, buffer, buffersize, &params, &storage, &src));
+
+    uint8_t *buffer_dest = malloc(buffersize);
+    MU_ASSERT_CATERVA(caterva_array_to_buffer(ctx, src, buffer_dest, buffersize));
+    MU_ASSERT_BUFFER(buffer, buffer_dest, buffersize);
+
+    /* Free mallocs */
+    free(buffer);
+    free(buffer_dest);
+    MU_ASSERT_CATERVA(caterva_array_free(ctx, &src));
+    return 0;
+}
+
+
+caterva_context_t *ctx;
+
+static char* tune_setup() {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_context_new(&cfg, &ctx);
+    return 0;
+}
+
+static char* tune_teardown() {
+    caterva_context_free(&ctx);
+    return 0;
+}
+
+
+static char* tune_2_double() {
+    uint8_t itemsize = sizeof(double);
+    uint8_t ndim = 2;
+    int64_t shape[] = {300, 250};
+    bool access_axes[] = {false, false};
+
+    return test_tune(ctx, itemsize, ndim, shape, access_axes, 8 * 1024, 256 * 1024, false);
+}
+
+static char* tune_3_float_axis() {
+    uint8_t itemsize = sizeof(float);
+    uint8_t ndim = 3;
+    int64_t shape[] = {500, 40, 30};
+    bool access_axes[] = {true, false, false};
+
+    return test_tune(ctx, itemsize, ndim, shape, access_axes, 4 * 1024, 64 * 1024, false);
+}
+
+static char* tune_4_uint8_axes() {
+    uint8_t itemsize = sizeof(uint8_t);
+    uint8_t ndim = 4;
+    int64_t shape[] = {20, 31, 12, 40};
+    bool access_axes[] = {false, true, false, true};
+
+    return test_tune(ctx, itemsize, ndim, shape, access_axes, 2 * 1024, 32 * 1024, false);
+}
+
+static char* tune_2_uint16_calibrate() {
+    uint8_t itemsize = sizeof(uint16_t);
+    uint8_t ndim = 2;
+    int64_t shape[] = {200, 150};
+    bool access_axes[] = {false, false};
+
+    return test_tune(ctx, itemsize, ndim, shape, access_axes, 4 * 1024, 64 * 1024, true);
+}
+
+static char* tune_3_double_calibrate_axis() {
+    uint8_t itemsize = sizeof(double);
+    uint8_t ndim = 3;
+    int64_t shape[] = {40, 35, 60};
+    bool access_axes[] = {false, false, true};
+
+    return test_tune(ctx, itemsize, ndim, shape, access_axes, 8 * 1024, 128 * 1024, true);
+}
+
+static char* all_tests() {
+    MU_RUN_SETUP(tune_setup)
+
+    MU_RUN_TEST(tune_2_double)
+    MU_RUN_TEST(tune_3_float_axis)
+    MU_RUN_TEST(tune_4_uint8_axes)
+    MU_RUN_TEST(tune_2_uint16_calibrate)
+    MU_RUN_TEST(tune_3_double_calibrate_axis)
+
+    MU_RUN_TEARDOWN(tune_teardown)
+    return 0;
+}
+
+MU_RUN_SUITE("TUNE")